@@ -0,0 +1,205 @@
+// Actor message rates: ping-pong between pairs of actors and fan-out from
+// outside threads to many actors, against the mutex + deque actor they
+// replace, plus the footprint of a million mostly idle actors.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "stl/actor.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kPairs = 64;
+constexpr int kBounces = 20'000;
+constexpr size_t kFanOutActors = 1'000;
+constexpr size_t kFanOutSenders = 4;
+constexpr size_t kFanOutMessages = 2'000'000;
+constexpr size_t kIdleActors = 1'000'000;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The mutex + queue object being replaced, scheduled the same way
+template <typename Message, typename Handler>
+class MutexActor {
+ public:
+  MutexActor(stl::ThreadPool& pool, Handler handler)
+      : pool_(pool), handler_(std::move(handler)) {}
+
+  ~MutexActor() {
+    while (pending() != 0) std::this_thread::yield();
+  }
+
+  void send(Message message) {
+    bool schedule = false;
+    {
+      std::scoped_lock lock(mutex_);
+      queue_.push_back(std::move(message));
+      schedule = !scheduled_;
+      scheduled_ = true;
+    }
+    if (schedule) pool_.post_continuation([this]() { run(); });
+  }
+
+  size_t pending() {
+    std::scoped_lock lock(mutex_);
+    return queue_.size() + (scheduled_ ? 1 : 0);
+  }
+
+ private:
+  stl::ThreadPool& pool_;
+  Handler handler_;
+  std::mutex mutex_;
+  std::deque<Message> queue_;
+  bool scheduled_ = false;
+
+  void run() {
+    for (uint32_t handled = 0; handled < 64; handled++) {
+      Message message;
+      {
+        std::scoped_lock lock(mutex_);
+        if (queue_.empty()) {
+          scheduled_ = false;
+          return;
+        }
+        message = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      handler_(std::move(message));
+    }
+    pool_.post_continuation([this]() { run(); });
+  }
+};
+
+template <template <typename, typename> class ActorType>
+struct PingPong {
+  struct Bounce {
+    PingPong* self;
+    size_t pair;
+    bool to_ping;
+    void operator()(int n) const;
+  };
+  using Node = ActorType<int, Bounce>;
+
+  std::vector<std::unique_ptr<Node>> pings;
+  std::vector<std::unique_ptr<Node>> pongs;
+  std::atomic<size_t> finished = 0;
+};
+
+template <template <typename, typename> class ActorType>
+void PingPong<ActorType>::Bounce::operator()(int n) const {
+  if (n == 0) {
+    self->finished.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  (to_ping ? self->pongs : self->pings)[pair]->send(n - 1);
+}
+
+template <typename Message, typename Handler>
+using LockFreeActor = stl::Actor<Message, Handler>;
+
+template <template <typename, typename> class ActorType>
+double ping_pong(stl::ThreadPool& pool) {
+  PingPong<ActorType> game;
+  for (size_t i = 0; i < kPairs; i++) {
+    game.pings.push_back(std::make_unique<typename PingPong<ActorType>::Node>(
+        pool, typename PingPong<ActorType>::Bounce{&game, i, true}));
+    game.pongs.push_back(std::make_unique<typename PingPong<ActorType>::Node>(
+        pool, typename PingPong<ActorType>::Bounce{&game, i, false}));
+  }
+
+  auto start = Clock::now();
+  for (auto& ping : game.pings) ping->send(kBounces);
+  while (game.finished.load(std::memory_order_relaxed) != kPairs) {
+    std::this_thread::yield();
+  }
+  double elapsed = seconds_since(start);
+  return kPairs * (kBounces + 1.0) / elapsed;
+}
+
+struct Count {
+  std::atomic<size_t>* handled;
+  void operator()(int) const {
+    handled->fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+template <template <typename, typename> class ActorType>
+double fan_out(stl::ThreadPool& pool) {
+  std::atomic<size_t> handled = 0;
+  std::vector<std::unique_ptr<ActorType<int, Count>>> actors;
+  for (size_t i = 0; i < kFanOutActors; i++) {
+    actors.push_back(
+        std::make_unique<ActorType<int, Count>>(pool, Count{&handled}));
+  }
+
+  auto start = Clock::now();
+  {
+    std::vector<std::jthread> senders;
+    for (size_t t = 0; t < kFanOutSenders; t++) {
+      senders.emplace_back([&actors, t]() {
+        for (size_t i = t; i < kFanOutMessages; i += kFanOutSenders) {
+          actors[i % actors.size()]->send(static_cast<int>(i));
+        }
+      });
+    }
+  }
+  while (handled.load(std::memory_order_relaxed) != kFanOutMessages) {
+    std::this_thread::yield();
+  }
+  return kFanOutMessages / seconds_since(start);
+}
+
+void idle_actors(stl::ThreadPool& pool) {
+  using Idle = stl::Actor<int, Count>;
+  std::atomic<size_t> handled = 0;
+
+  auto start = Clock::now();
+  std::vector<std::unique_ptr<Idle>> actors;
+  actors.reserve(kIdleActors);
+  for (size_t i = 0; i < kIdleActors; i++) {
+    actors.push_back(std::make_unique<Idle>(pool, Count{&handled}));
+  }
+  double created = seconds_since(start);
+
+  start = Clock::now();
+  for (auto& actor : actors) actor->send(0);
+  while (handled.load(std::memory_order_relaxed) != kIdleActors) {
+    std::this_thread::yield();
+  }
+  double woken = seconds_since(start);
+
+  std::printf("idle/bytes_per_actor          %12zu\n", sizeof(Idle));
+  std::printf("idle/create_1M                %12.1f ms\n", created * 1e3);
+  std::printf("idle/wake_each_once_1M        %12.1f ms\n", woken * 1e3);
+}
+
+}  // namespace
+
+int main() {
+  stl::ThreadPool pool(std::max(2U, std::thread::hardware_concurrency()));
+
+  std::printf("ping_pong/actor               %12.0f msgs/s\n",
+              ping_pong<LockFreeActor>(pool));
+  std::printf("ping_pong/mutex_actor         %12.0f msgs/s\n",
+              ping_pong<MutexActor>(pool));
+  std::printf("fan_out/actor                 %12.0f msgs/s\n",
+              fan_out<LockFreeActor>(pool));
+  std::printf("fan_out/mutex_actor           %12.0f msgs/s\n",
+              fan_out<MutexActor>(pool));
+  idle_actors(pool);
+  return 0;
+}
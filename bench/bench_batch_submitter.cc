@@ -0,0 +1,87 @@
+// Throughput of nanosecond-scale tasks on ThreadPool: one post() per task
+// against BatchSubmitter with a few batch sizes.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "stl/batch_submitter.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+constexpr size_t kTasks = 1'000'000;
+
+// Roughly 100 ns of work
+uint64_t burn(uint64_t x) {
+  for (int i = 0; i < 25; i++) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+  }
+  return x;
+}
+
+struct Workload {
+  std::vector<uint64_t> results = std::vector<uint64_t>(kTasks);
+  std::atomic<size_t> done = 0;
+
+  auto task(size_t i) {
+    return [this, i]() {
+      results[i] = burn(i);
+      done.fetch_add(1, std::memory_order_relaxed);
+    };
+  }
+
+  void wait() {
+    while (done.load(std::memory_order_relaxed) != kTasks) {
+      std::this_thread::yield();
+    }
+  }
+};
+
+double tasks_per_second(std::chrono::steady_clock::time_point start) {
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return static_cast<double>(kTasks) / seconds;
+}
+
+void bench_post(stl::ThreadPool& pool, size_t workers) {
+  Workload workload;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kTasks; i++) pool.post(workload.task(i));
+  workload.wait();
+
+  std::printf("%2zu workers post:             %12.0f tasks/s\n", workers,
+              tasks_per_second(start));
+}
+
+void bench_batched(stl::ThreadPool& pool, size_t workers, size_t batch) {
+  Workload workload;
+  auto start = std::chrono::steady_clock::now();
+  {
+    stl::BatchSubmitter submitter(pool, batch);
+    for (size_t i = 0; i < kTasks; i++) submitter.post(workload.task(i));
+  }  // Flushes the tail
+  workload.wait();
+
+  std::printf("%2zu workers batch %4zu:       %12.0f tasks/s\n", workers,
+              batch, tasks_per_second(start));
+}
+
+}  // namespace
+
+int main() {
+  size_t max_workers = std::max(1U, std::thread::hardware_concurrency());
+  for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+    stl::ThreadPool pool(workers);
+    bench_post(pool, workers);
+    for (size_t batch : {16, 64, 256}) bench_batched(pool, workers, batch);
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+// BTreeMap against std::map with uint64_t keys and values: random inserts,
+// in-order bulk loading (from_sorted here, inserts with an end hint for
+// std::map), random point lookups, and scans of 100-entry ranges from
+// random starts, from 64K to 16M entries.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "stl/btree_map.h"
+#include "stl/vector.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Map = stl::BTreeMap<uint64_t, uint64_t>;
+using StdMap = std::map<uint64_t, uint64_t>;
+
+constexpr size_t kLookups = 2'000'000;
+constexpr size_t kScans = 200'000;
+constexpr size_t kScanLength = 100;
+
+uint64_t sink = 0;
+
+double ns_per_op(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         static_cast<double>(ops);
+}
+
+struct Result {
+  double insert;
+  double load;
+  double lookup;
+  double scan;
+};
+
+// Every other key is present, so half the lookups miss
+template <typename M>
+void lookups_and_scans(const M& map, const std::vector<uint64_t>& probes,
+                       Result& result) {
+  auto start = Clock::now();
+  for (size_t i = 0; i < kLookups; i++) {
+    auto it = map.find(probes[i % probes.size()]);
+    if (it != map.end()) sink += it->second;
+  }
+  result.lookup = ns_per_op(start, kLookups);
+
+  start = Clock::now();
+  for (size_t i = 0; i < kScans; i++) {
+    auto it = map.lower_bound(probes[i % probes.size()]);
+    for (size_t j = 0; j < kScanLength && it != map.end(); j++, ++it) {
+      sink += it->second;
+    }
+  }
+  result.scan = ns_per_op(start, kScans * kScanLength);
+}
+
+Result run_btree(const std::vector<uint64_t>& keys,
+                 const std::vector<uint64_t>& probes) {
+  Result result{};
+  auto start = Clock::now();
+  {
+    Map map;
+    for (uint64_t key : keys) map.try_emplace(key, key);
+    sink += map.size();
+  }
+  result.insert = ns_per_op(start, keys.size());
+
+  stl::Vector<std::pair<uint64_t, uint64_t>> sorted(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) sorted.emplace_back(2 * i, i);
+  start = Clock::now();
+  Map map = Map::from_sorted(std::move(sorted));
+  result.load = ns_per_op(start, keys.size());
+
+  lookups_and_scans(map, probes, result);
+  return result;
+}
+
+Result run_std(const std::vector<uint64_t>& keys,
+               const std::vector<uint64_t>& probes) {
+  Result result{};
+  auto start = Clock::now();
+  {
+    StdMap map;
+    for (uint64_t key : keys) map.try_emplace(key, key);
+    sink += map.size();
+  }
+  result.insert = ns_per_op(start, keys.size());
+
+  start = Clock::now();
+  StdMap map;
+  for (size_t i = 0; i < keys.size(); i++) {
+    map.emplace_hint(map.end(), 2 * i, i);
+  }
+  result.load = ns_per_op(start, keys.size());
+
+  lookups_and_scans(map, probes, result);
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937_64 rng(13);
+  std::printf("%-10s %-16s %10s %10s %10s %10s\n", "entries", "map", "insert",
+              "load", "lookup", "scan");
+  for (size_t n : {size_t{1} << 16, size_t{1} << 20, size_t{1} << 24}) {
+    // Even keys 0 to 2n, inserted in random order
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) keys[i] = 2 * i;
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<uint64_t> probes(1 << 20);
+    for (uint64_t& probe : probes) probe = rng() % (2 * n);
+
+    // Alternated, as whichever runs first also pays for growing the heap
+    Result results[2] = {{1e9, 1e9, 1e9, 1e9}, {1e9, 1e9, 1e9, 1e9}};
+    for (int pass = 0; pass < 2; pass++) {
+      Result passes[2] = {run_btree(keys, probes), run_std(keys, probes)};
+      for (int i = 0; i < 2; i++) {
+        results[i].insert = std::min(results[i].insert, passes[i].insert);
+        results[i].load = std::min(results[i].load, passes[i].load);
+        results[i].lookup = std::min(results[i].lookup, passes[i].lookup);
+        results[i].scan = std::min(results[i].scan, passes[i].scan);
+      }
+    }
+    const char* names[2] = {"stl::BTreeMap", "std::map"};
+    for (int i = 0; i < 2; i++) {
+      std::printf("%-10zu %-16s %8.1fns %8.1fns %8.1fns %8.2fns\n", n,
+                  names[i], results[i].insert, results[i].load,
+                  results[i].lookup, results[i].scan);
+    }
+  }
+  return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+// ConcurrentHashMap against a std::unordered_map behind one std::shared_mutex
+// under 90/10 and 50/50 read/write mixes on uint64_t keys, from 1 to 64
+// threads. Each thread runs a fixed number of operations on a prefilled
+// key range; writes alternate between insert_or_assign and erase+insert.
+//
+//   bench_concurrent_hash_map [--max-threads N] [--ops PER_THREAD]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "stl/concurrent_hash_map.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64_t kKeys = 1 << 20;
+
+std::atomic<uint64_t> sink = 0;
+
+class LockedUnorderedMap {
+ public:
+  std::optional<uint64_t> find(uint64_t key) const {
+    std::shared_lock lock(mutex_);
+    auto it = map_.find(key);
+    if (it == map_.end()) return std::nullopt;
+    return it->second;
+  }
+
+  bool insert_or_assign(uint64_t key, uint64_t value) {
+    std::unique_lock lock(mutex_);
+    return map_.insert_or_assign(key, value).second;
+  }
+
+  bool erase(uint64_t key) {
+    std::unique_lock lock(mutex_);
+    return map_.erase(key) == 1;
+  }
+
+ private:
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<uint64_t, uint64_t> map_;
+};
+
+// Million operations per second across all threads
+template <typename Map>
+double run(Map& map, size_t threads, size_t ops, unsigned write_percent) {
+  std::atomic<size_t> ready = 0;
+  std::atomic<bool> go = false;
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      std::mt19937_64 rng(t + 1);
+      uint64_t local = 0;
+      ready++;
+      while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+      for (size_t i = 0; i < ops; i++) {
+        uint64_t r = rng();
+        uint64_t key = r % kKeys;
+        if ((r >> 32) % 100 >= write_percent) {
+          std::optional<uint64_t> value = map.find(key);
+          local += value ? *value : 1;
+        } else if (i % 2 == 0) {
+          map.insert_or_assign(key, r);
+        } else {
+          map.erase(key);
+          map.insert_or_assign(key, r);
+        }
+      }
+      sink += local;
+    });
+  }
+
+  while (ready.load() < threads) std::this_thread::yield();
+  auto start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto& worker : workers) worker.join();
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return static_cast<double>(threads * ops) / seconds / 1e6;
+}
+
+template <typename Map>
+void prefill(Map& map) {
+  for (uint64_t key = 0; key < kKeys; key++) map.insert_or_assign(key, key);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t max_threads = 64;
+  size_t ops = 200'000;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc) {
+      max_threads = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+      ops = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "usage: %s [--max-threads N] [--ops PER_THREAD]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::printf("hardware threads: %u, keys: %llu\n",
+              std::thread::hardware_concurrency(),
+              static_cast<unsigned long long>(kKeys));
+  std::printf("%-6s %-8s %18s %22s\n", "mix", "threads", "ConcurrentHashMap",
+              "shared_mutex+unordered");
+
+  for (unsigned write_percent : {10u, 50u}) {
+    stl::ConcurrentHashMap<uint64_t, uint64_t> sharded;
+    LockedUnorderedMap locked;
+    prefill(sharded);
+    prefill(locked);
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+      double sharded_mops = run(sharded, threads, ops, write_percent);
+      double locked_mops = run(locked, threads, ops, write_percent);
+      std::printf("%2u/%-3u %-8zu %13.2f Mop/s %17.2f Mop/s\n",
+                  100 - write_percent, write_percent, threads, sharded_mops,
+                  locked_mops);
+    }
+  }
+  return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+// Building a 100 MB response out of 16-256 byte pieces, prepending headers
+// once its length is known and writing it to a memfd: std::string, grown
+// by append() and written with write(), against Cord, written chunk by
+// chunk with writev(). Also copying the response and slicing it in two.
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stl/cord.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kResponseBytes = 100 << 20;
+constexpr int kRepeats = 5;
+
+uint64_t sink = 0;
+
+double ms_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// Pieces cycled through to build the response, like serialised rows
+std::vector<std::string> make_pieces() {
+  std::mt19937_64 rng(11);
+  std::vector<std::string> pieces(4096);
+  for (std::string& piece : pieces) {
+    piece.resize(16 + rng() % 241);
+    for (char& c : piece) c = static_cast<char>('a' + rng() % 26);
+  }
+  return pieces;
+}
+
+std::string header_for(size_t length) {
+  return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(length) +
+         "\r\n\r\n";
+}
+
+void write_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = write(fd, data.data(), data.size());
+    if (n <= 0) return;
+    data.remove_prefix(static_cast<size_t>(n));
+  }
+}
+
+// Up to IOV_MAX chunks per call
+void writev_all(int fd, const stl::Cord& cord) {
+  std::vector<iovec> iov;
+  iov.reserve(IOV_MAX);
+  auto flush = [&] {
+    size_t offset = 0;
+    while (offset < iov.size()) {
+      ssize_t n = writev(fd, iov.data() + offset,
+                         static_cast<int>(iov.size() - offset));
+      if (n <= 0) return;
+      // Skip whole iovecs written, then trim a partly written one
+      auto left = static_cast<size_t>(n);
+      while (offset < iov.size() && left >= iov[offset].iov_len) {
+        left -= iov[offset++].iov_len;
+      }
+      if (left != 0) {
+        iov[offset].iov_base = static_cast<char*>(iov[offset].iov_base) + left;
+        iov[offset].iov_len -= left;
+      }
+    }
+    iov.clear();
+  };
+  for (std::string_view chunk : cord.chunks()) {
+    iov.push_back({const_cast<char*>(chunk.data()), chunk.size()});
+    if (iov.size() == IOV_MAX) flush();
+  }
+  flush();
+}
+
+struct Result {
+  double build = 1e9;
+  double prepend = 1e9;
+  double write = 1e9;
+  double copy_slice = 1e9;
+};
+
+void rewind(int fd) {
+  ftruncate(fd, 0);
+  lseek(fd, 0, SEEK_SET);
+}
+
+Result run_string(const std::vector<std::string>& pieces, int fd) {
+  Result result;
+  for (int r = 0; r < kRepeats; r++) {
+    auto start = Clock::now();
+    std::string body;
+    for (size_t i = 0; body.size() < kResponseBytes; i++) {
+      body.append(pieces[i % pieces.size()]);
+    }
+    result.build = std::min(result.build, ms_since(start));
+
+    start = Clock::now();
+    body.insert(0, header_for(body.size()));
+    result.prepend = std::min(result.prepend, ms_since(start));
+
+    rewind(fd);
+    start = Clock::now();
+    write_all(fd, body);
+    result.write = std::min(result.write, ms_since(start));
+
+    start = Clock::now();
+    std::string copy = body;
+    std::string head = body.substr(0, body.size() / 2);
+    std::string tail = body.substr(body.size() / 2);
+    result.copy_slice = std::min(result.copy_slice, ms_since(start));
+    sink += copy.size() + head.size() + tail.size();
+  }
+  return result;
+}
+
+Result run_cord(const std::vector<std::string>& pieces, int fd) {
+  Result result;
+  for (int r = 0; r < kRepeats; r++) {
+    auto start = Clock::now();
+    stl::Cord body;
+    for (size_t i = 0; body.size() < kResponseBytes; i++) {
+      body.append(pieces[i % pieces.size()]);
+    }
+    result.build = std::min(result.build, ms_since(start));
+
+    start = Clock::now();
+    body.prepend(header_for(body.size()));
+    result.prepend = std::min(result.prepend, ms_since(start));
+
+    rewind(fd);
+    start = Clock::now();
+    writev_all(fd, body);
+    result.write = std::min(result.write, ms_since(start));
+
+    start = Clock::now();
+    stl::Cord copy = body;
+    stl::Cord head = body.substr(0, body.size() / 2);
+    stl::Cord tail = body.substr(body.size() / 2);
+    result.copy_slice = std::min(result.copy_slice, ms_since(start));
+    sink += copy.size() + head.size() + tail.size() + body.chunk_count();
+  }
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  int fd = memfd_create("bench_cord", 0);
+  if (fd < 0) {
+    std::perror("memfd_create");
+    return 1;
+  }
+  auto pieces = make_pieces();
+
+  // Alternated, as whichever runs first also pays for growing the heap
+  Result results[2];
+  for (int pass = 0; pass < 2; pass++) {
+    Result passes[2] = {run_string(pieces, fd), run_cord(pieces, fd)};
+    for (int i = 0; i < 2; i++) {
+      results[i].build = std::min(results[i].build, passes[i].build);
+      results[i].prepend = std::min(results[i].prepend, passes[i].prepend);
+      results[i].write = std::min(results[i].write, passes[i].write);
+      results[i].copy_slice =
+          std::min(results[i].copy_slice, passes[i].copy_slice);
+    }
+  }
+  close(fd);
+
+  std::printf("%zu MB response from 16-256 byte pieces\n\n",
+              kResponseBytes >> 20);
+  std::printf("%-12s %10s %10s %10s %12s\n", "", "build", "prepend",
+              "write", "copy+slice");
+  const char* names[2] = {"std::string", "stl::Cord"};
+  for (int i = 0; i < 2; i++) {
+    std::printf("%-12s %8.1fms %8.2fms %8.1fms %10.2fms\n", names[i],
+                results[i].build, results[i].prepend, results[i].write,
+                results[i].copy_slice);
+  }
+  return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+// DaryHeap with 2, 4 and 8 children against std::priority_queue, as a
+// min-heap of uint64_t deadlines: n pushes then n pops, building from n
+// values at once, and the scheduler's steady state of taking the earliest
+// deadline and pushing a later one (replace_top here, pop + push for
+// std::priority_queue), from 1K to 8M entries.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "stl/dary_heap.h"
+#include "stl/vector.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using StdHeap = std::priority_queue<uint64_t, std::vector<uint64_t>,
+                                    std::greater<uint64_t>>;
+
+constexpr size_t kHoldOps = 4'000'000;
+
+uint64_t sink = 0;
+
+double ns_per_op(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         static_cast<double>(ops);
+}
+
+struct Result {
+  double push_pop_all;
+  double build;
+  double hold;
+};
+
+template <size_t D>
+Result run_dary(const std::vector<uint64_t>& keys,
+                const std::vector<uint64_t>& steps) {
+  using Heap = stl::DaryHeap<uint64_t, D, std::greater<uint64_t>>;
+  Result result{};
+
+  auto start = Clock::now();
+  {
+    Heap heap;
+    for (uint64_t key : keys) heap.push(key);
+    while (!heap.empty()) {
+      sink += heap.top();
+      heap.pop();
+    }
+  }
+  result.push_pop_all = ns_per_op(start, keys.size());
+
+  stl::Vector<uint64_t> values(keys.size());
+  for (uint64_t key : keys) values.push_back(key);
+  start = Clock::now();
+  Heap heap(std::move(values));
+  result.build = ns_per_op(start, keys.size());
+
+  start = Clock::now();
+  for (size_t i = 0; i < kHoldOps; i++) {
+    sink += heap.replace_top(heap.top() + steps[i % steps.size()]);
+  }
+  result.hold = ns_per_op(start, kHoldOps);
+  return result;
+}
+
+Result run_std(const std::vector<uint64_t>& keys,
+               const std::vector<uint64_t>& steps) {
+  Result result{};
+
+  auto start = Clock::now();
+  {
+    StdHeap heap;
+    for (uint64_t key : keys) heap.push(key);
+    while (!heap.empty()) {
+      sink += heap.top();
+      heap.pop();
+    }
+  }
+  result.push_pop_all = ns_per_op(start, keys.size());
+
+  std::vector<uint64_t> values = keys;
+  start = Clock::now();
+  StdHeap heap{std::greater<uint64_t>{}, std::move(values)};
+  result.build = ns_per_op(start, keys.size());
+
+  start = Clock::now();
+  for (size_t i = 0; i < kHoldOps; i++) {
+    uint64_t next = heap.top() + steps[i % steps.size()];
+    sink += heap.top();
+    heap.pop();
+    heap.push(next);
+  }
+  result.hold = ns_per_op(start, kHoldOps);
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937_64 rng(7);
+  std::vector<uint64_t> steps(1 << 16);
+  for (uint64_t& step : steps) step = rng() % (1 << 20);
+
+  std::printf("%-10s %-22s %12s %10s %10s\n", "entries", "heap", "push+pop",
+              "build", "hold");
+  for (size_t n : {size_t{1} << 10, size_t{1} << 16, size_t{1} << 20,
+                   size_t{1} << 23}) {
+    std::vector<uint64_t> keys(n);
+    for (uint64_t& key : keys) key = rng() % (uint64_t{1} << 40);
+
+    const char* names[4] = {"std::priority_queue", "DaryHeap<2>",
+                            "DaryHeap<4>", "DaryHeap<8>"};
+    Result results[4] = {run_std(keys, steps), run_dary<2>(keys, steps),
+                         run_dary<4>(keys, steps), run_dary<8>(keys, steps)};
+    for (int i = 0; i < 4; i++) {
+      std::printf("%-10zu %-22s %10.1fns %8.1fns %8.1fns\n", n, names[i],
+                  results[i].push_pop_all, results[i].build, results[i].hold);
+    }
+  }
+  return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+// Deque against std::deque with a 16-byte work item: a FIFO work list held
+// at a steady depth (push_back + pop_front), filling from either end from
+// empty, and indexed reads, from 1K to 4M entries.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "stl/deque.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kOps = 8'000'000;
+constexpr int kRepeats = 3;
+
+uint64_t sink = 0;
+
+struct Task {
+  uint64_t id;
+  uint64_t arg;
+};
+
+template <typename F>
+double best_ns_per_op(size_t ops, F&& body) {
+  double best = 1e9;
+  for (int r = 0; r < kRepeats; r++) {
+    auto start = Clock::now();
+    body();
+    double ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    best = std::min(best, ns / static_cast<double>(ops));
+  }
+  return best;
+}
+
+struct Result {
+  double fifo;
+  double fill_back;
+  double fill_front;
+  double index;
+};
+
+template <typename D>
+Result run(size_t depth, const std::vector<uint32_t>& indices) {
+  Result result{};
+
+  D queue;
+  for (size_t i = 0; i < depth; i++) queue.push_back(Task{i, i});
+  result.fifo = best_ns_per_op(kOps, [&] {
+    for (size_t i = 0; i < kOps; i++) {
+      sink += queue.front().arg;
+      queue.pop_front();
+      queue.push_back(Task{i, i});
+    }
+  });
+
+  // Fresh containers each time, so growth is part of the cost
+  size_t rounds = std::max<size_t>(1, kOps / depth);
+  result.fill_back = best_ns_per_op(rounds * depth, [&] {
+    for (size_t r = 0; r < rounds; r++) {
+      D d;
+      for (size_t i = 0; i < depth; i++) d.push_back(Task{i, i});
+      sink += d.back().id;
+    }
+  });
+  result.fill_front = best_ns_per_op(rounds * depth, [&] {
+    for (size_t r = 0; r < rounds; r++) {
+      D d;
+      for (size_t i = 0; i < depth; i++) d.push_front(Task{i, i});
+      sink += d.front().id;
+    }
+  });
+
+  result.index = best_ns_per_op(indices.size(), [&] {
+    uint64_t local = 0;
+    for (uint32_t index : indices) local += queue[index % depth].arg;
+    sink += local;
+  });
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 rng(1);
+  std::vector<uint32_t> indices(kOps);
+  for (uint32_t& index : indices) index = rng();
+
+  std::printf("%-10s %-12s %10s %10s %10s %10s\n", "entries", "deque", "fifo",
+              "fill back", "fill front", "index");
+  for (size_t depth : {size_t{1} << 10, size_t{1} << 16, size_t{1} << 22}) {
+    // Alternated, as whichever runs first also pays for growing the heap
+    Result results[2] = {{1e9, 1e9, 1e9, 1e9}, {1e9, 1e9, 1e9, 1e9}};
+    for (int pass = 0; pass < 2; pass++) {
+      Result passes[2] = {run<stl::Deque<Task>>(depth, indices),
+                          run<std::deque<Task>>(depth, indices)};
+      for (int i = 0; i < 2; i++) {
+        results[i].fifo = std::min(results[i].fifo, passes[i].fifo);
+        results[i].fill_back =
+            std::min(results[i].fill_back, passes[i].fill_back);
+        results[i].fill_front =
+            std::min(results[i].fill_front, passes[i].fill_front);
+        results[i].index = std::min(results[i].index, passes[i].index);
+      }
+    }
+    const char* names[2] = {"stl::Deque", "std::deque"};
+    for (int i = 0; i < 2; i++) {
+      std::printf("%-10zu %-12s %8.2fns %8.2fns %8.2fns %8.2fns\n", depth,
+                  names[i], results[i].fifo, results[i].fill_back,
+                  results[i].fill_front, results[i].index);
+    }
+  }
+  return sink == 42 ? 1 : 0;
+}
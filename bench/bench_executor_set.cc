@@ -0,0 +1,114 @@
+// Request tail latency under a concurrent batch load: one shared ThreadPool
+// against an ExecutorSet with separate latency and batch pools (pinned to
+// disjoint CPUs when the machine has more than one), with and without the
+// batch pool lending its idle workers.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "stl/executor_set.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kRequests = 5'000;
+constexpr auto kRequestInterval = std::chrono::microseconds(200);
+
+std::atomic<uint64_t> sink = 0;
+
+uint64_t burn(uint64_t x, int rounds) {
+  for (int i = 0; i < rounds; i++) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+  }
+  return x;
+}
+
+// Keeps `pool` saturated with ~100 us batch tasks until stopped, through a
+// bounded queue so the backlog stays constant
+class BatchLoad {
+ public:
+  explicit BatchLoad(stl::ThreadPool& pool)
+      : feeder_([&pool](std::stop_token stop) {
+          while (!stop.stop_requested()) {
+            pool.post([]() { sink += burn(sink, 20'000); });
+          }
+        }) {}
+
+ private:
+  std::jthread feeder_;
+};
+
+// Submits requests at a fixed rate and records submit-to-completion time
+void measure(const char* label, stl::ThreadPool& requests) {
+  std::vector<double> latencies(kRequests);
+  std::atomic<size_t> done = 0;
+
+  auto next = Clock::now();
+  for (size_t i = 0; i < kRequests; i++) {
+    std::this_thread::sleep_until(next);
+    next += kRequestInterval;
+
+    auto submitted = Clock::now();
+    requests.post([&latencies, &done, submitted, i]() {
+      sink += burn(i, 200);
+      latencies[i] = std::chrono::duration<double, std::micro>(
+                         Clock::now() - submitted)
+                         .count();
+      done.fetch_add(1, std::memory_order_release);
+    });
+  }
+  while (done.load(std::memory_order_acquire) != kRequests) {
+    std::this_thread::yield();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto at = [&latencies](double p) {
+    return latencies[static_cast<size_t>(p / 100 * (latencies.size() - 1))];
+  };
+  std::printf("%-28s p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us\n", label,
+              at(50), at(99), at(99.9));
+}
+
+}  // namespace
+
+int main() {
+  size_t cpus = std::max(1U, std::thread::hardware_concurrency());
+  size_t latency_workers = std::max<size_t>(1, cpus / 4);
+  size_t batch_workers = std::max<size_t>(1, cpus - latency_workers);
+
+  {
+    stl::ThreadPool shared(cpus, 4 * cpus);
+    BatchLoad load(shared);
+    measure("shared pool", shared);
+  }
+
+  // Disjoint CPU sets only make sense with more than one CPU
+  std::vector<int> latency_cpus;
+  std::vector<int> batch_cpus;
+  if (cpus > 1) {
+    for (size_t i = 0; i < cpus; i++) {
+      (i < latency_workers ? latency_cpus : batch_cpus)
+          .push_back(static_cast<int>(i));
+    }
+  }
+
+  for (bool lend : {false, true}) {
+    stl::ExecutorSet executors(
+        {{"latency", latency_workers, latency_cpus},
+         {"batch", batch_workers, batch_cpus, 4 * batch_workers}});
+    if (lend) executors.lend("batch", "latency");
+
+    BatchLoad load(executors.pool("batch"));
+    measure(lend ? "executor set, lending" : "executor set",
+            executors.pool("latency"));
+  }
+  return 0;
+}
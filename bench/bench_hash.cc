@@ -0,0 +1,158 @@
+// stl::Hash against std::hash: throughput of the byte hasher from 4 B to
+// 64 KB and of the integer mixer, then hash quality, as the worst per-bit
+// avalanche bias (0 ideal, 1 for a bit that never or always flips) and the
+// fill of 2^16 buckets by sequential and strided integer keys, taking the
+// bucket from the low and from the high bits.
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "stl/hash.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t sink = 0;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename F>
+double bytes_gbps(F&& hash, const std::vector<char>& buffer, size_t len) {
+  size_t iterations = std::max<size_t>(1000, (size_t{256} << 20) / len);
+  // Vary the start so short inputs are not a single cached value
+  size_t offset_mask = std::bit_floor(buffer.size() - len + 1) - 1;
+  auto start = Clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    sink += hash(std::string_view(buffer.data() + ((i * 64) & offset_mask),
+                                  len));
+  }
+  return static_cast<double>(iterations * len) / seconds_since(start) / 1e9;
+}
+
+template <typename F>
+double integer_ns(F&& hash) {
+  constexpr size_t kIterations = 100'000'000;
+  auto start = Clock::now();
+  uint64_t chained = 0;
+  for (size_t i = 0; i < kIterations; i++) chained = hash(chained + i);
+  sink += chained;
+  return seconds_since(start) * 1e9 / kIterations;
+}
+
+// Largest |2 * P(output bit j flips | input bit i flips) - 1| over (i, j)
+template <typename F>
+double avalanche_bias(F&& hash, size_t len, size_t samples) {
+  std::mt19937_64 rng(len);
+  std::vector<uint32_t> flips(len * 8 * 64, 0);
+  std::vector<unsigned char> input(len);
+  for (size_t s = 0; s < samples; s++) {
+    for (auto& byte : input) byte = static_cast<unsigned char>(rng());
+    uint64_t base = hash(input);
+    for (size_t bit = 0; bit < len * 8; bit++) {
+      input[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+      uint64_t diff = base ^ hash(input);
+      input[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+      for (size_t out = 0; out < 64; out++) {
+        flips[bit * 64 + out] += (diff >> out) & 1;
+      }
+    }
+  }
+  double worst = 0;
+  for (uint32_t count : flips) {
+    double p = static_cast<double>(count) / static_cast<double>(samples);
+    worst = std::max(worst, std::fabs(2 * p - 1));
+  }
+  return worst;
+}
+
+// Fraction of 2^16 buckets hit by 2^16 keys; about 0.632 when uniform
+template <typename F>
+double bucket_fill(F&& hash, uint64_t stride, bool high_bits) {
+  constexpr size_t kBuckets = 1 << 16;
+  std::vector<bool> hit(kBuckets, false);
+  for (uint64_t i = 0; i < kBuckets; i++) {
+    uint64_t h = hash(i * stride);
+    hit[high_bits ? h >> 48 : h & (kBuckets - 1)] = true;
+  }
+  return static_cast<double>(std::count(hit.begin(), hit.end(), true)) /
+         kBuckets;
+}
+
+}  // namespace
+
+int main() {
+  std::vector<char> buffer((1 << 16) + 4096);
+  std::mt19937_64 rng(1);
+  for (char& c : buffer) c = static_cast<char>(rng());
+
+  auto stl_bytes = [](std::string_view s) {
+    return stl::Hash<std::string_view>{}(s);
+  };
+  auto std_bytes = [](std::string_view s) {
+    return std::hash<std::string_view>{}(s);
+  };
+
+  std::printf("%-8s %14s %14s\n", "bytes", "stl::Hash", "std::hash");
+  for (size_t len : {4, 16, 64, 256, 1024, 4096, 65536}) {
+    std::printf("%-8zu %9.2f GB/s %9.2f GB/s\n", len,
+                bytes_gbps(stl_bytes, buffer, len),
+                bytes_gbps(std_bytes, buffer, len));
+  }
+
+  auto stl_int = [](uint64_t x) { return stl::Hash<uint64_t>{}(x); };
+  auto std_int = [](uint64_t x) { return std::hash<uint64_t>{}(x); };
+  std::printf("\nuint64_t: stl::Hash %.2f ns, std::hash %.2f ns (identity)\n",
+              integer_ns(stl_int), integer_ns(std_int));
+
+  std::printf("\n%-22s %12s\n", "avalanche", "worst bias");
+  auto int_input = [](auto&& hash) {
+    return [hash](const std::vector<unsigned char>& bytes) {
+      uint64_t value;
+      std::memcpy(&value, bytes.data(), sizeof(value));
+      return static_cast<uint64_t>(hash(value));
+    };
+  };
+  auto bytes_input = [](auto&& hash) {
+    return [hash](const std::vector<unsigned char>& bytes) {
+      return static_cast<uint64_t>(hash(std::string_view(
+          reinterpret_cast<const char*>(bytes.data()), bytes.size())));
+    };
+  };
+  std::printf("%-22s %12.3f\n", "stl::Hash<uint64_t>",
+              avalanche_bias(int_input(stl_int), 8, 20000));
+  std::printf("%-22s %12.3f\n", "std::hash<uint64_t>",
+              avalanche_bias(int_input(std_int), 8, 20000));
+  for (size_t len : {8, 32, 300}) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "stl::Hash %zu B", len);
+    std::printf("%-22s %12.3f\n", name,
+                avalanche_bias(bytes_input(stl_bytes), len, 2000));
+    std::snprintf(name, sizeof(name), "std::hash %zu B", len);
+    std::printf("%-22s %12.3f\n", name,
+                avalanche_bias(bytes_input(std_bytes), len, 2000));
+  }
+
+  std::printf("\n%-22s %10s %10s %10s %10s\n", "bucket fill (0.632)",
+              "seq/low", "seq/high", "4096/low", "4096/high");
+  std::printf("%-22s %10.3f %10.3f %10.3f %10.3f\n", "stl::Hash<uint64_t>",
+              bucket_fill(stl_int, 1, false), bucket_fill(stl_int, 1, true),
+              bucket_fill(stl_int, 4096, false),
+              bucket_fill(stl_int, 4096, true));
+  std::printf("%-22s %10.3f %10.3f %10.3f %10.3f\n", "std::hash<uint64_t>",
+              bucket_fill(std_int, 1, false), bucket_fill(std_int, 1, true),
+              bucket_fill(std_int, 4096, false),
+              bucket_fill(std_int, 4096, true));
+  return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+// HashMap against std::unordered_map with uint64_t keys and values: insert
+// into a fresh map, find-hit, find-miss and erase, from 1K to 100M entries.
+//
+//   bench_hash_map [--max ENTRIES]
+//
+// Sizes whose tables would not fit in the available memory are skipped.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "stl/hash_map.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Generous per-entry footprint of the larger of the two maps plus the key
+// vectors, used only to skip sizes that would swap
+constexpr size_t kBytesPerEntry = 112;
+
+uint64_t sink = 0;
+
+double ns_per_op(Clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         static_cast<double>(ops);
+}
+
+std::vector<uint64_t> random_keys(size_t count, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<uint64_t> keys(count);
+  for (uint64_t& key : keys) key = rng();
+  return keys;
+}
+
+struct Result {
+  double insert;
+  double find_hit;
+  double find_miss;
+  double erase;
+};
+
+template <typename Map>
+Result run(const std::vector<uint64_t>& keys,
+           const std::vector<uint64_t>& shuffled,
+           const std::vector<uint64_t>& misses) {
+  Result result{};
+  Map map;
+
+  auto start = Clock::now();
+  for (uint64_t key : keys) map[key] = key;
+  result.insert = ns_per_op(start, keys.size());
+
+  start = Clock::now();
+  for (uint64_t key : shuffled) sink += map.find(key)->second;
+  result.find_hit = ns_per_op(start, shuffled.size());
+
+  start = Clock::now();
+  for (uint64_t key : misses) sink += map.find(key) == map.end();
+  result.find_miss = ns_per_op(start, misses.size());
+
+  start = Clock::now();
+  for (uint64_t key : shuffled) sink += map.erase(key);
+  result.erase = ns_per_op(start, shuffled.size());
+  return result;
+}
+
+size_t available_bytes() {
+  long pages = sysconf(_SC_AVPHYS_PAGES);
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (pages <= 0 || page_size <= 0) return SIZE_MAX;
+  return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t max_entries = 100'000'000;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+      max_entries = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr, "usage: %s [--max ENTRIES]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::printf("%-10s %-14s %10s %10s %10s %10s\n", "entries", "map",
+              "insert", "find-hit", "find-miss", "erase");
+  for (size_t n = 1'000; n <= max_entries; n *= 10) {
+    if (n > available_bytes() / kBytesPerEntry) {
+      std::printf("%-10zu skipped, needs about %zu MB\n", n,
+                  n * kBytesPerEntry >> 20);
+      continue;
+    }
+
+    auto keys = random_keys(n, 1);
+    auto misses = random_keys(n, 2);
+    auto shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(3));
+
+    // Small sizes repeat so every row does similar total work
+    size_t repeats = std::max<size_t>(1, 1'000'000 / n);
+    Result best[2] = {{1e9, 1e9, 1e9, 1e9}, {1e9, 1e9, 1e9, 1e9}};
+    for (size_t r = 0; r < repeats; r++) {
+      Result results[2] = {
+          run<stl::HashMap<uint64_t, uint64_t>>(keys, shuffled, misses),
+          run<std::unordered_map<uint64_t, uint64_t>>(keys, shuffled, misses),
+      };
+      for (int m = 0; m < 2; m++) {
+        best[m].insert = std::min(best[m].insert, results[m].insert);
+        best[m].find_hit = std::min(best[m].find_hit, results[m].find_hit);
+        best[m].find_miss = std::min(best[m].find_miss, results[m].find_miss);
+        best[m].erase = std::min(best[m].erase, results[m].erase);
+      }
+    }
+
+    const char* names[2] = {"HashMap", "unordered_map"};
+    for (int m = 0; m < 2; m++) {
+      std::printf("%-10zu %-14s %8.1fns %8.1fns %8.1fns %8.1fns\n", n,
+                  names[m], best[m].insert, best[m].find_hit,
+                  best[m].find_miss, best[m].erase);
+    }
+  }
+  return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// Pipeline throughput on a synthetic 4-stage ingest path:
+// parse (serial in order) -> transform (parallel) -> aggregate (serial out of
+// order) -> write (serial in order), against running the same stages inline.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "stl/pipeline.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+constexpr size_t kItems = 200'000;
+
+struct Record {
+  uint64_t raw = 0;
+  uint64_t parsed = 0;
+  uint64_t transformed = 0;
+};
+
+// Stand-in for real work, `rounds` iterations of a 64-bit mixer
+uint64_t burn(uint64_t x, int rounds) {
+  for (int i = 0; i < rounds; i++) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+  }
+  return x;
+}
+
+void parse(Record& r) { r.parsed = burn(r.raw, 20); }
+void transform(Record& r) { r.transformed = burn(r.parsed, 400); }
+
+double items_per_second(size_t items,
+                        std::chrono::steady_clock::time_point start) {
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return static_cast<double>(items) / seconds;
+}
+
+void bench_inline() {
+  uint64_t aggregate = 0;
+  uint64_t written = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kItems; i++) {
+    Record r{i, 0, 0};
+    parse(r);
+    transform(r);
+    aggregate += r.transformed;
+    written = burn(written ^ r.transformed, 5);
+  }
+  double rate = items_per_second(kItems, start);
+
+  std::printf("inline:                   %10.0f items/s (checksum %llx)\n",
+              rate, static_cast<unsigned long long>(aggregate ^ written));
+}
+
+template <size_t MaxTokens>
+void bench_pipeline(stl::ThreadPool& pool, size_t workers) {
+  uint64_t aggregate = 0;
+  uint64_t written = 0;
+  size_t next = 0;
+
+  stl::Pipeline<Record, MaxTokens> pipeline(pool);
+  pipeline.add_stage(stl::StageMode::kSerialInOrder, parse)
+      .add_stage(stl::StageMode::kParallel, transform)
+      .add_stage(stl::StageMode::kSerialOutOfOrder,
+                 [&aggregate](Record& r) { aggregate += r.transformed; })
+      .add_stage(stl::StageMode::kSerialInOrder, [&written](Record& r) {
+        written = burn(written ^ r.transformed, 5);
+      });
+
+  auto start = std::chrono::steady_clock::now();
+  pipeline.run([&next](Record& r) {
+    if (next == kItems) return false;
+    r = Record{next++, 0, 0};
+    return true;
+  });
+  double rate = items_per_second(kItems, start);
+
+  std::printf(
+      "pipeline %2zu workers %3zu tokens: %10.0f items/s (checksum %llx)\n",
+      workers, MaxTokens, rate,
+      static_cast<unsigned long long>(aggregate ^ written));
+}
+
+}  // namespace
+
+int main() {
+  bench_inline();
+
+  size_t max_workers = std::max(1U, std::thread::hardware_concurrency());
+  for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+    stl::ThreadPool pool(workers);
+    bench_pipeline<16>(pool, workers);
+    bench_pipeline<256>(pool, workers);
+  }
+  return 0;
+}
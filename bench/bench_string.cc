@@ -0,0 +1,139 @@
+// stl::String against std::string: construction from a string_view, copy
+// construction, and building a string by appending 1-8 char pieces, over
+// length distributions on both sides of the two inline capacities (23 chars
+// here, 15 for libstdc++).
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stl/string.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kStrings = 100'000;
+constexpr int kRepeats = 20;
+
+uint64_t sink = 0;
+
+struct Distribution {
+  const char* name;
+  // Chance in percent of drawing from the long range instead
+  unsigned long_percent;
+  size_t short_min, short_max;
+  size_t long_min, long_max;
+};
+
+std::vector<std::string> make_inputs(const Distribution& dist) {
+  std::mt19937_64 rng(42);
+  std::vector<std::string> inputs;
+  inputs.reserve(kStrings);
+  for (size_t i = 0; i < kStrings; i++) {
+    bool is_long = rng() % 100 < dist.long_percent;
+    size_t lo = is_long ? dist.long_min : dist.short_min;
+    size_t hi = is_long ? dist.long_max : dist.short_max;
+    size_t len = lo + rng() % (hi - lo + 1);
+    std::string text(len, ' ');
+    for (char& c : text) c = static_cast<char>('a' + rng() % 26);
+    inputs.push_back(std::move(text));
+  }
+  return inputs;
+}
+
+template <typename F>
+double best_ns_per_string(F&& body) {
+  double best = 1e9;
+  for (int r = 0; r < kRepeats; r++) {
+    auto start = Clock::now();
+    body();
+    double ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    best = std::min(best, ns / kStrings);
+  }
+  return best;
+}
+
+struct Result {
+  double construct;
+  double copy;
+  double append;
+};
+
+template <typename Str>
+Result run(const std::vector<std::string>& inputs) {
+  Result result{};
+  std::vector<Str> built;
+  built.reserve(inputs.size());
+
+  result.construct = best_ns_per_string([&] {
+    built.clear();
+    for (const std::string& input : inputs) {
+      built.emplace_back(std::string_view(input));
+    }
+  });
+
+  std::vector<Str> copies;
+  copies.reserve(inputs.size());
+  result.copy = best_ns_per_string([&] {
+    copies.clear();
+    for (const Str& s : built) copies.push_back(s);
+  });
+
+  result.append = best_ns_per_string([&] {
+    for (const std::string& input : inputs) {
+      Str s;
+      std::string_view rest = input;
+      while (!rest.empty()) {
+        size_t piece = std::min<size_t>(rest.size(), 1 + rest.size() % 8);
+        s.append(rest.substr(0, piece));
+        rest.remove_prefix(piece);
+      }
+      sink += s.size();
+    }
+  });
+
+  for (const Str& s : copies) sink += s.size();
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  const Distribution distributions[] = {
+      {"keys 4-15", 0, 4, 15, 0, 0},
+      {"keys 16-23", 0, 16, 23, 0, 0},
+      {"long 32-256", 100, 0, 0, 32, 256},
+      {"80% 4-20, 20% 30-200", 20, 4, 20, 30, 200},
+  };
+
+  std::printf("%-22s %-12s %10s %10s %10s\n", "lengths", "string",
+              "construct", "copy", "append");
+  for (const Distribution& dist : distributions) {
+    auto inputs = make_inputs(dist);
+    // Alternated, as whichever runs first also pays for growing the heap
+    Result results[2] = {{1e9, 1e9, 1e9}, {1e9, 1e9, 1e9}};
+    for (int pass = 0; pass < 2; pass++) {
+      Result passes[2] = {run<stl::String>(inputs), run<std::string>(inputs)};
+      for (int i = 0; i < 2; i++) {
+        results[i].construct =
+            std::min(results[i].construct, passes[i].construct);
+        results[i].copy = std::min(results[i].copy, passes[i].copy);
+        results[i].append = std::min(results[i].append, passes[i].append);
+      }
+    }
+    const char* names[2] = {"stl::String", "std::string"};
+    for (int i = 0; i < 2; i++) {
+      std::printf("%-22s %-12s %8.1fns %8.1fns %8.1fns\n", dist.name,
+                  names[i], results[i].construct, results[i].copy,
+                  results[i].append);
+    }
+  }
+  return sink == 42 ? 1 : 0;
+}
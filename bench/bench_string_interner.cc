@@ -0,0 +1,159 @@
+// StringInterner against the usual mutex + std::unordered_map<std::string,
+// uint32_t> + std::vector<const std::string*> interner: heap bytes per
+// symbol, intern() of symbols already present from 1 to 8 ThreadPool
+// workers, and comparing and hashing atoms against comparing and hashing
+// the strings themselves.
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "stl/hash.h"
+#include "stl/string_interner.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kSymbols = 300'000;
+constexpr size_t kLookups = 2'000'000;
+
+uint64_t sink = 0;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+size_t heap_in_use() { return mallinfo2().uordblks; }
+
+class NaiveInterner {
+ public:
+  uint32_t intern(std::string_view text) {
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] =
+        ids_.try_emplace(std::string(text), static_cast<uint32_t>(ids_.size()));
+    if (inserted) strings_.push_back(&it->first);
+    return it->second;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<const std::string*> strings_;
+};
+
+// Identifier-like symbols of 4 to 24 chars
+std::vector<std::string> make_symbols() {
+  std::mt19937_64 rng(9);
+  std::vector<std::string> symbols;
+  symbols.reserve(kSymbols);
+  for (size_t i = 0; i < kSymbols; i++) {
+    std::string symbol = "s" + std::to_string(i) + "_";
+    size_t len = 4 + rng() % 21;
+    while (symbol.size() < len) {
+      symbol.push_back(static_cast<char>('a' + rng() % 26));
+    }
+    symbols.push_back(std::move(symbol));
+  }
+  return symbols;
+}
+
+// Million intern() calls per second, every symbol already present
+template <typename Interner>
+double lookup_rate(Interner& interner, const std::vector<std::string>& symbols,
+                   size_t workers) {
+  stl::ThreadPool pool(workers);
+  std::vector<std::future<void>> done;
+  auto start = Clock::now();
+  for (size_t w = 0; w < workers; w++) {
+    done.push_back(pool.submit_task([&, w] {
+      std::mt19937_64 rng(w);
+      uint64_t local = 0;
+      for (size_t i = 0; i < kLookups / workers; i++) {
+        const std::string& symbol = symbols[rng() % symbols.size()];
+        if constexpr (std::is_same_v<Interner, stl::StringInterner>) {
+          local += interner.intern(symbol).id();
+        } else {
+          local += interner.intern(symbol);
+        }
+      }
+      sink += local;
+    }));
+  }
+  for (auto& future : done) future.get();
+  return static_cast<double>(kLookups) / seconds_since(start) / 1e6;
+}
+
+}  // namespace
+
+int main() {
+  auto symbols = make_symbols();
+  size_t chars = 0;
+  for (const auto& symbol : symbols) chars += symbol.size();
+  std::printf("%zu symbols, %.1f chars on average\n\n", symbols.size(),
+              static_cast<double>(chars) / symbols.size());
+
+  size_t before = heap_in_use();
+  auto interner = std::make_unique<stl::StringInterner>();
+  for (const auto& symbol : symbols) interner->intern(symbol);
+  size_t interner_bytes = heap_in_use() - before;
+
+  before = heap_in_use();
+  auto naive = std::make_unique<NaiveInterner>();
+  for (const auto& symbol : symbols) naive->intern(symbol);
+  size_t naive_bytes = heap_in_use() - before;
+
+  std::printf("%-26s %14s %14s\n", "", "StringInterner", "naive");
+  std::printf("%-26s %14.1f %14.1f\n", "heap bytes per symbol",
+              static_cast<double>(interner_bytes) / kSymbols,
+              static_cast<double>(naive_bytes) / kSymbols);
+
+  for (size_t workers = 1; workers <= 8; workers *= 2) {
+    char label[64];
+    std::snprintf(label, sizeof(label), "intern hit, %zu workers", workers);
+    std::printf("%-26s %8.2f Mop/s %8.2f Mop/s\n", label,
+                lookup_rate(*interner, symbols, workers),
+                lookup_rate(*naive, symbols, workers));
+  }
+
+  // Pairs of equal symbols held as atoms and as separate string copies
+  std::mt19937_64 rng(3);
+  std::vector<std::pair<stl::Atom, stl::Atom>> atom_pairs;
+  std::vector<std::pair<std::string, std::string>> string_pairs;
+  for (size_t i = 0; i < 1'000'000; i++) {
+    const std::string& a = symbols[rng() % kSymbols];
+    const std::string& b = rng() % 2 ? a : symbols[rng() % kSymbols];
+    atom_pairs.emplace_back(interner->intern(a), interner->intern(b));
+    string_pairs.emplace_back(a, b);
+  }
+
+  auto start = Clock::now();
+  for (const auto& [a, b] : atom_pairs) {
+    sink += (a == b) + stl::Hash<stl::Atom>{}(a);
+  }
+  double atom_ns = seconds_since(start) * 1e9 / atom_pairs.size();
+
+  start = Clock::now();
+  for (const auto& [a, b] : string_pairs) {
+    sink += (a == b) + std::hash<std::string>{}(a);
+  }
+  double string_ns = seconds_since(start) * 1e9 / string_pairs.size();
+
+  std::printf("%-26s %11.2f ns %11.2f ns\n", "compare + hash", atom_ns,
+              string_ns);
+  return sink == 42 ? 1 : 0;
+}
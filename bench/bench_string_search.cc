@@ -0,0 +1,178 @@
+// stl::find_first_of, count, split and Tokenizer against the equivalent
+// std::string_view::find / find_first_of loops, over synthetic access-log
+// lines of 100-300 bytes, with one delimiter byte and with several.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stl/string_search.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kLines = 20'000;
+constexpr int kRepeats = 30;
+
+uint64_t sink = 0;
+
+const char* level_name(stl::SimdLevel level) {
+  switch (level) {
+    case stl::SimdLevel::kAvx2:
+      return "AVX2";
+    case stl::SimdLevel::kSse42:
+      return "SSE4.2";
+    case stl::SimdLevel::kSse2:
+      return "SSE2";
+    case stl::SimdLevel::kScalar:
+      break;
+  }
+  return "scalar";
+}
+
+// Access-log style lines with a long URL and user agent, 100-300 bytes
+std::vector<std::string> make_lines() {
+  std::mt19937_64 rng(5);
+  auto word = [&](size_t min, size_t max) {
+    std::string out(min + rng() % (max - min + 1), ' ');
+    for (char& c : out) c = static_cast<char>('a' + rng() % 26);
+    return out;
+  };
+  std::vector<std::string> lines;
+  lines.reserve(kLines);
+  while (lines.size() < kLines) {
+    std::string line = "10.0." + std::to_string(rng() % 256) + "." +
+                       std::to_string(rng() % 256) +
+                       " - - [12/Mar/2024:10:" + std::to_string(rng() % 60) +
+                       ":07 +0000] \"GET /" + word(4, 40) + "/" + word(4, 40) +
+                       "?id=" + std::to_string(rng() % 100000) +
+                       "&q=" + word(2, 30) + " HTTP/1.1\" 200 " +
+                       std::to_string(rng() % 50000) + " \"Mozilla/5.0 (" +
+                       word(8, 60) + ")\"";
+    if (line.size() >= 100 && line.size() <= 300) {
+      lines.push_back(std::move(line));
+    }
+  }
+  return lines;
+}
+
+template <typename F>
+double best_ns_per_line(F&& body) {
+  double best = 1e9;
+  for (int r = 0; r < kRepeats; r++) {
+    auto start = Clock::now();
+    body();
+    double ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    best = std::min(best, ns / kLines);
+  }
+  return best;
+}
+
+// Positions of every delimiter, the usual way
+uint64_t std_find_all(std::string_view line, std::string_view delimiters) {
+  uint64_t total = 0;
+  size_t pos = delimiters.size() == 1 ? line.find(delimiters[0])
+                                      : line.find_first_of(delimiters);
+  while (pos != std::string_view::npos) {
+    total += pos;
+    pos = delimiters.size() == 1 ? line.find(delimiters[0], pos + 1)
+                                 : line.find_first_of(delimiters, pos + 1);
+  }
+  return total;
+}
+
+uint64_t stl_find_all(std::string_view line,
+                      const stl::DelimiterSet& delimiters) {
+  uint64_t total = 0;
+  size_t pos = stl::find_first_of(line, delimiters);
+  while (pos != std::string_view::npos) {
+    total += pos;
+    pos = stl::find_first_of(line, delimiters, pos + 1);
+  }
+  return total;
+}
+
+void run(const std::vector<std::string>& lines, const char* name,
+         std::string_view delimiters) {
+  stl::DelimiterSet set(delimiters);
+
+  double std_find = best_ns_per_line([&] {
+    for (const std::string& line : lines) {
+      sink += std_find_all(line, delimiters);
+    }
+  });
+  double stl_find = best_ns_per_line([&] {
+    for (const std::string& line : lines) sink += stl_find_all(line, set);
+  });
+
+  double std_count = best_ns_per_line([&] {
+    for (const std::string& line : lines) {
+      sink += std::count_if(line.begin(), line.end(), [&](char c) {
+        return delimiters.find(c) != std::string_view::npos;
+      });
+    }
+  });
+  double stl_count = best_ns_per_line([&] {
+    for (const std::string& line : lines) sink += stl::count(line, set);
+  });
+
+  // Fields into a reused std::vector against a fresh stl::Vector per line
+  std::vector<std::string_view> fields;
+  double std_split = best_ns_per_line([&] {
+    for (const std::string& line : lines) {
+      std::string_view rest = line;
+      fields.clear();
+      for (;;) {
+        size_t end = rest.find_first_of(delimiters);
+        fields.push_back(rest.substr(0, end));
+        if (end == std::string_view::npos) break;
+        rest.remove_prefix(end + 1);
+      }
+      sink += fields.size();
+    }
+  });
+  double stl_split = best_ns_per_line([&] {
+    for (const std::string& line : lines) {
+      sink += stl::split(line, set).size();
+    }
+  });
+
+  double stl_tokens = best_ns_per_line([&] {
+    for (const std::string& line : lines) {
+      for (std::string_view token : stl::Tokenizer(line, set)) {
+        sink += token.size();
+      }
+    }
+  });
+
+  std::printf("%-16s %-12s %9.1fns %9.1fns %9.1fns %9s\n", name,
+              "std", std_find, std_count, std_split, "-");
+  std::printf("%-16s %-12s %9.1fns %9.1fns %9.1fns %9.1fns\n", name, "stl",
+              stl_find, stl_count, stl_split, stl_tokens);
+}
+
+}  // namespace
+
+int main() {
+  auto lines = make_lines();
+  size_t bytes = 0;
+  for (const std::string& line : lines) bytes += line.size();
+  std::printf("%zu lines, %.1f bytes on average, %s kernels\n\n",
+              lines.size(), static_cast<double>(bytes) / lines.size(),
+              level_name(stl::simd_level()));
+
+  std::printf("%-16s %-12s %11s %11s %11s %11s\n", "delimiters", "", "find",
+              "count", "split", "tokenize");
+  run(lines, "' '", " ");
+  run(lines, "'\"'", "\"");
+  run(lines, "' /?&=' (5)", " /?&=");
+  run(lines, "12 bytes", " /?&=\"[]():;");
+  return sink == 42 ? 1 : 0;
+}
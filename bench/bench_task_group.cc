@@ -0,0 +1,137 @@
+// Recursive fork-join on ThreadPool: TaskGroup against one future per
+// subtask (submit_task + pool-aware get), for fibonacci with a tiny leaf and
+// quicksort with a realistic one.
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "stl/task_group.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+constexpr int kFib = 30;
+constexpr int kFibCutoff = 12;
+constexpr size_t kSortSize = 4'000'000;
+constexpr ptrdiff_t kSortCutoff = 2048;
+
+uint64_t serial_fib(int n) {
+  return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+uint64_t fib_group(stl::ThreadPool& pool, int n) {
+  if (n < kFibCutoff) return serial_fib(n);
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+  stl::TaskGroup group(pool);
+  group.run([&]() { a = fib_group(pool, n - 1); });
+  group.run_and_wait([&]() { b = fib_group(pool, n - 2); });
+  return a + b;
+}
+
+uint64_t fib_future(stl::ThreadPool& pool, int n) {
+  if (n < kFibCutoff) return serial_fib(n);
+
+  auto a = pool.submit_task([&pool, n]() { return fib_future(pool, n - 1); });
+  uint64_t b = fib_future(pool, n - 2);
+  return pool.get(a) + b;
+}
+
+// Three-way partition so runs of equal keys cannot degrade the recursion
+std::pair<int*, int*> partition(int* first, int* last) {
+  int pivot = first[(last - first) / 2];
+  int* middle1 = std::partition(first, last, [&](int x) { return x < pivot; });
+  int* middle2 =
+      std::partition(middle1, last, [&](int x) { return !(pivot < x); });
+  return {middle1, middle2};
+}
+
+void sort_group(stl::ThreadPool& pool, int* first, int* last) {
+  if (last - first < kSortCutoff) {
+    std::sort(first, last);
+    return;
+  }
+
+  auto [middle1, middle2] = partition(first, last);
+  stl::TaskGroup group(pool);
+  group.run([&]() { sort_group(pool, first, middle1); });
+  group.run_and_wait([&]() { sort_group(pool, middle2, last); });
+}
+
+void sort_future(stl::ThreadPool& pool, int* first, int* last) {
+  if (last - first < kSortCutoff) {
+    std::sort(first, last);
+    return;
+  }
+
+  auto [middle1, middle2] = partition(first, last);
+  auto left = pool.submit_task(
+      [&pool, first, middle1]() { sort_future(pool, first, middle1); });
+  sort_future(pool, middle2, last);
+  pool.get(left);
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Runs the recursion from inside the pool, as nested library code would
+template <typename F>
+double time_in_pool(stl::ThreadPool& pool, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  pool.submit_task(std::forward<F>(f)).get();
+  return elapsed_ms(start);
+}
+
+std::vector<int> random_values() {
+  std::vector<int> values(kSortSize);
+  std::mt19937 rng(42);
+  for (auto& value : values) value = static_cast<int>(rng());
+  return values;
+}
+
+}  // namespace
+
+int main() {
+  size_t max_workers = std::max(1U, std::thread::hardware_concurrency());
+  const std::vector<int> input = random_values();
+
+  for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+    stl::ThreadPool pool(workers);
+    uint64_t group_result = 0;
+    uint64_t future_result = 0;
+
+    double group_ms = time_in_pool(
+        pool, [&]() { group_result = fib_group(pool, kFib); });
+    double future_ms = time_in_pool(
+        pool, [&]() { future_result = fib_future(pool, kFib); });
+    std::printf(
+        "fib(%d)    %2zu workers: task_group %8.2f ms, futures %8.2f ms "
+        "(%llu/%llu)\n",
+        kFib, workers, group_ms, future_ms,
+        static_cast<unsigned long long>(group_result),
+        static_cast<unsigned long long>(future_result));
+
+    std::vector<int> a = input;
+    std::vector<int> b = input;
+    group_ms = time_in_pool(
+        pool, [&]() { sort_group(pool, a.data(), a.data() + a.size()); });
+    future_ms = time_in_pool(
+        pool, [&]() { sort_future(pool, b.data(), b.data() + b.size()); });
+    std::printf(
+        "sort(%zuM) %2zu workers: task_group %8.2f ms, futures %8.2f ms "
+        "(sorted %d/%d)\n",
+        kSortSize / 1'000'000, workers, group_ms, future_ms,
+        std::is_sorted(a.begin(), a.end()), std::is_sorted(b.begin(), b.end()));
+  }
+  return 0;
+}
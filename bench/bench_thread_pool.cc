@@ -0,0 +1,445 @@
+// ThreadPool benchmark suite against std::async and manual std::thread:
+// submit latency, end-to-end latency percentiles, empty-task throughput,
+// fan-out/fan-in, recursive parallelism and scaling across worker counts.
+//
+//   bench_thread_pool [--quick] [--repetitions N] [--json FILE]
+//                     [--compare BASELINE] [--threshold FRACTION]
+//
+// Every benchmark runs N times (default 3) and keeps its best result.
+// --json writes every metric as JSON, --compare checks them against a file
+// written the same way (bench/baseline/thread_pool.json is checked in) and
+// exits with 1 when a metric regressed by more than the threshold (default
+// 0.25). Baselines are only comparable on the machine that recorded them;
+// metrics the baseline lacks are listed rather than silently skipped.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <latch>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stl/task_group.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Metric {
+  std::string name;
+  std::string unit;
+  double value = 0;
+  bool higher_is_better = false;
+};
+
+std::vector<Metric> metrics;
+bool quick = false;
+
+// Repeated runs of a metric keep the best value, which filters out most
+// scheduling noise
+void report(const std::string& name, const std::string& unit, double value,
+            bool higher_is_better) {
+  for (Metric& m : metrics) {
+    if (m.name != name) continue;
+    m.value = higher_is_better ? std::max(m.value, value)
+                               : std::min(m.value, value);
+    return;
+  }
+  metrics.push_back(Metric{name, unit, value, higher_is_better});
+}
+
+size_t scaled(size_t n) { return quick ? std::max<size_t>(n / 10, 1) : n; }
+
+double ns_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+      .count();
+}
+
+uint64_t burn(uint64_t x, int rounds) {
+  for (int i = 0; i < rounds; i++) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 29;
+  }
+  return x;
+}
+
+double percentile(std::vector<double>& samples, double p) {
+  std::sort(samples.begin(), samples.end());
+  size_t index = static_cast<size_t>(p / 100.0 * (samples.size() - 1));
+  return samples[index];
+}
+
+// Cost of the submission call alone
+void bench_submit_latency(stl::ThreadPool& pool) {
+  size_t n = scaled(100'000);
+  std::vector<std::future<void>> futures;
+  futures.reserve(n);
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < n; i++) futures.push_back(pool.submit_task([]() {}));
+  report("submit_latency/pool_submit_task", "ns", ns_since(start) / n, false);
+  for (auto& future : futures) future.get();
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++) pool.post([]() {});
+  report("submit_latency/pool_post", "ns", ns_since(start) / n, false);
+
+  size_t spawns = scaled(2'000);
+  futures.clear();
+  start = Clock::now();
+  for (size_t i = 0; i < spawns; i++) {
+    futures.push_back(std::async(std::launch::async, []() {}));
+  }
+  report("submit_latency/std_async", "ns", ns_since(start) / spawns, false);
+  for (auto& future : futures) future.get();
+
+  std::vector<std::thread> threads;
+  threads.reserve(spawns);
+  start = Clock::now();
+  for (size_t i = 0; i < spawns; i++) threads.emplace_back([]() {});
+  report("submit_latency/std_thread", "ns", ns_since(start) / spawns, false);
+  for (auto& thread : threads) thread.join();
+}
+
+// Submission to first instruction of the task, one task at a time so the
+// queue is empty and the measurement includes the wake-up
+template <typename Launch>
+void end_to_end(const std::string& name, size_t n, Launch launch) {
+  std::vector<double> samples;
+  samples.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    auto start = Clock::now();
+    double latency = launch([start]() { return ns_since(start); });
+    samples.push_back(latency);
+  }
+  report("latency/" + name + "/p50", "ns", percentile(samples, 50), false);
+  report("latency/" + name + "/p99", "ns", percentile(samples, 99), false);
+}
+
+void bench_end_to_end(stl::ThreadPool& pool) {
+  size_t n = scaled(20'000);
+  end_to_end("pool", n, [&pool](auto task) {
+    return pool.submit_task(task).get();
+  });
+  end_to_end("std_async", scaled(2'000), [](auto task) {
+    return std::async(std::launch::async, task).get();
+  });
+  end_to_end("std_thread", scaled(2'000), [](auto task) {
+    double latency = 0;
+    std::thread thread([&]() { latency = task(); });
+    thread.join();
+    return latency;
+  });
+}
+
+// Empty tasks through the whole path, submission to completion
+void bench_throughput(stl::ThreadPool& pool) {
+  size_t n = scaled(500'000);
+  std::atomic<size_t> done = 0;
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < n; i++) {
+    pool.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+  }
+  while (done.load(std::memory_order_relaxed) != n) std::this_thread::yield();
+  report("throughput/pool_post", "tasks/s", n / (ns_since(start) * 1e-9),
+         true);
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(n);
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++) futures.push_back(pool.submit_task([]() {}));
+  for (auto& future : futures) future.get();
+  report("throughput/pool_submit_task", "tasks/s",
+         n / (ns_since(start) * 1e-9), true);
+
+  size_t spawns = scaled(5'000);
+  futures.clear();
+  start = Clock::now();
+  for (size_t i = 0; i < spawns; i++) {
+    futures.push_back(std::async(std::launch::async, []() {}));
+  }
+  for (auto& future : futures) future.get();
+  report("throughput/std_async", "tasks/s",
+         spawns / (ns_since(start) * 1e-9), true);
+}
+
+// One round: split work into `fan` tasks and wait for all of them
+void bench_fan_out(stl::ThreadPool& pool) {
+  constexpr size_t kFan = 64;
+  constexpr int kWork = 200;
+  size_t rounds = scaled(2'000);
+  std::vector<uint64_t> results(kFan);
+
+  auto start = Clock::now();
+  for (size_t round = 0; round < rounds; round++) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(kFan);
+    for (size_t i = 0; i < kFan; i++) {
+      futures.push_back(pool.submit_task(
+          [&results, i, round]() { results[i] = burn(i + round, kWork); }));
+    }
+    for (auto& future : futures) future.get();
+  }
+  report("fan_out_64/pool_futures", "us/round",
+         ns_since(start) / rounds / 1000, false);
+
+  start = Clock::now();
+  for (size_t round = 0; round < rounds; round++) {
+    stl::TaskGroup group(pool);
+    for (size_t i = 0; i < kFan; i++) {
+      group.run(
+          [&results, i, round]() { results[i] = burn(i + round, kWork); });
+    }
+    group.wait();
+  }
+  report("fan_out_64/pool_task_group", "us/round",
+         ns_since(start) / rounds / 1000, false);
+
+  size_t thread_rounds = scaled(100);
+  start = Clock::now();
+  for (size_t round = 0; round < thread_rounds; round++) {
+    std::vector<std::thread> threads;
+    threads.reserve(kFan);
+    for (size_t i = 0; i < kFan; i++) {
+      threads.emplace_back(
+          [&results, i, round]() { results[i] = burn(i + round, kWork); });
+    }
+    for (auto& thread : threads) thread.join();
+  }
+  report("fan_out_64/std_thread", "us/round",
+         ns_since(start) / thread_rounds / 1000, false);
+}
+
+constexpr int kFib = 32;
+constexpr int kFibCutoff = 16;
+// std::async and std::thread spawn an OS thread per fork, so they only
+// fork near the root
+constexpr int kSpawnCutoff = kFib - 6;
+
+uint64_t serial_fib(int n) {
+  return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+uint64_t fib_task_group(stl::ThreadPool& pool, int n) {
+  if (n < kFibCutoff) return serial_fib(n);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  stl::TaskGroup group(pool);
+  group.run([&]() { a = fib_task_group(pool, n - 1); });
+  group.run_and_wait([&]() { b = fib_task_group(pool, n - 2); });
+  return a + b;
+}
+
+uint64_t fib_pool_future(stl::ThreadPool& pool, int n) {
+  if (n < kFibCutoff) return serial_fib(n);
+  auto a =
+      pool.submit_task([&pool, n]() { return fib_pool_future(pool, n - 1); });
+  uint64_t b = fib_pool_future(pool, n - 2);
+  return pool.get(a) + b;
+}
+
+uint64_t fib_async(int n) {
+  if (n < kSpawnCutoff) return serial_fib(n);
+  auto a = std::async(std::launch::async, fib_async, n - 1);
+  uint64_t b = fib_async(n - 2);
+  return a.get() + b;
+}
+
+uint64_t fib_thread(int n) {
+  if (n < kSpawnCutoff) return serial_fib(n);
+  uint64_t a = 0;
+  std::thread thread([&a, n]() { a = fib_thread(n - 1); });
+  uint64_t b = fib_thread(n - 2);
+  thread.join();
+  return a + b;
+}
+
+void bench_recursive(stl::ThreadPool& pool) {
+  uint64_t check = serial_fib(kFib);
+  auto run = [check](const std::string& name, auto f) {
+    auto start = Clock::now();
+    uint64_t result = f();
+    report("recursive_fib/" + name, "ms", ns_since(start) / 1e6, false);
+    if (result != check) std::printf("  wrong result for %s\n", name.c_str());
+  };
+
+  run("pool_task_group", [&pool]() {
+    return pool.submit_task([&pool]() { return fib_task_group(pool, kFib); })
+        .get();
+  });
+  run("pool_futures", [&pool]() {
+    return pool.submit_task([&pool]() { return fib_pool_future(pool, kFib); })
+        .get();
+  });
+  run("std_async", []() { return fib_async(kFib); });
+  run("std_thread", []() { return fib_thread(kFib); });
+}
+
+// Fixed CPU-bound job split into many chunks, at worker counts 1 to 8 and
+// on up to the core count, so every machine reports the same metric names.
+// The caller blocks on a latch rather than helping, so N workers means N
+// threads running chunks
+void bench_scaling() {
+  constexpr size_t kChunks = 512;
+  int work = quick ? 2'000 : 20'000;
+  size_t max_workers =
+      std::max<size_t>(8, std::thread::hardware_concurrency());
+  double single = 0;
+
+  for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+    stl::ThreadPool pool(workers);
+    std::vector<uint64_t> results(kChunks);
+
+    auto start = Clock::now();
+    std::latch done(kChunks);
+    for (size_t i = 0; i < kChunks; i++) {
+      pool.post([&results, &done, i, work]() {
+        results[i] = burn(i, work);
+        done.count_down();
+      });
+    }
+    done.wait();
+    double ms = ns_since(start) / 1e6;
+    if (workers == 1) single = ms;
+
+    report("scaling/" + std::to_string(workers) + "_workers", "ms", ms, false);
+    report("scaling/" + std::to_string(workers) + "_workers_speedup", "x",
+           single / ms, true);
+  }
+}
+
+void write_json(const std::string& path) {
+  std::ofstream out(path);
+  out << "{\n  \"hardware_concurrency\": "
+      << std::thread::hardware_concurrency() << ",\n  \"metrics\": [\n";
+  for (size_t i = 0; i < metrics.size(); i++) {
+    const Metric& m = metrics[i];
+    out << "    {\"name\": \"" << m.name << "\", \"unit\": \"" << m.unit
+        << "\", \"value\": " << m.value << ", \"higher_is_better\": "
+        << (m.higher_is_better ? "true" : "false") << "}"
+        << (i + 1 < metrics.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+// Reads back the format write_json() produces: name and value of every
+// metric object, one per line, and the core count it was recorded with
+std::map<std::string, double> read_baseline(const std::string& path,
+                                            unsigned& hardware_concurrency) {
+  std::ifstream in(path);
+  std::map<std::string, double> baseline;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t cores = line.find("\"hardware_concurrency\": ");
+    if (cores != std::string::npos) {
+      hardware_concurrency = static_cast<unsigned>(std::strtoul(
+          line.c_str() + cores + std::strlen("\"hardware_concurrency\": "),
+          nullptr, 10));
+      continue;
+    }
+    size_t name = line.find("\"name\": \"");
+    size_t value = line.find("\"value\": ");
+    if (name == std::string::npos || value == std::string::npos) continue;
+    name += std::strlen("\"name\": \"");
+    std::string key = line.substr(name, line.find('"', name) - name);
+    baseline[key] = std::strtod(line.c_str() + value + 9, nullptr);
+  }
+  return baseline;
+}
+
+int compare(const std::string& path, double threshold) {
+  unsigned baseline_cores = 0;
+  auto baseline = read_baseline(path, baseline_cores);
+  if (baseline.empty()) {
+    std::printf("no metrics in baseline %s\n", path.c_str());
+    return 1;
+  }
+  if (baseline_cores != std::thread::hardware_concurrency()) {
+    std::printf("baseline recorded with %u cores, this machine has %u\n",
+                baseline_cores, std::thread::hardware_concurrency());
+  }
+
+  int regressions = 0;
+  std::printf("\n%-44s %12s %12s %8s\n", "metric", "baseline", "current",
+              "change");
+  for (const Metric& m : metrics) {
+    auto it = baseline.find(m.name);
+    if (it == baseline.end() || it->second == 0) {
+      std::printf("%-44s %12s %12.1f\n", m.name.c_str(), "none", m.value);
+      continue;
+    }
+
+    double change = (m.value - it->second) / it->second;
+    // Positive means worse
+    double loss = m.higher_is_better ? -change : change;
+    bool regressed = loss > threshold;
+    regressions += regressed;
+    std::printf("%-44s %12.1f %12.1f %+7.1f%%%s\n", m.name.c_str(),
+                it->second, m.value, change * 100,
+                regressed ? "  REGRESSION" : "");
+  }
+  std::printf("%d regression(s) beyond %.0f%%\n", regressions,
+              threshold * 100);
+  return regressions == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string json_path;
+  std::string baseline_path;
+  double threshold = 0.25;
+  int repetitions = 3;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--quick") {
+      quick = true;
+    } else if (arg == "--repetitions" && i + 1 < argc) {
+      repetitions = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--json" && i + 1 < argc) {
+      json_path = argv[++i];
+    } else if (arg == "--compare" && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (arg == "--threshold" && i + 1 < argc) {
+      threshold = std::atof(argv[++i]);
+    } else {
+      std::printf(
+          "usage: %s [--quick] [--repetitions N] [--json FILE] "
+          "[--compare BASELINE] [--threshold FRACTION]\n",
+          argv[0]);
+      return 2;
+    }
+  }
+
+  size_t workers = std::max(1U, std::thread::hardware_concurrency());
+  for (int rep = 0; rep < repetitions; rep++) {
+    {
+      stl::ThreadPool pool(workers);
+      bench_submit_latency(pool);
+      bench_end_to_end(pool);
+      bench_throughput(pool);
+      bench_fan_out(pool);
+      bench_recursive(pool);
+    }
+    bench_scaling();
+  }
+
+  for (const Metric& m : metrics) {
+    std::printf("%-44s %14.1f %s\n", m.name.c_str(), m.value, m.unit.c_str());
+  }
+
+  if (!json_path.empty()) write_json(json_path);
+  if (!baseline_path.empty()) return compare(baseline_path, threshold);
+  return 0;
+}
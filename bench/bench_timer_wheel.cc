@@ -0,0 +1,92 @@
+// Timer benchmark: 1M pending timers through the raw TimerWheel and through
+// ThreadPool::schedule_after. Build with -DCMAKE_BUILD_TYPE=Release.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "stl/thread_pool.h"
+#include "stl/timer_wheel.h"
+
+namespace {
+
+constexpr size_t kNumTimers = 1'000'000;
+// Expiries spread over ~16 minutes of 1ms ticks, so all four levels are used
+constexpr stl::TimerWheel::Tick kMaxDelay = 1'000'000;
+
+double elapsed_ns(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void bench_wheel() {
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<stl::TimerWheel::Tick> dist(1, kMaxDelay);
+  std::vector<stl::TimerWheel::Tick> expiries(kNumTimers);
+  for (auto& expiry : expiries) expiry = dist(rng);
+
+  stl::TimerWheel wheel;
+  std::vector<stl::TimerId> ids;
+  ids.reserve(kNumTimers);
+  size_t fired = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto expiry : expiries) {
+    ids.push_back(wheel.insert(expiry, [&fired]() { fired++; }));
+  }
+  double insert_ns = elapsed_ns(start);
+
+  // Cancel every other timer, typical of timeouts that mostly never fire
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ids.size(); i += 2) wheel.cancel(ids[i]);
+  double cancel_ns = elapsed_ns(start);
+
+  std::vector<stl::TimerWheel::Callback> expired;
+  expired.reserve(kNumTimers / 2);
+  start = std::chrono::steady_clock::now();
+  wheel.advance(kMaxDelay, expired);
+  double advance_ns = elapsed_ns(start);
+  for (auto& callback : expired) callback();
+
+  std::printf("wheel insert:  %8.1f ns/timer (%zu timers)\n",
+              insert_ns / kNumTimers, kNumTimers);
+  std::printf("wheel cancel:  %8.1f ns/timer\n", cancel_ns / (kNumTimers / 2));
+  std::printf("wheel advance: %8.1f ns/expiry over %llu ticks (%zu fired)\n",
+              advance_ns / static_cast<double>(fired),
+              static_cast<unsigned long long>(kMaxDelay), fired);
+}
+
+void bench_pool() {
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<int> dist(0, 2000);
+  std::atomic<size_t> fired = 0;
+
+  stl::ThreadPool pool(std::max(2U, std::thread::hardware_concurrency()));
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < kNumTimers; i++) {
+    pool.schedule_after(std::chrono::milliseconds(dist(rng)),
+                        [&fired]() { fired.fetch_add(1); });
+  }
+  double schedule_ns = elapsed_ns(start);
+
+  while (fired.load() < kNumTimers) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  double total_ms = elapsed_ns(start) / 1e6;
+
+  std::printf("pool schedule: %8.1f ns/timer\n", schedule_ns / kNumTimers);
+  std::printf("pool drained %zu timers spread over 2s in %.0f ms\n",
+              kNumTimers, total_ms);
+}
+
+}  // namespace
+
+int main() {
+  bench_wheel();
+  bench_pool();
+  return 0;
+}
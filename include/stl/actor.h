@@ -0,0 +1,141 @@
+/**
+ * @file actor.h
+ * @brief Implementation of actors with lock-free mailboxes on ThreadPool
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "stl/lock_free_queue.h"
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+// An object whose handler sees one message at a time, so state owned by the
+// handler needs no mutex. Messages wait in a small MPSC mailbox, a
+// LockFreeQueue packed without cache line padding so a million mostly idle
+// actors stay cheap; a full mailbox spills to a locked overflow list that
+// the handler takes over whole and frees once drained. The actor is handed
+// to the pool only when its mailbox goes from empty to non-empty, and after
+// `quota` messages it re-queues itself behind other work so a busy actor
+// cannot hog a worker. Messages from one sender are handled in the order
+// sent. Once the pool is shut down and refuses the actor, messages are still
+// handled: a run past its quota carries on on its worker, and a send() that
+// finds the actor idle runs the handler on the calling thread. Message must
+// be default constructible and movable, and the handler must not throw.
+template <typename Message,
+          typename Handler = std::function<void(Message)>,
+          size_t MailboxCapacity = 8>
+class Actor {
+ public:
+  static constexpr uint32_t kDefaultQuota = 64;
+
+  Actor(ThreadPool& pool, Handler handler, uint32_t quota = kDefaultQuota)
+      : pool_(pool), handler_(std::move(handler)), quota_(quota) {}
+
+  Actor(const Actor&) = delete;
+  Actor& operator=(const Actor&) = delete;
+
+  // Waits for queued messages, the pool must outlive the actor
+  ~Actor() {
+    while (pending_.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  // Safe from any thread, including the actor's own handler
+  void send(Message message) {
+    // Counted before the push so the handler never sees an uncounted
+    // message. Only the transition from idle schedules the actor
+    bool was_idle = pending_.fetch_add(1, std::memory_order_acq_rel) == 0;
+
+    // Once anything spilled, later messages follow it to keep their order
+    if (overflowed_.load(std::memory_order_acquire) != 0 ||
+        !mailbox_.try_push(std::move(message))) {
+      spill(std::move(message));
+    }
+
+    if (was_idle && !pool_.try_post_continuation([this]() { run(); })) run();
+  }
+
+  // Messages sent but not yet handled
+  [[nodiscard]] size_t pending() const noexcept {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using Mailbox =
+      LockFreeQueue<Message, MailboxCapacity, alignof(std::atomic<size_t>)>;
+
+  ThreadPool& pool_;
+  Handler handler_;
+  uint32_t quota_;
+  Mailbox mailbox_;
+  std::atomic<size_t> pending_ = 0;
+  // Messages in overflow_, guarded by overflow_mutex_
+  std::atomic<size_t> overflowed_ = 0;
+  std::unique_ptr<std::deque<Message>> overflow_;
+  std::mutex overflow_mutex_;
+  // Overflow taken over by the handler in one go, drained before the mailbox
+  std::unique_ptr<std::deque<Message>> spilled_;
+
+  void spill(Message&& message) {
+    std::scoped_lock lock(overflow_mutex_);
+    if (!overflow_) overflow_ = std::make_unique<std::deque<Message>>();
+    overflow_->push_back(std::move(message));
+    overflowed_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Single consumer. Returns false if the message counted in pending_ is
+  // still being pushed
+  bool pop(Message& message) {
+    if (spilled_) {
+      message = std::move(spilled_->front());
+      spilled_->pop_front();
+      if (spilled_->empty()) spilled_.reset();
+      return true;
+    }
+    if (mailbox_.try_pop(message)) return true;
+    if (overflowed_.load(std::memory_order_acquire) == 0) return false;
+
+    {
+      std::scoped_lock lock(overflow_mutex_);
+      // A sender's earlier message may still be landing in the mailbox
+      if (!mailbox_.empty() || overflow_ == nullptr) return false;
+      // Later messages go to the mailbox again, behind these
+      spilled_ = std::move(overflow_);
+      overflowed_.store(0, std::memory_order_release);
+    }
+    return pop(message);
+  }
+
+  void run() {
+    Message message;
+    for (uint32_t handled = 0;; handled++) {
+      if (handled == quota_) {
+        // Still non-empty, so nobody else will schedule us. A shut down
+        // pool leaves the rest to this run
+        if (pool_.try_post_continuation([this]() { run(); })) return;
+      }
+
+      while (!pop(message)) {
+        // pending_ counted a message whose sender has not pushed it yet
+        std::this_thread::yield();
+      }
+      handler_(std::move(message));
+
+      if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) return;
+    }
+  }
+};
+
+}  // namespace stl
@@ -0,0 +1,125 @@
+/**
+ * @file arena.h
+ * @brief Implementation of monotonic (bump pointer) arena allocator
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stl {
+
+// Bump pointer allocator for short-lived scratch memory. Allocation is a
+// pointer increment, individual frees do not exist and reset() releases
+// everything at once. When a block runs out a larger one is chained on;
+// reset() then merges them into a single block of the combined size, so a
+// steady workload settles on one block and never calls malloc again.
+// Not thread-safe: meant to be owned by one thread.
+class MonotonicArena {
+ public:
+  explicit MonotonicArena(size_t initial_size = 4096)
+      : next_block_size_(initial_size == 0 ? 1 : initial_size) {}
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  // `alignment` must be a power of 2
+  void* allocate(size_t bytes,
+                 size_t alignment = alignof(std::max_align_t)) {
+    if ((alignment & (alignment - 1)) != 0) {
+      throw std::invalid_argument("alignment must be power of 2");
+    }
+
+    if (!blocks_.empty()) {
+      if (void* p = bump(blocks_.back(), bytes, alignment)) return p;
+    }
+
+    add_block(bytes + alignment);
+    return bump(blocks_.back(), bytes, alignment);
+  }
+
+  // Objects are never destroyed, so only trivially destructible types
+  template <typename T, typename... Args>
+  T* create(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "MonotonicArena never runs destructors");
+    void* p = allocate(sizeof(T), alignof(T));
+    return new (p) T(std::forward<Args>(args)...);
+  }
+
+  // Uninitialized storage for n objects
+  template <typename T>
+  T* allocate_array(size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "MonotonicArena never runs destructors");
+    if (n > SIZE_MAX / sizeof(T)) throw std::bad_alloc();
+    return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+  }
+
+  // Invalidates every allocation, keeps the memory
+  void reset() noexcept {
+    if (used_ == 0) return;
+    if (blocks_.size() > 1) {
+      size_t total = capacity();
+      blocks_.clear();
+      next_block_size_ = total;
+      // On failure the next allocate() simply starts from scratch
+      try {
+        add_block(total);
+      } catch (const std::bad_alloc&) {
+      }
+    }
+    if (!blocks_.empty()) blocks_.back().offset = 0;
+    used_ = 0;
+  }
+
+  // Bytes handed out since the last reset, alignment padding included
+  [[nodiscard]] size_t bytes_used() const noexcept { return used_; }
+
+  [[nodiscard]] size_t capacity() const noexcept {
+    size_t total = 0;
+    for (const auto& block : blocks_) total += block.size;
+    return total;
+  }
+
+  [[nodiscard]] size_t num_blocks() const noexcept { return blocks_.size(); }
+
+ private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size = 0;
+    size_t offset = 0;
+  };
+
+  std::vector<Block> blocks_;
+  size_t next_block_size_;
+  size_t used_ = 0;
+
+  void* bump(Block& block, size_t bytes, size_t alignment) noexcept {
+    auto base = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t current = base + block.offset;
+    uintptr_t aligned = (current + alignment - 1) & ~(alignment - 1);
+    size_t padding = aligned - current;
+    if (padding + bytes > block.size - block.offset) return nullptr;
+
+    block.offset += padding + bytes;
+    used_ += padding + bytes;
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  void add_block(size_t min_size) {
+    size_t size = std::max(next_block_size_, min_size);
+    blocks_.push_back(Block{std::make_unique<std::byte[]>(size), size, 0});
+    next_block_size_ = size * 2;
+  }
+};
+
+}  // namespace stl
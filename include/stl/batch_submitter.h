@@ -0,0 +1,160 @@
+/**
+ * @file batch_submitter.h
+ * @brief Implementation of task coalescing submitter for ThreadPool
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+// Coalesces tiny fire-and-forget tasks into batches. Tasks are buffered and
+// handed to the pool as one queued task once batch_size of them have piled
+// up, or when max_delay has passed since the first one was buffered (rounded
+// up to the pool's 1 ms timer tick), or on flush(). Each shipped batch pays
+// the pool's lock, allocation and wake-up once instead of per task.
+// Tasks of one batch run in submission order on a single worker and must
+// not throw. Safe to use from several threads, though one submitter per
+// producing thread keeps its mutex uncontended.
+class BatchSubmitter {
+ public:
+  explicit BatchSubmitter(
+      ThreadPool& pool, size_t batch_size = 64,
+      std::chrono::microseconds max_delay = std::chrono::milliseconds(1))
+      : state_(std::make_shared<State>(pool, batch_size, max_delay)) {
+    if (batch_size == 0) {
+      throw std::invalid_argument("BatchSubmitter batch_size must be > 0");
+    }
+    state_->buffer.reserve(batch_size);
+  }
+
+  BatchSubmitter(const BatchSubmitter&) = delete;
+  BatchSubmitter& operator=(const BatchSubmitter&) = delete;
+
+  // Ships whatever is still buffered
+  ~BatchSubmitter() {
+    try {
+      flush();
+    } catch (const std::runtime_error&) {
+      // The pool shut down, the tasks could not run anyway
+    }
+  }
+
+  // Throws if a full batch has to be shipped and the pool refuses it
+  template <typename F>
+  void post(F&& f) {
+    std::vector<std::function<void()>> batch;
+    bool arm_timer = false;
+
+    {
+      std::scoped_lock lock(state_->mutex);
+      state_->buffer.emplace_back(std::forward<F>(f));
+      if (state_->buffer.size() >= state_->batch_size) {
+        batch = state_->take();
+      } else if (state_->buffer.size() == 1) {
+        arm_timer = true;
+      }
+    }
+
+    if (!batch.empty()) {
+      state_->ship(std::move(batch));
+    } else if (arm_timer) {
+      arm_deadline();
+    }
+  }
+
+  // Ships the buffered tasks now
+  void flush() {
+    std::vector<std::function<void()>> batch;
+    {
+      std::scoped_lock lock(state_->mutex);
+      batch = state_->take();
+    }
+    if (!batch.empty()) state_->ship(std::move(batch));
+  }
+
+  // Tasks waiting in the buffer
+  [[nodiscard]] size_t buffered() const {
+    std::scoped_lock lock(state_->mutex);
+    return state_->buffer.size();
+  }
+
+  [[nodiscard]] size_t batch_size() const noexcept {
+    return state_->batch_size;
+  }
+
+ private:
+  // Shared with pending deadline timers, which may fire after the
+  // submitter is gone
+  struct State {
+    State(ThreadPool& p, size_t size, std::chrono::microseconds delay)
+        : pool(p), batch_size(size), max_delay(delay) {}
+
+    ThreadPool& pool;
+    const size_t batch_size;
+    const std::chrono::microseconds max_delay;
+    mutable std::mutex mutex;
+    std::vector<std::function<void()>> buffer;
+    // Bumped whenever the buffer is taken, so a timer armed for an
+    // earlier batch leaves the current one alone
+    uint64_t generation = 0;
+    std::optional<TimerId> timer;
+
+    // Called with mutex held
+    std::vector<std::function<void()>> take() {
+      std::vector<std::function<void()>> batch;
+      if (buffer.empty()) return batch;
+
+      batch.reserve(batch_size);
+      batch.swap(buffer);
+      generation++;
+      if (timer) {
+        pool.cancel_timer(*timer);
+        timer.reset();
+      }
+      return batch;
+    }
+
+    void ship(std::vector<std::function<void()>>&& batch) {
+      pool.post([batch = std::move(batch)]() mutable {
+        for (auto& task : batch) task();
+      });
+    }
+  };
+
+  std::shared_ptr<State> state_;
+
+  void arm_deadline() {
+    std::scoped_lock lock(state_->mutex);
+    // Shipped or already armed while the lock was released
+    if (state_->buffer.empty() || state_->timer) return;
+
+    state_->timer = state_->pool.schedule_after(
+        state_->max_delay,
+        [state = state_, generation = state_->generation]() {
+          std::vector<std::function<void()>> batch;
+          {
+            std::scoped_lock lock(state->mutex);
+            if (state->generation != generation) return;
+            state->timer.reset();
+            batch = state->take();
+          }
+          // Already on a worker: run the batch here rather than requeue it
+          for (auto& task : batch) task();
+        });
+  }
+};
+
+}  // namespace stl
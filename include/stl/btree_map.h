@@ -0,0 +1,955 @@
+/**
+ * @file btree_map.h
+ * @brief Implementation of cache-conscious ordered map as a B+ tree
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "stl/relocate.h"
+#include "stl/simd.h"
+#include "stl/vector.h"
+
+namespace stl {
+
+namespace detail {
+
+// Keys the node search may compare as plain integers, many per instruction
+template <typename K, typename Compare>
+inline constexpr bool kSimdSearchable =
+    std::is_integral_v<K> && !std::is_same_v<K, bool> &&
+    (sizeof(K) == 4 || sizeof(K) == 8) &&
+    (std::is_same_v<Compare, std::less<K>> ||
+     std::is_same_v<Compare, std::less<>>);
+
+// Number of keys[0, n) below key, or with OrEqual not above it. Sorted keys
+// make that the lower or upper bound, found with no branch per key
+template <bool OrEqual, typename K>
+size_t count_below_scalar(const K* keys, size_t n, K key) noexcept {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += OrEqual ? keys[i] <= key : keys[i] < key;
+  }
+  return total;
+}
+
+#if defined(STL_SIMD_X86)
+
+// Compares a vector of keys at a time. Reads whole vectors past n, which
+// the node's key storage is padded and aligned for, and masks those lanes
+template <bool OrEqual, typename K>
+__attribute__((target("avx2,popcnt"))) size_t count_below_avx2(
+    const K* keys, size_t n, K key) noexcept {
+  constexpr size_t kLanes = 32 / sizeof(K);
+  constexpr unsigned kAll = (1u << kLanes) - 1;
+  // Unsigned keys compare as signed once their top bits are flipped
+  __m256i bias = _mm256_setzero_si256();
+  if constexpr (std::is_unsigned_v<K>) {
+    if constexpr (sizeof(K) == 8) {
+      bias = _mm256_set1_epi64x(INT64_MIN);
+    } else {
+      bias = _mm256_set1_epi32(INT32_MIN);
+    }
+  }
+  __m256i needle;
+  if constexpr (sizeof(K) == 8) {
+    needle = _mm256_set1_epi64x(static_cast<int64_t>(key));
+  } else {
+    needle = _mm256_set1_epi32(static_cast<int32_t>(key));
+  }
+  needle = _mm256_xor_si256(needle, bias);
+
+  size_t total = 0;
+  for (size_t i = 0; i < n; i += kLanes) {
+    __m256i v = _mm256_xor_si256(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i)), bias);
+    unsigned mask;
+    if constexpr (sizeof(K) == 8) {
+      __m256i cmp = OrEqual ? _mm256_cmpgt_epi64(v, needle)
+                            : _mm256_cmpgt_epi64(needle, v);
+      mask = _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+    } else {
+      __m256i cmp = OrEqual ? _mm256_cmpgt_epi32(v, needle)
+                            : _mm256_cmpgt_epi32(needle, v);
+      mask = _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+    }
+    // With OrEqual the compare found the keys above
+    if constexpr (OrEqual) mask = ~mask & kAll;
+    if (n - i < kLanes) mask &= (1u << (n - i)) - 1;
+    total += std::popcount(mask);
+  }
+  return total;
+}
+
+#endif
+
+template <bool OrEqual, typename K>
+size_t count_below(const K* keys, size_t n, K key) noexcept {
+#if defined(STL_SIMD_X86)
+  if (simd_level() == SimdLevel::kAvx2) {
+    return count_below_avx2<OrEqual>(keys, n, key);
+  }
+#endif
+  return count_below_scalar<OrEqual>(keys, n, key);
+}
+
+}  // namespace detail
+
+// Ordered map as a B+ tree: entries live in the leaves, which are linked
+// for range scans, and inner nodes hold only separator keys and children.
+// Nodes are a few cache lines each, so a lookup costs one short run of
+// adjacent lines per level, over a tree far shallower than a red-black
+// tree's, rather than a miss per key compared. Integer keys under
+// std::less are searched within a node with vector compares. Keys must
+// be copyable, as separators are copies. Inserts and erases invalidate
+// iterators
+template <typename K, typename V, typename Compare = std::less<K>>
+class BTreeMap {
+  template <bool Const>
+  class Iterator;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using size_type = size_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // Rough size of a node: eight cache lines
+  static constexpr size_t kNodeBytes = 512;
+  static constexpr size_t kLeafSlots = std::clamp<size_t>(
+      (kNodeBytes - 32) / (sizeof(K) + sizeof(V)), 4, UINT16_MAX);
+  static constexpr size_t kInnerSlots = std::clamp<size_t>(
+      (kNodeBytes - 16) / (sizeof(K) + sizeof(void*)), 4, UINT16_MAX - 1);
+
+  explicit BTreeMap(Compare compare = Compare())
+      : compare_(std::move(compare)) {}
+
+  // Builds the map from entries sorted by key with no duplicates in O(n),
+  // with leaves packed full, rather than by n inserts. Throws
+  // std::invalid_argument if entries are out of order
+  static BTreeMap from_sorted(Vector<std::pair<K, V>> entries,
+                              Compare compare = Compare()) {
+    BTreeMap map(std::move(compare));
+    for (size_t i = 1; i < entries.size(); i++) {
+      if (!map.compare_(entries[i - 1].first, entries[i].first)) {
+        throw std::invalid_argument("BTreeMap::from_sorted");
+      }
+    }
+    size_t next = 0;
+    map.build(entries.size(), [&](K* key, V* value) {
+      construct_entry(key, value, std::move(entries[next].first),
+                      std::move(entries[next].second));
+      next++;
+    });
+    return map;
+  }
+
+  BTreeMap(const BTreeMap& other) : compare_(other.compare_) {
+    const Leaf* leaf = other.first_;
+    size_t index = 0;
+    build(other.size_, [&](K* key, V* value) {
+      while (index == leaf->count) {
+        leaf = leaf->next;
+        index = 0;
+      }
+      construct_entry(key, value, leaf->keys.data()[index],
+                      leaf->values.data()[index]);
+      index++;
+    });
+  }
+
+  BTreeMap& operator=(const BTreeMap& other) {
+    if (this != &other) {
+      BTreeMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  BTreeMap(BTreeMap&& other) noexcept : compare_(other.compare_) {
+    swap(other);
+  }
+
+  BTreeMap& operator=(BTreeMap&& other) noexcept {
+    if (this != &other) {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~BTreeMap() noexcept { clear(); }
+
+  void swap(BTreeMap& other) noexcept {
+    std::swap(root_, other.root_);
+    std::swap(first_, other.first_);
+    std::swap(last_, other.last_);
+    std::swap(size_, other.size_);
+    std::swap(height_, other.height_);
+    std::swap(compare_, other.compare_);
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  // Levels from the root to the leaves
+  [[nodiscard]] size_t height() const noexcept { return height_; }
+
+  iterator begin() noexcept { return iterator(first_, 0); }
+  iterator end() noexcept { return iterator(last_, last_count()); }
+  const_iterator begin() const noexcept { return const_iterator(first_, 0); }
+  const_iterator end() const noexcept {
+    return const_iterator(last_, last_count());
+  }
+
+  iterator find(const K& key) {
+    auto [leaf, index] = locate(key);
+    return index == kNotFound ? end() : iterator(leaf, index);
+  }
+
+  const_iterator find(const K& key) const {
+    auto [leaf, index] = locate(key);
+    return index == kNotFound ? end() : const_iterator(leaf, index);
+  }
+
+  [[nodiscard]] bool contains(const K& key) const {
+    return locate(key).second != kNotFound;
+  }
+
+  [[nodiscard]] size_t count(const K& key) const { return contains(key); }
+
+  V& at(const K& key) {
+    auto [leaf, index] = locate(key);
+    if (index == kNotFound) throw std::out_of_range("BTreeMap::at");
+    return leaf->values.data()[index];
+  }
+
+  const V& at(const K& key) const {
+    return const_cast<BTreeMap*>(this)->at(key);
+  }
+
+  V& operator[](const K& key) {
+    auto [leaf, index] = emplace_unique(key).first;
+    return leaf->values.data()[index];
+  }
+
+  V& operator[](K&& key) {
+    auto [leaf, index] = emplace_unique(std::move(key)).first;
+    return leaf->values.data()[index];
+  }
+
+  // Constructs the value from args only if key is not present
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+    return to_iterator(emplace_unique(key, std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    return to_iterator(
+        emplace_unique(std::move(key), std::forward<Args>(args)...));
+  }
+
+  std::pair<iterator, bool> insert(const std::pair<K, V>& entry) {
+    return try_emplace(entry.first, entry.second);
+  }
+
+  std::pair<iterator, bool> insert(std::pair<K, V>&& entry) {
+    return try_emplace(std::move(entry.first), std::move(entry.second));
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const K& key, M&& value) {
+    auto [position, inserted] = emplace_unique(key, std::forward<M>(value));
+    if (!inserted) {
+      position.first->values.data()[position.second] = std::forward<M>(value);
+    }
+    return to_iterator({position, inserted});
+  }
+
+  // First entry whose key is not below key
+  iterator lower_bound(const K& key) {
+    auto [leaf, index] = bound<false>(key);
+    return iterator(leaf, index);
+  }
+
+  const_iterator lower_bound(const K& key) const {
+    auto [leaf, index] = bound<false>(key);
+    return const_iterator(leaf, index);
+  }
+
+  // First entry whose key is above key
+  iterator upper_bound(const K& key) {
+    auto [leaf, index] = bound<true>(key);
+    return iterator(leaf, index);
+  }
+
+  const_iterator upper_bound(const K& key) const {
+    auto [leaf, index] = bound<true>(key);
+    return const_iterator(leaf, index);
+  }
+
+  // Entries with keys in [low, high), for range-for
+  template <bool Const>
+  struct Range {
+    Iterator<Const> first;
+    Iterator<Const> last;
+    Iterator<Const> begin() const noexcept { return first; }
+    Iterator<Const> end() const noexcept { return last; }
+  };
+
+  Range<false> range(const K& low, const K& high) {
+    return {lower_bound(low), lower_bound(high)};
+  }
+
+  Range<true> range(const K& low, const K& high) const {
+    return {lower_bound(low), lower_bound(high)};
+  }
+
+  // Returns the number of entries removed, 0 or 1
+  size_t erase(const K& key) {
+    if (root_ == nullptr) return 0;
+    Path path;
+    Leaf* leaf = descend(key, path);
+    size_t pos = lower_index(leaf->keys.data(), leaf->count, key);
+    if (pos == leaf->count || compare_(key, leaf->keys.data()[pos])) {
+      return 0;
+    }
+    K* keys = leaf->keys.data();
+    V* values = leaf->values.data();
+    keys[pos].~K();
+    values[pos].~V();
+    relocate(keys + pos + 1, leaf->count - pos - 1, keys + pos);
+    relocate(values + pos + 1, leaf->count - pos - 1, values + pos);
+    leaf->count--;
+    size_--;
+    rebalance_leaf(leaf, path);
+    return 1;
+  }
+
+  void clear() noexcept {
+    if (root_ != nullptr) destroy(root_, 1);
+    root_ = nullptr;
+    first_ = last_ = nullptr;
+    size_ = 0;
+    height_ = 0;
+  }
+
+ private:
+  static constexpr bool kSimdSearch = detail::kSimdSearchable<K, Compare>;
+  // Vector loads read a whole 32-byte vector, so SIMD-searched key storage
+  // is aligned to one and padded to a multiple of one
+  static constexpr size_t kKeyAlign = kSimdSearch ? 32 : alignof(K);
+  static constexpr size_t kKeyPad = kSimdSearch ? 32 / sizeof(K) : 1;
+  static constexpr size_t kLeafMin = kLeafSlots / 2;
+  static constexpr size_t kInnerMin = kInnerSlots / 2;
+  // Far more levels than any tree that fits in memory
+  static constexpr size_t kMaxHeight = 64;
+  static constexpr size_t kNotFound = SIZE_MAX;
+
+  // Raw storage for N objects, constructed and destroyed by the node
+  template <typename T, size_t N, size_t Align>
+  struct Slots {
+    alignas(Align) unsigned char bytes[sizeof(T) * N];
+    T* data() noexcept { return reinterpret_cast<T*>(bytes); }
+    const T* data() const noexcept {
+      return reinterpret_cast<const T*>(bytes);
+    }
+  };
+
+  template <size_t N>
+  using KeySlots = Slots<K, (N + kKeyPad - 1) / kKeyPad * kKeyPad, kKeyAlign>;
+
+  struct Node {
+    // Entries in a leaf, separator keys in an inner node
+    uint16_t count = 0;
+  };
+
+  struct Leaf : Node {
+    Leaf* prev = nullptr;
+    Leaf* next = nullptr;
+    KeySlots<kLeafSlots> keys;
+    Slots<V, kLeafSlots, alignof(V)> values;
+  };
+
+  // children[i] holds the keys from keys[i - 1] up to but not including
+  // keys[i]
+  struct Inner : Node {
+    KeySlots<kInnerSlots> keys;
+    Node* children[kInnerSlots + 1];
+  };
+
+  // Inner nodes from the root down to a leaf, with the child taken
+  struct PathEntry {
+    Inner* node;
+    size_t index;
+  };
+  using Path = std::array<PathEntry, kMaxHeight>;
+
+  Node* root_ = nullptr;
+  Leaf* first_ = nullptr;
+  Leaf* last_ = nullptr;
+  size_t size_ = 0;
+  size_t height_ = 0;
+  [[no_unique_address]] Compare compare_;
+
+  size_t last_count() const noexcept {
+    return last_ == nullptr ? 0 : last_->count;
+  }
+
+  template <typename KeyArg, typename... Args>
+  static void construct_entry(K* key, V* value, KeyArg&& key_arg,
+                              Args&&... args) {
+    new (key) K(std::forward<KeyArg>(key_arg));
+    try {
+      new (value) V(std::forward<Args>(args)...);
+    } catch (...) {
+      key->~K();
+      throw;
+    }
+  }
+
+  // Keys in a node below key: where key goes in a leaf
+  size_t lower_index(const K* keys, size_t n, const K& key) const {
+    if constexpr (kSimdSearch) {
+      return detail::count_below<false>(keys, n, key);
+    } else {
+      return std::lower_bound(keys, keys + n, key, compare_) - keys;
+    }
+  }
+
+  // Keys in a node not above key: the child of an inner node key is under
+  size_t upper_index(const K* keys, size_t n, const K& key) const {
+    if constexpr (kSimdSearch) {
+      return detail::count_below<true>(keys, n, key);
+    } else {
+      return std::upper_bound(keys, keys + n, key, compare_) - keys;
+    }
+  }
+
+  Leaf* find_leaf(const K& key) const {
+    Node* node = root_;
+    for (size_t level = 1; level < height_; level++) {
+      auto* inner = static_cast<Inner*>(node);
+      node = inner->children[upper_index(inner->keys.data(), inner->count,
+                                         key)];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  // As find_leaf(), recording the way down for a split or merge
+  Leaf* descend(const K& key, Path& path) const {
+    Node* node = root_;
+    for (size_t level = 0; level + 1 < height_; level++) {
+      auto* inner = static_cast<Inner*>(node);
+      size_t index = upper_index(inner->keys.data(), inner->count, key);
+      path[level] = {inner, index};
+      node = inner->children[index];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  std::pair<Leaf*, size_t> locate(const K& key) const {
+    if (root_ == nullptr) return {nullptr, kNotFound};
+    Leaf* leaf = find_leaf(key);
+    size_t index = lower_index(leaf->keys.data(), leaf->count, key);
+    if (index == leaf->count || compare_(key, leaf->keys.data()[index])) {
+      return {leaf, kNotFound};
+    }
+    return {leaf, index};
+  }
+
+  // Position of the lower or, with Upper, upper bound, moved on to the
+  // next leaf if it falls past the end of one
+  template <bool Upper>
+  std::pair<Leaf*, size_t> bound(const K& key) const {
+    if (root_ == nullptr) return {nullptr, 0};
+    Leaf* leaf = find_leaf(key);
+    const K* keys = leaf->keys.data();
+    size_t index = Upper ? upper_index(keys, leaf->count, key)
+                         : lower_index(keys, leaf->count, key);
+    if (index == leaf->count && leaf->next != nullptr) {
+      return {leaf->next, 0};
+    }
+    return {leaf, index};
+  }
+
+  std::pair<iterator, bool> to_iterator(
+      std::pair<std::pair<Leaf*, size_t>, bool> result) noexcept {
+    return {iterator(result.first.first, result.first.second),
+            result.second};
+  }
+
+  // Nodes a split needs, allocated before the tree is touched, so that
+  // running out of memory leaves it as it was
+  struct SplitReserve {
+    Leaf* leaf = nullptr;
+    std::array<Inner*, kMaxHeight> inners;
+    size_t inner_count = 0;
+
+    SplitReserve() = default;
+    SplitReserve(const SplitReserve&) = delete;
+    SplitReserve& operator=(const SplitReserve&) = delete;
+
+    ~SplitReserve() noexcept {
+      delete leaf;
+      for (size_t i = 0; i < inner_count; i++) delete inners[i];
+    }
+
+    Inner* take_inner() noexcept { return inners[--inner_count]; }
+  };
+
+  template <typename KeyArg, typename... Args>
+  std::pair<std::pair<Leaf*, size_t>, bool> emplace_unique(
+      KeyArg&& key, Args&&... args) {
+    if (root_ == nullptr) {
+      auto* leaf = new Leaf;
+      root_ = first_ = last_ = leaf;
+      height_ = 1;
+    }
+    Path path;
+    Leaf* leaf = descend(key, path);
+    size_t pos = lower_index(leaf->keys.data(), leaf->count, key);
+    if (pos < leaf->count && !compare_(key, leaf->keys.data()[pos])) {
+      return {{leaf, pos}, false};
+    }
+    if (leaf->count == kLeafSlots) {
+      std::tie(leaf, pos) = split_leaf(leaf, pos, key, path);
+    }
+
+    K* keys = leaf->keys.data();
+    V* values = leaf->values.data();
+    relocate(keys + pos, leaf->count - pos, keys + pos + 1);
+    relocate(values + pos, leaf->count - pos, values + pos + 1);
+    try {
+      construct_entry(keys + pos, values + pos, std::forward<KeyArg>(key),
+                      std::forward<Args>(args)...);
+    } catch (...) {
+      relocate(keys + pos + 1, leaf->count - pos, keys + pos);
+      relocate(values + pos + 1, leaf->count - pos, values + pos);
+      throw;
+    }
+    leaf->count++;
+    size_++;
+    return {{leaf, pos}, true};
+  }
+
+  // Splits a full leaf that key goes in at pos, returning the leaf and
+  // position it now goes to
+  std::pair<Leaf*, size_t> split_leaf(Leaf* leaf, size_t pos, const K& key,
+                                      Path& path) {
+    SplitReserve reserve;
+    size_t full = 0;
+    while (full + 1 < height_ &&
+           path[height_ - 2 - full].node->count == kInnerSlots) {
+      full++;
+    }
+    for (size_t i = 0; i < full + (full + 1 == height_); i++) {
+      reserve.inners[reserve.inner_count] = new Inner;
+      reserve.inner_count++;
+    }
+    reserve.leaf = new Leaf;
+    // Appending past the last key, as loading in order does, starts a new
+    // leaf and leaves the full one be, so such loads pack leaves full
+    bool append = pos == kLeafSlots && leaf->next == nullptr;
+    K separator = append ? key : leaf->keys.data()[kLeafSlots / 2];
+
+    Leaf* right = std::exchange(reserve.leaf, nullptr);
+    size_t mid = append ? kLeafSlots : kLeafSlots / 2;
+    relocate(leaf->keys.data() + mid, kLeafSlots - mid, right->keys.data());
+    relocate(leaf->values.data() + mid, kLeafSlots - mid,
+             right->values.data());
+    right->count = static_cast<uint16_t>(kLeafSlots - mid);
+    leaf->count = static_cast<uint16_t>(mid);
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next != nullptr) {
+      leaf->next->prev = right;
+    } else {
+      last_ = right;
+    }
+    leaf->next = right;
+
+    insert_child(path, height_ - 1, std::move(separator), right, reserve);
+    if (pos <= mid && !append) return {leaf, pos};
+    return {right, pos - mid};
+  }
+
+  // Adds separator and, after it, right to the parent of the node at
+  // depth, which has just been split into itself and right. Full parents
+  // split in turn, up to a new root
+  void insert_child(Path& path, size_t depth, K separator, Node* right,
+                    SplitReserve& reserve) {
+    while (depth > 0) {
+      auto [parent, index] = path[depth - 1];
+      if (parent->count < kInnerSlots) {
+        insert_into_inner(parent, index, std::move(separator), right);
+        return;
+      }
+      // As with leaves, a child appended at the end leaves the node full
+      size_t n = kInnerSlots;
+      size_t mid = index == n ? n - 1 : n / 2;
+      Inner* sibling = reserve.take_inner();
+      K* keys = parent->keys.data();
+      K promoted = std::move(keys[mid]);
+      keys[mid].~K();
+      relocate(keys + mid + 1, n - mid - 1, sibling->keys.data());
+      std::memcpy(sibling->children, parent->children + mid + 1,
+                  sizeof(Node*) * (n - mid));
+      sibling->count = static_cast<uint16_t>(n - mid - 1);
+      parent->count = static_cast<uint16_t>(mid);
+      if (index <= mid) {
+        insert_into_inner(parent, index, std::move(separator), right);
+      } else {
+        insert_into_inner(sibling, index - mid - 1, std::move(separator),
+                          right);
+      }
+      separator = std::move(promoted);
+      right = sibling;
+      depth--;
+    }
+    Inner* root = reserve.take_inner();
+    new (root->keys.data()) K(std::move(separator));
+    root->children[0] = root_;
+    root->children[1] = right;
+    root->count = 1;
+    root_ = root;
+    height_++;
+  }
+
+  static void insert_into_inner(Inner* node, size_t index, K&& separator,
+                                Node* right) noexcept {
+    K* keys = node->keys.data();
+    relocate(keys + index, node->count - index, keys + index + 1);
+    new (keys + index) K(std::move(separator));
+    std::memmove(node->children + index + 2, node->children + index + 1,
+                 sizeof(Node*) * (node->count - index));
+    node->children[index + 1] = right;
+    node->count++;
+  }
+
+  // Drops keys[index] and the child after it
+  static void remove_child(Inner* node, size_t index) noexcept {
+    K* keys = node->keys.data();
+    keys[index].~K();
+    relocate(keys + index + 1, node->count - index - 1, keys + index);
+    std::memmove(node->children + index + 1, node->children + index + 2,
+                 sizeof(Node*) * (node->count - index - 1));
+    node->count--;
+  }
+
+  // Tops up a leaf left under half full from a sibling that can spare an
+  // entry, else merges it with one
+  void rebalance_leaf(Leaf* leaf, Path& path) {
+    if (height_ == 1) {
+      if (leaf->count == 0) clear();
+      return;
+    }
+    if (leaf->count >= kLeafMin) return;
+    auto [parent, index] = path[height_ - 2];
+    auto* left = index > 0 ? static_cast<Leaf*>(parent->children[index - 1])
+                           : nullptr;
+    auto* right = index < parent->count
+                      ? static_cast<Leaf*>(parent->children[index + 1])
+                      : nullptr;
+    K* keys = leaf->keys.data();
+    V* values = leaf->values.data();
+    if (left != nullptr && left->count > kLeafMin) {
+      relocate(keys, leaf->count, keys + 1);
+      relocate(values, leaf->count, values + 1);
+      relocate(left->keys.data() + left->count - 1, 1, keys);
+      relocate(left->values.data() + left->count - 1, 1, values);
+      left->count--;
+      leaf->count++;
+      parent->keys.data()[index - 1] = keys[0];
+    } else if (right != nullptr && right->count > kLeafMin) {
+      relocate(right->keys.data(), 1, keys + leaf->count);
+      relocate(right->values.data(), 1, values + leaf->count);
+      relocate(right->keys.data() + 1, right->count - 1, right->keys.data());
+      relocate(right->values.data() + 1, right->count - 1,
+               right->values.data());
+      right->count--;
+      leaf->count++;
+      parent->keys.data()[index] = right->keys.data()[0];
+    } else {
+      if (left != nullptr) {
+        merge_leaves(left, leaf);
+        remove_child(parent, index - 1);
+      } else {
+        merge_leaves(leaf, right);
+        remove_child(parent, index);
+      }
+      rebalance_inner(height_ - 2, path);
+    }
+  }
+
+  void merge_leaves(Leaf* left, Leaf* right) noexcept {
+    relocate(right->keys.data(), right->count,
+             left->keys.data() + left->count);
+    relocate(right->values.data(), right->count,
+             left->values.data() + left->count);
+    left->count += right->count;
+    left->next = right->next;
+    if (right->next != nullptr) {
+      right->next->prev = left;
+    } else {
+      last_ = left;
+    }
+    delete right;
+  }
+
+  // As rebalance_leaf(), for the inner node at depth, rotating keys
+  // through the parent, and on up while merges leave parents short
+  void rebalance_inner(size_t depth, Path& path) {
+    for (;; depth--) {
+      Inner* node = path[depth].node;
+      if (depth == 0) {
+        if (node->count == 0) {
+          root_ = node->children[0];
+          delete node;
+          height_--;
+        }
+        return;
+      }
+      if (node->count >= kInnerMin) return;
+      auto [parent, index] = path[depth - 1];
+      auto* left = index > 0
+                       ? static_cast<Inner*>(parent->children[index - 1])
+                       : nullptr;
+      auto* right = index < parent->count
+                        ? static_cast<Inner*>(parent->children[index + 1])
+                        : nullptr;
+      K* keys = node->keys.data();
+      if (left != nullptr && left->count > kInnerMin) {
+        K* left_keys = left->keys.data();
+        K& separator = parent->keys.data()[index - 1];
+        relocate(keys, node->count, keys + 1);
+        std::memmove(node->children + 1, node->children,
+                     sizeof(Node*) * (node->count + 1));
+        new (keys) K(std::move(separator));
+        node->children[0] = left->children[left->count];
+        separator = std::move(left_keys[left->count - 1]);
+        left_keys[left->count - 1].~K();
+        left->count--;
+        node->count++;
+        return;
+      }
+      if (right != nullptr && right->count > kInnerMin) {
+        K* right_keys = right->keys.data();
+        K& separator = parent->keys.data()[index];
+        new (keys + node->count) K(std::move(separator));
+        node->children[node->count + 1] = right->children[0];
+        separator = std::move(right_keys[0]);
+        right_keys[0].~K();
+        relocate(right_keys + 1, right->count - 1, right_keys);
+        std::memmove(right->children, right->children + 1,
+                     sizeof(Node*) * right->count);
+        right->count--;
+        node->count++;
+        return;
+      }
+      if (left != nullptr) {
+        merge_inner(left, parent, index - 1, node);
+      } else {
+        merge_inner(node, parent, index, right);
+      }
+    }
+  }
+
+  // Pulls the separator between left and right down into left, then the
+  // whole of right after it
+  static void merge_inner(Inner* left, Inner* parent, size_t index,
+                          Inner* right) noexcept {
+    K* keys = left->keys.data();
+    new (keys + left->count) K(std::move(parent->keys.data()[index]));
+    relocate(right->keys.data(), right->count, keys + left->count + 1);
+    std::memcpy(left->children + left->count + 1, right->children,
+                sizeof(Node*) * (right->count + 1));
+    left->count += right->count + 1;
+    delete right;
+    remove_child(parent, index);
+  }
+
+  void destroy(Node* node, size_t level) noexcept {
+    if (level == height_) {
+      auto* leaf = static_cast<Leaf*>(node);
+      std::destroy_n(leaf->keys.data(), leaf->count);
+      std::destroy_n(leaf->values.data(), leaf->count);
+      delete leaf;
+      return;
+    }
+    auto* inner = static_cast<Inner*>(node);
+    for (size_t i = 0; i <= inner->count; i++) {
+      destroy(inner->children[i], level + 1);
+    }
+    std::destroy_n(inner->keys.data(), inner->count);
+    delete inner;
+  }
+
+  // Bottom-up build from n entries in order, which emit(key, value)
+  // constructs one at a time: leaves evenly packed, then each level of
+  // inner nodes over the one below, separated by each child's lowest key
+  template <typename Emit>
+  void build(size_t n, Emit&& emit) {
+    if (n == 0) return;
+    Vector<Inner*> inners;
+    try {
+      size_t leaves = (n + kLeafSlots - 1) / kLeafSlots;
+      Vector<Node*> level(leaves);
+      Vector<const K*> lows(leaves);
+      height_ = 1;
+      for (size_t i = 0; i < leaves; i++) {
+        auto* leaf = new Leaf;
+        leaf->prev = last_;
+        if (last_ != nullptr) {
+          last_->next = leaf;
+        } else {
+          first_ = leaf;
+        }
+        last_ = leaf;
+        size_t take = n / leaves + (i < n % leaves);
+        for (size_t j = 0; j < take; j++) {
+          emit(leaf->keys.data() + j, leaf->values.data() + j);
+          leaf->count++;
+          size_++;
+        }
+        level.push_back(leaf);
+        lows.push_back(leaf->keys.data());
+      }
+
+      while (level.size() > 1) {
+        size_t parents = (level.size() + kInnerSlots) / (kInnerSlots + 1);
+        Vector<Node*> next_level(parents);
+        Vector<const K*> next_lows(parents);
+        size_t child = 0;
+        for (size_t i = 0; i < parents; i++) {
+          inners.push_back(nullptr);
+          auto* inner = new Inner;
+          inners[inners.size() - 1] = inner;
+          size_t take =
+              level.size() / parents + (i < level.size() % parents);
+          inner->children[0] = level[child];
+          for (size_t j = 1; j < take; j++) {
+            new (inner->keys.data() + j - 1) K(*lows[child + j]);
+            inner->children[j] = level[child + j];
+            inner->count++;
+          }
+          next_level.push_back(inner);
+          next_lows.push_back(lows[child]);
+          child += take;
+        }
+        level = std::move(next_level);
+        lows = std::move(next_lows);
+        height_++;
+      }
+      root_ = level[0];
+    } catch (...) {
+      for (Leaf* leaf = first_; leaf != nullptr;) {
+        std::destroy_n(leaf->keys.data(), leaf->count);
+        std::destroy_n(leaf->values.data(), leaf->count);
+        delete std::exchange(leaf, leaf->next);
+      }
+      for (size_t i = 0; i < inners.size(); i++) {
+        if (inners[i] == nullptr) continue;
+        std::destroy_n(inners[i]->keys.data(), inners[i]->count);
+        delete inners[i];
+      }
+      root_ = nullptr;
+      first_ = last_ = nullptr;
+      size_ = 0;
+      height_ = 0;
+      throw;
+    }
+  }
+
+  // A leaf and a position in it. Dereferencing yields a pair of
+  // references, as keys and values sit in separate arrays so that node
+  // searches read only keys
+  template <bool Const>
+  class Iterator {
+    using LeafPtr = std::conditional_t<Const, const Leaf*, Leaf*>;
+    using Value = std::conditional_t<Const, const V, V>;
+
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::pair<const K, V>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<const K&, Value&>;
+
+    // For it->first and it->second
+    struct pointer {
+      reference ref;
+      reference* operator->() noexcept { return &ref; }
+    };
+
+    Iterator() noexcept = default;
+    Iterator(LeafPtr leaf, size_t index) noexcept
+        : leaf_(leaf), index_(index) {}
+
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    Iterator(const Iterator<false>& other) noexcept
+        : leaf_(other.leaf_), index_(other.index_) {}
+
+    const K& key() const noexcept { return leaf_->keys.data()[index_]; }
+    Value& value() const noexcept { return leaf_->values.data()[index_]; }
+
+    reference operator*() const noexcept { return {key(), value()}; }
+    pointer operator->() const noexcept { return {**this}; }
+
+    Iterator& operator++() noexcept {
+      if (++index_ == leaf_->count && leaf_->next != nullptr) {
+        leaf_ = leaf_->next;
+        index_ = 0;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      Iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    Iterator& operator--() noexcept {
+      if (index_ == 0) {
+        leaf_ = leaf_->prev;
+        index_ = leaf_->count;
+      }
+      index_--;
+      return *this;
+    }
+
+    Iterator operator--(int) noexcept {
+      Iterator copy = *this;
+      --*this;
+      return copy;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+      return lhs.leaf_ == rhs.leaf_ && lhs.index_ == rhs.index_;
+    }
+
+   private:
+    friend class BTreeMap;
+    friend class Iterator<!Const>;
+    LeafPtr leaf_ = nullptr;
+    size_t index_ = 0;
+  };
+};
+
+}  // namespace stl
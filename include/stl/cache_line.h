@@ -0,0 +1,11 @@
+/**
+ * @file cache_line.h
+ * @brief Cache line size shared by the concurrent containers
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+// Align independently written hot data to this to avoid false sharing
+constexpr uint kCacheLineSize = 64;
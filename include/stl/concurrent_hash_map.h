@@ -0,0 +1,407 @@
+/**
+ * @file concurrent_hash_map.h
+ * @brief Implementation of sharded hash map with optimistic (seqlock) reads
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stl/cache_line.h"
+#include "stl/hash.h"
+#include "stl/hash_map.h"
+
+namespace stl {
+
+namespace detail {
+
+// Only asked once T is known to be trivially copyable, as std::atomic<T>
+// needs that
+template <typename T>
+struct IsLockFreeAtomic
+    : std::bool_constant<std::atomic<T>::is_always_lock_free> {};
+
+}  // namespace detail
+
+// Hash map for many threads at once, split into independently locked
+// shards so writers to different shards never contend and a shard grows
+// without stopping the others. With trivially copyable keys and values whose
+// atomics are lock-free, lookups take no lock at all: each shard keeps a
+// sequence number that writers make odd while they change it, and a reader
+// retries if the number moved while it probed. Their tables keep every field
+// in relaxed atomics, and a table outgrown by doubling is retired rather than
+// freed, since a reader may still be probing it. Each retired table is at
+// most half the next, so together they take less memory than the live one;
+// they are freed with the map. Clearing tombstones rehashes the table in
+// place instead, so insert and erase churn never retires anything. Other
+// types fall back to a reader-writer lock around a HashMap per shard.
+// Lookups return copies, because a reference could be invalidated by a
+// concurrent writer.
+template <typename K, typename V, typename Hash = stl::Hash<K>,
+          typename Eq = std::equal_to<K>>
+class ConcurrentHashMap {
+ public:
+  static constexpr bool kOptimisticReads = std::conjunction_v<
+      std::is_trivially_copyable<K>, std::is_trivially_copyable<V>,
+      std::is_default_constructible<K>, std::is_default_constructible<V>,
+      detail::IsLockFreeAtomic<K>, detail::IsLockFreeAtomic<V>>;
+
+  static constexpr size_t kDefaultShards = 64;
+
+  // The shard count is rounded up to a power of two, at most 65536
+  explicit ConcurrentHashMap(size_t num_shards = kDefaultShards)
+      : shard_bits_(std::bit_width(std::bit_ceil(std::max<size_t>(
+                        num_shards, 1))) -
+                    1),
+        shards_(size_t{1} << shard_bits_) {
+    if (shard_bits_ > 16) {
+      throw std::invalid_argument("ConcurrentHashMap: too many shards");
+    }
+  }
+
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  [[nodiscard]] std::optional<V> find(const K& key) const {
+    size_t hash = hash_of(key);
+    const Shard& shard = shard_for(hash);
+
+    if constexpr (kOptimisticReads) {
+      for (;;) {
+        uint64_t seq = shard.seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+          // A writer is mid-change
+          std::this_thread::yield();
+          continue;
+        }
+
+        const Table* table = shard.table.load(std::memory_order_acquire);
+        std::optional<size_t> index = table->locate(key, hash, eq_);
+        std::optional<V> value;
+        if (index) {
+          value = table->slots[*index].value.load(std::memory_order_relaxed);
+        }
+
+        // Orders the probe before the re-check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (shard.seq.load(std::memory_order_relaxed) == seq) return value;
+      }
+    } else {
+      std::shared_lock lock(shard.mutex);
+      auto it = shard.map.find(key);
+      if (it == shard.map.end()) return std::nullopt;
+      return it->second;
+    }
+  }
+
+  [[nodiscard]] bool contains(const K& key) const {
+    return find(key).has_value();
+  }
+
+  // Inserts only if the key is absent, returns whether it did
+  bool insert(const K& key, const V& value) {
+    size_t hash = hash_of(key);
+    Shard& shard = shard_for(hash);
+    std::unique_lock lock(shard.mutex);
+    return insert_locked(shard, key, hash, value, false);
+  }
+
+  // Returns true if the key was inserted, false if its value was replaced
+  bool insert_or_assign(const K& key, const V& value) {
+    size_t hash = hash_of(key);
+    Shard& shard = shard_for(hash);
+    std::unique_lock lock(shard.mutex);
+    return insert_locked(shard, key, hash, value, true);
+  }
+
+  // Returns the key's value, first inserting make() if the key is absent.
+  // make() runs at most once per key, under the shard's lock, so it must
+  // not use this map
+  template <typename F>
+  V compute_if_absent(const K& key, F&& make) {
+    if (std::optional<V> existing = find(key)) return *existing;
+
+    size_t hash = hash_of(key);
+    Shard& shard = shard_for(hash);
+    std::unique_lock lock(shard.mutex);
+    if constexpr (kOptimisticReads) {
+      Table* table = shard.table.load(std::memory_order_relaxed);
+      if (auto index = table->locate(key, hash, eq_)) {
+        return table->slots[*index].value.load(std::memory_order_relaxed);
+      }
+    } else {
+      auto it = shard.map.find(key);
+      if (it != shard.map.end()) return it->second;
+    }
+
+    V value = std::forward<F>(make)();
+    insert_locked(shard, key, hash, value, false);
+    return value;
+  }
+
+  bool erase(const K& key) {
+    size_t hash = hash_of(key);
+    Shard& shard = shard_for(hash);
+    std::unique_lock lock(shard.mutex);
+
+    if constexpr (kOptimisticReads) {
+      Table* table = shard.table.load(std::memory_order_relaxed);
+      std::optional<size_t> index = table->locate(key, hash, eq_);
+      if (!index) return false;
+
+      begin_write(shard);
+      table->slots[*index].ctrl.store(kDeleted, std::memory_order_relaxed);
+      end_write(shard);
+    } else {
+      if (shard.map.erase(key) == 0) return false;
+    }
+    shard.size.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Sum over the shards, exact only while no writer runs
+  [[nodiscard]] size_t size() const noexcept {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+      total += shard.size.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] size_t num_shards() const noexcept { return shards_.size(); }
+
+ private:
+  static constexpr uint8_t kEmpty = 0;
+  static constexpr uint8_t kDeleted = 1;
+  static constexpr size_t kInitialCapacity = 16;
+
+  // Open addressing with linear probing and 7-bit fingerprints, every field
+  // an atomic so readers can probe while a writer holds the shard
+  struct Table {
+    struct Slot {
+      // kEmpty, kDeleted or 0x80 | fingerprint
+      std::atomic<uint8_t> ctrl = kEmpty;
+      std::atomic<K> key;
+      std::atomic<V> value;
+    };
+
+    explicit Table(size_t capacity)
+        : capacity(capacity), slots(std::make_unique<Slot[]>(capacity)) {}
+
+    // Bounded by the capacity, so a torn read cannot probe forever
+    std::optional<size_t> locate(const K& key, size_t hash,
+                                 const Eq& eq) const {
+      uint8_t tag = full_tag(hash);
+      size_t mask = capacity - 1;
+      size_t index = (hash >> 7) & mask;
+      for (size_t probes = 0; probes < capacity; probes++) {
+        uint8_t ctrl = slots[index].ctrl.load(std::memory_order_relaxed);
+        if (ctrl == kEmpty) return std::nullopt;
+        if (ctrl == tag &&
+            eq(slots[index].key.load(std::memory_order_relaxed), key)) {
+          return index;
+        }
+        index = (index + 1) & mask;
+      }
+      return std::nullopt;
+    }
+
+    // Writer only, the key must be absent
+    size_t free_slot(size_t hash) const {
+      size_t mask = capacity - 1;
+      size_t index = (hash >> 7) & mask;
+      while (slots[index].ctrl.load(std::memory_order_relaxed) >= 0x80) {
+        index = (index + 1) & mask;
+      }
+      return index;
+    }
+
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    // Full slots plus tombstones, writer only
+    size_t used = 0;
+  };
+
+  struct OptimisticShard {
+    OptimisticShard()
+        : owned(std::make_unique<Table>(kInitialCapacity)),
+          table(owned.get()) {}
+
+    // Odd while a writer changes the table
+    std::atomic<uint64_t> seq = 0;
+    std::mutex mutex;
+    // Live table, then the ones outgrown by doubling
+    std::unique_ptr<Table> owned;
+    std::vector<std::unique_ptr<Table>> retired;
+    std::atomic<Table*> table;
+    std::atomic<size_t> size = 0;
+  };
+
+  struct LockedShard {
+    mutable std::shared_mutex mutex;
+    HashMap<K, V, Hash, Eq> map;
+    std::atomic<size_t> size = 0;
+  };
+
+  // Each shard on its own cache lines
+  struct alignas(kCacheLineSize) Shard
+      : std::conditional_t<kOptimisticReads, OptimisticShard, LockedShard> {
+  };
+
+  size_t shard_bits_;
+  std::vector<Shard> shards_;
+  [[no_unique_address]] Hash hash_;
+  [[no_unique_address]] Eq eq_;
+
+  static uint8_t full_tag(size_t hash) noexcept {
+    return static_cast<uint8_t>(0x80 | (hash & 0x7f));
+  }
+
+  size_t hash_of(const K& key) const noexcept {
+    if constexpr (AvalanchingHash<Hash>) {
+      return hash_(key);
+    } else {
+      return mix_hash(static_cast<uint64_t>(hash_(key)));
+    }
+  }
+
+  // The top bits pick the shard, the low ones the slot within it
+  Shard& shard_for(size_t hash) noexcept {
+    return shards_[shard_bits_ == 0 ? 0 : hash >> (64 - shard_bits_)];
+  }
+
+  const Shard& shard_for(size_t hash) const noexcept {
+    return shards_[shard_bits_ == 0 ? 0 : hash >> (64 - shard_bits_)];
+  }
+
+  static void begin_write(OptimisticShard& shard) noexcept {
+    shard.seq.store(shard.seq.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  static void end_write(OptimisticShard& shard) noexcept {
+    shard.seq.store(shard.seq.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+  }
+
+  // Called with the shard's lock held exclusively
+  bool insert_locked(Shard& shard, const K& key, size_t hash, const V& value,
+                     bool assign) {
+    if constexpr (kOptimisticReads) {
+      Table* table = shard.table.load(std::memory_order_relaxed);
+      if (auto index = table->locate(key, hash, eq_)) {
+        if (assign) {
+          begin_write(shard);
+          table->slots[*index].value.store(value, std::memory_order_relaxed);
+          end_write(shard);
+        }
+        return false;
+      }
+
+      // At most 3/4 of the slots full or tombstones
+      if ((table->used + 1) * 4 > table->capacity * 3) {
+        table = grow(shard, *table);
+      }
+
+      size_t index = table->free_slot(hash);
+      auto& slot = table->slots[index];
+      if (slot.ctrl.load(std::memory_order_relaxed) == kEmpty) table->used++;
+      begin_write(shard);
+      slot.key.store(key, std::memory_order_relaxed);
+      slot.value.store(value, std::memory_order_relaxed);
+      slot.ctrl.store(full_tag(hash), std::memory_order_relaxed);
+      end_write(shard);
+    } else {
+      auto [it, inserted] = shard.map.try_emplace(key, value);
+      if (!inserted) {
+        if (assign) it->second = value;
+        return false;
+      }
+    }
+    shard.size.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Copies the live entries into a fresh table twice the size and
+  // publishes it. Readers still on the old table see it unchanged until they
+  // notice the sequence moved. When tombstones were most of the load, the
+  // table is rehashed in place instead
+  Table* grow(OptimisticShard& shard, Table& old) {
+    size_t live = shard.size.load(std::memory_order_relaxed);
+    if ((live + 1) * 2 <= old.capacity) {
+      rehash_in_place(shard, old);
+      return &old;
+    }
+    auto fresh = std::make_unique<Table>(old.capacity * 2);
+
+    for (size_t i = 0; i < old.capacity; i++) {
+      const auto& slot = old.slots[i];
+      uint8_t ctrl = slot.ctrl.load(std::memory_order_relaxed);
+      if (ctrl < 0x80) continue;
+
+      K key = slot.key.load(std::memory_order_relaxed);
+      size_t index = fresh->free_slot(hash_of(key));
+      fresh->slots[index].key.store(key, std::memory_order_relaxed);
+      fresh->slots[index].value.store(
+          slot.value.load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      fresh->slots[index].ctrl.store(ctrl, std::memory_order_relaxed);
+      fresh->used++;
+    }
+
+    Table* published = fresh.get();
+    begin_write(shard);
+    shard.table.store(published, std::memory_order_release);
+    end_write(shard);
+    shard.retired.push_back(std::move(shard.owned));
+    shard.owned = std::move(fresh);
+    return published;
+  }
+
+  // Drops the tombstones. Readers wait out the odd sequence or retry, so
+  // whatever they probe mid-rehash is discarded
+  void rehash_in_place(OptimisticShard& shard, Table& table) {
+    std::vector<std::pair<K, V>> entries;
+    entries.reserve(shard.size.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < table.capacity; i++) {
+      const auto& slot = table.slots[i];
+      if (slot.ctrl.load(std::memory_order_relaxed) < 0x80) continue;
+      entries.emplace_back(slot.key.load(std::memory_order_relaxed),
+                           slot.value.load(std::memory_order_relaxed));
+    }
+
+    begin_write(shard);
+    for (size_t i = 0; i < table.capacity; i++) {
+      table.slots[i].ctrl.store(kEmpty, std::memory_order_relaxed);
+    }
+    table.used = 0;
+    for (const auto& [key, value] : entries) {
+      size_t hash = hash_of(key);
+      auto& slot = table.slots[table.free_slot(hash)];
+      slot.key.store(key, std::memory_order_relaxed);
+      slot.value.store(value, std::memory_order_relaxed);
+      slot.ctrl.store(full_tag(hash), std::memory_order_relaxed);
+      table.used++;
+    }
+    end_write(shard);
+  }
+};
+
+}  // namespace stl
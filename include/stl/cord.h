@@ -0,0 +1,730 @@
+/**
+ * @file cord.h
+ * @brief Implementation of a rope string of shared, reference-counted chunks
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "stl/string.h"
+#include "stl/vector.h"
+
+namespace stl {
+
+namespace detail {
+
+enum class CordKind : uint8_t { kFlat, kSubstring, kConcat };
+
+struct CordNode {
+  CordNode(CordKind kind, size_t length, uint8_t depth) noexcept
+      : kind(kind), depth(depth), length(length) {}
+
+  std::atomic<uint32_t> refs = 1;
+  CordKind kind;
+  // Concats above the deepest leaf
+  uint8_t depth;
+  size_t length;
+};
+
+// Chars follow the header in the same allocation
+struct CordFlat : CordNode {
+  explicit CordFlat(size_t capacity) noexcept
+      : CordNode(CordKind::kFlat, 0, 0), capacity(capacity) {}
+
+  char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+  const char* data() const noexcept {
+    return reinterpret_cast<const char*>(this + 1);
+  }
+
+  size_t capacity;
+};
+
+// A window into a flat, which it keeps alive
+struct CordSubstring : CordNode {
+  CordSubstring(CordFlat* flat, size_t offset, size_t length) noexcept
+      : CordNode(CordKind::kSubstring, length, 0),
+        flat(flat),
+        offset(offset) {}
+
+  CordFlat* flat;
+  size_t offset;
+};
+
+struct CordConcat : CordNode {
+  CordConcat(CordNode* left, CordNode* right) noexcept
+      : CordNode(CordKind::kConcat, 0, 0), left(left), right(right) {
+    update();
+  }
+
+  void update() noexcept {
+    length = left->length + right->length;
+    depth = static_cast<uint8_t>(std::max(left->depth, right->depth) + 1);
+  }
+
+  CordNode* left;
+  CordNode* right;
+};
+
+}  // namespace detail
+
+// Byte string held as a binary tree of immutable, reference-counted chunks,
+// for large buffers built by appending. Copying a Cord, taking a substring
+// and appending one Cord to another share chunks rather than copying chars.
+// Leaves are flat chunks, or windows into one; inner nodes concatenate two
+// subtrees. A node is only changed in place while this Cord is its sole
+// owner all the way from the root, which is how small appends fill the
+// last chunk before starting a new one. Appends and prepends join the new
+// chunk as an AVL tree would, by depth: it descends the facing spine to a
+// subtree at most one level deeper, and at most one rotation on the way back
+// keeps sibling depths within one, so each costs O(log n) in the chunk
+// count. A tree deeper than kMaxDepth anyway, as substrings of lopsided
+// trees can be, is rebuilt balanced. Separate copies may be used from
+// different threads
+class Cord {
+  using Node = detail::CordNode;
+  using Flat = detail::CordFlat;
+  using Substring = detail::CordSubstring;
+  using Concat = detail::CordConcat;
+  using Kind = detail::CordKind;
+
+ public:
+  // Appends fill chunks of up to this many chars, so each is one 4 KB
+  // allocation. A single larger append gets a chunk of its own size
+  static constexpr size_t kMaxFlat = 4096 - sizeof(Flat);
+  static constexpr size_t kMinFlat = 64 - sizeof(Flat);
+  static constexpr size_t kMaxDepth = 48;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  Cord() noexcept = default;
+
+  explicit Cord(std::string_view text)
+      : root_(text.empty() ? nullptr : make_flat(text, text.size())) {}
+
+  Cord(const Cord& other) noexcept
+      : root_(other.root_ != nullptr ? ref(other.root_) : nullptr) {}
+
+  Cord(Cord&& other) noexcept : root_(std::exchange(other.root_, nullptr)) {}
+
+  Cord& operator=(const Cord& other) noexcept {
+    Cord(other).swap(*this);
+    return *this;
+  }
+
+  Cord& operator=(Cord&& other) noexcept {
+    Cord(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~Cord() noexcept {
+    if (root_ != nullptr) unref(root_);
+  }
+
+  void swap(Cord& other) noexcept { std::swap(root_, other.root_); }
+
+  [[nodiscard]] size_t size() const noexcept {
+    return root_ != nullptr ? root_->length : 0;
+  }
+  [[nodiscard]] bool empty() const noexcept { return root_ == nullptr; }
+
+  // Height of the tree, 0 for a single chunk
+  [[nodiscard]] size_t depth() const noexcept {
+    return root_ != nullptr ? root_->depth : 0;
+  }
+
+  void clear() noexcept { Cord().swap(*this); }
+
+  Cord& append(std::string_view text) {
+    if (text.empty()) return *this;
+    size_t in_tail = std::min(tail_spare(), text.size());
+    if (in_tail == text.size()) {
+      fill_tail(text);
+      return *this;
+    }
+
+    std::string_view rest = text.substr(in_tail);
+    Node* flat = make_flat(rest, std::max(rest.size(), growth()));
+    if (root_ == nullptr) {
+      root_ = flat;
+      return *this;
+    }
+    attach_back(flat);
+    // The chars that fit the old tail are copied only once nothing more
+    // can fail, so a failed append leaves the cord unchanged
+    if (in_tail != 0) fill_tail_before_last(text.substr(0, in_tail));
+    return *this;
+  }
+
+  // Small cords are copied into the last chunk, larger ones shared
+  Cord& append(const Cord& other) {
+    if (other.empty()) return *this;
+    if (other.size() <= kMaxCopy) {
+      char buffer[kMaxCopy];
+      other.copy_to(buffer);
+      return append(std::string_view(buffer, other.size()));
+    }
+    if (root_ == nullptr) {
+      root_ = ref(other.root_);
+      return *this;
+    }
+    attach_back(ref(other.root_));
+    return *this;
+  }
+
+  // Each prepend of chars gets its own chunk, as chunks only grow at the
+  // back
+  Cord& prepend(std::string_view text) {
+    if (text.empty()) return *this;
+    Node* flat = make_flat(text, text.size());
+    if (root_ == nullptr) {
+      root_ = flat;
+      return *this;
+    }
+    attach_front(flat);
+    return *this;
+  }
+
+  Cord& prepend(const Cord& other) {
+    if (other.empty()) return *this;
+    if (root_ == nullptr) {
+      root_ = ref(other.root_);
+      return *this;
+    }
+    attach_front(ref(other.root_));
+    return *this;
+  }
+
+  // Shares the chunks of [pos, pos + count) in O(depth)
+  [[nodiscard]] Cord substr(size_t pos, size_t count = npos) const {
+    if (pos > size()) throw std::out_of_range("Cord::substr");
+    count = std::min(count, size() - pos);
+    Cord result;
+    if (count != 0) result.root_ = sub_node(root_, pos, count);
+    return result;
+  }
+
+  [[nodiscard]] char operator[](size_t index) const noexcept {
+    const Node* node = root_;
+    while (node->kind == Kind::kConcat) {
+      auto* concat = static_cast<const Concat*>(node);
+      if (index < concat->left->length) {
+        node = concat->left;
+      } else {
+        index -= concat->left->length;
+        node = concat->right;
+      }
+    }
+    return leaf_view(node)[index];
+  }
+
+  [[nodiscard]] char at(size_t index) const {
+    if (index >= size()) throw std::out_of_range("Cord::at");
+    return (*this)[index];
+  }
+
+  // The chunks in order, as views that stay valid while this Cord is
+  // unchanged, e.g. for writev()
+  class ChunkIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = const std::string_view&;
+
+    ChunkIterator() = default;
+
+    reference operator*() const noexcept { return chunk_; }
+    pointer operator->() const noexcept { return &chunk_; }
+
+    ChunkIterator& operator++() noexcept {
+      offset_ += chunk_.size();
+      load();
+      return *this;
+    }
+
+    ChunkIterator operator++(int) noexcept {
+      ChunkIterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const ChunkIterator& lhs,
+                           const ChunkIterator& rhs) noexcept {
+      return lhs.offset_ == rhs.offset_;
+    }
+
+   private:
+    friend class Cord;
+
+    ChunkIterator(const Node* root, size_t offset) noexcept
+        : root_(root), offset_(offset) {
+      load();
+    }
+
+    // Each step finds the next chunk from the root, so iterating holds no
+    // stack and costs O(depth) per chunk
+    void load() noexcept {
+      if (root_ == nullptr || offset_ >= root_->length) {
+        chunk_ = {};
+        return;
+      }
+      const Node* node = root_;
+      size_t offset = offset_;
+      while (node->kind == Kind::kConcat) {
+        auto* concat = static_cast<const Concat*>(node);
+        if (offset < concat->left->length) {
+          node = concat->left;
+        } else {
+          offset -= concat->left->length;
+          node = concat->right;
+        }
+      }
+      chunk_ = leaf_view(node);
+    }
+
+    const Node* root_ = nullptr;
+    size_t offset_ = 0;
+    std::string_view chunk_;
+  };
+
+  class ChunkRange {
+   public:
+    [[nodiscard]] ChunkIterator begin() const noexcept {
+      return ChunkIterator(root_, 0);
+    }
+    [[nodiscard]] ChunkIterator end() const noexcept {
+      return ChunkIterator(root_, root_ != nullptr ? root_->length : 0);
+    }
+
+   private:
+    friend class Cord;
+    explicit ChunkRange(const Node* root) noexcept : root_(root) {}
+    const Node* root_;
+  };
+
+  [[nodiscard]] ChunkRange chunks() const noexcept {
+    return ChunkRange(root_);
+  }
+
+  [[nodiscard]] size_t chunk_count() const noexcept {
+    return root_ != nullptr ? count_leaves(root_) : 0;
+  }
+
+  // Copies all size() chars to out
+  void copy_to(char* out) const noexcept {
+    for (std::string_view chunk : chunks()) {
+      std::memcpy(out, chunk.data(), chunk.size());
+      out += chunk.size();
+    }
+  }
+
+  // Replaces the tree with a single chunk, unless it already is one, and
+  // returns a view of all the chars
+  std::string_view flatten() {
+    if (root_ == nullptr) return {};
+    if (root_->kind != Kind::kConcat) return leaf_view(root_);
+    Flat* flat = new_flat(size());
+    copy_to(flat->data());
+    flat->length = size();
+    unref(root_);
+    root_ = flat;
+    return {flat->data(), flat->length};
+  }
+
+  [[nodiscard]] String to_string() const {
+    String result;
+    result.resize_for_overwrite(size());
+    copy_to(result.data());
+    return result;
+  }
+
+  friend bool operator==(const Cord& lhs, std::string_view rhs) noexcept {
+    if (lhs.size() != rhs.size()) return false;
+    for (std::string_view chunk : lhs.chunks()) {
+      if (std::memcmp(chunk.data(), rhs.data(), chunk.size()) != 0) {
+        return false;
+      }
+      rhs.remove_prefix(chunk.size());
+    }
+    return true;
+  }
+
+  // Walks both chunk sequences, whose boundaries need not line up
+  friend bool operator==(const Cord& lhs, const Cord& rhs) noexcept {
+    if (lhs.size() != rhs.size()) return false;
+    if (lhs.root_ == rhs.root_) return true;
+    ChunkRange right_chunks = rhs.chunks();
+    ChunkIterator it = right_chunks.begin();
+    std::string_view pending = *it;
+    for (std::string_view chunk : lhs.chunks()) {
+      while (!chunk.empty()) {
+        if (pending.empty()) pending = *++it;
+        size_t n = std::min(chunk.size(), pending.size());
+        if (std::memcmp(chunk.data(), pending.data(), n) != 0) return false;
+        chunk.remove_prefix(n);
+        pending.remove_prefix(n);
+      }
+    }
+    return true;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const Cord& cord) {
+    for (std::string_view chunk : cord.chunks()) os << chunk;
+    return os;
+  }
+
+ private:
+  static constexpr size_t kMaxCopy = 512;
+
+  Node* root_ = nullptr;
+
+  // Concat nodes allocated before a tree is modified, so that running out
+  // of memory leaves it untouched. Unused blocks are freed
+  class ConcatPool {
+   public:
+    explicit ConcatPool(size_t count) {
+      try {
+        for (size_t i = 0; i < count; i++) {
+          void* block = ::operator new(sizeof(Concat));
+          *static_cast<void**>(block) = head_;
+          head_ = block;
+        }
+      } catch (...) {
+        release();
+        throw;
+      }
+    }
+
+    ConcatPool(const ConcatPool&) = delete;
+    ConcatPool& operator=(const ConcatPool&) = delete;
+
+    ~ConcatPool() noexcept { release(); }
+
+    Node* make(Node* left, Node* right) noexcept {
+      void* block = head_;
+      head_ = *static_cast<void**>(block);
+      return new (block) Concat(left, right);
+    }
+
+   private:
+    void* head_ = nullptr;
+
+    void release() noexcept {
+      while (head_ != nullptr) {
+        void* next = *static_cast<void**>(head_);
+        ::operator delete(head_);
+        head_ = next;
+      }
+    }
+  };
+
+  static Node* ref(Node* node) noexcept {
+    node->refs.fetch_add(1, std::memory_order_relaxed);
+    return node;
+  }
+
+  static void unref(Node* node) noexcept {
+    if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    switch (node->kind) {
+      case Kind::kFlat:
+        static_cast<Flat*>(node)->~Flat();
+        ::operator delete(node);
+        return;
+      case Kind::kSubstring:
+        unref(static_cast<Substring*>(node)->flat);
+        delete static_cast<Substring*>(node);
+        return;
+      case Kind::kConcat:
+        unref(static_cast<Concat*>(node)->left);
+        unref(static_cast<Concat*>(node)->right);
+        delete static_cast<Concat*>(node);
+        return;
+    }
+  }
+
+  static bool unique(const Node* node) noexcept {
+    return node->refs.load(std::memory_order_acquire) == 1;
+  }
+
+  static Flat* new_flat(size_t capacity) {
+    return new (::operator new(sizeof(Flat) + capacity)) Flat(capacity);
+  }
+
+  static Node* make_flat(std::string_view text, size_t capacity) {
+    Flat* flat = new_flat(capacity);
+    std::memcpy(flat->data(), text.data(), text.size());
+    flat->length = text.size();
+    return flat;
+  }
+
+  static std::string_view leaf_view(const Node* node) noexcept {
+    if (node->kind == Kind::kFlat) {
+      auto* flat = static_cast<const Flat*>(node);
+      return {flat->data(), flat->length};
+    }
+    auto* sub = static_cast<const Substring*>(node);
+    return {sub->flat->data() + sub->offset, sub->length};
+  }
+
+  static size_t count_leaves(const Node* node) noexcept {
+    if (node->kind != Kind::kConcat) return 1;
+    auto* concat = static_cast<const Concat*>(node);
+    return count_leaves(concat->left) + count_leaves(concat->right);
+  }
+
+  // New chunks double with the cord up to kMaxFlat
+  size_t growth() const noexcept {
+    return std::clamp(size(), kMinFlat, kMaxFlat);
+  }
+
+  // Room left in the last chunk, if this Cord owns the whole path to it
+  size_t tail_spare() const noexcept {
+    const Node* node = root_;
+    if (node == nullptr) return 0;
+    while (unique(node) && node->kind == Kind::kConcat) {
+      node = static_cast<const Concat*>(node)->right;
+    }
+    if (!unique(node) || node->kind != Kind::kFlat) return 0;
+    auto* flat = static_cast<const Flat*>(node);
+    return flat->capacity - flat->length;
+  }
+
+  // text fits in tail_spare()
+  void fill_tail(std::string_view text) noexcept {
+    Node* node = root_;
+    while (node->kind == Kind::kConcat) {
+      node->length += text.size();
+      node = static_cast<Concat*>(node)->right;
+    }
+    auto* flat = static_cast<Flat*>(node);
+    std::memcpy(flat->data() + flat->length, text.data(), text.size());
+    flat->length += text.size();
+  }
+
+  // As fill_tail(), for the leaf just before the one attach_back() added,
+  // which is the rightmost leaf of the right spine's last left turn
+  void fill_tail_before_last(std::string_view text) noexcept {
+    Node* node = root_;
+    Node* last_left = nullptr;
+    while (node->kind == Kind::kConcat) {
+      auto* concat = static_cast<Concat*>(node);
+      node->length += text.size();
+      last_left = concat;
+      node = concat->right;
+    }
+    node = static_cast<Concat*>(last_left)->left;
+    while (node->kind == Kind::kConcat) {
+      node->length += text.size();
+      node = static_cast<Concat*>(node)->right;
+    }
+    auto* flat = static_cast<Flat*>(node);
+    std::memcpy(flat->data() + flat->length, text.data(), text.size());
+    flat->length += text.size();
+  }
+
+  // Concats join() takes from the pool: one for each node on the descent
+  // this Cord does not own alone, plus the new ones at the bottom
+  static size_t concats_to_join(const Node* left,
+                                const Node* right) noexcept {
+    if (left->depth > right->depth + 1) {
+      return concats_to_join_near(left, right->depth, true);
+    }
+    if (right->depth > left->depth + 1) {
+      return concats_to_join_near(right, left->depth, false);
+    }
+    return 1;
+  }
+
+  static size_t concats_to_join_near(const Node* node, size_t depth,
+                                     bool back) noexcept {
+    size_t count = 0;
+    bool owned = true;
+    for (;;) {
+      auto* concat = static_cast<const Concat*>(node);
+      const Node* near = back ? concat->right : concat->left;
+      const Node* far = back ? concat->left : concat->right;
+      owned = owned && unique(node);
+      if (!owned) count++;
+      if (near->depth <= depth + 1) {
+        if (std::max<size_t>(near->depth, depth) <= far->depth) {
+          return count + 1;
+        }
+        // near is split, and copied unless owned
+        return count + (owned && unique(near) ? 1 : 2);
+      }
+      node = near;
+    }
+  }
+
+  // Concatenates left and right, taking a reference to each
+  static Node* join(Node* left, Node* right, ConcatPool& pool) noexcept {
+    if (left->depth > right->depth + 1) {
+      return join_near(left, right, true, pool);
+    }
+    if (right->depth > left->depth + 1) {
+      return join_near(right, left, false, pool);
+    }
+    return pool.make(left, right);
+  }
+
+  // node is at least two levels deeper than add, which goes on its right
+  // when back, else on its left
+  static Node* join_near(Node* node, Node* add, bool back,
+                         ConcatPool& pool) noexcept {
+    auto [far, near, reuse] = open(node, back);
+    if (near->depth > add->depth + 1) {
+      Node* joined = join_near(near, add, back, pool);
+      if (joined->depth <= far->depth + 1) {
+        return link(reuse, far, joined, back, pool);
+      }
+      // Rotates toward far: joined's far child moves under node
+      auto* top = static_cast<Concat*>(joined);
+      Node*& inner = back ? top->left : top->right;
+      inner = link(reuse, far, inner, back, pool);
+      top->update();
+      return top;
+    }
+    if (std::max(near->depth, add->depth) <= far->depth) {
+      return link(reuse, far, link(nullptr, near, add, back, pool), back,
+                  pool);
+    }
+    // near is a level deeper than both far and add, so its children go one
+    // to each side
+    auto [near_far, near_near, near_reuse] = open(near, back);
+    Node* outer = link(reuse, far, near_far, back, pool);
+    Node* inner = link(near_reuse, near_near, add, back, pool);
+    return link(nullptr, outer, inner, back, pool);
+  }
+
+  struct Opened {
+    Node* far;
+    Node* near;
+    // The concat itself, free to reuse, if this Cord held it alone
+    Concat* reuse;
+  };
+
+  // Takes a concat apart, keeping a reference to each child
+  static Opened open(Node* node, bool back) noexcept {
+    auto* concat = static_cast<Concat*>(node);
+    Node* near = back ? concat->right : concat->left;
+    Node* far = back ? concat->left : concat->right;
+    if (unique(node)) return {far, near, concat};
+    ref(far);
+    ref(near);
+    unref(node);
+    return {far, near, nullptr};
+  }
+
+  // A concat of far and near, ordered by the side being joined
+  static Node* link(Concat* reuse, Node* far, Node* near, bool back,
+                    ConcatPool& pool) noexcept {
+    Node* left = back ? far : near;
+    Node* right = back ? near : far;
+    if (reuse == nullptr) return pool.make(left, right);
+    reuse->left = left;
+    reuse->right = right;
+    reuse->update();
+    return reuse;
+  }
+
+  // Takes ownership of add, including when allocation fails, in which
+  // case the tree is unchanged
+  void attach_back(Node* add) { attach_node(add, true); }
+  void attach_front(Node* add) { attach_node(add, false); }
+
+  void attach_node(Node* add, bool back) {
+    Node* left = back ? root_ : add;
+    Node* right = back ? add : root_;
+    try {
+      ConcatPool pool(concats_to_join(left, right));
+      root_ = join(left, right, pool);
+    } catch (...) {
+      unref(add);
+      throw;
+    }
+    // A deeper tree is still a valid one, so an append that got this far
+    // does not fail for want of memory to rebalance
+    if (root_->depth > kMaxDepth) {
+      try {
+        rebalance();
+      } catch (const std::bad_alloc&) {
+      }
+    }
+  }
+
+  static void collect_leaves(Node* node, Vector<Node*>& leaves) {
+    while (node->kind == Kind::kConcat) {
+      collect_leaves(static_cast<Concat*>(node)->left, leaves);
+      node = static_cast<Concat*>(node)->right;
+    }
+    leaves.push_back(node);
+  }
+
+  static Node* build_balanced(Node** leaves, size_t count,
+                              ConcatPool& pool) noexcept {
+    if (count == 1) return ref(leaves[0]);
+    size_t half = count / 2;
+    Node* left = build_balanced(leaves, half, pool);
+    return pool.make(left, build_balanced(leaves + half, count - half, pool));
+  }
+
+  // Rebuilds the tree with the same leaves and minimal depth. Leaves the
+  // tree as it was if allocation fails
+  void rebalance() {
+    Vector<Node*> leaves(count_leaves(root_));
+    collect_leaves(root_, leaves);
+    ConcatPool pool(leaves.size() - 1);
+    Node* balanced = build_balanced(&leaves[0], leaves.size(), pool);
+    unref(root_);
+    root_ = balanced;
+  }
+
+  static Node* sub_node(Node* node, size_t pos, size_t count) {
+    if (pos == 0 && count == node->length) return ref(node);
+    switch (node->kind) {
+      case Kind::kFlat: {
+        auto* flat = static_cast<Flat*>(node);
+        auto* sub = new Substring(flat, pos, count);
+        ref(flat);
+        return sub;
+      }
+      case Kind::kSubstring: {
+        auto* outer = static_cast<Substring*>(node);
+        auto* sub = new Substring(outer->flat, outer->offset + pos, count);
+        ref(outer->flat);
+        return sub;
+      }
+      case Kind::kConcat:
+        break;
+    }
+    auto* concat = static_cast<Concat*>(node);
+    size_t left_size = concat->left->length;
+    if (pos + count <= left_size) return sub_node(concat->left, pos, count);
+    if (pos >= left_size) {
+      return sub_node(concat->right, pos - left_size, count);
+    }
+    Node* left = sub_node(concat->left, pos, left_size - pos);
+    Node* right = nullptr;
+    try {
+      right = sub_node(concat->right, 0, pos + count - left_size);
+      return new Concat(left, right);
+    } catch (...) {
+      unref(left);
+      if (right != nullptr) unref(right);
+      throw;
+    }
+  }
+};
+
+}  // namespace stl
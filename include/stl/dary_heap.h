@@ -0,0 +1,211 @@
+/**
+ * @file dary_heap.h
+ * @brief Implementation of d-ary heap priority queue
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "stl/vector.h"
+
+namespace stl {
+
+// Default for DaryHeap's OnMove: positions are not tracked
+struct NoHeapIndex {
+  template <typename T>
+  void operator()(const T&, size_t) const noexcept {}
+};
+
+// Priority queue as a D-ary heap in a Vector: the children of slot i are
+// the D slots from D * i + 1, so with D = 4 or 8 a sift-down compares a
+// whole group that sits in one or two cache lines, and the tree is half or
+// a third as deep as a binary heap, which is where large heaps spend their
+// misses. As with std::priority_queue, top() is the greatest element under
+// Compare. OnMove(element, slot) is called whenever an element lands in a
+// slot, e.g. to keep an index from ids to slots for decrease_key()
+template <typename T, size_t D = 4, typename Compare = std::less<T>,
+          typename OnMove = NoHeapIndex>
+class DaryHeap {
+  static_assert(D >= 2, "DaryHeap needs at least two children per node");
+
+ public:
+  using value_type = T;
+
+  explicit DaryHeap(Compare compare = Compare(), OnMove on_move = OnMove())
+      : compare_(std::move(compare)), on_move_(std::move(on_move)) {}
+
+  // Heapifies values in O(n), rather than n pushes
+  explicit DaryHeap(Vector<T> values, Compare compare = Compare(),
+                    OnMove on_move = OnMove())
+      : data_(std::move(values)),
+        compare_(std::move(compare)),
+        on_move_(std::move(on_move)) {
+    heapify();
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return data_.size(); }
+  [[nodiscard]] bool empty() const noexcept { return data_.empty(); }
+
+  [[nodiscard]] const T& top() const noexcept { return data_[0]; }
+
+  // Element in a slot, as reported to OnMove
+  [[nodiscard]] const T& operator[](size_t slot) const noexcept {
+    return data_[slot];
+  }
+
+  template <typename U>
+    requires std::convertible_to<U&&, T>
+  void push(U&& value) {
+    data_.push_back(std::forward<U>(value));
+    sift_up(data_.size() - 1, std::move(data_.back()));
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<T, Args&&...>
+  void emplace(Args&&... args) {
+    data_.emplace_back(std::forward<Args>(args)...);
+    sift_up(data_.size() - 1, std::move(data_.back()));
+  }
+
+  void pop() {
+    if (data_.empty()) return;
+    if (data_.size() > 1) {
+      T last = std::move(data_.back());
+      data_.pop_back();
+      sift_down_from_leaf(std::move(last));
+    } else {
+      data_.pop_back();
+    }
+  }
+
+  // Same as push(value) then taking and popping top(), in one sift-down,
+  // or none when value would be the new top
+  T push_pop(T value) {
+    if (data_.empty() || !compare_(value, data_[0])) return value;
+    T result = std::move(data_[0]);
+    sift_down(0, std::move(value));
+    return result;
+  }
+
+  // Same as taking and popping top() then push(value), in one sift-down.
+  // The heap must not be empty
+  T replace_top(T value) {
+    T result = std::move(data_[0]);
+    sift_down(0, std::move(value));
+    return result;
+  }
+
+  // Replaces the element in slot with value, which must not compare less
+  // than it, i.e. for a min-heap under std::greater, a smaller key
+  void decrease_key(size_t slot, T value) {
+    if (slot >= data_.size()) throw std::out_of_range("DaryHeap::decrease_key");
+    sift_up(slot, std::move(value));
+  }
+
+  // Replaces the element in slot with a value that may move either way
+  void update(size_t slot, T value) {
+    if (slot >= data_.size()) throw std::out_of_range("DaryHeap::update");
+    if (compare_(data_[slot], value)) {
+      sift_up(slot, std::move(value));
+    } else {
+      sift_down(slot, std::move(value));
+    }
+  }
+
+  void erase(size_t slot) {
+    if (slot >= data_.size()) throw std::out_of_range("DaryHeap::erase");
+    T last = std::move(data_.back());
+    data_.pop_back();
+    if (slot < data_.size()) update(slot, std::move(last));
+  }
+
+  void clear() noexcept { data_.clear(); }
+
+  // Hands back the elements, in heap order, leaving the heap empty
+  Vector<T> release() noexcept { return std::move(data_); }
+
+ private:
+  Vector<T> data_;
+  [[no_unique_address]] Compare compare_;
+  [[no_unique_address]] OnMove on_move_;
+
+  static constexpr bool kTracksSlots = !std::is_same_v<OnMove, NoHeapIndex>;
+
+  void place(size_t slot, T&& value) {
+    data_[slot] = std::move(value);
+    if constexpr (kTracksSlots) on_move_(data_[slot], slot);
+  }
+
+  // Moves parents down into the hole until value fits
+  void sift_up(size_t slot, T value) {
+    while (slot > 0) {
+      size_t parent = (slot - 1) / D;
+      if (!compare_(data_[parent], value)) break;
+      place(slot, std::move(data_[parent]));
+      slot = parent;
+    }
+    place(slot, std::move(value));
+  }
+
+  // Greatest of the children from first, as a select rather than a branch
+  // per child, since which child wins is unpredictable. Full groups take a
+  // loop the compiler unrolls
+  size_t best_child(size_t first, size_t n) const {
+    size_t best = first;
+    if (first + D <= n) {
+      for (size_t c = first + 1; c < first + D; c++) {
+        best = compare_(data_[best], data_[c]) ? c : best;
+      }
+    } else {
+      for (size_t c = first + 1; c < n; c++) {
+        best = compare_(data_[best], data_[c]) ? c : best;
+      }
+    }
+    return best;
+  }
+
+  // Moves the greatest child up into the hole until value fits
+  void sift_down(size_t slot, T value) {
+    size_t n = data_.size();
+    for (size_t first = D * slot + 1; first < n; first = D * slot + 1) {
+      size_t best = best_child(first, n);
+      if (!compare_(value, data_[best])) break;
+      place(slot, std::move(data_[best]));
+      slot = best;
+    }
+    place(slot, std::move(value));
+  }
+
+  // For pop(), whose value comes from the bottom and mostly belongs back
+  // there: the hole at the root goes all the way down without comparing
+  // against value, and value then sifts up the few levels it needs
+  void sift_down_from_leaf(T value) {
+    size_t n = data_.size();
+    size_t slot = 0;
+    for (size_t first = 1; first < n; first = D * slot + 1) {
+      size_t best = best_child(first, n);
+      place(slot, std::move(data_[best]));
+      slot = best;
+    }
+    sift_up(slot, std::move(value));
+  }
+
+  // Floyd's bottom-up construction: sift down every parent, last first
+  void heapify() {
+    size_t n = data_.size();
+    if constexpr (kTracksSlots) {
+      for (size_t i = 0; i < n; i++) on_move_(data_[i], i);
+    }
+    if (n < 2) return;
+    for (size_t i = (n - 2) / D + 1; i-- > 0;) {
+      sift_down(i, std::move(data_[i]));
+    }
+  }
+};
+
+}  // namespace stl
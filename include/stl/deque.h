@@ -0,0 +1,329 @@
+/**
+ * @file deque.h
+ * @brief Implementation of double-ended queue on a circular buffer
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "stl/relocate.h"
+
+namespace stl {
+
+// Double-ended queue in one power-of-two circular buffer: element i lives
+// at (head + i) & (capacity - 1), so both ends push and pop in O(1) with no
+// per-block allocations, and random access is a mask away. Like Vector the
+// buffer doubles when full, and the ring moves over in at most two bulk
+// moves: with realloc() and one memcpy when T is trivially relocatable,
+// else by unrolling it into the new buffer. Popping never shrinks the
+// buffer, as work lists tend to refill it
+template <typename T>
+class Deque {
+  template <bool Const>
+  class Iterator;
+
+ public:
+  using value_type = T;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // Rounded up to a power of two
+  explicit Deque(size_t capacity = 0) {
+    if (capacity != 0) reallocate(std::bit_ceil(capacity));
+  }
+
+  ~Deque() noexcept {
+    clear();
+    std::free(data_);
+  }
+
+  Deque(const Deque& other) : Deque(other.size_) {
+    for (const T& element : other) push_back(element);
+  }
+
+  Deque(Deque&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        head_(std::exchange(other.head_, 0)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  Deque& operator=(const Deque& other) {
+    Deque copy(other);
+    copy.swap(*this);
+    return *this;
+  }
+
+  Deque& operator=(Deque&& other) noexcept {
+    Deque copy(std::move(other));
+    copy.swap(*this);
+    return *this;
+  }
+
+  void swap(Deque& other) noexcept {
+    using std::swap;
+    swap(data_, other.data_);
+    swap(capacity_, other.capacity_);
+    swap(head_, other.head_);
+    swap(size_, other.size_);
+  }
+
+  friend void swap(Deque& lhs, Deque& rhs) noexcept { lhs.swap(rhs); }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  template <typename U>
+    requires std::convertible_to<U&&, T>
+  void push_back(U&& element) {
+    emplace_back(std::forward<U>(element));
+  }
+
+  template <typename U>
+    requires std::convertible_to<U&&, T>
+  void push_front(U&& element) {
+    emplace_front(std::forward<U>(element));
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<T, Args&&...>
+  void emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      // args may refer into this deque, e.g. push_back(front()), so the
+      // element is built before the buffer moves
+      T element(std::forward<Args>(args)...);
+      grow();
+      new (data_ + slot(size_)) T(std::move(element));
+    } else {
+      new (data_ + slot(size_)) T(std::forward<Args>(args)...);
+    }
+    size_++;
+  }
+
+  template <typename... Args>
+    requires std::constructible_from<T, Args&&...>
+  void emplace_front(Args&&... args) {
+    if (size_ == capacity_) {
+      T element(std::forward<Args>(args)...);
+      grow();
+      head_ = (head_ - 1) & (capacity_ - 1);
+      new (data_ + head_) T(std::move(element));
+    } else {
+      size_t new_head = (head_ - 1) & (capacity_ - 1);
+      new (data_ + new_head) T(std::forward<Args>(args)...);
+      head_ = new_head;
+    }
+    size_++;
+  }
+
+  void pop_back() noexcept {
+    if (size_ == 0) return;
+    data_[slot(size_ - 1)].~T();
+    size_--;
+  }
+
+  void pop_front() noexcept {
+    if (size_ == 0) return;
+    data_[head_].~T();
+    head_ = (head_ + 1) & (capacity_ - 1);
+    size_--;
+  }
+
+  T& operator[](size_t index) noexcept { return data_[slot(index)]; }
+  const T& operator[](size_t index) const noexcept {
+    return data_[slot(index)];
+  }
+
+  T& at(size_t index) {
+    if (index >= size_) throw std::out_of_range("Deque::at");
+    return (*this)[index];
+  }
+  const T& at(size_t index) const {
+    if (index >= size_) throw std::out_of_range("Deque::at");
+    return (*this)[index];
+  }
+
+  T& front() noexcept { return data_[head_]; }
+  const T& front() const noexcept { return data_[head_]; }
+  T& back() noexcept { return data_[slot(size_ - 1)]; }
+  const T& back() const noexcept { return data_[slot(size_ - 1)]; }
+
+  iterator begin() noexcept { return {this, 0}; }
+  const_iterator begin() const noexcept { return {this, 0}; }
+  iterator end() noexcept { return {this, size_}; }
+  const_iterator end() const noexcept { return {this, size_}; }
+
+  // Rounded up to a power of two
+  void reserve(size_t new_capacity) {
+    if (new_capacity > capacity_) reallocate(std::bit_ceil(new_capacity));
+  }
+
+  // Down to the smallest power of two that holds size()
+  void shrink_to_fit() {
+    if (size_ == 0) {
+      std::free(std::exchange(data_, nullptr));
+      capacity_ = head_ = 0;
+      return;
+    }
+    if (std::bit_ceil(size_) < capacity_) reallocate(std::bit_ceil(size_));
+  }
+
+  void clear() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t i = 0; i < size_; i++) data_[slot(i)].~T();
+    }
+    head_ = 0;
+    size_ = 0;
+  }
+
+ private:
+  T* data_ = nullptr;
+  size_t capacity_ = 0;
+  size_t head_ = 0;
+  size_t size_ = 0;
+
+  size_t slot(size_t index) const noexcept {
+    return (head_ + index) & (capacity_ - 1);
+  }
+
+  void grow() { reallocate(capacity_ == 0 ? 1 : 2 * capacity_); }
+
+  void reallocate(size_t new_capacity) {
+    if constexpr (is_trivially_relocatable<T>::value) {
+      if (new_capacity > capacity_) {
+        grow_in_place(new_capacity);
+        return;
+      }
+    }
+    // The ring's two runs, [head, capacity) and then [0, tail), land at
+    // the start of the new buffer, which leaves head at 0
+    auto* new_data = static_cast<T*>(std::malloc(sizeof(T) * new_capacity));
+    if (new_data == nullptr) throw std::bad_alloc();
+    size_t first = std::min(size_, capacity_ - head_);
+    relocate(data_ + head_, first, new_data);
+    relocate(data_, size_ - first, new_data + first);
+    std::free(data_);
+    data_ = new_data;
+    capacity_ = new_capacity;
+    head_ = 0;
+  }
+
+  // realloc() can remap large buffers rather than copy them. If the ring
+  // wrapped, the shorter of its two runs then moves: the tail to just past
+  // the old end, or the head run to the end of the new buffer
+  void grow_in_place(size_t new_capacity) {
+    auto* new_data =
+        static_cast<T*>(std::realloc(data_, sizeof(T) * new_capacity));
+    if (new_data == nullptr) throw std::bad_alloc();
+    data_ = new_data;
+    if (head_ + size_ > capacity_) {
+      size_t head_run = capacity_ - head_;
+      size_t tail_run = size_ - head_run;
+      if (tail_run <= head_run) {
+        relocate(data_, tail_run, data_ + capacity_);
+      } else {
+        size_t new_head = new_capacity - head_run;
+        relocate(data_ + head_, head_run, data_ + new_head);
+        head_ = new_head;
+      }
+    }
+    capacity_ = new_capacity;
+  }
+
+  // Holds a position rather than a pointer, so it survives the buffer
+  // growing but not pushes or pops at the front
+  template <bool Const>
+  class Iterator {
+    using Owner = std::conditional_t<Const, const Deque, Deque>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+    Iterator() = default;
+    Iterator(Owner* owner, size_t index) noexcept
+        : owner_(owner), index_(index) {}
+
+    operator Iterator<true>() const noexcept
+      requires(!Const)
+    {
+      return {owner_, index_};
+    }
+
+    reference operator*() const noexcept { return (*owner_)[index_]; }
+    pointer operator->() const noexcept { return &(*owner_)[index_]; }
+    reference operator[](difference_type n) const noexcept {
+      return (*owner_)[index_ + n];
+    }
+
+    Iterator& operator++() noexcept {
+      index_++;
+      return *this;
+    }
+    Iterator operator++(int) noexcept {
+      Iterator copy = *this;
+      index_++;
+      return copy;
+    }
+    Iterator& operator--() noexcept {
+      index_--;
+      return *this;
+    }
+    Iterator operator--(int) noexcept {
+      Iterator copy = *this;
+      index_--;
+      return copy;
+    }
+
+    Iterator& operator+=(difference_type n) noexcept {
+      index_ += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) noexcept {
+      index_ -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) noexcept {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) noexcept {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) noexcept {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator& lhs,
+                                     const Iterator& rhs) noexcept {
+      return static_cast<difference_type>(lhs.index_) -
+             static_cast<difference_type>(rhs.index_);
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+      return lhs.index_ == rhs.index_;
+    }
+    friend auto operator<=>(const Iterator& lhs,
+                            const Iterator& rhs) noexcept {
+      return lhs.index_ <=> rhs.index_;
+    }
+
+   private:
+    Owner* owner_ = nullptr;
+    size_t index_ = 0;
+  };
+};
+
+}  // namespace stl
@@ -0,0 +1,142 @@
+/**
+ * @file deterministic_schedule.h
+ * @brief Seeded, replayable scheduling decisions for a deterministic
+ * ThreadPool
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stl {
+
+// One step of a deterministic pool: which worker ran which queued task
+struct ScheduleDecision {
+  uint64_t step = 0;
+  size_t worker = 0;
+  // Position of the task in the queue, 0 is the oldest
+  size_t task = 0;
+  // Tasks queued when the decision was made, checked on replay
+  size_t queued = 0;
+  // Picked by a worker waiting in help_until(), which always runs it itself
+  bool helped = false;
+
+  bool operator==(const ScheduleDecision&) const = default;
+};
+
+// Constructor argument selecting ThreadPool's deterministic mode
+struct DeterministicSchedule {
+  uint64_t seed = 0;
+  // Decisions to follow before falling back to the seed, usually the
+  // schedule_log() of an earlier run
+  std::vector<ScheduleDecision> replay;
+};
+
+// Makes the decisions of a deterministic ThreadPool. Not thread-safe, the
+// pool calls it with its mutex held
+class DeterministicScheduler {
+ public:
+  DeterministicScheduler(DeterministicSchedule schedule, size_t num_workers)
+      : state_(schedule.seed),
+        replay_(std::move(schedule.replay)),
+        num_workers_(num_workers) {}
+
+  // Picks the next task out of `queued` and the worker to run it. A helping
+  // worker always runs the task itself. Replayed decisions are followed
+  // until one no longer fits the queue, from then on the seed decides
+  ScheduleDecision next(size_t queued, std::optional<size_t> helper) {
+    ScheduleDecision decision;
+    decision.step = log_.size();
+    decision.queued = queued;
+    decision.helped = helper.has_value();
+
+    if (!diverged_at_ && decision.step < replay_.size()) {
+      const ScheduleDecision& planned = replay_[decision.step];
+      if (fits(planned, decision, helper)) {
+        decision.worker = planned.worker;
+        decision.task = planned.task;
+        log_.push_back(decision);
+        return decision;
+      }
+      diverged_at_ = decision.step;
+    }
+
+    decision.worker = helper ? *helper : random() % num_workers_;
+    decision.task = random() % queued;
+    log_.push_back(decision);
+    return decision;
+  }
+
+  [[nodiscard]] const std::vector<ScheduleDecision>& log() const noexcept {
+    return log_;
+  }
+
+  // First step where the replayed decision did not fit, nullopt if none
+  [[nodiscard]] std::optional<uint64_t> diverged_at() const noexcept {
+    return diverged_at_;
+  }
+
+ private:
+  uint64_t state_;
+  std::vector<ScheduleDecision> replay_;
+  std::vector<ScheduleDecision> log_;
+  std::optional<uint64_t> diverged_at_;
+  size_t num_workers_;
+
+  bool fits(const ScheduleDecision& planned, const ScheduleDecision& decision,
+            std::optional<size_t> helper) const noexcept {
+    return planned.queued == decision.queued &&
+           planned.helped == decision.helped &&
+           planned.task < decision.queued && planned.worker < num_workers_ &&
+           (!helper || planned.worker == *helper);
+  }
+
+  // SplitMix64
+  uint64_t random() noexcept {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+};
+
+// One decision per line: step worker task queued helped
+inline void write_schedule(std::ostream& out,
+                           const std::vector<ScheduleDecision>& log) {
+  for (const ScheduleDecision& decision : log) {
+    out << decision.step << ' ' << decision.worker << ' ' << decision.task
+        << ' ' << decision.queued << ' ' << (decision.helped ? 1 : 0) << '\n';
+  }
+}
+
+// Throws std::runtime_error on a malformed line
+inline std::vector<ScheduleDecision> read_schedule(std::istream& in) {
+  std::vector<ScheduleDecision> log;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) continue;
+
+    std::istringstream fields(line);
+    ScheduleDecision decision;
+    int helped = 0;
+    if (!(fields >> decision.step >> decision.worker >> decision.task >>
+          decision.queued >> helped) ||
+        (helped != 0 && helped != 1) || !(fields >> std::ws).eof()) {
+      throw std::runtime_error("malformed schedule line: " + line);
+    }
+    decision.helped = helped == 1;
+    log.push_back(decision);
+  }
+  return log;
+}
+
+}  // namespace stl
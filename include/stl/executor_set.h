@@ -0,0 +1,146 @@
+/**
+ * @file executor_set.h
+ * @brief Implementation of named ThreadPools with isolated CPU sets
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+struct ExecutorConfig {
+  std::string name;
+  size_t num_threads = 1;
+  // CPUs the pool's workers may run on, empty leaves them unpinned
+  std::vector<int> cpus;
+  // Per-pool queue limit, 0 for unbounded
+  size_t queue_capacity = 0;
+  OverflowPolicy overflow_policy = OverflowPolicy::kBlock;
+};
+
+// Owns several named ThreadPools so latency-critical and bulk work do not
+// compete for the same workers. Pools can be pinned to disjoint CPU sets,
+// and a pool's idle workers can be lent to another one, typically batch to
+// latency, so spare batch capacity absorbs request bursts while batch
+// tasks never run on latency workers.
+class ExecutorSet {
+ public:
+  // Throws std::invalid_argument on duplicate names or overlapping CPU sets
+  // and std::runtime_error if a CPU set cannot be applied
+  explicit ExecutorSet(const std::vector<ExecutorConfig>& configs) {
+    std::set<int> used_cpus;
+    for (const auto& config : configs) {
+      if (index_.count(config.name) != 0) {
+        throw std::invalid_argument("duplicate executor " + config.name);
+      }
+      for (int cpu : config.cpus) {
+        if (!used_cpus.insert(cpu).second) {
+          throw std::invalid_argument("CPU " + std::to_string(cpu) +
+                                      " assigned to two executors");
+        }
+      }
+      index_[config.name] = pools_.size();
+      names_.push_back(config.name);
+      lends_to_.push_back(std::nullopt);
+      pools_.push_back(std::make_unique<ThreadPool>(
+          config.num_threads, config.queue_capacity, config.overflow_policy));
+    }
+
+    for (size_t i = 0; i < configs.size(); i++) {
+      if (configs[i].cpus.empty()) continue;
+      if (!pools_[i]->set_affinity(configs[i].cpus)) {
+        throw std::runtime_error("cannot pin executor " + configs[i].name);
+      }
+    }
+  }
+
+  ExecutorSet(const ExecutorSet&) = delete;
+  ExecutorSet& operator=(const ExecutorSet&) = delete;
+
+  // Lenders go first: destroying a pool joins its workers, including any
+  // still running a borrowed task of a pool destroyed later
+  ~ExecutorSet() {
+    std::vector<bool> destroyed(pools_.size(), false);
+    for (size_t remaining = pools_.size(); remaining > 0;) {
+      for (size_t i = 0; i < pools_.size(); i++) {
+        if (destroyed[i] || has_live_lender(i, destroyed)) continue;
+        pools_[i].reset();
+        destroyed[i] = true;
+        remaining--;
+      }
+    }
+  }
+
+  // Throws std::out_of_range for an unknown name
+  [[nodiscard]] ThreadPool& pool(const std::string& name) const {
+    return *pools_[index_of(name)];
+  }
+
+  [[nodiscard]] bool contains(const std::string& name) const {
+    return index_.count(name) != 0;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return pools_.size(); }
+
+  [[nodiscard]] const std::vector<std::string>& names() const noexcept {
+    return names_;
+  }
+
+  // Idle workers of `lender` run tasks of `borrower` while all of the
+  // borrower's workers are busy. A pool lends to at most one other pool,
+  // and lending back along the chain is refused, so work only ever flows
+  // one way
+  void lend(const std::string& lender, const std::string& borrower) {
+    size_t from = index_of(lender);
+    size_t to = index_of(borrower);
+    for (std::optional<size_t> at = to; at; at = lends_to_[*at]) {
+      if (*at == from) {
+        throw std::invalid_argument(borrower + " already lends to " + lender);
+      }
+    }
+
+    pools_[from]->lend_idle_workers_to(pools_[to].get());
+    lends_to_[from] = to;
+  }
+
+  void stop_lending(const std::string& lender) {
+    size_t from = index_of(lender);
+    pools_[from]->lend_idle_workers_to(nullptr);
+    lends_to_[from] = std::nullopt;
+  }
+
+ private:
+  std::vector<std::unique_ptr<ThreadPool>> pools_;
+  std::vector<std::string> names_;
+  std::map<std::string, size_t> index_;
+  // Index of the pool each pool lends its idle workers to
+  std::vector<std::optional<size_t>> lends_to_;
+
+  size_t index_of(const std::string& name) const {
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+      throw std::out_of_range("unknown executor " + name);
+    }
+    return it->second;
+  }
+
+  bool has_live_lender(size_t pool,
+                       const std::vector<bool>& destroyed) const {
+    for (size_t i = 0; i < pools_.size(); i++) {
+      if (!destroyed[i] && lends_to_[i] == pool) return true;
+    }
+    return false;
+  }
+};
+
+}  // namespace stl
@@ -0,0 +1,301 @@
+/**
+ * @file hash.h
+ * @brief Implementation of fast non-cryptographic hashing for containers
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace stl {
+
+namespace detail {
+
+inline constexpr uint64_t kHashP0 = 0xa0761d6478bd642fULL;
+inline constexpr uint64_t kHashP1 = 0xe7037ed1a0b428dbULL;
+inline constexpr uint64_t kHashP2 = 0x8ebc6af09c88c6e3ULL;
+inline constexpr uint64_t kHashP3 = 0x589965cc75374cc3ULL;
+
+// Folds the 128-bit product, so every input bit reaches every output bit
+inline uint64_t mum(uint64_t a, uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^
+         static_cast<uint64_t>(product >> 64);
+#else
+  uint64_t ha = a >> 32, la = static_cast<uint32_t>(a);
+  uint64_t hb = b >> 32, lb = static_cast<uint32_t>(b);
+  uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+  uint64_t mid = (ll >> 32) + static_cast<uint32_t>(hl) +
+                 static_cast<uint32_t>(lh);
+  uint64_t lo = (mid << 32) | static_cast<uint32_t>(ll);
+  uint64_t hi = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+  return lo ^ hi;
+#endif
+}
+
+inline uint64_t read64(const unsigned char* p) noexcept {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t read32(const unsigned char* p) noexcept {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Inputs at least this long take the striped path
+inline constexpr size_t kLongHashInput = 256;
+
+// Eight 64-bit lanes consume a 64-byte stripe, keyed by a secret that
+// slides one word per stripe; after kStripesPerBlock the lanes are
+// scrambled so a long input cannot cancel itself out
+inline constexpr size_t kStripeBytes = 64;
+inline constexpr size_t kStripesPerBlock = 16;
+
+inline constexpr std::array<uint64_t, kStripesPerBlock + 8> kHashSecret = [] {
+  std::array<uint64_t, kStripesPerBlock + 8> secret{};
+  uint64_t state = kHashP0;
+  for (uint64_t& word : secret) {
+    // SplitMix64
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    word = z ^ (z >> 31);
+  }
+  return secret;
+}();
+
+inline constexpr uint32_t kScramblePrime = 0x9e3779b1U;
+
+// acc[i ^ 1] += data[i], acc[i] += lo32(data[i] ^ key[i]) * hi32(...)
+inline void accumulate_stripe(uint64_t* acc, const unsigned char* data,
+                              const uint64_t* key) noexcept {
+#if defined(__SSE2__)
+  for (size_t i = 0; i < 8; i += 2) {
+    __m128i value =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 8));
+    __m128i keyed = _mm_xor_si128(
+        value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i)));
+    __m128i product = _mm_mul_epu32(
+        keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+    __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i* lanes = reinterpret_cast<__m128i*>(acc + i);
+    _mm_storeu_si128(
+        lanes, _mm_add_epi64(_mm_loadu_si128(lanes),
+                             _mm_add_epi64(product, swapped)));
+  }
+#else
+  for (size_t i = 0; i < 8; i++) {
+    uint64_t value = read64(data + i * 8);
+    uint64_t keyed = value ^ key[i];
+    acc[i ^ 1] += value;
+    acc[i] += (keyed & 0xffffffff) * (keyed >> 32);
+  }
+#endif
+}
+
+inline void scramble_lanes(uint64_t* acc, const uint64_t* key) noexcept {
+#if defined(__SSE2__)
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(kScramblePrime));
+  for (size_t i = 0; i < 8; i += 2) {
+    __m128i* lanes = reinterpret_cast<__m128i*>(acc + i);
+    __m128i value = _mm_loadu_si128(lanes);
+    value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+    value = _mm_xor_si128(
+        value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i)));
+    // 64 x 32-bit multiply from two 32 x 32 halves
+    __m128i low = _mm_mul_epu32(value, prime);
+    __m128i high = _mm_mul_epu32(
+        _mm_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+    _mm_storeu_si128(lanes, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+  }
+#else
+  for (size_t i = 0; i < 8; i++) {
+    uint64_t value = acc[i];
+    value ^= value >> 47;
+    value ^= key[i];
+    acc[i] = value * kScramblePrime;
+  }
+#endif
+}
+
+inline uint64_t hash_long(const unsigned char* p, size_t len,
+                          uint64_t seed) noexcept {
+  uint64_t acc[8] = {kHashP0, kHashP1, kHashP2, kHashP3,
+                     ~kHashP0, ~kHashP1, ~kHashP2, ~kHashP3};
+  for (uint64_t& lane : acc) lane ^= seed;
+
+  const uint64_t* scramble_key = kHashSecret.data() + kStripesPerBlock;
+  size_t stripes = (len - 1) / kStripeBytes;
+  size_t stripe = 0;
+  for (; stripe + kStripesPerBlock <= stripes; stripe += kStripesPerBlock) {
+    for (size_t s = 0; s < kStripesPerBlock; s++) {
+      accumulate_stripe(acc, p + (stripe + s) * kStripeBytes,
+                        kHashSecret.data() + s);
+    }
+    scramble_lanes(acc, scramble_key);
+  }
+  for (size_t s = 0; stripe + s < stripes; s++) {
+    accumulate_stripe(acc, p + (stripe + s) * kStripeBytes,
+                      kHashSecret.data() + s);
+  }
+  // The last 64 bytes, overlapping the previous stripe when len is not a
+  // multiple of it
+  accumulate_stripe(acc, p + len - kStripeBytes, kHashSecret.data() + 7);
+
+  uint64_t result = len * kHashP0;
+  for (size_t i = 0; i < 8; i += 2) {
+    result += mum(acc[i] ^ kHashSecret[i + 1], acc[i + 1] ^ kHashSecret[i]);
+  }
+  return mum(result ^ seed, kHashP1 ^ len);
+}
+
+}  // namespace detail
+
+// Strong 64-bit finalizer. std::hash is the identity for integers, so this
+// is what spreads their bits before a table splits them between slot index
+// and fingerprint. One folded multiply leaves the top input bit flipping
+// only the top output bit; the second, keyed by the input again, fixes that
+inline size_t mix_hash(uint64_t h) noexcept {
+  using namespace detail;
+  return static_cast<size_t>(mum(mum(h ^ kHashP0, kHashP1), h ^ kHashP2));
+}
+
+// wyhash-style for short inputs; from kLongHashInput bytes, eight
+// independent lanes (SSE2 where available, same result without) in the
+// manner of xxh3, so throughput is bound by loads rather than multiplies
+inline size_t hash_bytes(const void* data, size_t len,
+                         uint64_t seed = 0) noexcept {
+  using namespace detail;
+  const auto* p = static_cast<const unsigned char*>(data);
+  if (len >= kLongHashInput) return hash_long(p, len, seed);
+
+  seed ^= mum(seed ^ kHashP0, kHashP1);
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (len <= 16) {
+    if (len >= 4) {
+      // Two overlapping pairs of 4-byte reads cover 4 to 16 bytes
+      size_t step = (len >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + step);
+      b = (read32(p + len - 4) << 32) | read32(p + len - 4 - step);
+    } else if (len > 0) {
+      a = (uint64_t{p[0]} << 16) | (uint64_t{p[len >> 1]} << 8) | p[len - 1];
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = mum(read64(p) ^ kHashP1, read64(p + 8) ^ seed);
+        see1 = mum(read64(p + 16) ^ kHashP2, read64(p + 24) ^ see1);
+        see2 = mum(read64(p + 32) ^ kHashP3, read64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = mum(read64(p) ^ kHashP1, read64(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = read64(p + i - 16);
+    b = read64(p + i - 8);
+  }
+  return static_cast<size_t>(
+      mum(mum(a ^ kHashP1, b ^ seed) ^ kHashP0 ^ len, seed ^ kHashP1));
+}
+
+// Order-dependent: hash_combine(a, b) != hash_combine(b, a)
+inline size_t hash_combine(size_t seed, size_t value) noexcept {
+  return mix_hash(detail::mum(seed ^ detail::kHashP0, value ^ detail::kHashP3));
+}
+
+// A hasher declaring is_avalanching already mixes well, so containers skip
+// their own mix_hash on its results
+template <typename H>
+concept AvalanchingHash = requires { typename H::is_avalanching; };
+
+template <typename T>
+struct Hash;
+
+// Types opt in with a hash_value(const T&) found by argument-dependent
+// lookup, typically returning hash_values(members...)
+template <typename T>
+concept HasHashValue = requires(const T& value) {
+  { hash_value(value) } -> std::convertible_to<size_t>;
+};
+
+namespace detail {
+
+template <typename T>
+struct IsTupleLike : std::false_type {};
+
+template <typename... Ts>
+struct IsTupleLike<std::tuple<Ts...>> : std::true_type {};
+
+template <typename A, typename B>
+struct IsTupleLike<std::pair<A, B>> : std::true_type {};
+
+}  // namespace detail
+
+template <typename... Ts>
+size_t hash_values(const Ts&... values) noexcept {
+  size_t seed = detail::kHashP3;
+  ((seed = hash_combine(seed, Hash<Ts>{}(values))), ...);
+  return seed;
+}
+
+// Drop-in for std::hash whose results are safe to split between index and
+// fingerprint: integers, enums and pointers are mixed, floats hash -0.0 as
+// 0.0, anything convertible to std::string_view hashes its bytes, pairs
+// and tuples combine their elements, and other types use hash_value() or,
+// failing that, a mixed std::hash
+template <typename T>
+struct Hash {
+  using is_avalanching = void;
+
+  size_t operator()(const T& value) const noexcept {
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+      return mix_hash(static_cast<uint64_t>(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+      return mix_hash(reinterpret_cast<uintptr_t>(value));
+    } else if constexpr (std::is_same_v<T, float>) {
+      return mix_hash(value == 0.0f ? 0 : std::bit_cast<uint32_t>(value));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return mix_hash(value == 0.0 ? 0 : std::bit_cast<uint64_t>(value));
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+      std::string_view bytes = value;
+      return hash_bytes(bytes.data(), bytes.size());
+    } else if constexpr (detail::IsTupleLike<T>::value) {
+      return std::apply(
+          [](const auto&... elements) { return hash_values(elements...); },
+          value);
+    } else if constexpr (HasHashValue<T>) {
+      return mix_hash(static_cast<uint64_t>(hash_value(value)));
+    } else {
+      return mix_hash(static_cast<uint64_t>(std::hash<T>{}(value)));
+    }
+  }
+};
+
+}  // namespace stl
@@ -0,0 +1,545 @@
+/**
+ * @file hash_map.h
+ * @brief Implementation of open addressing hash map with SIMD probing
+ * (Swiss table)
+ */
+
+#pragma once
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "stl/hash.h"
+
+namespace stl {
+
+// Sixteen control bytes matched at once, with SSE2 where available. A
+// control byte is kEmpty, kDeleted (a tombstone) or, for a full slot, the
+// low 7 bits of its hash, so full bytes are the non-negative ones
+class ControlGroup {
+ public:
+  static constexpr size_t kWidth = 16;
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  // ctrl must be 16-byte aligned
+  explicit ControlGroup(const int8_t* ctrl) noexcept {
+#if defined(__SSE2__)
+    bytes_ = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+    std::memcpy(bytes_, ctrl, kWidth);
+#endif
+  }
+
+  // Bit i is set when byte i equals h2
+  [[nodiscard]] uint32_t match(int8_t h2) const noexcept {
+#if defined(__SSE2__)
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes_, _mm_set1_epi8(h2))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kWidth; i++) {
+      mask |= static_cast<uint32_t>(bytes_[i] == h2) << i;
+    }
+    return mask;
+#endif
+  }
+
+  [[nodiscard]] uint32_t match_empty() const noexcept {
+    return match(kEmpty);
+  }
+
+  // Empty and deleted are the bytes with the sign bit set
+  [[nodiscard]] uint32_t match_empty_or_deleted() const noexcept {
+#if defined(__SSE2__)
+    return static_cast<uint32_t>(_mm_movemask_epi8(bytes_));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kWidth; i++) {
+      mask |= static_cast<uint32_t>(bytes_[i] < 0) << i;
+    }
+    return mask;
+#endif
+  }
+
+ private:
+#if defined(__SSE2__)
+  __m128i bytes_;
+#else
+  int8_t bytes_[kWidth];
+#endif
+};
+
+// Open addressing map in the Swiss table layout: a control byte array
+// beside the slot array, probed one 16-slot group at a time. The low 7 bits
+// of the hash are kept in the control byte, so a lookup compares keys only
+// for slots whose fingerprint matches, and stops at the first group with an
+// empty slot. Groups are probed triangularly, which visits every group of a
+// power of two table. Erase leaves a tombstone only where a probe may have
+// passed; when tombstones take up much of the load the table is rebuilt at
+// the same capacity instead of doubling. Slots are raw storage filled with
+// placement new, like Vector, and move on rehash, which invalidates
+// iterators and references. Keys may be move-only; a rehash copies entries
+// whose move could throw, so a failed one leaves the map as it was.
+template <typename K, typename V, typename Hash = stl::Hash<K>,
+          typename Eq = std::equal_to<K>>
+class HashMap {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = HashMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+    using reference =
+        std::conditional_t<Const, const value_type&, value_type&>;
+
+    Iterator() = default;
+
+    // Iterator converts to const_iterator
+    operator Iterator<true>() const noexcept
+      requires(!Const)
+    {
+      return Iterator<true>(ctrl_, end_, slot_);
+    }
+
+    reference operator*() const noexcept { return *slot_; }
+    pointer operator->() const noexcept { return slot_; }
+
+    Iterator& operator++() noexcept {
+      ++ctrl_;
+      ++slot_;
+      skip_free();
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      Iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator& other) const noexcept {
+      return slot_ == other.slot_;
+    }
+
+   private:
+    friend class HashMap;
+    template <bool>
+    friend class Iterator;
+
+    const int8_t* ctrl_ = nullptr;
+    const int8_t* end_ = nullptr;
+    pointer slot_ = nullptr;
+
+    Iterator(const int8_t* ctrl, const int8_t* end, pointer slot) noexcept
+        : ctrl_(ctrl), end_(end), slot_(slot) {}
+
+    void skip_free() noexcept {
+      while (ctrl_ != end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  HashMap() = default;
+
+  // Room for `capacity` entries without rehashing
+  explicit HashMap(size_t capacity) { reserve(capacity); }
+
+  ~HashMap() noexcept { release(); }
+
+  HashMap(const HashMap& other) : hash_(other.hash_), eq_(other.eq_) {
+    // The destructor does not run for a constructor that throws
+    try {
+      reserve(other.size_);
+      for (const value_type& entry : other) {
+        size_t hash = hash_of(entry.first);
+        construct_at(find_free(hash), hash, entry);
+      }
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  void swap(HashMap& other) noexcept {
+    using std::swap;
+    swap(ctrl_, other.ctrl_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+    swap(hash_, other.hash_);
+    swap(eq_, other.eq_);
+  }
+
+  friend void swap(HashMap& lhs, HashMap& rhs) noexcept { lhs.swap(rhs); }
+
+  HashMap& operator=(const HashMap& other) {
+    HashMap copy(other);
+    copy.swap(*this);
+    return *this;
+  }
+
+  HashMap(HashMap&& other) noexcept { swap(other); }
+
+  HashMap& operator=(HashMap&& other) noexcept {
+    HashMap copy(std::move(other));
+    copy.swap(*this);
+    return *this;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  // Slots allocated, at most 7/8 of them are filled before growing
+  [[nodiscard]] size_t capacity() const noexcept { return capacity_; }
+
+  iterator begin() noexcept { return make_iterator(0); }
+  iterator end() noexcept { return make_iterator(capacity_); }
+  const_iterator begin() const noexcept { return make_iterator(0); }
+  const_iterator end() const noexcept { return make_iterator(capacity_); }
+
+  iterator find(const K& key) noexcept {
+    return make_iterator(find_index(key, hash_of(key)));
+  }
+
+  const_iterator find(const K& key) const noexcept {
+    return make_iterator(find_index(key, hash_of(key)));
+  }
+
+  [[nodiscard]] bool contains(const K& key) const noexcept {
+    return find_index(key, hash_of(key)) != capacity_;
+  }
+
+  [[nodiscard]] size_t count(const K& key) const noexcept {
+    return contains(key) ? 1 : 0;
+  }
+
+  // Throws std::out_of_range for a missing key
+  V& at(const K& key) {
+    size_t index = find_index(key, hash_of(key));
+    if (index == capacity_) throw std::out_of_range("HashMap::at");
+    return slots_[index].second;
+  }
+
+  const V& at(const K& key) const {
+    size_t index = find_index(key, hash_of(key));
+    if (index == capacity_) throw std::out_of_range("HashMap::at");
+    return slots_[index].second;
+  }
+
+  V& operator[](const K& key) { return try_emplace(key).first->second; }
+  V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+  // Constructs the value from args only if the key is absent
+  template <typename KeyArg, typename... Args>
+    requires std::constructible_from<K, KeyArg&&>
+  std::pair<iterator, bool> try_emplace(KeyArg&& key, Args&&... args) {
+    auto [index, hash, found] = prepare_insert(key);
+    if (found) return {make_iterator(index), false};
+
+    construct_at(index, hash, std::piecewise_construct,
+                 std::forward_as_tuple(std::forward<KeyArg>(key)),
+                 std::forward_as_tuple(std::forward<Args>(args)...));
+    return {make_iterator(index), true};
+  }
+
+  std::pair<iterator, bool> insert(const value_type& entry) {
+    return try_emplace(entry.first, entry.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& entry) {
+    return try_emplace(entry.first, std::move(entry.second));
+  }
+
+  template <typename KeyArg, typename M>
+    requires std::constructible_from<K, KeyArg&&>
+  std::pair<iterator, bool> insert_or_assign(KeyArg&& key, M&& value) {
+    auto result =
+        try_emplace(std::forward<KeyArg>(key), std::forward<M>(value));
+    if (!result.second) result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  size_t erase(const K& key) {
+    size_t index = find_index(key, hash_of(key));
+    if (index == capacity_) return 0;
+    erase_at(index);
+    return 1;
+  }
+
+  // Returns the iterator following the erased entry
+  iterator erase(const_iterator position) {
+    size_t index = static_cast<size_t>(position.ctrl_ - ctrl_);
+    erase_at(index);
+    return make_iterator(index + 1);
+  }
+
+  // Keeps the allocation
+  void clear() noexcept {
+    for (size_t i = 0; i < capacity_; i++) {
+      if (ctrl_[i] >= 0) slots_[i].~value_type();
+    }
+    if (capacity_ != 0) std::memset(ctrl_, ControlGroup::kEmpty, capacity_);
+    size_ = 0;
+    growth_left_ = max_load(capacity_);
+  }
+
+  // Room for `count` entries without rehashing
+  void reserve(size_t count) {
+    size_t capacity = ControlGroup::kWidth;
+    while (max_load(capacity) < count) capacity *= 2;
+    if (capacity > capacity_) resize(capacity);
+  }
+
+ private:
+  static constexpr size_t kWidth = ControlGroup::kWidth;
+
+  int8_t* ctrl_ = nullptr;
+  value_type* slots_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  // Empty slots that may still be filled before the table must grow;
+  // reusing a tombstone does not count
+  size_t growth_left_ = 0;
+  [[no_unique_address]] Hash hash_;
+  [[no_unique_address]] Eq eq_;
+
+  struct InsertPosition {
+    size_t index;
+    size_t hash;
+    bool found;
+  };
+
+  static constexpr size_t max_load(size_t capacity) noexcept {
+    return capacity - capacity / 8;
+  }
+
+  size_t hash_of(const K& key) const noexcept {
+    if constexpr (AvalanchingHash<Hash>) {
+      return hash_(key);
+    } else {
+      return mix_hash(static_cast<uint64_t>(hash_(key)));
+    }
+  }
+
+  static int8_t fingerprint(size_t hash) noexcept {
+    return static_cast<int8_t>(hash & 0x7f);
+  }
+
+  size_t first_group(size_t hash) const noexcept {
+    return (hash >> 7) & (capacity_ / kWidth - 1);
+  }
+
+  size_t next_group(size_t group, size_t step) const noexcept {
+    return (group + step) & (capacity_ / kWidth - 1);
+  }
+
+  iterator make_iterator(size_t index) noexcept {
+    iterator it(ctrl_ + index, ctrl_ + capacity_, slots_ + index);
+    it.skip_free();
+    return it;
+  }
+
+  const_iterator make_iterator(size_t index) const noexcept {
+    const_iterator it(ctrl_ + index, ctrl_ + capacity_, slots_ + index);
+    it.skip_free();
+    return it;
+  }
+
+  // Index of the key's slot, capacity_ if absent
+  size_t find_index(const K& key, size_t hash) const noexcept {
+    if (capacity_ == 0) return capacity_;
+
+    int8_t h2 = fingerprint(hash);
+    size_t group = first_group(hash);
+    for (size_t step = 1;; step++) {
+      ControlGroup control(ctrl_ + group * kWidth);
+      for (uint32_t mask = control.match(h2); mask != 0; mask &= mask - 1) {
+        size_t index = group * kWidth + std::countr_zero(mask);
+        if (eq_(slots_[index].first, key)) return index;
+      }
+      if (control.match_empty() != 0) return capacity_;
+      group = next_group(group, step);
+    }
+  }
+
+  // First empty or deleted slot on the probe sequence
+  size_t find_free(size_t hash) const noexcept {
+    size_t group = first_group(hash);
+    for (size_t step = 1;; step++) {
+      uint32_t mask =
+          ControlGroup(ctrl_ + group * kWidth).match_empty_or_deleted();
+      if (mask != 0) return group * kWidth + std::countr_zero(mask);
+      group = next_group(group, step);
+    }
+  }
+
+  // One probe finds either the key or the slot a new entry goes to
+  InsertPosition prepare_insert(const K& key) {
+    size_t hash = hash_of(key);
+    if (capacity_ != 0) {
+      int8_t h2 = fingerprint(hash);
+      size_t group = first_group(hash);
+      size_t target = capacity_;
+      for (size_t step = 1;; step++) {
+        ControlGroup control(ctrl_ + group * kWidth);
+        for (uint32_t mask = control.match(h2); mask != 0; mask &= mask - 1) {
+          size_t index = group * kWidth + std::countr_zero(mask);
+          if (eq_(slots_[index].first, key)) return {index, hash, true};
+        }
+        uint32_t free = control.match_empty_or_deleted();
+        if (target == capacity_ && free != 0) {
+          target = group * kWidth + std::countr_zero(free);
+        }
+        if (control.match_empty() != 0) break;
+        group = next_group(group, step);
+      }
+
+      if (ctrl_[target] == ControlGroup::kDeleted || growth_left_ != 0) {
+        return {target, hash, false};
+      }
+    }
+
+    grow();
+    return {find_free(hash), hash, false};
+  }
+
+  template <typename... Args>
+  void construct_at(size_t index, size_t hash, Args&&... args) {
+    new (slots_ + index) value_type(std::forward<Args>(args)...);
+    if (ctrl_[index] == ControlGroup::kEmpty) growth_left_--;
+    ctrl_[index] = fingerprint(hash);
+    size_++;
+  }
+
+  void erase_at(size_t index) {
+    slots_[index].~value_type();
+    size_--;
+
+    // A group with an empty slot never sent a probe on to the next group,
+    // so no lookup needs a tombstone here
+    size_t group_start = index & ~(kWidth - 1);
+    if (ControlGroup(ctrl_ + group_start).match_empty() != 0) {
+      ctrl_[index] = ControlGroup::kEmpty;
+      growth_left_++;
+    } else {
+      ctrl_[index] = ControlGroup::kDeleted;
+    }
+  }
+
+  // Out of empty slots: drops the tombstones if live entries fill at most
+  // 25/32 of the table, which frees at least 3/32 of it, otherwise doubles
+  void grow() {
+    if (capacity_ == 0) {
+      resize(kWidth);
+    } else if (size_ * 32 <= capacity_ * 25) {
+      resize(capacity_);
+    } else {
+      resize(capacity_ * 2);
+    }
+  }
+
+  // Moves the entry, or copies it when its move could throw and a copy is
+  // possible. The key is const in value_type, so it is moved out through a
+  // const_cast, as node extraction does for std::map; the source is
+  // destroyed without being read again
+  static void relocate(value_type* to, value_type& from) {
+    using KeyRef =
+        std::conditional_t<std::is_nothrow_move_constructible_v<K> ||
+                               !std::is_copy_constructible_v<K>,
+                           K&&, const K&>;
+    using ValueRef =
+        std::conditional_t<std::is_nothrow_move_constructible_v<V> ||
+                               !std::is_copy_constructible_v<V>,
+                           V&&, const V&>;
+    new (to) value_type(
+        std::piecewise_construct,
+        std::forward_as_tuple(static_cast<KeyRef>(const_cast<K&>(from.first))),
+        std::forward_as_tuple(static_cast<ValueRef>(from.second)));
+  }
+
+  void resize(size_t new_capacity) {
+    int8_t* old_ctrl = ctrl_;
+    value_type* old_slots = slots_;
+    size_t old_capacity = capacity_;
+    size_t old_growth_left = growth_left_;
+
+    ctrl_ = static_cast<int8_t*>(std::aligned_alloc(kWidth, new_capacity));
+    slots_ = static_cast<value_type*>(
+        std::malloc(sizeof(value_type) * new_capacity));
+    if (ctrl_ == nullptr || slots_ == nullptr) {
+      std::free(ctrl_);
+      std::free(slots_);
+      ctrl_ = old_ctrl;
+      slots_ = old_slots;
+      throw std::bad_alloc();
+    }
+    std::memset(ctrl_, ControlGroup::kEmpty, new_capacity);
+    capacity_ = new_capacity;
+    growth_left_ = max_load(new_capacity) - size_;
+
+    // Fill the new table before touching the old one, so a throwing copy
+    // can put the old table back
+    try {
+      for (size_t i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] < 0) continue;
+        size_t hash = hash_of(old_slots[i].first);
+        size_t index = find_free(hash);
+        relocate(slots_ + index, old_slots[i]);
+        ctrl_[index] = fingerprint(hash);
+      }
+    } catch (...) {
+      for (size_t i = 0; i < new_capacity; i++) {
+        if (ctrl_[i] >= 0) slots_[i].~value_type();
+      }
+      std::free(ctrl_);
+      std::free(slots_);
+      ctrl_ = old_ctrl;
+      slots_ = old_slots;
+      capacity_ = old_capacity;
+      growth_left_ = old_growth_left;
+      throw;
+    }
+
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (old_ctrl[i] >= 0) old_slots[i].~value_type();
+    }
+    std::free(old_ctrl);
+    std::free(old_slots);
+  }
+
+  void release() noexcept {
+    for (size_t i = 0; i < capacity_; i++) {
+      if (ctrl_[i] >= 0) slots_[i].~value_type();
+    }
+    std::free(ctrl_);
+    std::free(slots_);
+  }
+};
+
+}  // namespace stl
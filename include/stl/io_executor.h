@@ -0,0 +1,512 @@
+/**
+ * @file io_executor.h
+ * @brief Implementation of asynchronous file I/O executor for ThreadPool
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cerrno>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define STL_HAS_IO_URING 1
+#else
+#define STL_HAS_IO_URING 0
+#endif
+
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+enum class IoBackend {
+  kAuto,     // io_uring when the kernel allows it, threads otherwise
+  kIoUring,  // io_uring or throw
+  kThreads,  // Blocking pread/pwrite on dedicated I/O threads
+};
+
+struct IoResult {
+  // Bytes transferred, may be short at end of file
+  size_t bytes = 0;
+  // errno value, 0 on success
+  int error = 0;
+
+  [[nodiscard]] bool ok() const noexcept { return error == 0; }
+};
+
+// Runs pread/pwrite style requests off the CPU workers and delivers each
+// result to a callback queued on the ThreadPool, so workers never block on
+// disk. With io_uring a single reaper thread moves every request queued
+// since its last wake-up into the submission ring and enters the kernel
+// once for the whole batch; without it, a small set of I/O threads run the
+// blocking calls. The buffer must stay valid until the callback runs, and
+// the pool must outlive the executor.
+class IoExecutor {
+ public:
+  explicit IoExecutor(ThreadPool& pool, IoBackend backend = IoBackend::kAuto,
+                      unsigned queue_depth = 128, size_t io_threads = 2)
+      : pool_(pool) {
+    if (backend != IoBackend::kThreads && setup_ring(queue_depth)) {
+      backend_ = IoBackend::kIoUring;
+      threads_.emplace_back([this]() { uring_loop(); });
+      return;
+    }
+    if (backend == IoBackend::kIoUring) {
+      throw std::runtime_error("io_uring is not available");
+    }
+
+    backend_ = IoBackend::kThreads;
+    if (io_threads == 0) io_threads = 1;
+    for (size_t i = 0; i < io_threads; i++) {
+      threads_.emplace_back([this]() { blocking_loop(); });
+    }
+  }
+
+  IoExecutor(const IoExecutor&) = delete;
+  IoExecutor& operator=(const IoExecutor&) = delete;
+
+  // Completes every accepted request before returning
+  ~IoExecutor() {
+    {
+      std::scoped_lock lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    wake_reaper();
+
+    for (auto& thread : threads_) thread.join();
+    teardown_ring();
+  }
+
+  // on_complete(IoResult) runs as a pool continuation
+  template <typename F>
+  void read(int fd, void* buffer, size_t length, uint64_t offset,
+            F&& on_complete) {
+    enqueue(Op::kRead, fd, buffer, length, offset,
+            std::forward<F>(on_complete));
+  }
+
+  template <typename F>
+  void write(int fd, const void* buffer, size_t length, uint64_t offset,
+             F&& on_complete) {
+    enqueue(Op::kWrite, fd, const_cast<void*>(buffer), length, offset,
+            std::forward<F>(on_complete));
+  }
+
+  std::future<IoResult> read(int fd, void* buffer, size_t length,
+                             uint64_t offset) {
+    auto promise = std::make_shared<std::promise<IoResult>>();
+    auto future = promise->get_future();
+    read(fd, buffer, length, offset,
+         [promise](IoResult result) { promise->set_value(result); });
+    return future;
+  }
+
+  std::future<IoResult> write(int fd, const void* buffer, size_t length,
+                              uint64_t offset) {
+    auto promise = std::make_shared<std::promise<IoResult>>();
+    auto future = promise->get_future();
+    write(fd, buffer, length, offset,
+          [promise](IoResult result) { promise->set_value(result); });
+    return future;
+  }
+
+  // The backend actually in use, never kAuto
+  [[nodiscard]] IoBackend backend() const noexcept { return backend_; }
+
+  // Requests accepted but not yet completed
+  [[nodiscard]] size_t in_flight() const noexcept {
+    return in_flight_.load(std::memory_order_relaxed);
+  }
+
+  // Whether this kernel (and seccomp policy) lets us create a ring
+  static bool io_uring_available() {
+#if STL_HAS_IO_URING
+    io_uring_params params{};
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, 2, &params));
+    if (fd < 0) return false;
+    ::close(fd);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+ private:
+  enum class Op { kRead, kWrite };
+
+  struct Request {
+    Op op = Op::kRead;
+    int fd = -1;
+    void* buffer = nullptr;
+    size_t length = 0;
+    uint64_t offset = 0;
+    std::function<void(IoResult)> on_complete;
+#if STL_HAS_IO_URING
+    // Referenced by the SQE until the kernel consumed it
+    iovec iov{};
+    // Links in the reaper's list of requests the kernel holds
+    Request* prev = nullptr;
+    Request* next = nullptr;
+#endif
+  };
+
+  ThreadPool& pool_;
+  IoBackend backend_ = IoBackend::kThreads;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Request>> pending_;
+  bool stopping_ = false;
+  std::atomic<size_t> in_flight_ = 0;
+
+  template <typename F>
+  void enqueue(Op op, int fd, void* buffer, size_t length, uint64_t offset,
+               F&& on_complete) {
+    auto request = std::make_unique<Request>();
+    request->op = op;
+    request->fd = fd;
+    request->buffer = buffer;
+    request->length = length;
+    request->offset = offset;
+    request->on_complete = std::forward<F>(on_complete);
+
+    {
+      std::scoped_lock lock(mutex_);
+      if (stopping_) throw std::runtime_error("IoExecutor is shutting down");
+      pending_.push_back(std::move(request));
+      in_flight_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The reaper waits on the cv too if io_uring ever fails on it
+    cv_.notify_one();
+    wake_reaper();
+  }
+
+  void complete(std::unique_ptr<Request> request, IoResult result) {
+    std::function<void()> task = [callback = std::move(request->on_complete),
+                                  result]() { callback(result); };
+    try {
+      pool_.post_continuation(std::move(task));
+    } catch (const std::runtime_error&) {
+      // The pool shut down before queueing (task was not moved from), run
+      // the callback here rather than lose it
+      task();
+    }
+    in_flight_.fetch_sub(1, std::memory_order_release);
+  }
+
+  static IoResult run_blocking(const Request& request) {
+    for (;;) {
+      ssize_t n =
+          request.op == Op::kRead
+              ? ::pread(request.fd, request.buffer, request.length,
+                        static_cast<off_t>(request.offset))
+              : ::pwrite(request.fd, request.buffer, request.length,
+                         static_cast<off_t>(request.offset));
+      if (n >= 0) return IoResult{static_cast<size_t>(n), 0};
+      if (errno != EINTR) return IoResult{0, errno};
+    }
+  }
+
+  void blocking_loop() {
+    for (;;) {
+      std::unique_ptr<Request> request;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) return;
+        request = std::move(pending_.front());
+        pending_.pop_front();
+      }
+
+      IoResult result = run_blocking(*request);
+      complete(std::move(request), result);
+    }
+  }
+
+#if STL_HAS_IO_URING
+  static constexpr uint64_t kWakeTag = 0;
+
+  // Ring state, only touched by the reaper thread after setup
+  int ring_fd_ = -1;
+  // Written by submitters to interrupt the reaper's wait for completions
+  int wake_fd_ = -1;
+  // Set once the eventfd was written, so a burst of submissions pays for a
+  // single wake-up
+  std::atomic<bool> wake_pending_ = false;
+  unsigned sq_entries_ = 0;
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  // Requests handed to the kernel and not reaped yet, owned by this list
+  Request* in_kernel_ = nullptr;
+
+  bool setup_ring(unsigned entries) {
+    io_uring_params params{};
+    ring_fd_ =
+        static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd_ < 0) return false;
+
+    sq_entries_ = params.sq_entries;
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr ||
+        wake_fd_ < 0) {
+      teardown_ring();
+      return false;
+    }
+
+    auto* sq = static_cast<char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  void* map(size_t size, off_t offset) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  void teardown_ring() {
+    if (sqes_ != nullptr) ::munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) ::munmap(sq_ring_, sq_ring_size_);
+    sqes_ = nullptr;
+    sq_ring_ = cq_ring_ = nullptr;
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    if (ring_fd_ >= 0) ::close(ring_fd_);
+    wake_fd_ = ring_fd_ = -1;
+  }
+
+  void wake_reaper() {
+    if (wake_fd_ < 0 || wake_pending_.exchange(true)) return;
+    uint64_t one = 1;
+    while (::write(wake_fd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+  }
+
+  // Returns false when the submission ring is full
+  bool push_sqe(uint8_t opcode, int fd, uint64_t address, uint32_t length,
+                uint64_t offset, uint64_t user_data) {
+    unsigned tail = *sq_tail_;
+    unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(
+        std::memory_order_acquire);
+    if (tail - head >= sq_entries_) return false;
+
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe& sqe = sqes_[index];
+    sqe = io_uring_sqe{};
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.addr = address;
+    sqe.len = length;
+    sqe.off = offset;
+    sqe.user_data = user_data;
+    sq_array_[index] = index;
+    std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1,
+                                                std::memory_order_release);
+    return true;
+  }
+
+  bool push_request(Request& request) {
+    request.iov.iov_base = request.buffer;
+    request.iov.iov_len = request.length;
+    return push_sqe(request.op == Op::kRead ? IORING_OP_READV
+                                            : IORING_OP_WRITEV,
+                    request.fd, reinterpret_cast<uint64_t>(&request.iov), 1,
+                    request.offset, reinterpret_cast<uint64_t>(&request));
+  }
+
+  // Re-armed after every wake-up, poll requests are one-shot
+  bool arm_wake_poll() {
+    if (!push_sqe(IORING_OP_POLL_ADD, wake_fd_, 0, 0, 0, kWakeTag)) {
+      return false;
+    }
+    sqes_[(*sq_tail_ - 1) & *sq_mask_].poll_events = POLLIN;
+    return true;
+  }
+
+  void track(Request* request) noexcept {
+    request->prev = nullptr;
+    request->next = in_kernel_;
+    if (in_kernel_ != nullptr) in_kernel_->prev = request;
+    in_kernel_ = request;
+  }
+
+  std::unique_ptr<Request> untrack(Request* request) noexcept {
+    if (request->prev != nullptr) {
+      request->prev->next = request->next;
+    } else {
+      in_kernel_ = request->next;
+    }
+    if (request->next != nullptr) request->next->prev = request->prev;
+    return std::unique_ptr<Request>(request);
+  }
+
+  // Completes everything the kernel posted so far
+  void reap(unsigned& submitted, bool& poll_armed) {
+    unsigned head = *cq_head_;
+    unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(
+        std::memory_order_acquire);
+    for (; head != tail; head++) {
+      io_uring_cqe cqe = cqes_[head & *cq_mask_];
+      submitted--;
+      if (cqe.user_data == kWakeTag) {
+        poll_armed = false;
+        uint64_t count = 0;
+        (void)::read(wake_fd_, &count, sizeof(count));
+        continue;
+      }
+
+      std::unique_ptr<Request> request =
+          untrack(reinterpret_cast<Request*>(cqe.user_data));
+      IoResult result = cqe.res >= 0
+                            ? IoResult{static_cast<size_t>(cqe.res), 0}
+                            : IoResult{0, -cqe.res};
+      complete(std::move(request), result);
+    }
+    std::atomic_ref<unsigned>(*cq_head_).store(head,
+                                                std::memory_order_release);
+  }
+
+  void uring_loop() {
+    // Requests taken from pending_ that did not fit in the ring yet
+    std::deque<std::unique_ptr<Request>> backlog;
+    // Requests handed to the kernel, plus the wake-up poll
+    unsigned submitted = 0;
+    unsigned to_submit = 0;
+    bool poll_armed = false;
+
+    for (;;) {
+      bool stopping = false;
+      {
+        std::scoped_lock lock(mutex_);
+        // Cleared before draining so a submission racing with us re-wakes
+        wake_pending_.store(false, std::memory_order_relaxed);
+        while (!pending_.empty()) {
+          backlog.push_back(std::move(pending_.front()));
+          pending_.pop_front();
+        }
+        stopping = stopping_;
+      }
+
+      if (!poll_armed && arm_wake_poll()) {
+        poll_armed = true;
+        submitted++;
+        to_submit++;
+      }
+      // Keep the CQ (twice the SQ) from overflowing
+      while (!backlog.empty() && submitted < sq_entries_ &&
+             push_request(*backlog.front())) {
+        track(backlog.front().release());
+        backlog.pop_front();
+        submitted++;
+        to_submit++;
+      }
+
+      unsigned requests = submitted - (poll_armed ? 1 : 0);
+      if (stopping && requests == 0 && backlog.empty()) return;
+
+      int entered = static_cast<int>(
+          syscall(__NR_io_uring_enter, ring_fd_, to_submit, 1,
+                  IORING_ENTER_GETEVENTS, nullptr, 0));
+      if (entered >= 0) {
+        to_submit -= std::min<unsigned>(to_submit, entered);
+      } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        fall_back_to_blocking(backlog, submitted, poll_armed);
+        return;
+      }
+
+      reap(submitted, poll_armed);
+    }
+  }
+
+  // io_uring_enter failed for good. Completions already posted are
+  // delivered, requests the kernel still holds fail with ECANCELED so no
+  // callback or future is left waiting, and the backlog and every later
+  // request run as blocking calls on this thread
+  void fall_back_to_blocking(std::deque<std::unique_ptr<Request>>& backlog,
+                             unsigned& submitted, bool& poll_armed) {
+    reap(submitted, poll_armed);
+    // Pushed to the ring but never consumed by the kernel, so still ours
+    unsigned head =
+        std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+    for (unsigned tail = *sq_tail_; tail != head;) {
+      tail--;
+      uint64_t user_data = sqes_[sq_array_[tail & *sq_mask_]].user_data;
+      if (user_data != kWakeTag) {
+        backlog.push_front(untrack(reinterpret_cast<Request*>(user_data)));
+      }
+    }
+    while (in_kernel_ != nullptr) {
+      complete(untrack(in_kernel_), IoResult{0, ECANCELED});
+    }
+    for (auto& request : backlog) {
+      IoResult result = run_blocking(*request);
+      complete(std::move(request), result);
+    }
+    backlog.clear();
+    blocking_loop();
+  }
+#else
+  bool setup_ring(unsigned) { return false; }
+  void teardown_ring() {}
+  void wake_reaper() {}
+  void uring_loop() {}
+#endif
+};
+
+}  // namespace stl
@@ -6,30 +6,36 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <concepts>
 #include <cstddef>
 #include <utility>
 
-constexpr uint kCacheLineSize = 64;
+#include "stl/cache_line.h"
 
 namespace stl {
-template <typename T, size_t Capacity>
+// Cells and indices are padded to Alignment. The cache line default keeps
+// producers and consumers off each other's lines; a smaller value packs the
+// queue tightly for programs holding very many mostly idle queues
+template <typename T, size_t Capacity, size_t Alignment = kCacheLineSize>
 class LockFreeQueue {
   // Performance reasons -> modulo operation compiles to a single AND operation
   static_assert((Capacity & (Capacity - 1)) == 0,
                 "Capacity must be power of 2");
   static constexpr size_t MASK = Capacity - 1;
+  static constexpr size_t kAlignment =
+      std::max({Alignment, alignof(std::atomic<size_t>), alignof(T)});
 
  private:
-  struct alignas(kCacheLineSize) Cell {
+  struct alignas(kAlignment) Cell {
     std::atomic<size_t> seq;
     T data;
   };
-  alignas(kCacheLineSize) std::array<Cell, Capacity> buffer_;
-  alignas(kCacheLineSize) std::atomic<size_t> enqueue_index_ = 0;
-  alignas(kCacheLineSize) std::atomic<size_t> dequeue_index_ = 0;
+  alignas(kAlignment) std::array<Cell, Capacity> buffer_;
+  alignas(kAlignment) std::atomic<size_t> enqueue_index_ = 0;
+  alignas(kAlignment) std::atomic<size_t> dequeue_index_ = 0;
 
  public:
   LockFreeQueue() {
@@ -108,6 +114,13 @@ class LockFreeQueue {
 
     return true;
   }
+
+  // True once every claimed slot has been popped. Unlike a failed try_pop,
+  // a push still writing its item counts as non-empty
+  [[nodiscard]] bool empty() const noexcept {
+    return enqueue_index_.load(std::memory_order_acquire) ==
+           dequeue_index_.load(std::memory_order_acquire);
+  }
 };
 
 }  // namespace stl
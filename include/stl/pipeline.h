@@ -0,0 +1,261 @@
+/**
+ * @file pipeline.h
+ * @brief Implementation of token-based parallel pipeline on ThreadPool
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "stl/lock_free_queue.h"
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+enum class StageMode {
+  kSerialInOrder,     // One token at a time, in the order the source made them
+  kSerialOutOfOrder,  // One token at a time, in arrival order
+  kParallel,          // Any number of tokens at once
+};
+
+// Linear pipeline in the style of TBB's parallel_pipeline. A source running on
+// the calling thread fills tokens, which then flow through each stage in turn
+// and are recycled after the last one. At most MaxTokens items are in flight,
+// which bounds both memory and the reorder window of in-order stages.
+// Stages hand tokens to each other through LockFreeQueues and run as tasks on
+// a ThreadPool; a serial stage is only scheduled when it goes from idle to
+// busy, like a Strand.
+template <typename T, size_t MaxTokens = 64>
+class Pipeline {
+  static_assert((MaxTokens & (MaxTokens - 1)) == 0,
+                "MaxTokens must be power of 2");
+
+ public:
+  explicit Pipeline(ThreadPool& pool) : pool_(pool), tokens_(MaxTokens) {}
+
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator=(const Pipeline&) = delete;
+
+  // Appends a stage transforming each token in place through f(T&)
+  template <typename F>
+  Pipeline& add_stage(StageMode mode, F&& f) {
+    auto stage = std::make_unique<Stage>();
+    stage->mode = mode;
+    stage->fn = std::forward<F>(f);
+    stages_.push_back(std::move(stage));
+    return *this;
+  }
+
+  // Pulls items with source(T&) until it returns false, then waits for every
+  // token to leave the last stage. Returns the number of items processed.
+  // The first exception thrown by a stage stops the source and is rethrown
+  // here once the pipeline has drained
+  template <typename Source>
+  size_t run(Source&& source, size_t max_in_flight = MaxTokens) {
+    if (max_in_flight == 0 || max_in_flight > MaxTokens) {
+      max_in_flight = MaxTokens;
+    }
+    reset(max_in_flight);
+
+    size_t seq = 0;
+    for (;;) {
+      // help_until() may evaluate the predicate again after it held, so a
+      // popped token is kept rather than popped afresh each time
+      size_t token = kNoToken;
+      wait_until([&]() {
+        if (token == kNoToken) {
+          size_t popped = 0;
+          if (free_.try_pop(popped)) token = popped;
+        }
+        return token != kNoToken ||
+               error_flag_.load(std::memory_order_acquire);
+      });
+      if (error_flag_.load(std::memory_order_acquire)) {
+        if (token != kNoToken) free_.try_push(token);
+        break;
+      }
+
+      try {
+        if (!source(tokens_[token].value)) {
+          free_.try_push(token);
+          break;
+        }
+      } catch (...) {
+        free_.try_push(token);
+        record_error(std::current_exception());
+        break;
+      }
+
+      tokens_[token].seq = seq++;
+      tokens_[token].failed = false;
+      in_flight_.fetch_add(1, std::memory_order_relaxed);
+      deliver(0, token);
+    }
+
+    wait_until(
+        [this]() { return in_flight_.load(std::memory_order_acquire) == 0; });
+
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    return seq;
+  }
+
+  [[nodiscard]] size_t num_stages() const noexcept { return stages_.size(); }
+
+ private:
+  struct Token {
+    T value{};
+    size_t seq = 0;
+    // Once a stage threw, later stages pass the token through untouched so
+    // in-order stages downstream still see every sequence number
+    bool failed = false;
+  };
+
+  struct Stage {
+    StageMode mode = StageMode::kParallel;
+    std::function<void(T&)> fn;
+    LockFreeQueue<size_t, MaxTokens> input;
+    // Serial stages: tokens queued but not yet taken by the running drain
+    std::atomic<size_t> pending = 0;
+    // In-order stages: next sequence number to process and tokens that
+    // arrived early, indexed by seq % MaxTokens
+    size_t next_seq = 0;
+    std::vector<size_t> reorder = std::vector<size_t>(MaxTokens, kNoToken);
+  };
+
+  static constexpr size_t kNoToken = static_cast<size_t>(-1);
+
+  ThreadPool& pool_;
+  std::vector<Token> tokens_;
+  std::vector<std::unique_ptr<Stage>> stages_;
+  LockFreeQueue<size_t, MaxTokens> free_;
+  alignas(kCacheLineSize) std::atomic<size_t> in_flight_ = 0;
+  std::atomic<bool> error_flag_ = false;
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+
+  void reset(size_t max_in_flight) {
+    size_t token = 0;
+    while (free_.try_pop(token)) {
+    }
+    for (size_t i = 0; i < max_in_flight; i++) free_.try_push(i);
+
+    for (auto& stage : stages_) {
+      stage->next_seq = 0;
+      std::fill(stage->reorder.begin(), stage->reorder.end(), kNoToken);
+    }
+    error_flag_.store(false, std::memory_order_relaxed);
+  }
+
+  // A worker calling run() keeps executing pool tasks while it waits, an
+  // outside thread sleeps on in_flight_, which every retired token bumps
+  template <typename Predicate>
+  void wait_until(Predicate done) {
+    if (pool_.is_worker_thread()) {
+      pool_.help_until(done);
+      return;
+    }
+
+    for (;;) {
+      size_t observed = in_flight_.load(std::memory_order_acquire);
+      if (done()) return;
+      in_flight_.wait(observed, std::memory_order_acquire);
+    }
+  }
+
+  void deliver(size_t stage_index, size_t token) {
+    if (stage_index == stages_.size()) {
+      retire(token);
+      return;
+    }
+
+    Stage& stage = *stages_[stage_index];
+    // Cannot fail: never more than MaxTokens tokens exist
+    stage.input.try_push(token);
+
+    if (stage.mode == StageMode::kParallel) {
+      pool_.post_continuation(
+          [this, stage_index]() { run_parallel(stage_index); });
+    } else if (stage.pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+      pool_.post_continuation(
+          [this, stage_index]() { drain_serial(stage_index); });
+    }
+  }
+
+  // Every parallel task owns exactly one queued token, though not
+  // necessarily the one its delivery pushed
+  void run_parallel(size_t stage_index) {
+    size_t token = pop(*stages_[stage_index]);
+    process(stage_index, token);
+    deliver(stage_index + 1, token);
+  }
+
+  void drain_serial(size_t stage_index) {
+    Stage& stage = *stages_[stage_index];
+
+    do {
+      size_t token = pop(stage);
+
+      if (stage.mode == StageMode::kSerialOutOfOrder) {
+        process(stage_index, token);
+        deliver(stage_index + 1, token);
+        continue;
+      }
+
+      stage.reorder[tokens_[token].seq & (MaxTokens - 1)] = token;
+      for (;;) {
+        size_t& slot = stage.reorder[stage.next_seq & (MaxTokens - 1)];
+        if (slot == kNoToken) break;
+
+        size_t ready = std::exchange(slot, kNoToken);
+        stage.next_seq++;
+        process(stage_index, ready);
+        deliver(stage_index + 1, ready);
+      }
+    } while (stage.pending.fetch_sub(1, std::memory_order_acq_rel) != 1);
+  }
+
+  // A push racing ahead of us may make try_pop miss briefly
+  static size_t pop(Stage& stage) {
+    size_t token = 0;
+    while (!stage.input.try_pop(token)) std::this_thread::yield();
+    return token;
+  }
+
+  void process(size_t stage_index, size_t token) {
+    Token& slot = tokens_[token];
+    if (slot.failed) return;
+
+    try {
+      stages_[stage_index]->fn(slot.value);
+    } catch (...) {
+      slot.failed = true;
+      record_error(std::current_exception());
+    }
+  }
+
+  void record_error(std::exception_ptr error) {
+    {
+      std::scoped_lock lock(error_mutex_);
+      if (!error_) error_ = std::move(error);
+    }
+    // The failed token still retires, which wakes a waiting source
+    error_flag_.store(true, std::memory_order_release);
+  }
+
+  void retire(size_t token) {
+    free_.try_push(token);
+    in_flight_.fetch_sub(1, std::memory_order_acq_rel);
+    in_flight_.notify_all();
+  }
+};
+
+}  // namespace stl
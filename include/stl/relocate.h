@@ -0,0 +1,43 @@
+/**
+ * @file relocate.h
+ * @brief Moving objects to new storage and ending them at the old
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stl {
+
+// Types whose objects can be moved to new storage by copying their bytes,
+// with the old bytes then simply forgotten. Specialise for types such as
+// owning handles that are not trivially copyable but do not point into
+// themselves
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// Moves count objects from from to the raw storage at to, leaving from as
+// raw storage. The ranges may overlap, as when shifting within an array
+template <typename T>
+void relocate(T* from, size_t count, T* to) noexcept {
+  if (count == 0 || from == to) return;
+  if constexpr (is_trivially_relocatable<T>::value) {
+    std::memmove(static_cast<void*>(to), from, sizeof(T) * count);
+  } else if (to < from) {
+    for (size_t i = 0; i < count; i++) {
+      new (to + i) T(std::move(from[i]));
+      from[i].~T();
+    }
+  } else {
+    for (size_t i = count; i-- > 0;) {
+      new (to + i) T(std::move(from[i]));
+      from[i].~T();
+    }
+  }
+}
+
+}  // namespace stl
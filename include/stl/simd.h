@@ -0,0 +1,43 @@
+/**
+ * @file simd.h
+ * @brief Runtime detection of the SIMD instruction sets kernels target
+ */
+
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STL_SIMD_X86 1
+#endif
+
+namespace stl {
+
+// Instruction sets the vector kernels are built for, picked once at
+// runtime from what the CPU supports
+enum class SimdLevel { kScalar, kSse2, kSse42, kAvx2 };
+
+namespace detail {
+
+inline SimdLevel detect_simd_level() noexcept {
+#if defined(STL_SIMD_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+    return SimdLevel::kSse42;
+  }
+  return SimdLevel::kSse2;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+}  // namespace detail
+
+inline SimdLevel simd_level() noexcept {
+  static const SimdLevel level = detail::detect_simd_level();
+  return level;
+}
+
+}  // namespace stl
@@ -0,0 +1,216 @@
+/**
+ * @file strand.h
+ * @brief Implementation of strand (serial executor) on top of ThreadPool
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stl/cache_line.h"
+#include "stl/hash.h"
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+// Runs posted tasks one at a time in FIFO order on whichever ThreadPool worker
+// is free, so state touched only from a strand needs no mutex. Pending tasks
+// sit in a lock-free MPSC list; the strand is only handed to the pool when it
+// goes from idle to busy, and keeps running until its list is drained.
+// Scheduling bypasses a bounded pool's capacity and kDropOldest never evicts
+// the queued runner, since dropping or rejecting it would strand every task
+// behind it. Once the pool is
+// shut down and refuses to take the strand back, posted tasks still run, in
+// order: a batch carries on on its worker rather than yielding, and a post()
+// that finds the strand idle runs it on the calling thread.
+class Strand {
+ public:
+  explicit Strand(ThreadPool& pool)
+      : pool_(pool), head_(&stub_), tail_(&stub_) {}
+
+  Strand(const Strand&) = delete;
+  Strand& operator=(const Strand&) = delete;
+
+  // Waits for queued tasks, the pool must outlive the strand
+  ~Strand() {
+    while (pending_.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  // The task must not throw, use submit() for that
+  template <typename F>
+  void post(F&& f) {
+    push(new Node(std::forward<F>(f)));
+
+    // Only the transition from idle schedules the strand
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0 &&
+        !pool_.try_post_continuation([this]() { run(); })) {
+      run();
+    }
+  }
+
+  template <typename F, typename... Args>
+  auto submit(F&& f, Args&&... args) -> std::future<
+      std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
+    using return_type =
+        std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+    auto task = std::make_shared<std::packaged_task<return_type()>>(
+        [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(
+                                     args)...)]() mutable -> return_type {
+          return std::apply(f, std::move(args));
+        });
+
+    auto future = task->get_future();
+    post([task]() { (*task)(); });
+    return future;
+  }
+
+  // True inside a task currently being run by this strand
+  [[nodiscard]] bool running_in_this_thread() const noexcept {
+    return current_strand_ == this;
+  }
+
+  // Tasks posted but not yet finished
+  [[nodiscard]] size_t pending() const noexcept {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    template <typename F>
+    explicit Node(F&& f) : task(std::forward<F>(f)) {}
+
+    std::function<void()> task;
+    std::atomic<Node*> next = nullptr;
+  };
+
+  // After this many tasks the strand yields its worker to other work and
+  // re-queues itself at the back of the pool
+  static constexpr size_t kMaxBatch = 64;
+
+  static inline thread_local const Strand* current_strand_ = nullptr;
+
+  ThreadPool& pool_;
+  Node stub_;
+  // Producers swap themselves in at head_, the single consumer follows tail_
+  alignas(kCacheLineSize) std::atomic<Node*> head_;
+  alignas(kCacheLineSize) Node* tail_;
+  alignas(kCacheLineSize) std::atomic<size_t> pending_ = 0;
+
+  // Vyukov intrusive MPSC queue: one exchange per push, no CAS loop
+  void push(Node* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  // Single consumer. Returns nullptr if the queue is empty or a producer is
+  // between its exchange and linking the node in
+  Node* pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+      if (next == nullptr) return nullptr;
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+
+    // Last node: put the stub back behind it so it can be detached
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+  void run() {
+    const Strand* previous = current_strand_;
+    current_strand_ = this;
+
+    for (size_t executed = 0;; executed++) {
+      // Still non-empty, so nobody else will schedule us
+      if (executed == kMaxBatch &&
+          pool_.try_post_continuation([this]() { run(); })) {
+        current_strand_ = previous;
+        return;
+      }
+
+      Node* node = pop();
+      while (node == nullptr) {
+        // pending_ counted a task whose producer has not linked it yet
+        std::this_thread::yield();
+        node = pop();
+      }
+
+      node->task();
+      delete node;
+
+      if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) break;
+    }
+
+    current_strand_ = previous;
+  }
+};
+
+// Fixed set of strands that keys are hashed onto, e.g. one per connection
+// id. Equal keys always share a strand, so their tasks stay ordered
+template <typename Key, typename Hash = stl::Hash<Key>>
+class StrandMap {
+ public:
+  StrandMap(ThreadPool& pool, size_t num_strands) {
+    if (num_strands == 0) {
+      throw std::invalid_argument("StrandMap num_strands must be > 0");
+    }
+    strands_.reserve(num_strands);
+    for (size_t i = 0; i < num_strands; i++) {
+      strands_.push_back(std::make_unique<Strand>(pool));
+    }
+  }
+
+  Strand& strand_for(const Key& key) {
+    return *strands_[hash_(key) % strands_.size()];
+  }
+
+  template <typename F>
+  void post(const Key& key, F&& f) {
+    strand_for(key).post(std::forward<F>(f));
+  }
+
+  template <typename F, typename... Args>
+  auto submit(const Key& key, F&& f, Args&&... args) {
+    return strand_for(key).submit(std::forward<F>(f),
+                                  std::forward<Args>(args)...);
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return strands_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<Strand>> strands_;
+  Hash hash_;
+};
+
+}  // namespace stl
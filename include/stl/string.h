@@ -0,0 +1,363 @@
+/**
+ * @file string.h
+ * @brief Implementation of string with small string optimization (SSO)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace stl {
+
+// Byte string in 24 bytes that keeps up to 23 chars inline, so short keys
+// never allocate. Inline, the last byte holds 23 - size: it is zero exactly
+// when the string is full, and then doubles as the terminator. On the heap
+// the three words are pointer, size and capacity, with the capacity's top
+// bit set, which on little-endian lands in that same last byte. The heap
+// buffer grows like Vector, to at least twice its capacity, and always
+// keeps a terminator after size() chars
+class String {
+ public:
+  static constexpr size_t kInlineCapacity = 23;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  using value_type = char;
+  using iterator = char*;
+  using const_iterator = const char*;
+
+  String() noexcept { set_inline_size(0); }
+
+  String(const char* s) : String(std::string_view(s)) {}
+
+  String(const char* s, size_t count) : String(std::string_view(s, count)) {}
+
+  explicit String(std::string_view text) {
+    init(text.size());
+    std::memcpy(data(), text.data(), text.size());
+  }
+
+  String(size_t count, char c) {
+    init(count);
+    std::memset(data(), c, count);
+  }
+
+  ~String() noexcept {
+    if (is_heap()) std::free(heap_data());
+  }
+
+  String(const String& other) {
+    if (!other.is_heap()) {
+      std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+      return;
+    }
+    init(other.size());
+    std::memcpy(data(), other.data(), other.size());
+  }
+
+  String(String&& other) noexcept {
+    std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+    other.set_inline_size(0);
+  }
+
+  void swap(String& other) noexcept {
+    char tmp[sizeof(bytes_)];
+    std::memcpy(tmp, bytes_, sizeof(bytes_));
+    std::memcpy(bytes_, other.bytes_, sizeof(bytes_));
+    std::memcpy(other.bytes_, tmp, sizeof(bytes_));
+  }
+
+  friend void swap(String& lhs, String& rhs) noexcept { lhs.swap(rhs); }
+
+  // Reuses the existing buffer when it is large enough
+  String& operator=(const String& other) {
+    if (this != &other) assign(other);
+    return *this;
+  }
+
+  String& operator=(String&& other) noexcept {
+    String copy(std::move(other));
+    copy.swap(*this);
+    return *this;
+  }
+
+  String& operator=(std::string_view text) { return assign(text); }
+  String& operator=(const char* s) { return assign(std::string_view(s)); }
+
+  String& assign(std::string_view text) {
+    if (text.size() > capacity()) {
+      // text may point into this string, so copy before releasing
+      String fresh(text);
+      fresh.swap(*this);
+      return *this;
+    }
+    std::memmove(data(), text.data(), text.size());
+    set_size(text.size());
+    return *this;
+  }
+
+  [[nodiscard]] size_t size() const noexcept {
+    return is_heap() ? heap_size() : kInlineCapacity - inline_remaining();
+  }
+  [[nodiscard]] size_t length() const noexcept { return size(); }
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] size_t capacity() const noexcept {
+    return is_heap() ? heap_capacity() : kInlineCapacity;
+  }
+
+  // True while the chars live inside the object itself
+  [[nodiscard]] bool is_inline() const noexcept { return !is_heap(); }
+
+  char* data() noexcept { return is_heap() ? heap_data() : bytes_; }
+  const char* data() const noexcept {
+    return is_heap() ? heap_data() : bytes_;
+  }
+  const char* c_str() const noexcept { return data(); }
+
+  char& operator[](size_t index) noexcept { return data()[index]; }
+  const char& operator[](size_t index) const noexcept {
+    return data()[index];
+  }
+
+  char& at(size_t index) {
+    if (index >= size()) throw std::out_of_range("String::at");
+    return data()[index];
+  }
+  const char& at(size_t index) const {
+    if (index >= size()) throw std::out_of_range("String::at");
+    return data()[index];
+  }
+
+  char& front() noexcept { return data()[0]; }
+  const char& front() const noexcept { return data()[0]; }
+  char& back() noexcept { return data()[size() - 1]; }
+  const char& back() const noexcept { return data()[size() - 1]; }
+
+  iterator begin() noexcept { return data(); }
+  const_iterator begin() const noexcept { return data(); }
+  iterator end() noexcept { return data() + size(); }
+  const_iterator end() const noexcept { return data() + size(); }
+
+  operator std::string_view() const noexcept { return {data(), size()}; }
+
+  // Capacity becomes exactly new_capacity if that is larger
+  void reserve(size_t new_capacity) {
+    if (new_capacity > capacity()) reallocate(new_capacity);
+  }
+
+  // Moves back inline, or to an exactly sized buffer
+  void shrink_to_fit() {
+    if (!is_heap() || heap_size() == heap_capacity()) return;
+    String fresh(std::string_view(*this));
+    fresh.swap(*this);
+  }
+
+  void clear() noexcept { set_size(0); }
+
+  String& append(const char* s, size_t count) {
+    size_t old_size = size();
+    if (count > capacity() - old_size) {
+      // s may point into this string, so it is copied before the old
+      // buffer goes
+      size_t new_size = old_size + count;
+      size_t new_capacity = grown_capacity(new_size);
+      char* fresh = allocate(new_capacity);
+      std::memcpy(fresh, data(), old_size);
+      std::memcpy(fresh + old_size, s, count);
+      fresh[new_size] = '\0';
+      if (is_heap()) std::free(heap_data());
+      set_heap(fresh, new_size, new_capacity);
+      return *this;
+    }
+    std::memmove(data() + old_size, s, count);
+    set_size(old_size + count);
+    return *this;
+  }
+
+  String& append(std::string_view text) {
+    return append(text.data(), text.size());
+  }
+
+  String& append(size_t count, char c) {
+    size_t old_size = size();
+    resize_for_overwrite(old_size + count);
+    std::memset(data() + old_size, c, count);
+    return *this;
+  }
+
+  String& operator+=(std::string_view text) { return append(text); }
+  String& operator+=(const char* s) { return append(std::string_view(s)); }
+  String& operator+=(char c) {
+    push_back(c);
+    return *this;
+  }
+
+  void push_back(char c) {
+    size_t old_size = size();
+    if (old_size == capacity()) reallocate(grown_capacity(old_size + 1));
+    data()[old_size] = c;
+    set_size(old_size + 1);
+  }
+
+  void pop_back() noexcept { set_size(size() - 1); }
+
+  void resize(size_t new_size, char c = '\0') {
+    size_t old_size = size();
+    if (new_size > old_size) {
+      append(new_size - old_size, c);
+    } else {
+      set_size(new_size);
+    }
+  }
+
+  // Like resize() but leaves any new chars uninitialized, for callers that
+  // are about to write them through data(), e.g. from read() or a formatter
+  void resize_for_overwrite(size_t new_size) {
+    if (new_size > capacity()) reallocate(grown_capacity(new_size));
+    set_size(new_size);
+  }
+
+  [[nodiscard]] String substr(size_t pos, size_t count = npos) const {
+    if (pos > size()) throw std::out_of_range("String::substr");
+    return String(std::string_view(*this).substr(pos, count));
+  }
+
+  // String == String resolves to these too, preferring the unreversed form
+  friend bool operator==(const String& lhs, std::string_view rhs) noexcept {
+    return std::string_view(lhs) == rhs;
+  }
+  friend std::strong_ordering operator<=>(const String& lhs,
+                                          std::string_view rhs) noexcept {
+    return std::string_view(lhs) <=> rhs;
+  }
+
+  friend String operator+(const String& lhs, const String& rhs) {
+    return concat(lhs, rhs);
+  }
+  friend String operator+(const String& lhs, std::string_view rhs) {
+    return concat(lhs, rhs);
+  }
+  friend String operator+(std::string_view lhs, const String& rhs) {
+    return concat(lhs, rhs);
+  }
+  friend String operator+(const String& lhs, const char* rhs) {
+    return concat(lhs, rhs);
+  }
+  friend String operator+(const char* lhs, const String& rhs) {
+    return concat(lhs, rhs);
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const String& s) {
+    return os << std::string_view(s);
+  }
+
+ private:
+  static_assert(std::endian::native == std::endian::little,
+                "String keeps its heap flag in the capacity's top byte");
+
+  static constexpr uint64_t kHeapFlag = uint64_t{1} << 63;
+  static constexpr size_t kLastByte = sizeof(uint64_t) * 3 - 1;
+
+  alignas(uint64_t) char bytes_[kInlineCapacity + 1];
+
+  bool is_heap() const noexcept {
+    return static_cast<unsigned char>(bytes_[kLastByte]) & 0x80;
+  }
+
+  size_t inline_remaining() const noexcept {
+    return static_cast<unsigned char>(bytes_[kLastByte]);
+  }
+
+  // The heap words are copied in and out, since the same bytes hold chars
+  // when inline
+  uint64_t word(size_t index) const noexcept {
+    uint64_t value;
+    std::memcpy(&value, bytes_ + index * sizeof(uint64_t), sizeof(value));
+    return value;
+  }
+
+  void set_word(size_t index, uint64_t value) noexcept {
+    std::memcpy(bytes_ + index * sizeof(uint64_t), &value, sizeof(value));
+  }
+
+  char* heap_data() const noexcept {
+    char* data;
+    std::memcpy(&data, bytes_, sizeof(data));
+    return data;
+  }
+  size_t heap_size() const noexcept { return word(1); }
+  size_t heap_capacity() const noexcept { return word(2) & ~kHeapFlag; }
+
+  void set_heap(char* data, size_t size, size_t capacity) noexcept {
+    std::memcpy(bytes_, &data, sizeof(data));
+    set_word(1, size);
+    set_word(2, capacity | kHeapFlag);
+  }
+
+  void set_inline_size(size_t size) noexcept {
+    bytes_[size] = '\0';
+    bytes_[kLastByte] = static_cast<char>(kInlineCapacity - size);
+  }
+
+  void set_size(size_t size) noexcept {
+    if (is_heap()) {
+      set_word(1, size);
+      heap_data()[size] = '\0';
+    } else {
+      set_inline_size(size);
+    }
+  }
+
+  size_t grown_capacity(size_t needed) const noexcept {
+    return std::max(needed, 2 * capacity());
+  }
+
+  // One extra byte for the terminator
+  static char* allocate(size_t capacity) {
+    if (capacity >= kHeapFlag) throw std::bad_alloc();
+    auto* data = static_cast<char*>(std::malloc(capacity + 1));
+    if (data == nullptr) throw std::bad_alloc();
+    return data;
+  }
+
+  // Uninitialized storage for size chars plus the terminator
+  void init(size_t size) {
+    if (size <= kInlineCapacity) {
+      set_inline_size(size);
+    } else {
+      set_heap(allocate(size), size, size);
+      heap_data()[size] = '\0';
+    }
+  }
+
+  static String concat(std::string_view lhs, std::string_view rhs) {
+    String result;
+    result.reserve(lhs.size() + rhs.size());
+    result.append(lhs).append(rhs);
+    return result;
+  }
+
+  void reallocate(size_t new_capacity) {
+    size_t old_size = size();
+    char* fresh = allocate(new_capacity);
+    // Including the terminator
+    std::memcpy(fresh, data(), old_size + 1);
+    if (is_heap()) std::free(heap_data());
+    set_heap(fresh, old_size, new_capacity);
+  }
+};
+
+static_assert(sizeof(String) == 24);
+
+}  // namespace stl
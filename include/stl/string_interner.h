@@ -0,0 +1,258 @@
+/**
+ * @file string_interner.h
+ * @brief Implementation of thread-safe string interning to 32-bit atoms
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stl/arena.h"
+#include "stl/cache_line.h"
+#include "stl/hash.h"
+#include "stl/hash_map.h"
+
+namespace stl {
+
+// Handle to an interned string. Two atoms from the same interner are equal
+// exactly when their strings are, so comparing and hashing them is O(1)
+class Atom {
+ public:
+  static constexpr uint32_t kInvalidId = UINT32_MAX;
+
+  constexpr Atom() noexcept = default;
+  constexpr explicit Atom(uint32_t id) noexcept : id_(id) {}
+
+  [[nodiscard]] constexpr uint32_t id() const noexcept { return id_; }
+  [[nodiscard]] constexpr bool valid() const noexcept {
+    return id_ != kInvalidId;
+  }
+
+  friend constexpr bool operator==(Atom, Atom) noexcept = default;
+  friend constexpr auto operator<=>(Atom, Atom) noexcept = default;
+
+  friend size_t hash_value(Atom atom) noexcept { return atom.id_; }
+
+ private:
+  uint32_t id_ = kInvalidId;
+};
+
+// Maps strings to Atoms, storing each distinct string once. Strings are
+// copied into per-shard arena blocks, length-prefixed and terminated, and
+// never move, so view() stays valid for the interner's lifetime. A shard,
+// picked by the top bits of the string's hash, owns a HashMap from string
+// to atom behind a reader-writer lock, so interning a string already seen
+// only takes a shared lock, and threads interning new strings contend only
+// when they land on the same shard. The atom's low bits name the shard and
+// the rest index that shard's table of string pointers, which grows in
+// chunks of doubling size that never move, so view() takes no lock
+class StringInterner {
+ public:
+  static constexpr size_t kDefaultShards = 16;
+  static constexpr size_t kMaxShards = 256;
+
+  // The shard count is rounded up to a power of two
+  explicit StringInterner(size_t num_shards = kDefaultShards)
+      : shard_bits_(std::bit_width(std::bit_ceil(std::max<size_t>(
+                        num_shards, 1))) -
+                    1),
+        shards_(size_t{1} << shard_bits_) {
+    if (shards_.size() > kMaxShards) {
+      throw std::invalid_argument("StringInterner: too many shards");
+    }
+  }
+
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+
+  ~StringInterner() noexcept {
+    for (Shard& shard : shards_) {
+      for (auto& chunk : shard.chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Thread-safe. Strings are limited to 4 GB
+  Atom intern(std::string_view text) {
+    if (text.size() > UINT32_MAX) {
+      throw std::invalid_argument("StringInterner: string too long");
+    }
+    HashedView key{text, Hash<std::string_view>{}(text)};
+    size_t shard_index = shard_of(key.hash);
+    Shard& shard = shards_[shard_index];
+
+    {
+      std::shared_lock lock(shard.mutex);
+      auto it = shard.map.find(key);
+      if (it != shard.map.end()) return Atom(it->second);
+    }
+
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) return Atom(it->second);
+
+    uint32_t local = shard.count.load(std::memory_order_relaxed);
+    if (local >= max_per_shard()) {
+      throw std::runtime_error("StringInterner: atom space exhausted");
+    }
+
+    const char* stored = store(shard, text);
+    publish_entry(shard, local, stored);
+    uint32_t id = (local << shard_bits_) | static_cast<uint32_t>(shard_index);
+    shard.map.try_emplace(HashedView{{stored, text.size()}, key.hash}, id);
+    shard.count.store(local + 1, std::memory_order_relaxed);
+    return Atom(id);
+  }
+
+  // The atom for text if it was interned, without interning it
+  [[nodiscard]] std::optional<Atom> find(std::string_view text) const {
+    HashedView key{text, Hash<std::string_view>{}(text)};
+    const Shard& shard = shards_[shard_of(key.hash)];
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) return std::nullopt;
+    return Atom(it->second);
+  }
+
+  // atom must come from this interner
+  [[nodiscard]] std::string_view view(Atom atom) const noexcept {
+    const char* data = c_str(atom);
+    uint32_t size;
+    std::memcpy(&size, data - sizeof(size), sizeof(size));
+    return {data, size};
+  }
+
+  [[nodiscard]] const char* c_str(Atom atom) const noexcept {
+    return entry(shards_[atom.id() & (shards_.size() - 1)],
+                 atom.id() >> shard_bits_);
+  }
+
+  // Distinct strings interned so far
+  [[nodiscard]] size_t size() const noexcept {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+      total += shard.count.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  [[nodiscard]] size_t num_shards() const noexcept { return shards_.size(); }
+
+  // Arena, string tables and hash maps, including unused capacity
+  [[nodiscard]] size_t memory_usage() const {
+    size_t total = sizeof(*this) + shards_.size() * sizeof(Shard);
+    for (const Shard& shard : shards_) {
+      std::shared_lock lock(shard.mutex);
+      total += shard.arena.capacity();
+      total += shard.map.capacity() *
+               (sizeof(std::pair<const HashedView, uint32_t>) + 1);
+      for (size_t k = 0; k < kMaxChunks; k++) {
+        if (shard.chunks[k].load(std::memory_order_relaxed) != nullptr) {
+          total += chunk_size(k) * sizeof(const char*);
+        }
+      }
+    }
+    return total;
+  }
+
+ private:
+  static constexpr size_t kFirstChunkBits = 8;
+  static constexpr size_t kMaxChunks = 32 - kFirstChunkBits + 1;
+  static constexpr size_t kArenaBlockSize = 64 * 1024;
+
+  // The hash is computed once per intern() and carried with the key
+  struct HashedView {
+    std::string_view text;
+    size_t hash;
+  };
+
+  struct HashedViewHash {
+    using is_avalanching = void;
+    size_t operator()(const HashedView& key) const noexcept {
+      return key.hash;
+    }
+  };
+
+  struct HashedViewEq {
+    bool operator()(const HashedView& lhs,
+                    const HashedView& rhs) const noexcept {
+      return lhs.hash == rhs.hash && lhs.text == rhs.text;
+    }
+  };
+
+  struct alignas(kCacheLineSize) Shard {
+    mutable std::shared_mutex mutex;
+    HashMap<HashedView, uint32_t, HashedViewHash, HashedViewEq> map;
+    MonotonicArena arena{kArenaBlockSize};
+    // Chunk k holds 2^(kFirstChunkBits + k) string pointers
+    std::array<std::atomic<const char**>, kMaxChunks> chunks{};
+    std::atomic<uint32_t> count = 0;
+  };
+
+  size_t shard_bits_;
+  std::vector<Shard> shards_;
+
+  size_t shard_of(size_t hash) const noexcept {
+    return shard_bits_ == 0 ? 0 : hash >> (64 - shard_bits_);
+  }
+
+  // Local indices leave Atom::kInvalidId unused
+  uint32_t max_per_shard() const noexcept {
+    return static_cast<uint32_t>((uint64_t{1} << (32 - shard_bits_)) - 1);
+  }
+
+  static constexpr size_t chunk_size(size_t k) noexcept {
+    return size_t{1} << (kFirstChunkBits + k);
+  }
+
+  // Chunk k starts at local index 2^kFirstChunkBits * (2^k - 1)
+  static std::pair<size_t, size_t> chunk_of(uint32_t local) noexcept {
+    size_t k = std::bit_width((size_t{local} >> kFirstChunkBits) + 1) - 1;
+    return {k, local - (((size_t{1} << k) - 1) << kFirstChunkBits)};
+  }
+
+  static const char* entry(const Shard& shard, uint32_t local) noexcept {
+    auto [k, offset] = chunk_of(local);
+    return shard.chunks[k].load(std::memory_order_acquire)[offset];
+  }
+
+  // Called with the shard's lock held exclusively
+  static void publish_entry(Shard& shard, uint32_t local, const char* data) {
+    auto [k, offset] = chunk_of(local);
+    const char** chunk = shard.chunks[k].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      chunk = new const char*[chunk_size(k)];
+      shard.chunks[k].store(chunk, std::memory_order_release);
+    }
+    chunk[offset] = data;
+  }
+
+  // Length prefix, the chars, then a terminator
+  static const char* store(Shard& shard, std::string_view text) {
+    uint32_t size = static_cast<uint32_t>(text.size());
+    auto* block = static_cast<char*>(shard.arena.allocate(
+        sizeof(size) + text.size() + 1, alignof(uint32_t)));
+    std::memcpy(block, &size, sizeof(size));
+    std::memcpy(block + sizeof(size), text.data(), text.size());
+    block[sizeof(size) + text.size()] = '\0';
+    return block + sizeof(size);
+  }
+};
+
+}  // namespace stl
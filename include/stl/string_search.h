@@ -0,0 +1,426 @@
+/**
+ * @file string_search.h
+ * @brief Implementation of SIMD delimiter search and zero-copy tokenizing
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include "stl/simd.h"
+#include "stl/vector.h"
+
+namespace stl {
+
+// Up to 256 distinct delimiter bytes: a bitmap for the scalar path and,
+// for sets of up to kMaxSimd, the bytes themselves for the vector paths
+class DelimiterSet {
+ public:
+  static constexpr size_t kMaxSimd = 16;
+
+  explicit DelimiterSet(std::string_view delimiters) noexcept {
+    for (char c : delimiters) add(c);
+  }
+
+  explicit DelimiterSet(char delimiter) noexcept { add(delimiter); }
+
+  [[nodiscard]] bool contains(char c) const noexcept {
+    auto byte = static_cast<unsigned char>(c);
+    return (bitmap_[byte / 64] >> (byte % 64)) & 1;
+  }
+
+  // Distinct delimiters
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+
+  // The delimiters themselves, valid only when size() <= kMaxSimd
+  [[nodiscard]] const char* bytes() const noexcept { return bytes_.data(); }
+
+ private:
+  std::array<uint64_t, 4> bitmap_{};
+  std::array<char, kMaxSimd> bytes_{};
+  size_t size_ = 0;
+
+  void add(char c) noexcept {
+    if (contains(c)) return;
+    auto byte = static_cast<unsigned char>(c);
+    bitmap_[byte / 64] |= uint64_t{1} << (byte % 64);
+    if (size_ < kMaxSimd) bytes_[size_] = c;
+    size_++;
+  }
+};
+
+namespace detail {
+
+inline size_t find_any_scalar(const char* p, size_t n,
+                              const DelimiterSet& set) noexcept {
+  for (size_t i = 0; i < n; i++) {
+    if (set.contains(p[i])) return i;
+  }
+  return n;
+}
+
+inline size_t count_any_scalar(const char* p, size_t n,
+                               const DelimiterSet& set) noexcept {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) total += set.contains(p[i]);
+  return total;
+}
+
+#if defined(STL_SIMD_X86)
+
+// The delimiters broadcast, one vector each
+struct Needles16 {
+  explicit Needles16(const DelimiterSet& set) noexcept : count(set.size()) {
+    for (size_t i = 0; i < count; i++) {
+      lanes[i] = _mm_set1_epi8(set.bytes()[i]);
+    }
+  }
+
+  __m128i lanes[DelimiterSet::kMaxSimd];
+  size_t count;
+};
+
+// Bit i set when byte i of the 16 at p is a delimiter
+inline uint32_t match16_sse2(const char* p, const Needles16& needles) noexcept {
+  __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i hits = _mm_cmpeq_epi8(chunk, needles.lanes[0]);
+  for (size_t i = 1; i < needles.count; i++) {
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles.lanes[i]));
+  }
+  return static_cast<uint32_t>(_mm_movemask_epi8(hits));
+}
+
+// Each kernel scans whole blocks, then one block ending at n that overlaps
+// the last, with the bytes already seen shifted out of its mask. The loops
+// are spelled out per instruction set rather than shared through a
+// template, since a helper without the target attribute could not inline
+// the vector code
+inline size_t find_any_sse2(const char* p, size_t n,
+                            const DelimiterSet& set) noexcept {
+  if (n < 16) return find_any_scalar(p, n, set);
+  Needles16 needles(set);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint32_t mask = match16_sse2(p + i, needles);
+    if (mask != 0) return i + std::countr_zero(mask);
+  }
+  if (i == n) return n;
+  uint32_t mask = match16_sse2(p + n - 16, needles) >> (i - (n - 16));
+  return mask != 0 ? i + std::countr_zero(mask) : n;
+}
+
+inline size_t count_any_sse2(const char* p, size_t n,
+                             const DelimiterSet& set) noexcept {
+  if (n < 16) return count_any_scalar(p, n, set);
+  Needles16 needles(set);
+  size_t total = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    total += std::popcount(match16_sse2(p + i, needles));
+  }
+  if (i == n) return total;
+  return total +
+         std::popcount(match16_sse2(p + n - 16, needles) >> (i - (n - 16)));
+}
+
+// pcmpestrm compares 16 bytes against all (up to 16) delimiters in one
+// instruction, which beats an OR of compares once there are several
+constexpr int kAnyByteMask =
+    _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+
+__attribute__((target("sse4.2"))) inline uint32_t match16_sse42(
+    const char* p, __m128i set, int set_size) noexcept {
+  __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(
+      _mm_cmpestrm(set, set_size, chunk, 16, kAnyByteMask)));
+}
+
+__attribute__((target("sse4.2"))) inline size_t find_any_sse42(
+    const char* p, size_t n, const DelimiterSet& set) noexcept {
+  if (n < 16) return find_any_scalar(p, n, set);
+  __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.bytes()));
+  int size = static_cast<int>(set.size());
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint32_t mask = match16_sse42(p + i, bytes, size);
+    if (mask != 0) return i + std::countr_zero(mask);
+  }
+  if (i == n) return n;
+  uint32_t mask = match16_sse42(p + n - 16, bytes, size) >> (i - (n - 16));
+  return mask != 0 ? i + std::countr_zero(mask) : n;
+}
+
+__attribute__((target("sse4.2,popcnt"))) inline size_t count_any_sse42(
+    const char* p, size_t n, const DelimiterSet& set) noexcept {
+  if (n < 16) return count_any_scalar(p, n, set);
+  __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.bytes()));
+  int size = static_cast<int>(set.size());
+  size_t total = 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    total += std::popcount(match16_sse42(p + i, bytes, size));
+  }
+  if (i == n) return total;
+  return total + std::popcount(match16_sse42(p + n - 16, bytes, size) >>
+                               (i - (n - 16)));
+}
+
+struct Needles32 {
+  __attribute__((target("avx2"))) explicit Needles32(
+      const DelimiterSet& set) noexcept
+      : count(set.size()) {
+    for (size_t i = 0; i < count; i++) {
+      lanes[i] = _mm256_set1_epi8(set.bytes()[i]);
+    }
+  }
+
+  __m256i lanes[DelimiterSet::kMaxSimd];
+  size_t count;
+};
+
+__attribute__((target("avx2"))) inline uint32_t match32_avx2(
+    const char* p, const Needles32& needles) noexcept {
+  __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  __m256i hits = _mm256_cmpeq_epi8(chunk, needles.lanes[0]);
+  for (size_t i = 1; i < needles.count; i++) {
+    hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, needles.lanes[i]));
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+}
+
+// Below 32 bytes the 16-byte kernel still beats scalar
+__attribute__((target("avx2"))) inline size_t find_any_avx2(
+    const char* p, size_t n, const DelimiterSet& set) noexcept {
+  if (n < 32) return find_any_sse2(p, n, set);
+  Needles32 needles(set);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    uint32_t mask = match32_avx2(p + i, needles);
+    if (mask != 0) return i + std::countr_zero(mask);
+  }
+  if (i == n) return n;
+  uint32_t mask = match32_avx2(p + n - 32, needles) >> (i - (n - 32));
+  return mask != 0 ? i + std::countr_zero(mask) : n;
+}
+
+__attribute__((target("avx2,popcnt"))) inline size_t count_any_avx2(
+    const char* p, size_t n, const DelimiterSet& set) noexcept {
+  if (n < 32) return count_any_sse2(p, n, set);
+  Needles32 needles(set);
+  size_t total = 0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    total += std::popcount(match32_avx2(p + i, needles));
+  }
+  if (i == n) return total;
+  return total +
+         std::popcount(match32_avx2(p + n - 32, needles) >> (i - (n - 32)));
+}
+
+#endif
+
+// With few delimiters and no AVX2, or-ing SSE2 compares beats pcmpestrm
+inline constexpr size_t kSse42MinDelimiters = 4;
+
+inline size_t find_any(SimdLevel level, const char* p, size_t n,
+                       const DelimiterSet& set) noexcept {
+  // The kernels would build needles from unset delimiters
+  if (set.size() == 0) return n;
+#if defined(STL_SIMD_X86)
+  if (set.size() <= DelimiterSet::kMaxSimd) {
+    switch (level) {
+      case SimdLevel::kAvx2:
+        return find_any_avx2(p, n, set);
+      case SimdLevel::kSse42:
+        if (set.size() >= kSse42MinDelimiters) {
+          return find_any_sse42(p, n, set);
+        }
+        return find_any_sse2(p, n, set);
+      case SimdLevel::kSse2:
+        return find_any_sse2(p, n, set);
+      case SimdLevel::kScalar:
+        break;
+    }
+  }
+#endif
+  return find_any_scalar(p, n, set);
+}
+
+inline size_t count_any(SimdLevel level, const char* p, size_t n,
+                        const DelimiterSet& set) noexcept {
+  if (set.size() == 0) return 0;
+#if defined(STL_SIMD_X86)
+  if (set.size() <= DelimiterSet::kMaxSimd) {
+    switch (level) {
+      case SimdLevel::kAvx2:
+        return count_any_avx2(p, n, set);
+      case SimdLevel::kSse42:
+        if (set.size() >= kSse42MinDelimiters) {
+          return count_any_sse42(p, n, set);
+        }
+        return count_any_sse2(p, n, set);
+      case SimdLevel::kSse2:
+        return count_any_sse2(p, n, set);
+      case SimdLevel::kScalar:
+        break;
+    }
+  }
+#endif
+  return count_any_scalar(p, n, set);
+}
+
+}  // namespace detail
+
+// Position of the first delimiter at or after pos, or npos
+inline size_t find_first_of(std::string_view text,
+                            const DelimiterSet& delimiters,
+                            size_t pos = 0) noexcept {
+  if (pos >= text.size()) return std::string_view::npos;
+  size_t n = text.size() - pos;
+  // libc's memchr is already vectorised and skips building the needles
+  if (delimiters.size() == 1) {
+    const void* found =
+        std::memchr(text.data() + pos, delimiters.bytes()[0], n);
+    if (found == nullptr) return std::string_view::npos;
+    return static_cast<const char*>(found) - text.data();
+  }
+  size_t found =
+      detail::find_any(simd_level(), text.data() + pos, n, delimiters);
+  return found == n ? std::string_view::npos : pos + found;
+}
+
+inline size_t find_first_of(std::string_view text,
+                            std::string_view delimiters,
+                            size_t pos = 0) noexcept {
+  return find_first_of(text, DelimiterSet(delimiters), pos);
+}
+
+inline size_t find_byte(std::string_view text, char c,
+                        size_t pos = 0) noexcept {
+  return find_first_of(text, DelimiterSet(c), pos);
+}
+
+inline size_t count(std::string_view text,
+                    const DelimiterSet& delimiters) noexcept {
+  return detail::count_any(simd_level(), text.data(), text.size(),
+                           delimiters);
+}
+
+inline size_t count(std::string_view text, char c) noexcept {
+  return count(text, DelimiterSet(c));
+}
+
+// Every field between delimiters, empty ones included, so n delimiters
+// always give n + 1 fields. The views point into text
+inline Vector<std::string_view> split(std::string_view text,
+                                      const DelimiterSet& delimiters) {
+  Vector<std::string_view> fields;
+  size_t start = 0;
+  for (;;) {
+    size_t end = find_first_of(text, delimiters, start);
+    if (end == std::string_view::npos) {
+      fields.push_back(text.substr(start));
+      return fields;
+    }
+    fields.push_back(text.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
+inline Vector<std::string_view> split(std::string_view text,
+                                      std::string_view delimiters) {
+  return split(text, DelimiterSet(delimiters));
+}
+
+// Lazy range over the non-empty tokens of text, i.e. runs of delimiters
+// count as one, as with whitespace. Nothing is copied or allocated
+class Tokenizer {
+ public:
+  Tokenizer(std::string_view text, std::string_view delimiters) noexcept
+      : text_(text), delimiters_(delimiters) {}
+
+  Tokenizer(std::string_view text, const DelimiterSet& delimiters) noexcept
+      : text_(text), delimiters_(delimiters) {}
+
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = const std::string_view&;
+
+    iterator() = default;
+
+    reference operator*() const noexcept { return token_; }
+    pointer operator->() const noexcept { return &token_; }
+
+    iterator& operator++() noexcept {
+      advance(end_);
+      return *this;
+    }
+
+    iterator operator++(int) noexcept {
+      iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const iterator& lhs,
+                           const iterator& rhs) noexcept {
+      return lhs.start_ == rhs.start_;
+    }
+
+   private:
+    friend class Tokenizer;
+
+    iterator(const Tokenizer* owner, size_t from) noexcept : owner_(owner) {
+      advance(from);
+    }
+
+    // Skips delimiters from pos, then takes the token up to the next one
+    void advance(size_t pos) noexcept {
+      std::string_view text = owner_->text_;
+      while (pos < text.size() && owner_->delimiters_.contains(text[pos])) {
+        pos++;
+      }
+      if (pos >= text.size()) {
+        start_ = end_ = text.size();
+        token_ = {};
+        return;
+      }
+      size_t end = find_first_of(text, owner_->delimiters_, pos);
+      start_ = pos;
+      end_ = end == std::string_view::npos ? text.size() : end;
+      token_ = text.substr(start_, end_ - start_);
+    }
+
+    const Tokenizer* owner_ = nullptr;
+    size_t start_ = 0;
+    size_t end_ = 0;
+    std::string_view token_;
+  };
+
+  iterator begin() const noexcept { return iterator(this, 0); }
+
+  iterator end() const noexcept {
+    iterator it;
+    it.owner_ = this;
+    it.start_ = it.end_ = text_.size();
+    return it;
+  }
+
+ private:
+  std::string_view text_;
+  DelimiterSet delimiters_;
+};
+
+}  // namespace stl
@@ -0,0 +1,198 @@
+/**
+ * @file task_group.h
+ * @brief Implementation of structured fork-join task group on ThreadPool
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "stl/cache_line.h"
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+// Fork-join scope in the style of TBB's task_group. run() spawns a task
+// without creating a future, wait() blocks until every task spawned so far
+// has finished, running queued pool work (newest first, so usually this
+// group's own subtasks) on the calling thread meanwhile. Recursive
+// divide-and-conquer code can nest groups freely inside group tasks.
+// The first exception thrown by a task is rethrown once by wait(), later
+// ones are dropped. Task nodes come from a thread-local freelist and small
+// callables are stored inline, so spawning usually does not allocate.
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  // Waits for outstanding tasks, discarding an unobserved exception
+  ~TaskGroup() { pool_.help_until([this]() { return done(); }); }
+
+  template <typename F>
+  void run(F&& f) {
+    Node* node = Node::make(std::forward<F>(f), this);
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    // Bypasses a bounded queue: a dropped task would never be waited out
+    try {
+      pool_.post_continuation([node]() { node->execute(); });
+    } catch (...) {
+      Node::destroy(node);
+      pending_.fetch_sub(1, std::memory_order_release);
+      throw;
+    }
+  }
+
+  // Also runs f on the calling thread before waiting, saving one spawn for
+  // the last branch of a fork
+  template <typename F>
+  void run_and_wait(F&& f) {
+    try {
+      std::forward<F>(f)();
+    } catch (...) {
+      record_error(std::current_exception());
+    }
+    wait();
+  }
+
+  void wait() {
+    pool_.help_until([this]() { return done(); });
+
+    if (has_error_.load(std::memory_order_acquire)) {
+      std::exception_ptr error;
+      {
+        std::scoped_lock lock(error_mutex_);
+        error = std::exchange(error_, nullptr);
+        has_error_.store(false, std::memory_order_relaxed);
+      }
+      if (error) std::rethrow_exception(error);
+    }
+  }
+
+  // Tasks spawned but not yet finished
+  [[nodiscard]] size_t pending() const noexcept {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Type-erased task. Callables up to kInlineSize bytes live in the node,
+  // larger ones on the heap behind a pointer stored there
+  struct Node {
+    static constexpr size_t kInlineSize = 48;
+
+    alignas(std::max_align_t) unsigned char storage[kInlineSize];
+    void (*invoke)(Node*) = nullptr;
+    void (*drop)(Node*) = nullptr;
+    TaskGroup* group = nullptr;
+    Node* next_free = nullptr;
+
+    template <typename F>
+    static Node* make(F&& f, TaskGroup* group) {
+      using Fn = std::decay_t<F>;
+      Node* node = Cache::local().acquire();
+      node->group = group;
+
+      if constexpr (sizeof(Fn) <= kInlineSize &&
+                    alignof(Fn) <= alignof(std::max_align_t)) {
+        new (node->storage) Fn(std::forward<F>(f));
+        node->invoke = [](Node* n) {
+          (*std::launder(reinterpret_cast<Fn*>(n->storage)))();
+        };
+        node->drop = [](Node* n) {
+          std::launder(reinterpret_cast<Fn*>(n->storage))->~Fn();
+        };
+      } else {
+        Fn* heap = new Fn(std::forward<F>(f));
+        new (node->storage) Fn*(heap);
+        node->invoke = [](Node* n) {
+          (**std::launder(reinterpret_cast<Fn**>(n->storage)))();
+        };
+        node->drop = [](Node* n) {
+          delete *std::launder(reinterpret_cast<Fn**>(n->storage));
+        };
+      }
+      return node;
+    }
+
+    static void destroy(Node* node) {
+      node->drop(node);
+      Cache::local().release(node);
+    }
+
+    // Nothing may touch the group after the last task finishes, a waiter
+    // can destroy it as soon as pending_ drops to zero
+    void execute() {
+      TaskGroup* owner = group;
+      try {
+        invoke(this);
+      } catch (...) {
+        owner->record_error(std::current_exception());
+      }
+      destroy(this);
+      owner->pending_.fetch_sub(1, std::memory_order_release);
+    }
+  };
+
+  // Per-thread freelist. A node goes back to the cache of whichever thread
+  // ran it; each cache keeps at most kMaxCached nodes so a thread that only
+  // consumes cannot hoard memory
+  class Cache {
+   public:
+    static constexpr size_t kMaxCached = 1024;
+
+    ~Cache() {
+      while (head_ != nullptr) delete std::exchange(head_, head_->next_free);
+    }
+
+    static Cache& local() {
+      static thread_local Cache cache;
+      return cache;
+    }
+
+    Node* acquire() {
+      if (head_ == nullptr) return new Node;
+      count_--;
+      return std::exchange(head_, head_->next_free);
+    }
+
+    void release(Node* node) {
+      if (count_ == kMaxCached) {
+        delete node;
+        return;
+      }
+      node->next_free = head_;
+      head_ = node;
+      count_++;
+    }
+
+   private:
+    Node* head_ = nullptr;
+    size_t count_ = 0;
+  };
+
+  ThreadPool& pool_;
+  alignas(kCacheLineSize) std::atomic<size_t> pending_ = 0;
+  std::atomic<bool> has_error_ = false;
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+
+  bool done() const noexcept {
+    return pending_.load(std::memory_order_acquire) == 0;
+  }
+
+  void record_error(std::exception_ptr error) {
+    std::scoped_lock lock(error_mutex_);
+    if (!error_) error_ = std::move(error);
+    has_error_.store(true, std::memory_order_release);
+  }
+};
+
+}  // namespace stl
@@ -5,93 +5,640 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <stdexcept>
 #include <stop_token>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "stl/arena.h"
+#include "stl/deterministic_schedule.h"
+#include "stl/thread_pool_stats.h"
+#include "stl/timer_wheel.h"
+#include "stl/tracer.h"
+
 namespace stl {
+
+// What a bounded ThreadPool does with a submission when its queue is full
+enum class OverflowPolicy {
+  kBlock,       // The submitter waits for space
+  kReject,      // submit_task returns a failed future, post throws
+  kCallerRuns,  // The task runs on the submitting thread
+  // The oldest queued submission is discarded (broken_promise). Queued
+  // continuations are never dropped, with only those queued it rejects
+  kDropOldest,
+};
+
 class ThreadPool {
  public:
-  ThreadPool(size_t num_threads) {
-    thread_workers_.reserve(num_threads);
+  ThreadPool(size_t num_threads) : ThreadPool(num_threads, 0) {}
 
-    for (size_t i = 0; i < num_threads; i++) {
-      thread_workers_.emplace_back(
-          [this](std::stop_token stop_token) { this->worker(stop_token); });
-    }
+  // A queue_capacity of 0 leaves the queue unbounded
+  ThreadPool(size_t num_threads, size_t queue_capacity,
+             OverflowPolicy overflow_policy = OverflowPolicy::kBlock)
+      : recorders_(num_threads),
+        queue_capacity_(queue_capacity),
+        overflow_policy_(overflow_policy) {
+    start_workers(num_threads);
   }
 
+  // Deterministic mode for reproducible performance tests: one task runs
+  // at a time, and each step the seeded scheduler picks which queued task
+  // runs next and on which worker. Every decision is logged so a run can
+  // be replayed. Only submissions made by the tasks themselves are
+  // reproducible; outside submissions, timers and I/O completions race
+  // with the steps, so submit from outside between pause() and resume().
+  // Outside threads never run tasks in wait(), and the pool cannot lend
+  // or borrow workers
+  ThreadPool(size_t num_threads, DeterministicSchedule schedule)
+      : recorders_(num_threads),
+        queue_capacity_(0),
+        overflow_policy_(OverflowPolicy::kBlock),
+        scheduler_(std::make_unique<DeterministicScheduler>(
+            std::move(schedule), num_threads)) {
+    start_workers(num_threads);
+  }
+
+  static constexpr bool kTelemetryEnabled = STL_THREAD_POOL_TELEMETRY;
+
   template <typename F, typename... Args>
   auto submit_task(F&& f, Args&&... args) -> std::future<
       std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> {
     using return_type =
         std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
 
-    // Create a packaged_task to get the future
-    // Perfect forwarding
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(
-                                     args)...)]() mutable -> return_type {
-          return std::apply(f, std::move(args));
-        });
+    auto [task, future] =
+        make_task(std::forward<F>(f), std::forward<Args>(args)...);
 
-    auto future = task->get_future();
+    switch (admit(task, overflow_policy_)) {
+      case Admission::kQueued:
+        break;
+      case Admission::kRunInline:
+        task();
+        break;
+      case Admission::kShutdown:
+        return failed_future<return_type>("ThreadPool is shut down");
+      case Admission::kRejected:
+        return failed_future<return_type>("ThreadPool queue is full");
+    }
+    return std::move(future);
+  }
+
+  // Never blocks or runs the task inline: returns nullopt when the task
+  // could not be queued because the queue is full or the pool shut down
+  template <typename F, typename... Args>
+  auto try_submit(F&& f, Args&&... args) -> std::optional<std::future<
+      std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>> {
+    auto [task, future] =
+        make_task(std::forward<F>(f), std::forward<Args>(args)...);
+
+    if (admit(task, OverflowPolicy::kReject) != Admission::kQueued) {
+      return std::nullopt;
+    }
+    return std::move(future);
+  }
+
+  // Fire-and-forget submission, no future or packaged_task is created. The
+  // task must not throw. Follows the overflow policy; throws if rejected
+  template <typename F>
+  void post(F&& f) {
+    std::function<void()> task(std::forward<F>(f));
+
+    switch (admit(task, overflow_policy_)) {
+      case Admission::kQueued:
+        break;
+      case Admission::kRunInline:
+        task();
+        break;
+      case Admission::kShutdown:
+        throw std::runtime_error("ThreadPool is shut down");
+      case Admission::kRejected:
+        throw std::runtime_error("ThreadPool queue is full");
+    }
+  }
+
+  // For work continuing something already admitted (a strand rescheduling
+  // itself, an expired timer): ignores the capacity so it is never dropped
+  // or blocked, but still refused after shutdown
+  template <typename F>
+  void post_continuation(F&& f) {
+    if (!try_post_continuation(std::forward<F>(f))) {
+      throw std::runtime_error("ThreadPool is shut down");
+    }
+  }
 
+  // As post_continuation(), returning false rather than throwing after
+  // shutdown, for callers that must then finish the work themselves
+  template <typename F>
+  bool try_post_continuation(F&& f) {
     {
       std::scoped_lock lock(mutex_);
-      if (is_shutdown_.load(std::memory_order_relaxed)) {
-        // If shutdown, return an invalid future or throw
-        std::promise<return_type> promise;
-        promise.set_exception(std::make_exception_ptr(
-            std::runtime_error("ThreadPool is shut down")));
-        return promise.get_future();
+      if (is_shutdown_.load(std::memory_order_relaxed)) return false;
+      task_queue_.emplace_back(std::forward<F>(f), true);
+      note_enqueued();
+    }
+
+    notify_worker();
+    notify_lenders();
+    return true;
+  }
+
+  // Tasks waiting for a worker, for upstream load shedding
+  [[nodiscard]] size_t queue_depth() {
+    std::scoped_lock lock(mutex_);
+    return task_queue_.size();
+  }
+
+  [[nodiscard]] size_t queue_capacity() const noexcept {
+    return queue_capacity_;
+  }
+
+  // Merges the per-worker recorders into one snapshot. Without
+  // STL_THREAD_POOL_TELEMETRY only the queue depth is filled in. Idle time
+  // counts finished idle periods, not the one a sleeping worker is in
+  [[nodiscard]] ThreadPoolStats stats() {
+    ThreadPoolStats snapshot;
+    snapshot.workers.reserve(recorders_.size());
+    for (const auto& recorder : recorders_) {
+      snapshot.workers.push_back(recorder.snapshot());
+      snapshot.total.merge(snapshot.workers.back());
+    }
+
+    std::scoped_lock lock(mutex_);
+    snapshot.queue_depth = task_queue_.size();
+    snapshot.max_queue_depth = max_queue_depth_;
+    return snapshot;
+  }
+
+  // Pool-aware wait. Called from one of this pool's workers, it keeps the
+  // worker busy by running other queued tasks until the future is ready, so
+  // nested submit/wait cannot deadlock the pool. Any other thread simply
+  // blocks.
+  template <typename T>
+  void wait(const std::future<T>& future) {
+    if (current_pool_ != this) {
+      future.wait();
+      return;
+    }
+
+    help_until([&future]() { return is_ready(future); });
+  }
+
+  // Runs queued tasks on the calling thread until done() returns true. The
+  // most recently queued task is taken first, which in divide-and-conquer
+  // code is usually the one being waited on. done() is re-checked whenever a
+  // task finishes anywhere in the pool, so it should depend on pool work
+  template <typename Predicate>
+  void help_until(Predicate done) {
+    helping_waiters_.fetch_add(1, std::memory_order_relaxed);
+    if (scheduler_) {
+      help_deterministically(done);
+      helping_waiters_.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+
+    while (!done()) {
+      QueuedTask task;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Woken early by a new task or by any task finishing on another
+        // worker, the timeout only covers conditions this pool does not drive
+        cv_.wait_for(lock, kHelpPollInterval,
+                     [&]() { return !task_queue_.empty() || done(); });
+
+        if (!task_queue_.empty()) {
+          task = std::move(task_queue_.back());
+          task_queue_.pop_back();
+          note_dequeued();
+        }
+      }  // unlocked
+
+      if (task && queue_capacity_ != 0) not_full_cv_.notify_one();
+
+      if (task) {
+        execute(task, true);
+        notify_helping_waiters();
+      }
+    }
+    helping_waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  template <typename T>
+  T get(std::future<T>& future) {
+    wait(future);
+    return future.get();
+  }
+
+  // Delayed and periodic tasks. A timer thread, started on first use, keeps
+  // them in a hierarchical timing wheel with millisecond ticks and hands
+  // whatever expires to the workers in one batch. Callbacks run detached, so
+  // they must not throw. The returned id can be passed to cancel_timer()
+  template <typename F>
+  TimerId schedule_at(std::chrono::steady_clock::time_point time_point, F&& f) {
+    return add_timer(to_tick(time_point), std::forward<F>(f), 0);
+  }
+
+  template <typename Rep, typename Period, typename F>
+  TimerId schedule_after(std::chrono::duration<Rep, Period> delay, F&& f) {
+    return schedule_at(std::chrono::steady_clock::now() + delay,
+                       std::forward<F>(f));
+  }
+
+  // First run after one period, then every period until cancelled. Runs
+  // missed while the timer thread was held up are not made up: the next
+  // one fires once and the schedule carries on. Throws
+  // std::invalid_argument unless period is positive
+  template <typename Rep, typename Period, typename F>
+  TimerId schedule_every(std::chrono::duration<Rep, Period> period, F&& f) {
+    if (period <= std::chrono::duration<Rep, Period>::zero()) {
+      throw std::invalid_argument("ThreadPool::schedule_every");
+    }
+    auto ticks = std::max<TimerWheel::Tick>(
+        1, std::chrono::ceil<std::chrono::milliseconds>(period).count());
+    return add_timer(to_tick(std::chrono::steady_clock::now()) + ticks,
+                     std::forward<F>(f), ticks);
+  }
+
+  // Returns false if the timer already fired (one-shot) or was cancelled
+  bool cancel_timer(TimerId id) {
+    std::scoped_lock lock(timer_mutex_);
+    return timer_wheel_.cancel(id);
+  }
+
+  [[nodiscard]] size_t pending_timers() {
+    std::scoped_lock lock(timer_mutex_);
+    return timer_wheel_.size();
+  }
+
+  // Attaches a tracer, nullptr detaches. Give it size() worker rings; extra
+  // workers fall back to its shared ring. It must stay alive until detached
+  // or until the pool is destroyed
+  void set_tracer(Tracer* tracer) noexcept {
+    tracer_.store(tracer, std::memory_order_release);
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return thread_workers_.size(); }
+
+  // Restricts every worker to the given CPUs. Returns false if the
+  // platform has no affinity support or the kernel refused the mask
+  bool set_affinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+      CPU_SET(cpu, &mask);
+    }
+    for (auto& thread : thread_workers_) {
+      if (pthread_setaffinity_np(thread.native_handle(), sizeof(mask),
+                                 &mask) != 0) {
+        return false;
       }
-      task_queue_.emplace([task]() { (*task)(); });
     }
+    return true;
+#else
+    (void)cpus;
+    return false;
+#endif
+  }
 
-    cv_.notify_one();
-    return future;
+  // Lets this pool's idle workers run tasks queued on `borrower` whenever
+  // all of the borrower's own workers are busy; nullptr stops lending.
+  // Lending is one-way, the borrower's workers never run our tasks. At
+  // most kMaxLentThreads lent threads run the borrower's tasks at once,
+  // each in its own current_slot(). Both pools must outlive the arrangement
+  void lend_idle_workers_to(ThreadPool* borrower) {
+    if (borrower == this) {
+      throw std::invalid_argument("ThreadPool cannot lend to itself");
+    }
+    if (scheduler_ || (borrower != nullptr && borrower->scheduler_)) {
+      throw std::invalid_argument("deterministic ThreadPool cannot lend");
+    }
+    ThreadPool* previous = borrower_.exchange(borrower);
+    if (previous != nullptr) previous->remove_lender(this);
+    if (borrower != nullptr) {
+      borrower->add_lender(this);
+      // Workers already asleep re-check with the new borrower
+      { std::scoped_lock lock(mutex_); }
+      cv_.notify_all();
+    }
   }
 
+  [[nodiscard]] bool is_deterministic() const noexcept {
+    return scheduler_ != nullptr;
+  }
+
+  // Deterministic pools only: no step starts until resume(), so a batch of
+  // outside submissions is queued in full before the scheduler sees it.
+  // Throws std::runtime_error on a regular pool
+  void pause() { set_paused(true); }
+  void resume() { set_paused(false); }
+
+  // Decisions made so far by a deterministic pool, empty for a regular one
+  [[nodiscard]] std::vector<ScheduleDecision> schedule_log() {
+    std::scoped_lock lock(mutex_);
+    if (!scheduler_) return {};
+    return scheduler_->log();
+  }
+
+  // First step where the replayed schedule no longer fit the queue
+  [[nodiscard]] std::optional<uint64_t> replay_diverged_at() {
+    std::scoped_lock lock(mutex_);
+    if (!scheduler_) return std::nullopt;
+    return scheduler_->diverged_at();
+  }
+
+  // True when called from one of this pool's worker threads
+  [[nodiscard]] bool is_worker_thread() const noexcept {
+    return current_pool_ == this;
+  }
+
+  // Index in [0, size()) of the calling worker, nullopt on other threads
+  [[nodiscard]] std::optional<size_t> current_worker_index() const noexcept {
+    if (current_pool_ != this) return std::nullopt;
+    return current_worker_index_;
+  }
+
+  // Lent threads running this pool's tasks at once, see slot_count()
+  static constexpr size_t kMaxLentThreads = 16;
+
+  // Index in [0, slot_count()) for per-thread state such as WorkerLocal:
+  // the worker index on our workers, one of kMaxLentThreads slots past them
+  // on a lender's worker running our task, nullopt on other threads
+  [[nodiscard]] std::optional<size_t> current_slot() const noexcept {
+    if (current_pool_ == this) return current_worker_index_;
+    if (lent_to_ == this) return thread_workers_.size() + lent_slot_;
+    return std::nullopt;
+  }
+
+  [[nodiscard]] size_t slot_count() const noexcept {
+    return thread_workers_.size() + kMaxLentThreads;
+  }
+
+  // Scratch memory for the running task, owned by the calling thread. It is
+  // reset when the thread's outermost task returns, so allocations must not
+  // outlive the task; tasks run nested through help_until() share it
+  static MonotonicArena& scratch_arena() {
+    static thread_local MonotonicArena arena;
+    return arena;
+  }
+
+  // Stops accepting work. Workers drain the tasks already queued and exit,
+  // pending timers are dropped
   void shutdown() {
-    is_shutdown_.store(true, std::memory_order_relaxed);
+    {
+      std::scoped_lock lock(mutex_);
+      is_shutdown_.store(true, std::memory_order_relaxed);
+      // The queued tasks still drain
+      paused_ = false;
+    }
     cv_.notify_all();
-    for (auto& thread : thread_workers_) {
-      thread.request_stop();
+    not_full_cv_.notify_all();
+
+    {
+      std::scoped_lock lock(timer_mutex_);
+      timer_thread_.request_stop();
     }
+    timer_cv_.notify_all();
   }
 
   ~ThreadPool() {
+    if (borrower_.load() != nullptr) lend_idle_workers_to(nullptr);
     shutdown();
-    // jthreads will automatically join and request_stop, so no need to join
+    // Join before the members the threads use are destroyed
+    if (timer_thread_.joinable()) timer_thread_.join();
+    for (auto& thread : thread_workers_) {
+      if (thread.joinable()) thread.join();
+    }
   }
 
  private:
+  // With telemetry, also carries its submission time so queueing delay can
+  // be measured
+  struct QueuedTask {
+    QueuedTask() = default;
+    QueuedTask(std::function<void()> task, bool continuation = false)
+        : fn(std::move(task)), continuation(continuation) {
+#if STL_THREAD_POOL_TELEMETRY
+      enqueued_ns = telemetry_now_ns();
+#endif
+    }
+
+    void operator()() { fn(); }
+    explicit operator bool() const noexcept { return static_cast<bool>(fn); }
+
+    std::function<void()> fn;
+    // Queued past the capacity, so kDropOldest never evicts it
+    bool continuation = false;
+#if STL_THREAD_POOL_TELEMETRY
+    uint64_t enqueued_ns = 0;
+#endif
+  };
+
   std::vector<std::jthread> thread_workers_;
-  std::queue<std::function<void()>> task_queue_;
+  // One per worker, written only by its owner
+  std::vector<WorkerRecorder> recorders_;
+  // Workers pop from the front, helping waiters from the back
+  std::deque<QueuedTask> task_queue_;
+  // High-water mark of task_queue_, only tracked with telemetry
+  size_t max_queue_depth_ = 0;
   std::mutex mutex_;
   std::condition_variable cv_;
+  // Submitters blocked on a full bounded queue
+  std::condition_variable not_full_cv_;
+  const size_t queue_capacity_;
+  const OverflowPolicy overflow_policy_;
   std::atomic<bool> is_shutdown_ = false;
+  std::atomic<size_t> helping_waiters_ = 0;
+  // Opt-in event tracing, every hook is a single null check when detached
+  std::atomic<Tracer*> tracer_ = nullptr;
+
+  // Lending idle workers between pools
+  // Mirror of task_queue_.size() readable without mutex_
+  std::atomic<size_t> queued_ = 0;
+  // Workers blocked waiting for tasks
+  std::atomic<size_t> idle_workers_ = 0;
+  // Bit i set while a lent thread runs our task in slot size() + i
+  std::atomic<uint32_t> lent_slots_ = 0;
+  // Pool our idle workers take tasks from
+  std::atomic<ThreadPool*> borrower_ = nullptr;
+  // Pools lending their idle workers to us, guarded by lenders_mutex_
+  std::vector<ThreadPool*> lenders_;
+  std::mutex lenders_mutex_;
+  std::atomic<bool> has_lenders_ = false;
+
+  // Deterministic mode, all guarded by mutex_
+  std::unique_ptr<DeterministicScheduler> scheduler_;
+  // A step is running from its decision until its task returns
+  bool step_running_ = false;
+  // Worker the decided step was handed to, and its task
+  std::optional<size_t> turn_;
+  QueuedTask handoff_;
+  bool paused_ = false;
+
+  // Timers, guarded by timer_mutex_
+  TimerWheel timer_wheel_;
+  std::mutex timer_mutex_;
+  std::condition_variable timer_cv_;
+  // Tick the timer thread sleeps until, so inserts only wake it when earlier
+  TimerWheel::Tick timer_wakeup_tick_ = UINT64_MAX;
+  std::chrono::steady_clock::time_point timer_epoch_ =
+      std::chrono::steady_clock::now();
+  std::jthread timer_thread_;
+
+  static constexpr auto kHelpPollInterval = std::chrono::milliseconds(1);
+  static constexpr auto kTimerTick = std::chrono::milliseconds(1);
+  // Pool owning the current thread, nullptr outside of workers
+  static inline thread_local ThreadPool* current_pool_ = nullptr;
+  static inline thread_local size_t current_worker_index_ = 0;
+  // Borrower whose task a lent worker is running, and the slot it holds
+  static inline thread_local const ThreadPool* lent_to_ = nullptr;
+  static inline thread_local size_t lent_slot_ = 0;
+  // Tasks currently executing on this thread, nested ones included
+  static inline thread_local size_t task_depth_ = 0;
+
+  enum class Admission { kQueued, kRunInline, kShutdown, kRejected };
+
+  void start_workers(size_t num_threads) {
+    thread_workers_.reserve(num_threads);
+
+    for (size_t i = 0; i < num_threads; i++) {
+      thread_workers_.emplace_back([this, i](std::stop_token stop_token) {
+        this->worker(stop_token, i);
+      });
+    }
+  }
+
+  // Wraps the call in a packaged_task so the future reports its outcome
+  template <typename F, typename... Args>
+  static auto make_task(F&& f, Args&&... args) {
+    using return_type =
+        std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+
+    // Perfect forwarding
+    auto task = std::make_shared<std::packaged_task<return_type()>>(
+        [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(
+                                     args)...)]() mutable -> return_type {
+          return std::apply(f, std::move(args));
+        });
+
+    auto future = task->get_future();
+    return std::make_pair(std::function<void()>([task]() { (*task)(); }),
+                          std::move(future));
+  }
+
+  template <typename T>
+  static std::future<T> failed_future(const char* reason) {
+    std::promise<T> promise;
+    promise.set_exception(
+        std::make_exception_ptr(std::runtime_error(reason)));
+    return promise.get_future();
+  }
+
+  // Queues the task or tells the caller what to do with it instead
+  Admission admit(std::function<void()>& task, OverflowPolicy policy) {
+    QueuedTask evicted;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (is_shutdown_.load(std::memory_order_relaxed)) {
+        return Admission::kShutdown;
+      }
+
+      if (queue_capacity_ != 0 && task_queue_.size() >= queue_capacity_) {
+        switch (policy) {
+          case OverflowPolicy::kBlock:
+            // A worker waiting for space could wait on itself
+            if (is_worker_thread()) return Admission::kRunInline;
+            not_full_cv_.wait(lock, [this]() {
+              return task_queue_.size() < queue_capacity_ ||
+                     is_shutdown_.load(std::memory_order_relaxed);
+            });
+            if (is_shutdown_.load(std::memory_order_relaxed)) {
+              return Admission::kShutdown;
+            }
+            break;
+          case OverflowPolicy::kReject:
+            return Admission::kRejected;
+          case OverflowPolicy::kCallerRuns:
+            return Admission::kRunInline;
+          case OverflowPolicy::kDropOldest: {
+            // Continuations carry work already admitted, e.g. a strand's
+            // runner, and dropping one would strand everything behind it
+            auto oldest = std::find_if(
+                task_queue_.begin(), task_queue_.end(),
+                [](const QueuedTask& queued) { return !queued.continuation; });
+            if (oldest == task_queue_.end()) return Admission::kRejected;
+            evicted = std::move(*oldest);
+            task_queue_.erase(oldest);
+            break;
+          }
+        }
+      }
+
+      task_queue_.emplace_back(std::move(task));
+      note_enqueued();
+    }  // unlocked, the evicted task is destroyed outside the lock
+
+    notify_worker();
+    notify_lenders();
+    return Admission::kQueued;
+  }
+
+  template <typename T>
+  static bool is_ready(const std::future<T>& future) {
+    return future.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  }
+
+  void worker(std::stop_token stop_token, size_t index) {
+    current_pool_ = this;
+    current_worker_index_ = index;
+    if (scheduler_) {
+      deterministic_worker(stop_token, index);
+      return;
+    }
+    WorkerRecorder& recorder = recorders_[index];
 
-  void worker(std::stop_token stop_token) {
     while (!stop_token.stop_requested()) {
-      std::function<void()> task;
+      QueuedTask task;
 
       {
         std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [&]() {
+        auto wake = [&]() {
           return !task_queue_.empty() ||
                  is_shutdown_.load(std::memory_order_relaxed) ||
-                 stop_token.stop_requested();
-        });
+                 stop_token.stop_requested() || borrowable();
+        };
+        recorder.idle_begin();
+        if (!wake()) {
+          trace(TraceEventType::kSleepBegin);
+          idle_workers_.fetch_add(1, std::memory_order_relaxed);
+          cv_.wait(lock, wake);
+          idle_workers_.fetch_sub(1, std::memory_order_relaxed);
+          trace(TraceEventType::kSleepEnd);
+        }
+        recorder.idle_end();
 
         // Check if we should exit
         if (stop_token.stop_requested() ||
@@ -100,19 +647,355 @@ class ThreadPool {
           return;
         }
 
-        // If we have tasks, get one
+        // If we have tasks, get one, otherwise help the borrower
         if (!task_queue_.empty()) {
           task = std::move(task_queue_.front());
-          task_queue_.pop();
+          task_queue_.pop_front();
+          note_dequeued();
         } else {
+          lock.unlock();
+          ThreadPool* borrower = borrower_.load(std::memory_order_acquire);
+          if (borrower != nullptr) borrower->run_for_lender();
           continue;
         }
       }  // unlocked
 
+      if (queue_capacity_ != 0) not_full_cv_.notify_one();
+
       if (task) {
-        task();
+        execute(task, false);
+        notify_helping_waiters();
+      }
+    }
+  }
+
+  // Whichever worker sees the pool free decides the next step and hands
+  // the task to the chosen worker, then every worker waits for it to finish
+  void deterministic_worker(std::stop_token stop_token, size_t index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto can_step = [this]() {
+      return !step_running_ && !paused_ && !task_queue_.empty();
+    };
+
+    while (true) {
+      cv_.wait(lock, [&]() {
+        return stop_token.stop_requested() || turn_ == index || can_step() ||
+               (is_shutdown_.load(std::memory_order_relaxed) &&
+                !step_running_ && task_queue_.empty());
+      });
+      if (stop_token.stop_requested()) return;
+
+      QueuedTask task;
+      if (turn_ == index) {
+        task = std::move(handoff_);
+        turn_.reset();
+      } else if (can_step()) {
+        ScheduleDecision decision =
+            scheduler_->next(task_queue_.size(), std::nullopt);
+        task = take_queued(decision.task);
+        step_running_ = true;
+        if (decision.worker != index) {
+          handoff_ = std::move(task);
+          turn_ = decision.worker;
+          cv_.notify_all();
+          continue;
+        }
+      } else {
+        // Shut down with nothing left to run
+        return;
+      }
+
+      lock.unlock();
+      execute(task, false);
+      lock.lock();
+      step_running_ = false;
+      // Wakes the next decider and any waiter
+      cv_.notify_all();
+    }
+  }
+
+  // A worker waiting inside a step runs further steps itself, outside
+  // threads only wait so that tasks stay on the scheduled workers
+  template <typename Predicate>
+  void help_deterministically(Predicate& done) {
+    bool is_worker = current_pool_ == this;
+    while (!done()) {
+      QueuedTask task;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto can_help = [&]() {
+          return is_worker && !paused_ && !task_queue_.empty();
+        };
+        cv_.wait_for(lock, kHelpPollInterval,
+                     [&]() { return can_help() || done(); });
+
+        if (can_help()) {
+          ScheduleDecision decision =
+              scheduler_->next(task_queue_.size(), current_worker_index_);
+          task = take_queued(decision.task);
+        }
+      }  // unlocked
+
+      if (task) {
+        execute(task, true);
+        notify_helping_waiters();
+      }
+    }
+  }
+
+  // Called with mutex_ held
+  QueuedTask take_queued(size_t position) {
+    auto it = task_queue_.begin() + static_cast<std::ptrdiff_t>(position);
+    QueuedTask task = std::move(*it);
+    task_queue_.erase(it);
+    note_dequeued();
+    return task;
+  }
+
+  void set_paused(bool paused) {
+    {
+      std::scoped_lock lock(mutex_);
+      if (!scheduler_) {
+        throw std::runtime_error("only a deterministic ThreadPool pauses");
+      }
+      paused_ = paused && !is_shutdown_.load(std::memory_order_relaxed);
+    }
+    cv_.notify_all();
+  }
+
+  void execute(QueuedTask& task, bool helped) {
+    trace(helped ? TraceEventType::kHelpBegin : TraceEventType::kTaskBegin);
+    task_depth_++;
+    execute_task(task, helped);
+    if (--task_depth_ == 0) scratch_arena().reset();
+    trace(helped ? TraceEventType::kHelpEnd : TraceEventType::kTaskEnd);
+  }
+
+  // Runs a dequeued task, timing it when a worker of this pool runs it.
+  // Work an outside thread picks up through help_until() is not attributed
+  void execute_task(QueuedTask& task, bool helped) {
+#if STL_THREAD_POOL_TELEMETRY
+    if (current_pool_ == this) {
+      WorkerRecorder& recorder = recorders_[current_worker_index_];
+      uint64_t started = recorder.task_begin(task.enqueued_ns);
+      task();
+      recorder.task_end(started, helped);
+      return;
+    }
+#else
+    (void)helped;
+#endif
+    task();
+  }
+
+  // Called with mutex_ held after every push, a batch counts as one submit
+  void note_enqueued() {
+    trace(TraceEventType::kSubmit);
+    queued_.store(task_queue_.size(), std::memory_order_relaxed);
+#if STL_THREAD_POOL_TELEMETRY
+    if (task_queue_.size() > max_queue_depth_) {
+      max_queue_depth_ = task_queue_.size();
+    }
+#endif
+  }
+
+  // Called with mutex_ held after every pop
+  void note_dequeued() {
+    queued_.store(task_queue_.size(), std::memory_order_relaxed);
+  }
+
+  bool borrowable() const noexcept {
+    ThreadPool* borrower = borrower_.load(std::memory_order_acquire);
+    return borrower != nullptr && borrower->saturated();
+  }
+
+  static constexpr uint32_t kAllLentSlots = (1u << kMaxLentThreads) - 1;
+
+  // Tasks queued, none of our workers idle to take them and a lent slot
+  // free, so a lender's worker would actually help
+  bool saturated() const noexcept {
+    return queued_.load(std::memory_order_relaxed) != 0 &&
+           idle_workers_.load(std::memory_order_relaxed) == 0 &&
+           lent_slots_.load(std::memory_order_relaxed) != kAllLentSlots;
+  }
+
+  std::optional<size_t> acquire_lent_slot() noexcept {
+    uint32_t used = lent_slots_.load(std::memory_order_relaxed);
+    while (used != kAllLentSlots) {
+      int slot = std::countr_one(used);
+      if (lent_slots_.compare_exchange_weak(used, used | (1u << slot),
+                                            std::memory_order_acquire)) {
+        return static_cast<size_t>(slot);
+      }
+    }
+    return std::nullopt;
+  }
+
+  void release_lent_slot(size_t slot) noexcept {
+    lent_slots_.fetch_and(~(1u << slot), std::memory_order_release);
+  }
+
+  // Runs one of our queued tasks on a lender's idle worker, in a lent slot
+  // so per-slot state is never shared with another thread
+  void run_for_lender() {
+    if (!saturated()) return;
+    std::optional<size_t> slot = acquire_lent_slot();
+    if (!slot) return;
+
+    QueuedTask task;
+    {
+      std::scoped_lock lock(mutex_);
+      if (!task_queue_.empty()) {
+        task = std::move(task_queue_.front());
+        task_queue_.pop_front();
+        note_dequeued();
       }
     }
+
+    if (task) {
+      if (queue_capacity_ != 0) not_full_cv_.notify_one();
+      lent_to_ = this;
+      lent_slot_ = *slot;
+      execute(task, false);
+      lent_to_ = nullptr;
+      notify_helping_waiters();
+    }
+    release_lent_slot(*slot);
+  }
+
+  void add_lender(ThreadPool* lender) {
+    std::scoped_lock lock(lenders_mutex_);
+    lenders_.push_back(lender);
+    has_lenders_.store(true, std::memory_order_release);
+  }
+
+  void remove_lender(ThreadPool* lender) {
+    std::scoped_lock lock(lenders_mutex_);
+    std::erase(lenders_, lender);
+    has_lenders_.store(!lenders_.empty(), std::memory_order_release);
+  }
+
+  // Wakes a lender's worker for work our own idle workers cannot take
+  void notify_lenders() {
+    if (!has_lenders_.load(std::memory_order_acquire)) return;
+    if (idle_workers_.load(std::memory_order_relaxed) != 0) return;
+
+    std::scoped_lock lock(lenders_mutex_);
+    for (ThreadPool* lender : lenders_) {
+      // Orders the notify after the lender's predicate check
+      { std::scoped_lock lender_lock(lender->mutex_); }
+      lender->cv_.notify_one();
+    }
+  }
+
+  // Rounds up so a timer never fires early
+  TimerWheel::Tick to_tick(std::chrono::steady_clock::time_point time_point) {
+    if (time_point <= timer_epoch_) return 0;
+    return std::chrono::ceil<std::chrono::milliseconds>(time_point -
+                                                        timer_epoch_)
+        .count();
+  }
+
+  // Rounds down, the last tick that has fully elapsed
+  TimerWheel::Tick current_tick() {
+    return std::chrono::floor<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - timer_epoch_)
+        .count();
+  }
+
+  template <typename F>
+  TimerId add_timer(TimerWheel::Tick expiry, F&& f, TimerWheel::Tick period) {
+    std::scoped_lock lock(timer_mutex_);
+    if (is_shutdown_.load(std::memory_order_relaxed)) {
+      throw std::runtime_error("ThreadPool is shut down");
+    }
+    if (!timer_thread_.joinable()) {
+      timer_thread_ = std::jthread(
+          [this](std::stop_token stop_token) { this->timer_loop(stop_token); });
+    }
+
+    TimerId id = timer_wheel_.insert(
+        expiry, std::function<void()>(std::forward<F>(f)), period);
+    if (expiry < timer_wakeup_tick_) {
+      timer_wakeup_tick_ = expiry;
+      timer_cv_.notify_one();
+    }
+    return id;
+  }
+
+  void timer_loop(std::stop_token stop_token) {
+    std::vector<std::function<void()>> expired;
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+
+    while (!stop_token.stop_requested()) {
+      timer_wheel_.advance(current_tick(), expired);
+
+      if (!expired.empty()) {
+        lock.unlock();
+        enqueue_batch(expired);
+        expired.clear();
+        lock.lock();
+        continue;
+      }
+
+      auto next = timer_wheel_.ticks_until_next();
+      if (!next) {
+        timer_wakeup_tick_ = UINT64_MAX;
+        timer_cv_.wait(lock);
+      } else {
+        timer_wakeup_tick_ = timer_wheel_.now() + *next;
+        timer_cv_.wait_until(lock,
+                             timer_epoch_ + timer_wakeup_tick_ * kTimerTick);
+      }
+    }
+  }
+
+  // Pushes a batch of tasks under a single lock acquisition. Like
+  // post_continuation() this ignores the capacity: the timer thread must not
+  // block, and the timers were admitted when they were scheduled
+  void enqueue_batch(std::vector<std::function<void()>>& tasks) {
+    {
+      std::scoped_lock lock(mutex_);
+      if (is_shutdown_.load(std::memory_order_relaxed)) return;
+      for (auto& task : tasks) {
+        task_queue_.emplace_back(std::move(task), true);
+      }
+      note_enqueued();
+    }
+
+    if (tasks.size() >= thread_workers_.size() || scheduler_) {
+      cv_.notify_all();
+    } else {
+      for (size_t i = 0; i < tasks.size(); i++) cv_.notify_one();
+    }
+    notify_lenders();
+  }
+
+  // Workers write their own ring, every other thread the shared one
+  void trace(TraceEventType type) noexcept {
+    Tracer* tracer = tracer_.load(std::memory_order_acquire);
+    if (tracer == nullptr) return;
+    tracer->record(
+        current_pool_ == this ? current_worker_index_ : tracer->external_ring(),
+        type);
+  }
+
+  // Outside threads waiting on a deterministic pool share cv_ with the
+  // workers without taking tasks, so a single notify could be lost on them
+  void notify_worker() {
+    if (scheduler_) {
+      cv_.notify_all();
+    } else {
+      cv_.notify_one();
+    }
+  }
+
+  void notify_helping_waiters() {
+    if (helping_waiters_.load(std::memory_order_relaxed) == 0) return;
+    // Taking the lock orders the notify after a waiter's predicate check
+    { std::scoped_lock lock(mutex_); }
+    cv_.notify_all();
   }
 };
 
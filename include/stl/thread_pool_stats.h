@@ -0,0 +1,221 @@
+/**
+ * @file thread_pool_stats.h
+ * @brief ThreadPool telemetry: latency histograms and per-worker counters
+ *
+ * Recording is compiled in only when STL_THREAD_POOL_TELEMETRY is 1 (CMake
+ * option of the same name). Otherwise the recorder is an empty struct whose
+ * hooks inline to nothing and ThreadPool::stats() returns an empty snapshot.
+ * The macro must have the same value in every translation unit of a program.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "stl/cache_line.h"
+
+#ifndef STL_THREAD_POOL_TELEMETRY
+#define STL_THREAD_POOL_TELEMETRY 0
+#endif
+
+namespace stl {
+
+// Latency histogram with power-of-two nanosecond buckets: bucket i counts
+// samples in [2^(i-1), 2^i), bucket 0 counts zeros. Cheap to record and
+// merge, percentiles are accurate to within a factor of two
+struct LatencyHistogram {
+  static constexpr size_t kBuckets = 48;
+
+  std::array<uint64_t, kBuckets> buckets{};
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+
+  static constexpr size_t bucket_for(uint64_t ns) noexcept {
+    size_t bucket = std::bit_width(ns);
+    return bucket < kBuckets ? bucket : kBuckets - 1;
+  }
+
+  void record(uint64_t ns) noexcept {
+    buckets[bucket_for(ns)]++;
+    count++;
+    total_ns += ns;
+    if (ns > max_ns) max_ns = ns;
+  }
+
+  void merge(const LatencyHistogram& other) noexcept {
+    for (size_t i = 0; i < kBuckets; i++) buckets[i] += other.buckets[i];
+    count += other.count;
+    total_ns += other.total_ns;
+    if (other.max_ns > max_ns) max_ns = other.max_ns;
+  }
+
+  [[nodiscard]] double mean_ns() const noexcept {
+    return count == 0 ? 0.0
+                      : static_cast<double>(total_ns) /
+                            static_cast<double>(count);
+  }
+
+  // Upper bound of the bucket holding the p-th percentile, p in [0, 100]
+  [[nodiscard]] uint64_t percentile_ns(double p) const noexcept {
+    if (count == 0) return 0;
+    auto rank =
+        static_cast<uint64_t>(p / 100.0 * static_cast<double>(count));
+    if (rank >= count) rank = count - 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+      seen += buckets[i];
+      if (seen > rank) {
+        uint64_t upper = i == 0 ? 0 : (uint64_t{1} << i) - 1;
+        return upper < max_ns ? upper : max_ns;
+      }
+    }
+    return max_ns;
+  }
+};
+
+struct WorkerStats {
+  // Time from submission until a thread picked the task up
+  LatencyHistogram queue_wait;
+  // Time spent inside the task
+  LatencyHistogram run_time;
+  uint64_t tasks_executed = 0;
+  // Tasks this worker ran on behalf of a blocked wait (help_until), the
+  // pool's equivalent of stealing since all workers share one queue
+  uint64_t tasks_helped = 0;
+  uint64_t busy_ns = 0;
+  uint64_t idle_ns = 0;
+
+  void merge(const WorkerStats& other) noexcept {
+    queue_wait.merge(other.queue_wait);
+    run_time.merge(other.run_time);
+    tasks_executed += other.tasks_executed;
+    tasks_helped += other.tasks_helped;
+    busy_ns += other.busy_ns;
+    idle_ns += other.idle_ns;
+  }
+};
+
+// Point-in-time view of a pool, merged from the per-worker recorders
+struct ThreadPoolStats {
+  std::vector<WorkerStats> workers;
+  WorkerStats total;
+  size_t queue_depth = 0;
+  size_t max_queue_depth = 0;
+
+  // Fraction of worker time spent running tasks
+  [[nodiscard]] double utilisation() const noexcept {
+    uint64_t elapsed = total.busy_ns + total.idle_ns;
+    return elapsed == 0 ? 0.0
+                        : static_cast<double>(total.busy_ns) /
+                              static_cast<double>(elapsed);
+  }
+};
+
+#if STL_THREAD_POOL_TELEMETRY
+
+inline uint64_t telemetry_now_ns() noexcept {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// Per-worker recorder. Only the owning worker writes, so updates are plain
+// relaxed load/store pairs (no locked instructions); snapshot() may run
+// concurrently on another thread and sees each counter atomically
+class alignas(kCacheLineSize) WorkerRecorder {
+ public:
+  void idle_begin() noexcept { idle_since_ = telemetry_now_ns(); }
+
+  void idle_end() noexcept {
+    add(idle_ns_, telemetry_now_ns() - idle_since_);
+  }
+
+  // Returns the start timestamp to hand back to task_end()
+  uint64_t task_begin(uint64_t enqueued_ns) noexcept {
+    uint64_t now = telemetry_now_ns();
+    record(queue_wait_, now > enqueued_ns ? now - enqueued_ns : 0);
+    return now;
+  }
+
+  void task_end(uint64_t started_ns, bool helped) noexcept {
+    uint64_t run = telemetry_now_ns() - started_ns;
+    record(run_time_, run);
+    // A helped task runs nested inside another task already counted as busy
+    if (!helped) add(busy_ns_, run);
+    add(helped ? tasks_helped_ : tasks_executed_, 1);
+  }
+
+  [[nodiscard]] WorkerStats snapshot() const noexcept {
+    WorkerStats stats;
+    copy(queue_wait_, stats.queue_wait);
+    copy(run_time_, stats.run_time);
+    stats.tasks_executed = tasks_executed_.load(std::memory_order_relaxed);
+    stats.tasks_helped = tasks_helped_.load(std::memory_order_relaxed);
+    stats.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+    stats.idle_ns = idle_ns_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  struct Histogram {
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> buckets{};
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> total_ns = 0;
+    std::atomic<uint64_t> max_ns = 0;
+  };
+
+  Histogram queue_wait_;
+  Histogram run_time_;
+  std::atomic<uint64_t> tasks_executed_ = 0;
+  std::atomic<uint64_t> tasks_helped_ = 0;
+  std::atomic<uint64_t> busy_ns_ = 0;
+  std::atomic<uint64_t> idle_ns_ = 0;
+  uint64_t idle_since_ = 0;
+
+  static void add(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  static void record(Histogram& histogram, uint64_t ns) noexcept {
+    add(histogram.buckets[LatencyHistogram::bucket_for(ns)], 1);
+    add(histogram.count, 1);
+    add(histogram.total_ns, ns);
+    if (ns > histogram.max_ns.load(std::memory_order_relaxed)) {
+      histogram.max_ns.store(ns, std::memory_order_relaxed);
+    }
+  }
+
+  static void copy(const Histogram& from, LatencyHistogram& to) noexcept {
+    for (size_t i = 0; i < LatencyHistogram::kBuckets; i++) {
+      to.buckets[i] = from.buckets[i].load(std::memory_order_relaxed);
+    }
+    to.count = from.count.load(std::memory_order_relaxed);
+    to.total_ns = from.total_ns.load(std::memory_order_relaxed);
+    to.max_ns = from.max_ns.load(std::memory_order_relaxed);
+  }
+};
+
+#else
+
+// Telemetry compiled out: every hook is an empty inline function
+struct WorkerRecorder {
+  void idle_begin() noexcept {}
+  void idle_end() noexcept {}
+  uint64_t task_begin(uint64_t /*enqueued_ns*/) noexcept { return 0; }
+  void task_end(uint64_t /*started_ns*/, bool /*helped*/) noexcept {}
+  [[nodiscard]] WorkerStats snapshot() const noexcept { return {}; }
+};
+
+#endif
+
+}  // namespace stl
@@ -0,0 +1,247 @@
+/**
+ * @file timer_wheel.h
+ * @brief Implementation of hierarchical timing wheel (Varghese & Lauck)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace stl {
+
+// Handle to a pending timer. The generation makes stale handles harmless once
+// the slot has been reused by another timer
+struct TimerId {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+
+  friend bool operator==(const TimerId&, const TimerId&) = default;
+};
+
+// Single-threaded hierarchical timing wheel. Time is measured in abstract
+// ticks; the owner decides what a tick is and drives the wheel with advance().
+// Insert and cancel are O(1): timers live in a slab and are linked into slots
+// by index, so nothing is searched or shifted.
+class TimerWheel {
+ public:
+  using Tick = uint64_t;
+  using Callback = std::function<void()>;
+
+  static constexpr size_t kSlotBits = 8;
+  static constexpr size_t kSlots = size_t{1} << kSlotBits;
+  static constexpr size_t kLevels = 4;
+
+  explicit TimerWheel(Tick start_tick = 0) : now_(start_tick) {
+    for (auto& level : slots_) level.fill(kNil);
+  }
+
+  // Fires at the first advance() reaching `expiry`, then every `period` ticks
+  // when period is non-zero. Expiries in the past fire on the next tick. A
+  // periodic timer that an advance() leaves several periods behind fires
+  // once for all of them rather than in a burst, and keeps its phase
+  TimerId insert(Tick expiry, Callback callback, Tick period = 0) {
+    uint32_t index = allocate();
+    Node& node = nodes_[index];
+    node.expiry = expiry <= now_ ? now_ + 1 : expiry;
+    node.period = period;
+    node.callback = std::move(callback);
+    node.active = true;
+    link(index);
+    size_++;
+
+    return TimerId{index, node.generation};
+  }
+
+  // Returns false if the timer already fired (one-shot) or was cancelled
+  bool cancel(TimerId id) {
+    if (id.index >= nodes_.size()) return false;
+    Node& node = nodes_[id.index];
+    if (!node.active || node.generation != id.generation) return false;
+
+    unlink(id.index);
+    release(id.index);
+    size_--;
+    return true;
+  }
+
+  // Moves the wheel forward to `now`, appending every expired callback to
+  // `expired` in expiry order. Periodic timers are re-armed with a copy.
+  // Only ticks with something to fire or cascade are visited
+  void advance(Tick now, std::vector<Callback>& expired) {
+    while (size_ != 0) {
+      Tick next = next_event_tick();
+      if (next > now) break;
+
+      now_ = next;
+      cascade();
+      fire_slot(now_ & kMask, now, expired);
+    }
+    if (now_ < now) now_ = now;
+  }
+
+  // Ticks until the next expiry or cascade, nullopt when empty. Exact for
+  // timers already on level 0, a lower bound for the rest
+  [[nodiscard]] std::optional<Tick> ticks_until_next() const {
+    if (size_ == 0) return std::nullopt;
+    return next_event_tick() - now_;
+  }
+
+  [[nodiscard]] Tick now() const noexcept { return now_; }
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr Tick kMask = kSlots - 1;
+
+  struct Node {
+    Tick expiry = 0;
+    Tick period = 0;
+    Callback callback;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    uint32_t generation = 0;
+    uint16_t level = 0;
+    uint16_t slot = 0;
+    bool active = false;
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_list_;
+  std::array<std::array<uint32_t, kSlots>, kLevels> slots_;
+  Tick now_;
+  size_t size_ = 0;
+
+  uint32_t allocate() {
+    if (!free_list_.empty()) {
+      uint32_t index = free_list_.back();
+      free_list_.pop_back();
+      return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  void release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.callback = nullptr;
+    node.active = false;
+    // Invalidate outstanding handles
+    node.generation++;
+    free_list_.push_back(index);
+  }
+
+  // A timer goes on the lowest level whose window still contains both now_
+  // and its expiry, in the slot picked by that level's digit of the expiry
+  void link(uint32_t index) {
+    Node& node = nodes_[index];
+    size_t level = 0;
+    while (level < kLevels &&
+           (node.expiry >> (kSlotBits * (level + 1))) !=
+               (now_ >> (kSlotBits * (level + 1)))) {
+      level++;
+    }
+
+    size_t slot = 0;
+    if (level == kLevels) {
+      // Beyond the wheel's range: park in top slot 0, which only a new
+      // top level window cascades, and re-evaluate from there
+      level = kLevels - 1;
+      slot = 0;
+    } else {
+      slot = (node.expiry >> (kSlotBits * level)) & kMask;
+    }
+
+    node.level = static_cast<uint16_t>(level);
+    node.slot = static_cast<uint16_t>(slot);
+    node.prev = kNil;
+    node.next = slots_[level][slot];
+    if (node.next != kNil) nodes_[node.next].prev = index;
+    slots_[level][slot] = index;
+  }
+
+  void unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.prev != kNil) {
+      nodes_[node.prev].next = node.next;
+    } else {
+      slots_[node.level][node.slot] = node.next;
+    }
+    if (node.next != kNil) nodes_[node.next].prev = node.prev;
+  }
+
+  // First tick after now_ whose slot is non-empty on some level. Level l
+  // slots are visited at multiples of 256^l until the enclosing window of
+  // level l + 1 ends; the top level wraps around to reach parked timers
+  [[nodiscard]] Tick next_event_tick() const {
+    for (size_t level = 0; level < kLevels; level++) {
+      size_t shift = kSlotBits * level;
+      Tick first = ((now_ >> shift) + 1) << shift;
+      Tick count = kSlots;
+      if (level + 1 < kLevels) {
+        Tick window_end = ((now_ >> (shift + kSlotBits)) + 1)
+                          << (shift + kSlotBits);
+        count = (window_end - first) >> shift;
+      }
+
+      for (Tick i = 0; i < count; i++) {
+        Tick tick = first + (i << shift);
+        if (slots_[level][(tick >> shift) & kMask] != kNil) return tick;
+      }
+    }
+    return now_ + 1;
+  }
+
+  // Entering a new window of a level redistributes the matching slot of the
+  // level above, highest level first so timers can fall several levels
+  void cascade() {
+    size_t levels = 0;
+    while (levels + 1 < kLevels) {
+      Tick window = Tick{1} << (kSlotBits * (levels + 1));
+      if ((now_ & (window - 1)) != 0) break;
+      levels++;
+    }
+
+    for (size_t level = levels; level >= 1; level--) {
+      size_t slot = (now_ >> (kSlotBits * level)) & kMask;
+      uint32_t index = std::exchange(slots_[level][slot], kNil);
+      while (index != kNil) {
+        uint32_t next = nodes_[index].next;
+        link(index);
+        index = next;
+      }
+    }
+  }
+
+  void fire_slot(size_t slot, Tick target, std::vector<Callback>& expired) {
+    uint32_t index = std::exchange(slots_[0][slot], kNil);
+    while (index != kNil) {
+      Node& node = nodes_[index];
+      uint32_t next = node.next;
+
+      if (node.period != 0) {
+        expired.push_back(node.callback);
+        node.expiry += node.period;
+        // Skip the periods missed up to the advance() target
+        if (node.expiry <= target) {
+          node.expiry += ((target - node.expiry) / node.period + 1) *
+                         node.period;
+        }
+        link(index);
+      } else {
+        expired.push_back(std::move(node.callback));
+        release(index);
+        size_--;
+      }
+      index = next;
+    }
+  }
+};
+
+}  // namespace stl
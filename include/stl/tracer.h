@@ -0,0 +1,226 @@
+/**
+ * @file tracer.h
+ * @brief Task tracer with per-thread ring buffers and Chrome trace-event
+ * JSON output (loadable in chrome://tracing and ui.perfetto.dev)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "stl/cache_line.h"
+
+namespace stl {
+
+enum class TraceEventType : uint8_t {
+  kTaskBegin,
+  kTaskEnd,
+  // A task run by a thread blocked in a wait (ThreadPool::help_until)
+  kHelpBegin,
+  kHelpEnd,
+  kSubmit,
+  kSleepBegin,
+  kSleepEnd,
+};
+
+struct TraceEvent {
+  uint64_t timestamp = 0;
+  TraceEventType type = TraceEventType::kTaskBegin;
+};
+
+// Fixed-size flight recorder: keeps the newest Capacity events, overwriting
+// the oldest. Single-writer rings bump the head with a plain store, shared
+// rings claim slots with fetch_add
+class TraceRing {
+ public:
+  explicit TraceRing(size_t capacity) : events_(round_up(capacity)) {}
+
+  void record(TraceEventType type, uint64_t timestamp, bool shared) noexcept {
+    uint64_t slot = 0;
+    if (shared) {
+      slot = head_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      slot = head_.load(std::memory_order_relaxed);
+      head_.store(slot + 1, std::memory_order_release);
+    }
+    events_[slot & (events_.size() - 1)] = TraceEvent{timestamp, type};
+  }
+
+  // Oldest to newest. Only consistent once the writers are quiet
+  [[nodiscard]] std::vector<TraceEvent> events() const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t count = head < events_.size() ? head : events_.size();
+
+    std::vector<TraceEvent> out;
+    out.reserve(count);
+    for (uint64_t i = head - count; i < head; i++) {
+      out.push_back(events_[i & (events_.size() - 1)]);
+    }
+    return out;
+  }
+
+  // Events recorded so far, including overwritten ones
+  [[nodiscard]] uint64_t recorded() const noexcept {
+    return head_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static size_t round_up(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    return size;
+  }
+
+  std::vector<TraceEvent> events_;
+  alignas(kCacheLineSize) std::atomic<uint64_t> head_ = 0;
+};
+
+// One ring per worker plus a shared ring for every other thread (external
+// submitters, the timer thread). Timestamps are raw TSC reads where
+// available, converted to microseconds at dump time by calibrating against
+// steady_clock over the tracer's lifetime.
+class Tracer {
+ public:
+  explicit Tracer(size_t num_workers, size_t events_per_ring = 1 << 16)
+      : start_tsc_(now()), start_time_(std::chrono::steady_clock::now()) {
+    rings_.reserve(num_workers + 1);
+    for (size_t i = 0; i < num_workers + 1; i++) {
+      rings_.push_back(std::make_unique<TraceRing>(events_per_ring));
+    }
+  }
+
+  // Ring index for threads that are not workers
+  [[nodiscard]] size_t external_ring() const noexcept {
+    return rings_.size() - 1;
+  }
+
+  [[nodiscard]] size_t num_rings() const noexcept { return rings_.size(); }
+
+  // Indices past the worker rings go to the shared ring
+  void record(size_t ring, TraceEventType type) noexcept {
+    bool shared = ring >= external_ring();
+    rings_[shared ? external_ring() : ring]->record(type, now(), shared);
+  }
+
+  [[nodiscard]] const TraceRing& ring(size_t index) const {
+    return *rings_[index];
+  }
+
+  static uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+  }
+
+  // Chrome trace-event JSON: one track per ring, tasks and sleeps as
+  // duration events, submissions as instant events
+  void write_chrome_trace(std::ostream& out) const {
+    double ticks_per_us = calibrate();
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+      if (!first) out << ",";
+      first = false;
+    };
+
+    for (size_t tid = 0; tid < rings_.size(); tid++) {
+      separator();
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+          << ",\"args\":{\"name\":\""
+          << (tid == external_ring() ? std::string("external")
+                                     : "worker " + std::to_string(tid))
+          << "\"}}";
+
+      for (const TraceEvent& event : rings_[tid]->events()) {
+        separator();
+        double ts = static_cast<double>(event.timestamp - start_tsc_) /
+                    ticks_per_us;
+        out << "{\"name\":\"" << name(event.type) << "\",\"ph\":\""
+            << phase(event.type) << "\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << std::to_string(ts);
+        if (event.type == TraceEventType::kSubmit) out << ",\"s\":\"t\"";
+        out << "}";
+      }
+    }
+    out << "]}\n";
+  }
+
+  // Returns false if the file could not be written
+  bool write_chrome_trace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+    write_chrome_trace(file);
+    return static_cast<bool>(file);
+  }
+
+ private:
+  std::vector<std::unique_ptr<TraceRing>> rings_;
+  uint64_t start_tsc_;
+  std::chrono::steady_clock::time_point start_time_;
+
+  double calibrate() const {
+#if defined(__x86_64__) || defined(__i386__)
+    double elapsed_us = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start_time_)
+                            .count();
+    double ticks = static_cast<double>(now() - start_tsc_);
+    return elapsed_us > 0 && ticks > 0 ? ticks / elapsed_us : 1.0;
+#else
+    // Timestamps are already nanoseconds
+    return 1000.0;
+#endif
+  }
+
+  static const char* name(TraceEventType type) {
+    switch (type) {
+      case TraceEventType::kTaskBegin:
+      case TraceEventType::kTaskEnd:
+        return "task";
+      case TraceEventType::kHelpBegin:
+      case TraceEventType::kHelpEnd:
+        return "helped task";
+      case TraceEventType::kSubmit:
+        return "submit";
+      case TraceEventType::kSleepBegin:
+      case TraceEventType::kSleepEnd:
+        return "sleep";
+    }
+    return "unknown";
+  }
+
+  static const char* phase(TraceEventType type) {
+    switch (type) {
+      case TraceEventType::kTaskBegin:
+      case TraceEventType::kHelpBegin:
+      case TraceEventType::kSleepBegin:
+        return "B";
+      case TraceEventType::kTaskEnd:
+      case TraceEventType::kHelpEnd:
+      case TraceEventType::kSleepEnd:
+        return "E";
+      case TraceEventType::kSubmit:
+        return "i";
+    }
+    return "i";
+  }
+};
+
+}  // namespace stl
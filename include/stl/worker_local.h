@@ -0,0 +1,60 @@
+/**
+ * @file worker_local.h
+ * @brief Implementation of per-worker state for ThreadPool tasks
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "stl/cache_line.h"
+#include "stl/thread_pool.h"
+
+namespace stl {
+
+// One T per worker of a pool, each on its own cache line, so tasks can
+// accumulate into local() without atomics or false sharing and the results
+// are folded afterwards with combine(). Workers lent by another pool get
+// slots of their own too, see ThreadPool::current_slot(). Other threads
+// (an outside thread helping in wait()) share one extra slot, so at most
+// one of them may use local() at a time.
+template <typename T>
+class WorkerLocal {
+ public:
+  explicit WorkerLocal(ThreadPool& pool, const T& init = T{})
+      : pool_(pool), slots_(pool.slot_count() + 1, Slot{init}) {}
+
+  [[nodiscard]] T& local() noexcept {
+    return slots_[pool_.current_slot().value_or(pool_.slot_count())].value;
+  }
+
+  // Folds every slot left to right with op(T, T), starting from the first
+  // worker's. Only meaningful once the tasks writing the slots finished
+  template <typename BinaryOp>
+  [[nodiscard]] T combine(BinaryOp op) const {
+    T result = slots_[0].value;
+    for (size_t i = 1; i < slots_.size(); i++) {
+      result = op(result, slots_[i].value);
+    }
+    return result;
+  }
+
+  template <typename F>
+  void for_each(F&& f) {
+    for (auto& slot : slots_) f(slot.value);
+  }
+
+  // Worker and lent-thread slots plus the shared one
+  [[nodiscard]] size_t size() const noexcept { return slots_.size(); }
+
+ private:
+  struct alignas(kCacheLineSize) Slot {
+    T value;
+  };
+
+  ThreadPool& pool_;
+  std::vector<Slot> slots_;
+};
+
+}  // namespace stl
@@ -0,0 +1,220 @@
+#define CATCH_CONFIG_MAIN
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "stl/actor.h"
+#include "stl/deterministic_schedule.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+struct Tagged {
+  int sender = 0;
+  int sequence = 0;
+};
+
+void wait_idle(const auto& actor) {
+  while (actor.pending() != 0) std::this_thread::yield();
+}
+
+}  // namespace
+
+TEST_CASE("Actor") {
+  SECTION("Handles every message one at a time") {
+    stl::ThreadPool pool(4);
+    std::atomic<int> handled = 0;
+    std::atomic<int> inside = 0;
+    std::atomic<bool> overlapped = false;
+
+    {
+      stl::Actor<int> actor(pool, [&](int) {
+        if (inside.fetch_add(1) != 0) overlapped = true;
+        handled++;
+        inside.fetch_sub(1);
+      });
+
+      std::vector<std::jthread> senders;
+      for (int t = 0; t < 4; t++) {
+        senders.emplace_back([&actor]() {
+          for (int i = 0; i < 5000; i++) actor.send(i);
+        });
+      }
+    }  // senders joined, then the actor drains
+
+    REQUIRE(handled.load() == 20000);
+    REQUIRE_FALSE(overlapped);
+  }
+
+  SECTION("Keeps each sender's order through the overflow") {
+    stl::ThreadPool pool(2);
+    std::vector<int> last(4, -1);
+    bool in_order = true;
+
+    {
+      // A two-slot mailbox spills constantly
+      stl::Actor<Tagged, std::function<void(Tagged)>, 2> actor(
+          pool, [&](Tagged message) {
+            if (message.sequence != last[message.sender] + 1) in_order = false;
+            last[message.sender] = message.sequence;
+          });
+
+      std::vector<std::jthread> senders;
+      for (int t = 0; t < 4; t++) {
+        senders.emplace_back([&actor, t]() {
+          for (int i = 0; i < 20000; i++) actor.send(Tagged{t, i});
+        });
+      }
+    }
+
+    REQUIRE(in_order);
+    for (int sequence : last) REQUIRE(sequence == 19999);
+  }
+
+  SECTION("Is scheduled once per idle to busy transition") {
+    stl::ThreadPool pool(2, stl::DeterministicSchedule{1, {}});
+    std::atomic<int> handled = 0;
+    stl::Actor<int> actor(pool, [&](int) { handled++; });
+
+    pool.pause();
+    for (int i = 0; i < 10; i++) actor.send(i);
+    REQUIRE(pool.queue_depth() == 1);
+    pool.resume();
+    wait_idle(actor);
+    REQUIRE(handled.load() == 10);
+    REQUIRE(pool.schedule_log().size() == 1);
+
+    // Idle again, the next message schedules it anew
+    actor.send(10);
+    wait_idle(actor);
+    REQUIRE(handled.load() == 11);
+    REQUIRE(pool.schedule_log().size() == 2);
+  }
+
+  SECTION("Yields the worker after its quota") {
+    stl::ThreadPool pool(1);
+    std::atomic<int> busy_handled = 0;
+    std::atomic<int> busy_handled_before_quiet = -1;
+
+    stl::Actor<int> busy(pool, [&](int) { busy_handled++; }, 8);
+    stl::Actor<int> quiet(
+        pool, [&](int) { busy_handled_before_quiet = busy_handled.load(); });
+
+    // Hold the only worker so both actors are queued before either runs
+    std::promise<void> release;
+    std::atomic<bool> started = false;
+    pool.post([&started, gate = release.get_future().share()]() {
+      started = true;
+      gate.wait();
+    });
+    while (!started.load()) std::this_thread::yield();
+
+    for (int i = 0; i < 100; i++) busy.send(i);
+    quiet.send(0);
+    release.set_value();
+
+    wait_idle(busy);
+    wait_idle(quiet);
+    REQUIRE(busy_handled.load() == 100);
+    REQUIRE(busy_handled_before_quiet.load() == 8);
+  }
+
+  SECTION("Handlers can send to themselves and to others") {
+    stl::ThreadPool pool(2);
+    std::atomic<int> rounds = 0;
+    std::unique_ptr<stl::Actor<int>> ping;
+    std::unique_ptr<stl::Actor<int>> pong;
+
+    ping = std::make_unique<stl::Actor<int>>(pool, [&](int n) {
+      if (n > 0) pong->send(n - 1);
+    });
+    pong = std::make_unique<stl::Actor<int>>(pool, [&](int n) {
+      rounds++;
+      if (n > 0) ping->send(n - 1);
+    });
+
+    ping->send(1000);
+    while (rounds.load() != 500) std::this_thread::yield();
+    // Both drained before either is destroyed
+    wait_idle(*ping);
+    wait_idle(*pong);
+  }
+
+  SECTION("Idle actors are small") {
+    struct Counter {
+      int64_t* total;
+      void operator()(int64_t n) { *total += n; }
+    };
+    using Small = stl::Actor<int64_t, Counter>;
+    REQUIRE(sizeof(Small) <= 256);
+
+    stl::ThreadPool pool(4);
+    constexpr size_t kActors = 100'000;
+    std::vector<int64_t> totals(kActors, 0);
+    std::vector<std::unique_ptr<Small>> actors;
+    actors.reserve(kActors);
+    for (size_t i = 0; i < kActors; i++) {
+      actors.push_back(std::make_unique<Small>(pool, Counter{&totals[i]}));
+    }
+
+    for (size_t i = 0; i < kActors; i++) {
+      actors[i]->send(static_cast<int64_t>(i));
+    }
+    actors.clear();  // Each destructor waits for its message
+
+    for (size_t i = 0; i < kActors; i++) {
+      REQUIRE(totals[i] == static_cast<int64_t>(i));
+    }
+  }
+}
+
+TEST_CASE("Actor across pool shutdown") {
+  SECTION("A run past its quota finishes the mailbox") {
+    stl::ThreadPool pool(2);
+    std::vector<int> handled;
+    std::atomic<bool> release = false;
+
+    {
+      // Holds the actor on its worker until the pool is shut down, so the
+      // quota finds the pool refusing continuations
+      stl::Actor<int> actor(
+          pool,
+          [&](int n) {
+            if (n < 0) {
+              while (!release.load()) std::this_thread::yield();
+            } else {
+              handled.push_back(n);
+            }
+          },
+          8);
+      actor.send(-1);
+      for (int i = 0; i < 200; i++) actor.send(i);
+      pool.shutdown();
+      release.store(true);
+    }
+
+    REQUIRE(handled.size() == 200);
+    for (int i = 0; i < 200; i++) {
+      REQUIRE(handled[i] == i);
+    }
+  }
+
+  SECTION("Sending after shutdown runs the handler on the caller") {
+    stl::ThreadPool pool(1);
+    pool.shutdown();
+    std::thread::id ran_on;
+    stl::Actor<int> actor(pool,
+                          [&](int) { ran_on = std::this_thread::get_id(); });
+
+    actor.send(1);
+
+    REQUIRE(ran_on == std::this_thread::get_id());
+    REQUIRE(actor.pending() == 0);
+  }
+}
@@ -0,0 +1,72 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+
+#include "stl/arena.h"
+
+TEST_CASE("MonotonicArena allocation") {
+  SECTION("Starts empty and allocates lazily") {
+    stl::MonotonicArena arena(256);
+
+    REQUIRE(arena.bytes_used() == 0);
+    REQUIRE(arena.capacity() == 0);
+
+    void* p = arena.allocate(16);
+    REQUIRE(p != nullptr);
+    REQUIRE(arena.capacity() == 256);
+    REQUIRE(arena.bytes_used() == 16);
+  }
+
+  SECTION("Respects alignment") {
+    stl::MonotonicArena arena(1024);
+    arena.allocate(1, 1);
+
+    for (size_t alignment : {2, 8, 16, 64, 256}) {
+      auto address = reinterpret_cast<uintptr_t>(arena.allocate(3, alignment));
+      REQUIRE(address % alignment == 0);
+    }
+    REQUIRE_THROWS_AS(arena.allocate(8, 3), std::invalid_argument);
+  }
+
+  SECTION("Allocations do not overlap") {
+    stl::MonotonicArena arena(64);
+    int* values[100];
+    for (int i = 0; i < 100; ++i) values[i] = arena.create<int>(i);
+    for (int i = 0; i < 100; ++i) REQUIRE(*values[i] == i);
+  }
+
+  SECTION("Oversized requests get their own block") {
+    stl::MonotonicArena arena(64);
+    auto* big = arena.allocate_array<char>(10000);
+    big[9999] = 'x';
+
+    REQUIRE(arena.capacity() >= 10000);
+  }
+}
+
+TEST_CASE("MonotonicArena reset") {
+  SECTION("Reset reuses the same memory") {
+    stl::MonotonicArena arena(128);
+    void* first = arena.allocate(32);
+    arena.reset();
+
+    REQUIRE(arena.bytes_used() == 0);
+    REQUIRE(arena.allocate(32) == first);
+  }
+
+  SECTION("Reset merges chained blocks into one") {
+    stl::MonotonicArena arena(64);
+    for (int i = 0; i < 50; ++i) arena.allocate(32);
+    REQUIRE(arena.num_blocks() > 1);
+
+    size_t capacity = arena.capacity();
+    arena.reset();
+    REQUIRE(arena.num_blocks() == 1);
+    REQUIRE(arena.capacity() == capacity);
+
+    // The same workload now fits in the merged block
+    for (int i = 0; i < 50; ++i) arena.allocate(32);
+    REQUIRE(arena.num_blocks() == 1);
+  }
+}
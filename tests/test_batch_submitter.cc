@@ -0,0 +1,139 @@
+#define CATCH_CONFIG_MAIN
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "stl/batch_submitter.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+// Polls until pred() holds or a generous timeout passes
+template <typename Predicate>
+bool eventually(Predicate pred) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("BatchSubmitter batching") {
+  SECTION("A full buffer is shipped as one batch") {
+    std::atomic<int> counter = 0;
+    stl::ThreadPool pool(2);
+    stl::BatchSubmitter submitter(pool, 4, std::chrono::hours(1));
+
+    for (int i = 0; i < 3; ++i) submitter.post([&counter]() { counter++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(counter == 0);
+    REQUIRE(submitter.buffered() == 3);
+
+    submitter.post([&counter]() { counter++; });
+    REQUIRE(submitter.buffered() == 0);
+    REQUIRE(eventually([&]() { return counter == 4; }));
+  }
+
+  SECTION("Tasks of a batch run in order") {
+    std::mutex mutex;
+    std::vector<int> order;
+    stl::ThreadPool pool(4);
+    stl::BatchSubmitter submitter(pool, 100, std::chrono::hours(1));
+
+    for (int i = 0; i < 100; ++i) {
+      submitter.post([&, i]() {
+        std::scoped_lock lock(mutex);
+        order.push_back(i);
+      });
+    }
+    REQUIRE(eventually([&]() {
+      std::scoped_lock lock(mutex);
+      return order.size() == 100;
+    }));
+    for (int i = 0; i < 100; ++i) REQUIRE(order[i] == i);
+  }
+
+  SECTION("Explicit flush") {
+    std::atomic<int> counter = 0;
+    stl::ThreadPool pool(2);
+    stl::BatchSubmitter submitter(pool, 64, std::chrono::hours(1));
+
+    for (int i = 0; i < 10; ++i) submitter.post([&counter]() { counter++; });
+    submitter.flush();
+
+    REQUIRE(submitter.buffered() == 0);
+    REQUIRE(eventually([&]() { return counter == 10; }));
+    REQUIRE(pool.pending_timers() == 0);
+  }
+
+  SECTION("Deadline ships a partial batch") {
+    std::atomic<int> counter = 0;
+    stl::ThreadPool pool(2);
+    stl::BatchSubmitter submitter(pool, 1000, std::chrono::milliseconds(5));
+
+    for (int i = 0; i < 10; ++i) submitter.post([&counter]() { counter++; });
+
+    REQUIRE(eventually([&]() { return counter == 10; }));
+    REQUIRE(submitter.buffered() == 0);
+  }
+
+  SECTION("Destructor flushes") {
+    std::atomic<int> counter = 0;
+    stl::ThreadPool pool(2);
+
+    {
+      stl::BatchSubmitter submitter(pool, 64, std::chrono::hours(1));
+      for (int i = 0; i < 10; ++i) submitter.post([&counter]() { counter++; });
+    }
+
+    REQUIRE(eventually([&]() { return counter == 10; }));
+  }
+
+  SECTION("Zero batch size is rejected") {
+    stl::ThreadPool pool(1);
+    REQUIRE_THROWS_AS(stl::BatchSubmitter(pool, 0), std::invalid_argument);
+  }
+}
+
+TEST_CASE("BatchSubmitter concurrency") {
+  SECTION("Several producers share one submitter") {
+    std::atomic<int> counter = 0;
+    stl::ThreadPool pool(4);
+    stl::BatchSubmitter submitter(pool, 32, std::chrono::milliseconds(1));
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+      producers.emplace_back([&]() {
+        for (int i = 0; i < 2500; ++i) {
+          submitter.post([&counter]() { counter++; });
+        }
+      });
+    }
+    for (auto& producer : producers) producer.join();
+    submitter.flush();
+
+    REQUIRE(eventually([&]() { return counter == 10000; }));
+  }
+
+  SECTION("Posting from a worker") {
+    std::atomic<int> counter = 0;
+    stl::ThreadPool pool(2);
+    stl::BatchSubmitter submitter(pool, 8, std::chrono::milliseconds(1));
+
+    pool.submit_task([&]() {
+          for (int i = 0; i < 100; ++i) {
+            submitter.post([&counter]() { counter++; });
+          }
+        })
+        .get();
+
+    REQUIRE(eventually([&]() { return counter == 100; }));
+  }
+}
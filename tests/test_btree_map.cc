@@ -0,0 +1,229 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "stl/btree_map.h"
+#include "stl/vector.h"
+
+using stl::BTreeMap;
+
+namespace {
+
+// Counts live objects, so leaks and double destruction both show
+struct Tracked {
+  static inline int live = 0;
+  int value;
+  explicit Tracked(int value) : value(value) { live++; }
+  Tracked(const Tracked& other) : value(other.value) { live++; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { live++; }
+  Tracked& operator=(const Tracked&) = default;
+  ~Tracked() { live--; }
+};
+
+template <typename Map, typename Expected>
+void require_same(const Map& map, const Expected& expected) {
+  REQUIRE(map.size() == expected.size());
+  auto it = map.begin();
+  for (const auto& [key, value] : expected) {
+    REQUIRE(it != map.end());
+    REQUIRE(it->first == key);
+    REQUIRE(it->second == value);
+    ++it;
+  }
+  REQUIRE(it == map.end());
+}
+
+// Random inserts, erases and lookups against std::map
+template <typename K>
+void check_random_operations(uint64_t seed, uint64_t key_range) {
+  std::mt19937_64 rng(seed);
+  BTreeMap<K, uint64_t> map;
+  std::map<K, uint64_t> expected;
+  for (int i = 0; i < 200000; i++) {
+    K key = static_cast<K>(rng() % key_range) - static_cast<K>(key_range / 3);
+    switch (rng() % 4) {
+      case 0:
+      case 1: {
+        bool inserted = map.try_emplace(key, uint64_t(i)).second;
+        REQUIRE(inserted == expected.try_emplace(key, uint64_t(i)).second);
+        break;
+      }
+      case 2:
+        REQUIRE(map.erase(key) == expected.erase(key));
+        break;
+      case 3: {
+        auto it = map.lower_bound(key);
+        auto want = expected.lower_bound(key);
+        if (want == expected.end()) {
+          REQUIRE(it == map.end());
+        } else {
+          REQUIRE(it->first == want->first);
+          REQUIRE(it->second == want->second);
+        }
+        break;
+      }
+    }
+  }
+  require_same(map, expected);
+}
+
+}  // namespace
+
+TEST_CASE("BTreeMap basic operations", "[btree_map]") {
+  BTreeMap<int, std::string> map;
+  REQUIRE(map.empty());
+  REQUIRE(map.begin() == map.end());
+  REQUIRE(map.find(1) == map.end());
+  REQUIRE(map.erase(1) == 0);
+
+  REQUIRE(map.insert({2, "two"}).second);
+  REQUIRE(map.try_emplace(1, "one").second);
+  REQUIRE_FALSE(map.try_emplace(1, "uno").second);
+  map[3] = "three";
+  REQUIRE(map.size() == 3);
+  REQUIRE(map.at(1) == "one");
+  REQUIRE(map.contains(3));
+  REQUIRE(map.count(4) == 0);
+  REQUIRE_THROWS_AS(map.at(4), std::out_of_range);
+
+  REQUIRE_FALSE(map.insert_or_assign(2, "deux").second);
+  REQUIRE(map.find(2)->second == "deux");
+
+  REQUIRE(map.erase(2) == 1);
+  REQUIRE_FALSE(map.contains(2));
+  REQUIRE(map.begin()->first == 1);
+  REQUIRE(std::prev(map.end())->first == 3);
+}
+
+TEST_CASE("BTreeMap matches std::map on random operations",
+          "[btree_map]") {
+  // A small key range keeps nodes splitting and merging back and forth
+  check_random_operations<int64_t>(1, 5000);
+  check_random_operations<uint64_t>(2, 1 << 20);
+  check_random_operations<int32_t>(3, 3000);
+  check_random_operations<uint32_t>(4, 1 << 20);
+}
+
+TEST_CASE("BTreeMap with non-integer keys and a custom order",
+          "[btree_map]") {
+  std::mt19937 rng(5);
+  BTreeMap<std::string, int, std::greater<std::string>> map;
+  std::map<std::string, int, std::greater<std::string>> expected;
+  for (int i = 0; i < 20000; i++) {
+    std::string key = "key_" + std::to_string(rng() % 3000);
+    if (rng() % 3 == 0) {
+      REQUIRE(map.erase(key) == expected.erase(key));
+    } else {
+      map[key] = i;
+      expected[key] = i;
+    }
+  }
+  require_same(map, expected);
+}
+
+TEST_CASE("BTreeMap loads in order and scans ranges", "[btree_map]") {
+  constexpr uint64_t kEntries = 100000;
+  BTreeMap<uint64_t, uint64_t> map;
+  for (uint64_t i = 0; i < kEntries; i++) map.try_emplace(i * 2, i);
+  REQUIRE(map.size() == kEntries);
+
+  SECTION("Range iteration") {
+    uint64_t expected = 1000;
+    for (auto [key, value] : map.range(2000, 3001)) {
+      REQUIRE(key == expected * 2);
+      REQUIRE(value == expected);
+      expected++;
+    }
+    REQUIRE(expected == 1501);
+    REQUIRE(map.range(7, 8).begin() == map.range(7, 8).end());
+    REQUIRE(map.upper_bound(10)->first == 12);
+    REQUIRE(map.lower_bound(11)->first == 12);
+    REQUIRE(map.lower_bound(kEntries * 2) == map.end());
+  }
+
+  SECTION("Backwards from the end") {
+    uint64_t expected = kEntries;
+    for (auto it = map.end(); it != map.begin();) {
+      --it;
+      expected--;
+      REQUIRE(it->second == expected);
+    }
+    REQUIRE(expected == 0);
+  }
+
+  SECTION("Erase everything back to empty") {
+    for (uint64_t i = 0; i < kEntries; i += 2) map.erase(i * 2);
+    REQUIRE(map.size() == kEntries / 2);
+    for (uint64_t i = 1; i < kEntries; i += 2) map.erase(i * 2);
+    REQUIRE(map.empty());
+    REQUIRE(map.height() == 0);
+    REQUIRE(map.begin() == map.end());
+  }
+}
+
+TEST_CASE("BTreeMap bulk loads from a sorted Vector", "[btree_map]") {
+  stl::Vector<std::pair<uint64_t, uint64_t>> entries;
+  for (uint64_t i = 0; i < 50000; i++) entries.emplace_back(i * 3, i);
+  auto map = BTreeMap<uint64_t, uint64_t>::from_sorted(std::move(entries));
+  REQUIRE(map.size() == 50000);
+
+  // Packed leaves leave a tree no taller than inserting would
+  BTreeMap<uint64_t, uint64_t> inserted;
+  for (uint64_t i = 0; i < 50000; i++) inserted.try_emplace(i * 3, i);
+  REQUIRE(map.height() <= inserted.height());
+
+  for (uint64_t i = 0; i < 50000; i++) {
+    REQUIRE(map.at(i * 3) == i);
+    REQUIRE_FALSE(map.contains(i * 3 + 1));
+  }
+  // Still takes inserts and erases after loading
+  for (uint64_t i = 0; i < 50000; i += 5) {
+    map.try_emplace(i * 3 + 1, i);
+    map.erase(i * 3);
+  }
+  REQUIRE(map.size() == 50000);
+
+  stl::Vector<std::pair<int, int>> unsorted;
+  unsorted.emplace_back(2, 0);
+  unsorted.emplace_back(1, 0);
+  using IntMap = BTreeMap<int, int>;
+  REQUIRE_THROWS_AS(IntMap::from_sorted(std::move(unsorted)),
+                    std::invalid_argument);
+}
+
+TEST_CASE("BTreeMap manages object lifetimes", "[btree_map]") {
+  {
+    BTreeMap<int, Tracked> map;
+    for (int i = 0; i < 5000; i++) map.try_emplace(i * 7 % 5000, i);
+    REQUIRE(Tracked::live == 5000);
+    for (int i = 0; i < 5000; i += 3) map.erase(i);
+    REQUIRE(Tracked::live == static_cast<int>(map.size()));
+
+    BTreeMap<int, Tracked> copy = map;
+    REQUIRE(Tracked::live == 2 * static_cast<int>(map.size()));
+    REQUIRE(copy.size() == map.size());
+    BTreeMap<int, Tracked> moved = std::move(copy);
+    REQUIRE(copy.empty());
+    REQUIRE(moved.at(1).value == map.at(1).value);
+    map.clear();
+    REQUIRE(Tracked::live == static_cast<int>(moved.size()));
+  }
+  REQUIRE(Tracked::live == 0);
+}
+
+TEST_CASE("BTreeMap holds move-only values", "[btree_map]") {
+  BTreeMap<int, std::unique_ptr<int>> map;
+  for (int i = 0; i < 1000; i++) map.try_emplace(i, std::make_unique<int>(i));
+  for (int i = 0; i < 1000; i += 2) map.erase(i);
+  REQUIRE(*map.at(999) == 999);
+  REQUIRE(map.size() == 500);
+}
@@ -0,0 +1,266 @@
+#define CATCH_CONFIG_MAIN
+
+#include <array>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "stl/concurrent_hash_map.h"
+
+namespace {
+
+using OptimisticMap = stl::ConcurrentHashMap<uint64_t, uint64_t>;
+using LockedMap = stl::ConcurrentHashMap<std::string, std::string>;
+// Trivially copyable, but too wide for a lock-free atomic
+using WideValueMap = stl::ConcurrentHashMap<uint64_t, std::array<char, 24>>;
+
+static_assert(OptimisticMap::kOptimisticReads);
+static_assert(!LockedMap::kOptimisticReads);
+static_assert(!WideValueMap::kOptimisticReads);
+
+// Every key lands in the same shard and probe chain
+struct ConstantHash {
+  size_t operator()(uint64_t) const noexcept { return 42; }
+};
+
+}  // namespace
+
+TEST_CASE("ConcurrentHashMap basic operations") {
+  SECTION("Optimistic shards") {
+    OptimisticMap map(8);
+    REQUIRE(map.num_shards() == 8);
+    REQUIRE(map.empty());
+    REQUIRE_FALSE(map.find(1).has_value());
+
+    REQUIRE(map.insert(1, 10));
+    REQUIRE_FALSE(map.insert(1, 11));
+    REQUIRE(*map.find(1) == 10);
+
+    REQUIRE_FALSE(map.insert_or_assign(1, 12));
+    REQUIRE(*map.find(1) == 12);
+    REQUIRE(map.insert_or_assign(2, 20));
+    REQUIRE(map.size() == 2);
+
+    REQUIRE(map.erase(1));
+    REQUIRE_FALSE(map.erase(1));
+    REQUIRE_FALSE(map.contains(1));
+    REQUIRE(map.contains(2));
+    REQUIRE(map.size() == 1);
+  }
+
+  SECTION("Locked shards") {
+    LockedMap map;
+    REQUIRE(map.insert("a", "1"));
+    REQUIRE_FALSE(map.insert("a", "2"));
+    REQUIRE(*map.find("a") == "1");
+    REQUIRE_FALSE(map.insert_or_assign("a", "3"));
+    REQUIRE(*map.find("a") == "3");
+    REQUIRE(map.compute_if_absent("b", [] { return std::string("4"); }) ==
+            "4");
+    REQUIRE(map.erase("a"));
+    REQUIRE_FALSE(map.contains("a"));
+    REQUIRE(map.size() == 1);
+  }
+
+  SECTION("Values without lock-free atomics use locked shards") {
+    WideValueMap map;
+    std::array<char, 24> value{};
+    value.fill('v');
+    REQUIRE(map.insert(1, value));
+    REQUIRE(*map.find(1) == value);
+    REQUIRE(map.erase(1));
+    REQUIRE(map.empty());
+  }
+
+  SECTION("Shard count is rounded up to a power of two") {
+    REQUIRE(OptimisticMap(0).num_shards() == 1);
+    REQUIRE(OptimisticMap(5).num_shards() == 8);
+    REQUIRE_THROWS_AS(OptimisticMap(size_t{1} << 20), std::invalid_argument);
+  }
+}
+
+TEST_CASE("ConcurrentHashMap growth") {
+  SECTION("Matches std::unordered_map under random operations") {
+    OptimisticMap map(4);
+    std::unordered_map<uint64_t, uint64_t> reference;
+    std::mt19937_64 rng(11);
+
+    for (int i = 0; i < 200000; i++) {
+      uint64_t key = rng() % 5000;
+      switch (rng() % 3) {
+        case 0:
+          REQUIRE(map.insert_or_assign(key, i) ==
+                  reference.insert_or_assign(key, i).second);
+          break;
+        case 1:
+          REQUIRE(map.erase(key) == (reference.erase(key) == 1));
+          break;
+        case 2:
+          REQUIRE(map.contains(key) == reference.contains(key));
+          break;
+      }
+    }
+
+    REQUIRE(map.size() == reference.size());
+    for (const auto& [key, value] : reference) REQUIRE(*map.find(key) == value);
+  }
+
+  SECTION("Survives a hash that always collides") {
+    stl::ConcurrentHashMap<uint64_t, uint64_t, ConstantHash> map;
+    for (uint64_t i = 0; i < 500; i++) map.insert(i, i * 2);
+    for (uint64_t i = 0; i < 500; i += 2) map.erase(i);
+    REQUIRE(map.size() == 250);
+    for (uint64_t i = 0; i < 500; i++) {
+      REQUIRE(map.contains(i) == (i % 2 == 1));
+    }
+  }
+
+  SECTION("Insert and erase churn keeps the table size") {
+    OptimisticMap map(1);
+    for (uint64_t i = 0; i < 64; i++) map.insert(i, i);
+    // Each pair leaves a tombstone, cleared by rehashing in place
+    for (uint64_t i = 64; i < 200000; i++) {
+      REQUIRE(map.insert(i, i));
+      REQUIRE(map.erase(i));
+    }
+    REQUIRE(map.size() == 64);
+    for (uint64_t i = 0; i < 64; i++) REQUIRE(*map.find(i) == i);
+    REQUIRE_FALSE(map.contains(64));
+  }
+}
+
+TEST_CASE("ConcurrentHashMap under concurrency") {
+  SECTION("Readers never see a torn or missing entry while shards grow") {
+    // Few shards so each one resizes many times during the run
+    OptimisticMap map(2);
+    constexpr uint64_t kKeys = 100000;
+    for (uint64_t i = 0; i < 64; i++) map.insert(i, i * 3);
+
+    std::atomic<bool> done = false;
+    std::atomic<uint64_t> bad = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+      readers.emplace_back([&, t] {
+        std::mt19937_64 rng(t);
+        while (!done.load(std::memory_order_relaxed)) {
+          uint64_t key = rng() % 64;
+          std::optional<uint64_t> value = map.find(key);
+          if (!value || *value != key * 3) bad++;
+        }
+      });
+    }
+
+    for (uint64_t i = 64; i < kKeys; i++) map.insert(i, i * 3);
+    done = true;
+    for (auto& reader : readers) reader.join();
+
+    REQUIRE(bad == 0);
+    REQUIRE(map.size() == kKeys);
+    for (uint64_t i = 0; i < kKeys; i++) REQUIRE(*map.find(i) == i * 3);
+  }
+
+  SECTION("Readers never miss an entry while tombstones are cleared") {
+    OptimisticMap map(1);
+    for (uint64_t i = 0; i < 64; i++) map.insert(i, i * 3);
+
+    std::atomic<bool> done = false;
+    std::atomic<uint64_t> bad = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+      readers.emplace_back([&, t] {
+        std::mt19937_64 rng(t);
+        while (!done.load(std::memory_order_relaxed)) {
+          uint64_t key = rng() % 64;
+          std::optional<uint64_t> value = map.find(key);
+          if (!value || *value != key * 3) bad++;
+        }
+      });
+    }
+
+    for (uint64_t i = 64; i < 100000; i++) {
+      map.insert(i, i);
+      map.erase(i);
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+
+    REQUIRE(bad == 0);
+    REQUIRE(map.size() == 64);
+  }
+
+  SECTION("Values stay consistent with their key under overwrites") {
+    OptimisticMap map(4);
+    for (uint64_t i = 0; i < 256; i++) map.insert(i, i << 32);
+
+    std::atomic<bool> done = false;
+    std::atomic<uint64_t> bad = 0;
+    std::thread reader([&] {
+      std::mt19937_64 rng(1);
+      while (!done.load(std::memory_order_relaxed)) {
+        uint64_t key = rng() % 256;
+        std::optional<uint64_t> value = map.find(key);
+        if (!value || (*value >> 32) != key) bad++;
+      }
+    });
+
+    std::vector<std::thread> writers;
+    for (uint64_t t = 0; t < 2; t++) {
+      writers.emplace_back([&map, t] {
+        for (uint64_t round = 0; round < 20000; round++) {
+          uint64_t key = (round * 7 + t) % 256;
+          map.insert_or_assign(key, (key << 32) | round);
+        }
+      });
+    }
+    for (auto& writer : writers) writer.join();
+    done = true;
+    reader.join();
+    REQUIRE(bad == 0);
+    REQUIRE(map.size() == 256);
+  }
+
+  SECTION("compute_if_absent runs make once per key") {
+    OptimisticMap map(4);
+    std::atomic<uint64_t> calls = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&] {
+        for (uint64_t key = 0; key < 2000; key++) {
+          uint64_t value = map.compute_if_absent(key, [&] {
+            calls++;
+            return key + 1;
+          });
+          if (value != key + 1) calls += 1000000;
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(calls == 2000);
+    REQUIRE(map.size() == 2000);
+  }
+
+  SECTION("Concurrent writers to disjoint keys in the locked mode") {
+    LockedMap map(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&map, t] {
+        for (int i = 0; i < 1000; i++) {
+          std::string key = std::to_string(t * 1000 + i);
+          map.insert(key, key);
+          if (i % 2 == 0) map.erase(key);
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(map.size() == 2000);
+    REQUIRE(*map.find("1001") == "1001");
+    REQUIRE_FALSE(map.contains("1000"));
+  }
+}
@@ -0,0 +1,219 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stl/cord.h"
+
+using stl::Cord;
+
+namespace {
+
+std::string flat_copy(const Cord& cord) {
+  std::string out;
+  for (std::string_view chunk : cord.chunks()) out += chunk;
+  return out;
+}
+
+}  // namespace
+
+TEST_CASE("Cord basic operations") {
+  SECTION("Empty") {
+    Cord cord;
+    REQUIRE(cord.empty());
+    REQUIRE(cord.size() == 0);
+    REQUIRE(cord.chunk_count() == 0);
+    REQUIRE(cord.chunks().begin() == cord.chunks().end());
+    REQUIRE(cord == "");
+    REQUIRE(cord.flatten().empty());
+  }
+
+  SECTION("Append and prepend") {
+    Cord cord("world");
+    cord.append("!").prepend("hello, ");
+    REQUIRE(cord.size() == 13);
+    REQUIRE(cord == "hello, world!");
+    REQUIRE(cord.at(7) == 'w');
+    REQUIRE_THROWS_AS(cord.at(13), std::out_of_range);
+    REQUIRE(cord.to_string() == "hello, world!");
+  }
+
+  SECTION("Small appends fill chunks that double in size") {
+    Cord cord;
+    for (int i = 0; i < 100000; i++) cord.append("x");
+    REQUIRE(cord.size() == 100000);
+    REQUIRE(cord.chunk_count() <= 100000 / Cord::kMaxFlat + 8);
+  }
+
+  SECTION("Large appends get their own chunk") {
+    std::string big(3 * Cord::kMaxFlat, 'b');
+    Cord cord("a");
+    cord.append(big);
+    REQUIRE(cord.chunk_count() == 2);
+    REQUIRE(cord == "a" + big);
+  }
+
+  SECTION("Streaming") {
+    Cord cord("abc");
+    cord.append(Cord(std::string(600, 'd')));
+    std::ostringstream os;
+    os << cord;
+    REQUIRE(os.str() == "abc" + std::string(600, 'd'));
+  }
+}
+
+TEST_CASE("Cord copies share chunks") {
+  Cord a;
+  for (int i = 0; i < 10000; i++) a.append("0123456789");
+  Cord b = a;
+  std::string before = flat_copy(a);
+
+  SECTION("Appending to a copy leaves the original alone") {
+    b.append("tail");
+    b.prepend("head");
+    REQUIRE(flat_copy(a) == before);
+    REQUIRE(b == "head" + before + "tail");
+    a.append("other");
+    REQUIRE(b == "head" + before + "tail");
+    REQUIRE(a == before + "other");
+  }
+
+  SECTION("Appending a cord to itself") {
+    a.append(a);
+    REQUIRE(a == before + before);
+    Cord small("xy");
+    small.append(small);
+    REQUIRE(small == "xyxy");
+  }
+
+  SECTION("Equality across different chunk boundaries") {
+    // One chunk per char, against 4 KB chunks and a single flat string
+    Cord c;
+    for (size_t i = before.size(); i-- > 0;) {
+      c.prepend(std::string_view(&before[i], 1));
+    }
+    REQUIRE(c == a);
+    REQUIRE(c == Cord(before));
+    b.append("x");
+    REQUIRE_FALSE(c == b);
+  }
+}
+
+TEST_CASE("Cord substr") {
+  std::mt19937_64 rng(1);
+  Cord cord;
+  std::string expected;
+  for (int i = 0; i < 2000; i++) {
+    std::string piece(1 + rng() % 300, static_cast<char>('a' + i % 26));
+    if (rng() % 4 == 0) {
+      cord.prepend(piece);
+      expected.insert(0, piece);
+    } else {
+      cord.append(piece);
+      expected += piece;
+    }
+  }
+  REQUIRE(cord == expected);
+
+  for (int i = 0; i < 200; i++) {
+    size_t pos = rng() % (expected.size() + 1);
+    size_t count = rng() % 20000;
+    Cord sub = cord.substr(pos, count);
+    REQUIRE(sub == std::string_view(expected).substr(pos, count));
+    // A substring of a substring still points at the original chunks
+    if (sub.size() > 2) {
+      REQUIRE(sub.substr(1, sub.size() - 2) ==
+              std::string_view(expected).substr(pos + 1, sub.size() - 2));
+    }
+  }
+  REQUIRE(cord.substr(expected.size()).empty());
+  REQUIRE_THROWS_AS(cord.substr(expected.size() + 1), std::out_of_range);
+}
+
+TEST_CASE("Cord stays balanced") {
+  // An AVL tree of n chunks is at most about 1.44 log2(n) deep
+  auto max_depth = [](size_t chunks) {
+    return static_cast<size_t>(1.45 * std::log2(chunks + 2.0)) + 1;
+  };
+
+  SECTION("Appends of shared cords") {
+    Cord cord;
+    std::vector<Cord> snapshots;
+    for (int i = 0; i < 4000; i++) {
+      cord.append(Cord(std::string(600, 'a' + i % 26)));
+      if (i % 100 == 0) snapshots.push_back(cord);
+    }
+    REQUIRE(cord.size() == 600u * 4000);
+    REQUIRE(cord.depth() <= max_depth(cord.chunk_count()));
+    for (int i = 0; i < 4000; i++) {
+      REQUIRE(cord[600 * i] == 'a' + i % 26);
+    }
+    // Earlier snapshots are untouched by later appends
+    REQUIRE(snapshots[1].size() == 600u * 101);
+    REQUIRE(snapshots[1][600 * 100] == 'a' + 100 % 26);
+  }
+
+  SECTION("Alternating prepends and appends") {
+    Cord cord;
+    std::string expected;
+    for (int i = 0; i < 4000; i++) {
+      if (i % 2 == 0) {
+        std::string piece(1, static_cast<char>('0' + i % 10));
+        cord.prepend(piece);
+        expected.insert(0, piece);
+      } else {
+        std::string piece(600, static_cast<char>('a' + i % 26));
+        cord.append(Cord(piece));
+        expected += piece;
+      }
+    }
+    REQUIRE(cord.size() == expected.size());
+    REQUIRE(cord == expected);
+    REQUIRE(cord.depth() <= max_depth(cord.chunk_count()));
+  }
+
+  SECTION("Mixed prepends and appends onto shared trees") {
+    std::mt19937 rng(29);
+    Cord cord;
+    std::string expected;
+    std::vector<std::pair<Cord, std::string>> snapshots;
+    for (int i = 0; i < 3000; i++) {
+      std::string piece(1 + rng() % 700, static_cast<char>('a' + i % 26));
+      if (rng() % 2 == 0) {
+        cord.prepend(Cord(piece));
+        expected.insert(0, piece);
+      } else {
+        cord.append(Cord(piece));
+        expected += piece;
+      }
+      if (i % 300 == 0) snapshots.emplace_back(cord, expected);
+    }
+    REQUIRE(cord == expected);
+    REQUIRE(cord.depth() <= max_depth(cord.chunk_count()));
+    // Shared nodes were copied, not rotated in place
+    for (const auto& [snapshot, text] : snapshots) REQUIRE(snapshot == text);
+  }
+}
+
+TEST_CASE("Cord flatten") {
+  Cord cord;
+  std::string expected;
+  for (int i = 0; i < 5000; i++) {
+    std::string piece = std::to_string(i) + ",";
+    cord.append(piece);
+    expected += piece;
+  }
+  Cord copy = cord;
+  REQUIRE(cord.chunk_count() > 1);
+  REQUIRE(cord.flatten() == expected);
+  REQUIRE(cord.chunk_count() == 1);
+  REQUIRE(cord.flatten().data() == cord.flatten().data());
+  REQUIRE(copy == cord);
+}
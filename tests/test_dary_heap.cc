@@ -0,0 +1,179 @@
+#define CATCH_CONFIG_MAIN
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "stl/dary_heap.h"
+#include "stl/vector.h"
+
+using stl::DaryHeap;
+
+namespace {
+
+// Pops everything, which must come out in descending order under Compare
+template <typename Heap>
+std::vector<int> drain(Heap& heap) {
+  std::vector<int> out;
+  while (!heap.empty()) {
+    out.push_back(heap.top());
+    heap.pop();
+  }
+  return out;
+}
+
+template <size_t D>
+void check_heapsort() {
+  std::mt19937 rng(D);
+  std::vector<int> values(1000);
+  for (int& value : values) value = static_cast<int>(rng() % 500);
+
+  DaryHeap<int, D> heap;
+  for (int value : values) heap.push(value);
+  REQUIRE(heap.size() == values.size());
+
+  std::vector<int> expected = values;
+  std::sort(expected.begin(), expected.end(), std::greater<int>());
+  REQUIRE(drain(heap) == expected);
+}
+
+// Scheduler-style entry whose slot is kept in a side table by id
+struct Entry {
+  uint64_t deadline;
+  size_t id;
+};
+
+struct EarlierFirst {
+  bool operator()(const Entry& lhs, const Entry& rhs) const noexcept {
+    return lhs.deadline > rhs.deadline;
+  }
+};
+
+struct TrackSlot {
+  std::vector<size_t>* slots;
+  void operator()(const Entry& entry, size_t slot) const noexcept {
+    (*slots)[entry.id] = slot;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("DaryHeap orders elements for any arity", "[dary_heap]") {
+  check_heapsort<2>();
+  check_heapsort<3>();
+  check_heapsort<4>();
+  check_heapsort<8>();
+}
+
+TEST_CASE("DaryHeap basic operations", "[dary_heap]") {
+  DaryHeap<int> heap;
+  REQUIRE(heap.empty());
+  heap.pop();
+  REQUIRE(heap.empty());
+
+  SECTION("Min-heap through the comparator") {
+    DaryHeap<int, 8, std::greater<int>> min_heap;
+    for (int value : {5, 1, 4, 2, 3}) min_heap.emplace(value);
+    REQUIRE(min_heap.top() == 1);
+    REQUIRE(drain(min_heap) == std::vector<int>{1, 2, 3, 4, 5});
+  }
+
+  SECTION("push_pop and replace_top") {
+    for (int value : {10, 20, 30}) heap.push(value);
+    // Larger than the top: comes straight back
+    REQUIRE(heap.push_pop(40) == 40);
+    REQUIRE(heap.size() == 3);
+    REQUIRE(heap.push_pop(25) == 30);
+    REQUIRE(heap.top() == 25);
+    REQUIRE(heap.replace_top(5) == 25);
+    REQUIRE(drain(heap) == std::vector<int>{20, 10, 5});
+    REQUIRE(heap.push_pop(7) == 7);
+    REQUIRE(heap.empty());
+  }
+
+  SECTION("Heapify from a Vector") {
+    stl::Vector<int> values;
+    for (int i = 0; i < 1000; i++) values.push_back((i * 7919) % 1000);
+    DaryHeap<int, 4> built(std::move(values));
+    REQUIRE(built.size() == 1000);
+    std::vector<int> out = drain(built);
+    REQUIRE(out.size() == 1000);
+    REQUIRE(std::is_sorted(out.begin(), out.end(), std::greater<int>()));
+  }
+
+  SECTION("Move-only elements") {
+    struct Greater {
+      bool operator()(const std::unique_ptr<int>& lhs,
+                      const std::unique_ptr<int>& rhs) const {
+        return *lhs < *rhs;
+      }
+    };
+    DaryHeap<std::unique_ptr<int>, 4, Greater> ptrs;
+    for (int i = 0; i < 50; i++) ptrs.push(std::make_unique<int>(i % 17));
+    REQUIRE(*ptrs.top() == 16);
+    auto top = ptrs.push_pop(std::make_unique<int>(3));
+    REQUIRE(*top == 16);
+  }
+}
+
+TEST_CASE("DaryHeap tracks slots for decrease_key", "[dary_heap]") {
+  constexpr size_t kEntries = 5000;
+  std::vector<size_t> slots(kEntries);
+  std::vector<uint64_t> deadlines(kEntries);
+  std::mt19937_64 rng(11);
+
+  stl::Vector<Entry> entries;
+  for (size_t id = 0; id < kEntries; id++) {
+    deadlines[id] = 1000 + rng() % 1'000'000;
+    entries.push_back(Entry{deadlines[id], id});
+  }
+  DaryHeap<Entry, 8, EarlierFirst, TrackSlot> heap(
+      std::move(entries), EarlierFirst(), TrackSlot{&slots});
+
+  auto check_slots = [&] {
+    for (size_t slot = 0; slot < heap.size(); slot++) {
+      REQUIRE(slots[heap[slot].id] == slot);
+    }
+  };
+  check_slots();
+
+  // Bring some deadlines forward and push others back
+  for (int i = 0; i < 2000; i++) {
+    size_t id = rng() % kEntries;
+    if (i % 2 == 0) {
+      deadlines[id] /= 2;
+      heap.decrease_key(slots[id], Entry{deadlines[id], id});
+    } else {
+      deadlines[id] += rng() % 1000;
+      heap.update(slots[id], Entry{deadlines[id], id});
+    }
+  }
+  check_slots();
+
+  // Cancel a few
+  std::vector<bool> cancelled(kEntries);
+  for (size_t id = 0; id < kEntries; id += 7) {
+    heap.erase(slots[id]);
+    cancelled[id] = true;
+  }
+  check_slots();
+
+  std::vector<uint64_t> expected;
+  for (size_t id = 0; id < kEntries; id++) {
+    if (!cancelled[id]) expected.push_back(deadlines[id]);
+  }
+  std::sort(expected.begin(), expected.end());
+  std::vector<uint64_t> popped;
+  while (!heap.empty()) {
+    popped.push_back(heap.top().deadline);
+    heap.pop();
+  }
+  REQUIRE(popped == expected);
+
+  REQUIRE_THROWS_AS(heap.erase(0), std::out_of_range);
+}
@@ -0,0 +1,200 @@
+#define CATCH_CONFIG_MAIN
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "stl/deque.h"
+
+using stl::Deque;
+
+namespace {
+
+// Counts live objects, so leaks and double destruction both show
+struct Tracked {
+  static inline int live = 0;
+  int value;
+  explicit Tracked(int value) : value(value) { live++; }
+  Tracked(const Tracked& other) : value(other.value) { live++; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { live++; }
+  ~Tracked() { live--; }
+};
+
+}  // namespace
+
+static_assert(std::random_access_iterator<Deque<int>::iterator>);
+static_assert(std::random_access_iterator<Deque<int>::const_iterator>);
+
+TEST_CASE("Deque basic operations", "[deque]") {
+  Deque<int> d;
+  REQUIRE(d.empty());
+  REQUIRE(d.capacity() == 0);
+
+  SECTION("Push and pop at both ends") {
+    d.push_back(2);
+    d.push_front(1);
+    d.push_back(3);
+    REQUIRE(d.size() == 3);
+    REQUIRE(d.front() == 1);
+    REQUIRE(d.back() == 3);
+    REQUIRE(d[1] == 2);
+    d.pop_front();
+    REQUIRE(d.front() == 2);
+    d.pop_back();
+    REQUIRE(d.back() == 2);
+    d.pop_back();
+    REQUIRE(d.empty());
+    d.pop_front();
+    REQUIRE(d.empty());
+  }
+
+  SECTION("Capacity is a power of two") {
+    for (int i = 0; i < 100; i++) d.push_back(i);
+    REQUIRE(d.capacity() == 128);
+    Deque<int> reserved(100);
+    REQUIRE(reserved.capacity() == 128);
+    reserved.reserve(129);
+    REQUIRE(reserved.capacity() == 256);
+  }
+
+  SECTION("at checks bounds") {
+    d.push_back(7);
+    REQUIRE(d.at(0) == 7);
+    REQUIRE_THROWS_AS(d.at(1), std::out_of_range);
+  }
+}
+
+TEST_CASE("Deque grows with the ring wrapped", "[deque]") {
+  // Pushing to the front first leaves head at the end of the buffer, so
+  // every reallocation has to unroll two runs
+  Deque<std::string> d;
+  std::deque<std::string> expected;
+  for (int i = 0; i < 1000; i++) {
+    std::string value = "value_" + std::to_string(i);
+    if (i % 3 == 0) {
+      d.push_back(value);
+      expected.push_back(value);
+    } else {
+      d.push_front(value);
+      expected.push_front(value);
+    }
+  }
+  REQUIRE(d.size() == expected.size());
+  REQUIRE(std::equal(d.begin(), d.end(), expected.begin(), expected.end()));
+}
+
+TEST_CASE("Deque matches std::deque on random operations", "[deque]") {
+  std::mt19937_64 rng(3);
+  Deque<int> d;
+  std::deque<int> expected;
+  for (int i = 0; i < 100000; i++) {
+    switch (rng() % 5) {
+      case 0:
+        d.push_front(i);
+        expected.push_front(i);
+        break;
+      case 1:
+      case 2:
+        d.push_back(i);
+        expected.push_back(i);
+        break;
+      case 3:
+        if (!expected.empty()) {
+          d.pop_front();
+          expected.pop_front();
+        }
+        break;
+      case 4:
+        if (!expected.empty()) {
+          d.pop_back();
+          expected.pop_back();
+        }
+        break;
+    }
+    REQUIRE(d.size() == expected.size());
+    if (!expected.empty()) {
+      REQUIRE(d.front() == expected.front());
+      REQUIRE(d.back() == expected.back());
+      size_t k = rng() % expected.size();
+      REQUIRE(d[k] == expected[k]);
+    }
+  }
+  REQUIRE(std::equal(d.begin(), d.end(), expected.begin(), expected.end()));
+}
+
+TEST_CASE("Deque pushes its own elements while full", "[deque]") {
+  SECTION("Relocated by malloc") {
+    Deque<std::string> d;
+    for (int i = 0; i < 4; i++) d.push_back(std::string(32, 'a' + i));
+    REQUIRE(d.size() == d.capacity());
+    d.push_back(d.front());
+    REQUIRE(d.back() == std::string(32, 'a'));
+    for (int i = 0; i < 3; i++) d.push_back(d[1]);
+    REQUIRE(d.size() == d.capacity());
+    d.push_front(d.back());
+    REQUIRE(d.front() == std::string(32, 'b'));
+    REQUIRE(d.size() == 9);
+    REQUIRE(d[1] == std::string(32, 'a'));
+  }
+
+  SECTION("Relocated by realloc") {
+    Deque<int> d;
+    for (int i = 0; i < 8; i++) d.push_front(i);
+    REQUIRE(d.size() == d.capacity());
+    d.emplace_back(d.front());
+    REQUIRE(d.back() == 7);
+    for (int i = 0; i < 7; i++) d.push_back(i);
+    REQUIRE(d.size() == d.capacity());
+    d.emplace_front(d.back());
+    REQUIRE(d.front() == 6);
+    REQUIRE(d.size() == 17);
+  }
+}
+
+TEST_CASE("Deque manages object lifetimes", "[deque]") {
+  {
+    Deque<Tracked> d;
+    for (int i = 0; i < 50; i++) d.emplace_front(i);
+    for (int i = 0; i < 10; i++) d.pop_back();
+    REQUIRE(Tracked::live == 40);
+
+    Deque<Tracked> copy = d;
+    REQUIRE(Tracked::live == 80);
+    Deque<Tracked> moved = std::move(copy);
+    REQUIRE(Tracked::live == 80);
+    REQUIRE(copy.empty());
+
+    d.shrink_to_fit();
+    REQUIRE(d.capacity() == 64);
+    REQUIRE(d.front().value == 49);
+    REQUIRE(d.back().value == 10);
+    d.clear();
+    REQUIRE(Tracked::live == 40);
+  }
+  REQUIRE(Tracked::live == 0);
+}
+
+TEST_CASE("Deque holds move-only types", "[deque]") {
+  Deque<std::unique_ptr<int>> d;
+  for (int i = 0; i < 20; i++) d.push_front(std::make_unique<int>(i));
+  REQUIRE(*d.front() == 19);
+  REQUIRE(*d.back() == 0);
+}
+
+TEST_CASE("Deque iterators", "[deque]") {
+  Deque<int> d;
+  for (int i = 0; i < 10; i++) d.push_front(i);
+  std::sort(d.begin(), d.end());
+  for (int i = 0; i < 10; i++) REQUIRE(d[i] == i);
+
+  Deque<int>::const_iterator it = d.begin();
+  REQUIRE(*(it + 3) == 3);
+  REQUIRE(it[4] == 4);
+  REQUIRE(d.end() - d.begin() == 10);
+  REQUIRE(std::prev(d.end()) > it);
+}
@@ -0,0 +1,273 @@
+#define CATCH_CONFIG_MAIN
+
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "stl/deterministic_schedule.h"
+#include "stl/task_group.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+struct Run {
+  std::vector<int> order;
+  std::vector<size_t> workers;
+  std::vector<stl::ScheduleDecision> log;
+  std::optional<uint64_t> diverged_at;
+};
+
+// Submits `tasks` tasks from outside while paused, each of the first few
+// spawning two children from inside, and records what ran where
+Run run_tasks(stl::DeterministicSchedule schedule, int tasks,
+              size_t workers = 4) {
+  stl::ThreadPool pool(workers, std::move(schedule));
+  Run run;
+  std::mutex mutex;
+  auto record = [&](int id) {
+    std::scoped_lock lock(mutex);
+    run.order.push_back(id);
+    run.workers.push_back(*pool.current_worker_index());
+  };
+
+  std::vector<std::future<void>> futures;
+  pool.pause();
+  for (int i = 0; i < tasks; i++) {
+    futures.push_back(pool.submit_task([&, i]() {
+      record(i);
+      if (i < 4) {
+        pool.post_continuation([&, i]() { record(100 + i); });
+        pool.post_continuation([&, i]() { record(200 + i); });
+      }
+    }));
+  }
+  pool.resume();
+  for (auto& future : futures) future.get();
+
+  // Children may still be queued when the last parent returns
+  size_t expected = static_cast<size_t>(tasks + 2 * std::min(tasks, 4));
+  while (true) {
+    std::scoped_lock lock(mutex);
+    if (run.order.size() == expected) break;
+  }
+
+  run.log = pool.schedule_log();
+  run.diverged_at = pool.replay_diverged_at();
+  return run;
+}
+
+}  // namespace
+
+TEST_CASE("DeterministicScheduler") {
+  SECTION("The same seed makes the same decisions") {
+    stl::DeterministicScheduler a({42, {}}, 4);
+    stl::DeterministicScheduler b({42, {}}, 4);
+    for (size_t queued = 1; queued < 50; queued++) {
+      REQUIRE(a.next(queued, std::nullopt) == b.next(queued, std::nullopt));
+    }
+    REQUIRE(a.log() == b.log());
+  }
+
+  SECTION("Decisions stay in range") {
+    stl::DeterministicScheduler scheduler({7, {}}, 3);
+    for (size_t queued = 1; queued < 100; queued++) {
+      auto decision = scheduler.next(queued, std::nullopt);
+      REQUIRE(decision.worker < 3);
+      REQUIRE(decision.task < queued);
+      REQUIRE(decision.queued == queued);
+      REQUIRE(decision.step == queued - 1);
+    }
+  }
+
+  SECTION("A helping worker runs the task itself") {
+    stl::DeterministicScheduler scheduler({7, {}}, 8);
+    for (int i = 0; i < 20; i++) {
+      auto decision = scheduler.next(5, 3);
+      REQUIRE(decision.worker == 3);
+      REQUIRE(decision.helped);
+    }
+  }
+
+  SECTION("Replays a log made with another seed") {
+    stl::DeterministicScheduler original({1, {}}, 4);
+    for (size_t queued = 1; queued < 20; queued++) {
+      original.next(queued, std::nullopt);
+    }
+
+    stl::DeterministicScheduler replay({2, original.log()}, 4);
+    for (size_t queued = 1; queued < 20; queued++) {
+      replay.next(queued, std::nullopt);
+    }
+    REQUIRE(replay.log() == original.log());
+    REQUIRE_FALSE(replay.diverged_at());
+  }
+
+  SECTION("Reports where a replay stops fitting") {
+    stl::DeterministicScheduler original({1, {}}, 4);
+    for (size_t queued = 1; queued < 10; queued++) {
+      original.next(queued, std::nullopt);
+    }
+
+    stl::DeterministicScheduler replay({1, original.log()}, 4);
+    for (size_t queued = 1; queued < 5; queued++) {
+      replay.next(queued, std::nullopt);
+    }
+    auto decision = replay.next(99, std::nullopt);
+    REQUIRE(replay.diverged_at() == 4);
+    REQUIRE(decision.task < 99);
+  }
+}
+
+TEST_CASE("Schedule log text format") {
+  std::vector<stl::ScheduleDecision> log = {{0, 1, 2, 3, false},
+                                            {1, 0, 0, 4, true}};
+
+  SECTION("Round trips") {
+    std::stringstream text;
+    stl::write_schedule(text, log);
+    REQUIRE(stl::read_schedule(text) == log);
+  }
+
+  SECTION("Rejects malformed lines") {
+    std::istringstream missing("0 1 2 3\n");
+    REQUIRE_THROWS_AS(stl::read_schedule(missing), std::runtime_error);
+    std::istringstream extra("0 1 2 3 0 9\n");
+    REQUIRE_THROWS_AS(stl::read_schedule(extra), std::runtime_error);
+    std::istringstream flag("0 1 2 3 2\n");
+    REQUIRE_THROWS_AS(stl::read_schedule(flag), std::runtime_error);
+  }
+}
+
+TEST_CASE("Deterministic ThreadPool") {
+  SECTION("The same seed reproduces the order and the workers") {
+    Run first = run_tasks({123, {}}, 32);
+    Run second = run_tasks({123, {}}, 32);
+    REQUIRE(first.order == second.order);
+    REQUIRE(first.workers == second.workers);
+    REQUIRE(first.log == second.log);
+  }
+
+  SECTION("Different seeds give different orders") {
+    Run first = run_tasks({1, {}}, 32);
+    Run second = run_tasks({2, {}}, 32);
+    REQUIRE(first.order != second.order);
+  }
+
+  SECTION("Tasks run on the logged workers") {
+    Run run = run_tasks({5, {}}, 16);
+    REQUIRE(run.log.size() == run.workers.size());
+    for (size_t i = 0; i < run.log.size(); i++) {
+      REQUIRE(run.log[i].worker == run.workers[i]);
+    }
+  }
+
+  SECTION("Replaying a log reproduces the run") {
+    Run original = run_tasks({77, {}}, 24);
+
+    std::stringstream saved;
+    stl::write_schedule(saved, original.log);
+    Run replayed = run_tasks({0, stl::read_schedule(saved)}, 24);
+
+    REQUIRE_FALSE(replayed.diverged_at);
+    REQUIRE(replayed.order == original.order);
+    REQUIRE(replayed.workers == original.workers);
+  }
+
+  SECTION("A replay of a different workload diverges") {
+    Run original = run_tasks({77, {}}, 24);
+    Run other = run_tasks({77, original.log}, 10);
+    REQUIRE(other.diverged_at);
+  }
+
+  SECTION("Only one task runs at a time") {
+    stl::ThreadPool pool(4, stl::DeterministicSchedule{9, {}});
+    std::atomic<int> running = 0;
+    std::atomic<int> max_running = 0;
+
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 200; i++) {
+      futures.push_back(pool.submit_task([&]() {
+        int now = running.fetch_add(1) + 1;
+        int seen = max_running.load();
+        while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::yield();
+        running.fetch_sub(1);
+      }));
+    }
+    for (auto& future : futures) future.get();
+    REQUIRE(max_running.load() == 1);
+  }
+
+  SECTION("Nested fork-join is reproducible") {
+    auto fork_join = [](uint64_t seed) {
+      stl::ThreadPool pool(3, stl::DeterministicSchedule{seed, {}});
+      std::vector<int> order;
+      pool.submit_task([&]() {
+            stl::TaskGroup group(pool);
+            for (int i = 0; i < 8; i++) {
+              group.run([&, i]() { order.push_back(i); });
+            }
+            group.wait();
+          })
+          .get();
+      return std::make_pair(order, pool.schedule_log());
+    };
+
+    auto [order, log] = fork_join(11);
+    REQUIRE(order.size() == 8);
+    REQUIRE(log.size() == 9);
+    for (size_t i = 1; i < log.size(); i++) REQUIRE(log[i].helped);
+    REQUIRE(fork_join(11) == std::make_pair(order, log));
+  }
+
+  SECTION("Outside waits do not run tasks") {
+    stl::ThreadPool pool(2, stl::DeterministicSchedule{3, {}});
+    std::atomic<int> outside = 0;
+    stl::TaskGroup group(pool);
+    for (int i = 0; i < 16; i++) {
+      group.run([&]() {
+        if (!pool.current_worker_index()) outside++;
+      });
+    }
+    group.wait();
+    REQUIRE(outside.load() == 0);
+    REQUIRE(pool.schedule_log().size() == 16);
+  }
+
+  SECTION("Shutdown drains a paused pool") {
+    std::atomic<int> ran = 0;
+    {
+      stl::ThreadPool pool(2, stl::DeterministicSchedule{3, {}});
+      pool.pause();
+      for (int i = 0; i < 10; i++) pool.post([&]() { ran++; });
+    }
+    REQUIRE(ran.load() == 10);
+  }
+
+  SECTION("Regular pools do not pause or log") {
+    stl::ThreadPool pool(2);
+    REQUIRE_FALSE(pool.is_deterministic());
+    REQUIRE_THROWS_AS(pool.pause(), std::runtime_error);
+    REQUIRE(pool.schedule_log().empty());
+    REQUIRE_FALSE(pool.replay_diverged_at());
+  }
+
+  SECTION("Deterministic pools do not lend or borrow workers") {
+    stl::ThreadPool deterministic(2, stl::DeterministicSchedule{});
+    stl::ThreadPool regular(2);
+    REQUIRE(deterministic.is_deterministic());
+    REQUIRE_THROWS_AS(deterministic.lend_idle_workers_to(&regular),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(regular.lend_idle_workers_to(&deterministic),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,180 @@
+#define CATCH_CONFIG_MAIN
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "stl/executor_set.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+// Unpinned, unbounded pool
+stl::ExecutorConfig config(const char* name, size_t num_threads,
+                           std::vector<int> cpus = {}) {
+  stl::ExecutorConfig result;
+  result.name = name;
+  result.num_threads = num_threads;
+  result.cpus = std::move(cpus);
+  return result;
+}
+
+// First CPU this process may run on
+int allowed_cpu() {
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  sched_getaffinity(0, sizeof(mask), &mask);
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &mask)) return cpu;
+  }
+  return 0;
+}
+
+}  // namespace
+
+TEST_CASE("ExecutorSet configuration") {
+  SECTION("Pools are looked up by name") {
+    stl::ExecutorSet executors({config("latency", 1), config("batch", 2)});
+
+    REQUIRE(executors.size() == 2);
+    REQUIRE(executors.contains("batch"));
+    REQUIRE_FALSE(executors.contains("other"));
+    REQUIRE(executors.pool("latency").size() == 1);
+    REQUIRE(executors.pool("batch").size() == 2);
+    REQUIRE(executors.pool("batch").submit_task([]() { return 7; }).get() ==
+            7);
+    REQUIRE_THROWS_AS(executors.pool("other"), std::out_of_range);
+  }
+
+  SECTION("Duplicate names and overlapping CPUs are rejected") {
+    REQUIRE_THROWS_AS(stl::ExecutorSet({config("a", 1), config("a", 1)}),
+                      std::invalid_argument);
+
+    stl::ExecutorConfig first = config("a", 1, {0, 1});
+    stl::ExecutorConfig second = config("b", 1, {1, 2});
+    REQUIRE_THROWS_AS(stl::ExecutorSet({first, second}),
+                      std::invalid_argument);
+  }
+
+  SECTION("Per-pool queue limits") {
+    stl::ExecutorConfig bounded = config("bounded", 1);
+    bounded.queue_capacity = 4;
+    bounded.overflow_policy = stl::OverflowPolicy::kReject;
+    stl::ExecutorSet executors({bounded, config("unbounded", 1)});
+
+    REQUIRE(executors.pool("bounded").queue_capacity() == 4);
+    REQUIRE(executors.pool("unbounded").queue_capacity() == 0);
+  }
+
+  SECTION("Workers are pinned to their CPU set") {
+    int cpu = allowed_cpu();
+    stl::ExecutorSet executors({config("pinned", 2, {cpu})});
+
+    auto pinned = executors.pool("pinned").submit_task([cpu]() {
+      cpu_set_t mask;
+      CPU_ZERO(&mask);
+      pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask);
+      return CPU_COUNT(&mask) == 1 && CPU_ISSET(cpu, &mask);
+    });
+    REQUIRE(pinned.get());
+  }
+
+  SECTION("Pinning to a CPU that does not exist fails") {
+    REQUIRE_THROWS_AS(stl::ExecutorSet({config("bad", 1, {CPU_SETSIZE - 1})}),
+                      std::runtime_error);
+  }
+}
+
+TEST_CASE("ExecutorSet lending") {
+  SECTION("Idle batch workers run latency tasks") {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> started = false;
+    stl::ExecutorSet executors({config("latency", 1), config("batch", 2)});
+    stl::ThreadPool& latency = executors.pool("latency");
+
+    // Occupy the only latency worker, then start lending
+    auto blocker = latency.submit_task([&started, released]() {
+      started = true;
+      released.wait();
+    });
+    while (!started) std::this_thread::yield();
+    executors.lend("batch", "latency");
+
+    std::atomic<int> ran_elsewhere = 0;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 10; ++i) {
+      futures.push_back(latency.submit_task([&]() {
+        if (!latency.is_worker_thread()) ran_elsewhere++;
+      }));
+    }
+    bool all_ready = true;
+    for (auto& future : futures) {
+      all_ready &= future.wait_for(std::chrono::seconds(5)) ==
+                   std::future_status::ready;
+    }
+    release.set_value();
+    blocker.get();
+
+    REQUIRE(all_ready);
+    REQUIRE(ran_elsewhere == 10);
+  }
+
+  SECTION("Latency workers never run batch tasks") {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    stl::ExecutorSet executors({config("latency", 2), config("batch", 1)});
+    executors.lend("batch", "latency");
+    stl::ThreadPool& batch = executors.pool("batch");
+
+    auto blocker = batch.submit_task([released]() { released.wait(); });
+    auto queued = batch.submit_task([]() {});
+
+    auto status = queued.wait_for(std::chrono::milliseconds(50));
+    release.set_value();
+    blocker.get();
+    queued.get();
+
+    REQUIRE(status == std::future_status::timeout);
+  }
+
+  SECTION("Lenders stay out while the borrower has an idle worker") {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    stl::ExecutorSet executors({config("latency", 2), config("batch", 2)});
+    executors.lend("batch", "latency");
+    stl::ThreadPool& latency = executors.pool("latency");
+
+    auto blocker = latency.submit_task([released]() { released.wait(); });
+    // Lets the second latency worker go to sleep
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto task = latency.submit_task([&latency]() {
+      return latency.is_worker_thread();
+    });
+
+    REQUIRE(task.get());
+    release.set_value();
+    blocker.get();
+  }
+
+  SECTION("Lending back is refused") {
+    stl::ExecutorSet executors(
+        {config("a", 1), config("b", 1), config("c", 1)});
+    executors.lend("a", "b");
+    executors.lend("b", "c");
+
+    REQUIRE_THROWS_AS(executors.lend("b", "a"), std::invalid_argument);
+    REQUIRE_THROWS_AS(executors.lend("c", "a"), std::invalid_argument);
+    REQUIRE_THROWS_AS(executors.lend("a", "a"), std::invalid_argument);
+
+    executors.stop_lending("a");
+    REQUIRE_NOTHROW(executors.lend("b", "a"));
+  }
+}
@@ -0,0 +1,184 @@
+#define CATCH_CONFIG_MAIN
+
+#include <algorithm>
+#include <bit>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "stl/hash.h"
+#include "stl/hash_map.h"
+
+namespace {
+
+struct Point {
+  int x;
+  int y;
+
+  bool operator==(const Point&) const = default;
+
+  friend size_t hash_value(const Point& p) noexcept {
+    return stl::hash_values(p.x, p.y);
+  }
+};
+
+enum class Color { kRed, kGreen };
+
+std::vector<unsigned char> random_bytes(size_t count, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<unsigned char> bytes(count);
+  for (auto& byte : bytes) byte = static_cast<unsigned char>(rng());
+  return bytes;
+}
+
+// Mean number of output bits that flip per flipped input bit
+template <typename F>
+double mean_flipped_bits(F&& hash, size_t len) {
+  auto bytes = random_bytes(len, len);
+  size_t base = hash(bytes);
+  size_t total = 0;
+  for (size_t bit = 0; bit < len * 8; bit++) {
+    bytes[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+    total += std::popcount(base ^ hash(bytes));
+    bytes[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+  }
+  return static_cast<double>(total) / static_cast<double>(len * 8);
+}
+
+}  // namespace
+
+TEST_CASE("hash_bytes") {
+  SECTION("Is deterministic and depends on the seed") {
+    auto bytes = random_bytes(1000, 1);
+    for (size_t len : {0, 3, 8, 17, 100, 256, 1000}) {
+      REQUIRE(stl::hash_bytes(bytes.data(), len) ==
+              stl::hash_bytes(bytes.data(), len));
+      REQUIRE(stl::hash_bytes(bytes.data(), len, 1) !=
+              stl::hash_bytes(bytes.data(), len, 2));
+    }
+  }
+
+  SECTION("Every prefix of an input hashes differently") {
+    // Zeros, so only the length tells the prefixes apart
+    std::vector<unsigned char> zeros(4096, 0);
+    std::set<size_t> seen;
+    for (size_t len = 0; len <= zeros.size(); len++) {
+      REQUIRE(seen.insert(stl::hash_bytes(zeros.data(), len)).second);
+    }
+  }
+
+  SECTION("Any single byte change is seen, short or long") {
+    for (size_t len : {1, 7, 16, 33, 255, 256, 300, 1024, 5000}) {
+      auto bytes = random_bytes(len, len);
+      size_t base = stl::hash_bytes(bytes.data(), len);
+      for (size_t i = 0; i < len; i++) {
+        bytes[i] ^= 0x10;
+        REQUIRE(stl::hash_bytes(bytes.data(), len) != base);
+        bytes[i] ^= 0x10;
+      }
+    }
+  }
+
+  SECTION("Alignment does not change the result") {
+    auto bytes = random_bytes(2100, 2);
+    std::vector<unsigned char> shifted(bytes.size() + 1);
+    std::copy(bytes.begin(), bytes.end(), shifted.begin() + 1);
+    for (size_t len : {5, 40, 2000}) {
+      REQUIRE(stl::hash_bytes(bytes.data(), len) ==
+              stl::hash_bytes(shifted.data() + 1, len));
+    }
+  }
+
+  SECTION("Avalanches on short and long inputs") {
+    auto hash = [](const std::vector<unsigned char>& bytes) {
+      return stl::hash_bytes(bytes.data(), bytes.size());
+    };
+    for (size_t len : {4, 12, 40, 100, 512}) {
+      double flipped = mean_flipped_bits(hash, len);
+      REQUIRE(flipped > 30.0);
+      REQUIRE(flipped < 34.0);
+    }
+  }
+}
+
+TEST_CASE("mix_hash") {
+  SECTION("Avalanches") {
+    auto hash = [](const std::vector<unsigned char>& bytes) {
+      uint64_t value;
+      std::memcpy(&value, bytes.data(), sizeof(value));
+      return stl::mix_hash(value);
+    };
+    double flipped = mean_flipped_bits(hash, 8);
+    REQUIRE(flipped > 30.0);
+    REQUIRE(flipped < 34.0);
+  }
+
+  SECTION("Sequential integers spread over the high and low bits") {
+    std::set<size_t> low;
+    std::set<size_t> high;
+    for (uint64_t i = 0; i < 4096; i++) {
+      low.insert(stl::mix_hash(i) & 0xfff);
+      high.insert(stl::mix_hash(i << 32) >> 52);
+    }
+    // A uniform hash fills about 63% of 4096 buckets with 4096 keys
+    REQUIRE(low.size() > 2400);
+    REQUIRE(high.size() > 2400);
+  }
+}
+
+TEST_CASE("Hash") {
+  SECTION("Strings hash their bytes whatever the type") {
+    std::string text = "hello, world";
+    size_t expected = stl::hash_bytes(text.data(), text.size());
+    REQUIRE(stl::Hash<std::string>{}(text) == expected);
+    REQUIRE(stl::Hash<std::string_view>{}(text) == expected);
+    REQUIRE(stl::Hash<std::string>{}("hello, there") != expected);
+  }
+
+  SECTION("Floats hash by value") {
+    REQUIRE(stl::Hash<double>{}(0.0) == stl::Hash<double>{}(-0.0));
+    REQUIRE(stl::Hash<float>{}(0.0f) == stl::Hash<float>{}(-0.0f));
+    REQUIRE(stl::Hash<double>{}(1.0) != stl::Hash<double>{}(2.0));
+  }
+
+  SECTION("Pairs and tuples combine in order") {
+    stl::Hash<std::pair<int, int>> pair_hash;
+    REQUIRE(pair_hash({1, 2}) == pair_hash({1, 2}));
+    REQUIRE(pair_hash({1, 2}) != pair_hash({2, 1}));
+
+    using Key = std::tuple<int, std::string, Color>;
+    stl::Hash<Key> tuple_hash;
+    REQUIRE(tuple_hash({1, "a", Color::kRed}) ==
+            stl::hash_values(1, std::string("a"), Color::kRed));
+    REQUIRE(tuple_hash({1, "a", Color::kRed}) !=
+            tuple_hash({1, "a", Color::kGreen}));
+    REQUIRE(stl::hash_combine(1, 2) != stl::hash_combine(2, 1));
+  }
+
+  SECTION("Structs opt in through hash_value") {
+    stl::Hash<Point> hash;
+    REQUIRE(hash({1, 2}) == hash({1, 2}));
+    REQUIRE(hash({1, 2}) != hash({2, 1}));
+  }
+
+  SECTION("Is the containers' default and skips their extra mix") {
+    static_assert(stl::AvalanchingHash<stl::Hash<int>>);
+    static_assert(!stl::AvalanchingHash<std::hash<int>>);
+    static_assert(std::is_same_v<stl::HashMap<int, int>,
+                                 stl::HashMap<int, int, stl::Hash<int>>>);
+
+    stl::HashMap<Point, int> map;
+    for (int i = 0; i < 1000; i++) map[{i, -i}] = i;
+    for (int i = 0; i < 1000; i++) REQUIRE(map.at({i, -i}) == i);
+    REQUIRE_FALSE(map.contains({1, 1}));
+  }
+}
@@ -0,0 +1,328 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "stl/hash_map.h"
+
+namespace {
+
+// Every key lands in the same group and shares one fingerprint
+struct ConstantHash {
+  size_t operator()(int) const noexcept { return 42; }
+};
+
+struct Counted {
+  static inline int alive = 0;
+  int value = 0;
+
+  Counted(int v = 0) : value(v) { alive++; }
+  Counted(const Counted& other) : value(other.value) { alive++; }
+  Counted(Counted&& other) noexcept : value(other.value) { alive++; }
+  Counted& operator=(const Counted&) = default;
+  ~Counted() { alive--; }
+};
+
+struct MoveOnlyKey {
+  int value = 0;
+
+  explicit MoveOnlyKey(int v) : value(v) {}
+  MoveOnlyKey(MoveOnlyKey&&) noexcept = default;
+  MoveOnlyKey& operator=(MoveOnlyKey&&) noexcept = default;
+  bool operator==(const MoveOnlyKey&) const = default;
+};
+
+// Copies throw once copies_left reaches 0. The move may throw, so a rehash
+// copies these keys
+struct FragileKey {
+  static inline int alive = 0;
+  static inline int copies_left = -1;
+  int value = 0;
+
+  FragileKey(int v) : value(v) { alive++; }
+  FragileKey(const FragileKey& other) : value(other.value) {
+    if (copies_left == 0) throw std::runtime_error("FragileKey copy");
+    if (copies_left > 0) copies_left--;
+    alive++;
+  }
+  FragileKey(FragileKey&& other) : value(other.value) { alive++; }
+  ~FragileKey() { alive--; }
+  bool operator==(const FragileKey&) const = default;
+};
+
+struct ValueHash {
+  size_t operator()(const MoveOnlyKey& key) const noexcept {
+    return std::hash<int>{}(key.value);
+  }
+  size_t operator()(const FragileKey& key) const noexcept {
+    return std::hash<int>{}(key.value);
+  }
+};
+
+}  // namespace
+
+TEST_CASE("ControlGroup") {
+  alignas(16) int8_t ctrl[16];
+  for (int i = 0; i < 16; i++) ctrl[i] = static_cast<int8_t>(i % 4);
+  ctrl[3] = stl::ControlGroup::kEmpty;
+  ctrl[9] = stl::ControlGroup::kDeleted;
+
+  stl::ControlGroup group(ctrl);
+  REQUIRE(group.match(1) == ((1u << 1) | (1u << 5) | (1u << 13)));
+  REQUIRE(group.match(3) == ((1u << 7) | (1u << 11) | (1u << 15)));
+  REQUIRE(group.match_empty() == (1u << 3));
+  REQUIRE(group.match_empty_or_deleted() == ((1u << 3) | (1u << 9)));
+}
+
+TEST_CASE("HashMap basic operations") {
+  stl::HashMap<int, std::string> map;
+
+  SECTION("Starts empty without allocating") {
+    REQUIRE(map.empty());
+    REQUIRE(map.capacity() == 0);
+    REQUIRE(map.find(1) == map.end());
+    REQUIRE_FALSE(map.contains(1));
+    REQUIRE(map.erase(1) == 0);
+    REQUIRE(map.begin() == map.end());
+  }
+
+  SECTION("Insert and find") {
+    REQUIRE(map.insert({1, "one"}).second);
+    REQUIRE(map.try_emplace(2, "two").second);
+    map[3] = "three";
+
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.find(1)->second == "one");
+    REQUIRE(map.at(2) == "two");
+    REQUIRE(map[3] == "three");
+    REQUIRE(map.count(4) == 0);
+  }
+
+  SECTION("Existing keys are not overwritten by insert") {
+    map.insert({1, "one"});
+    auto [it, inserted] = map.insert({1, "uno"});
+    REQUIRE_FALSE(inserted);
+    REQUIRE(it->second == "one");
+
+    auto [it2, inserted2] = map.insert_or_assign(1, "uno");
+    REQUIRE_FALSE(inserted2);
+    REQUIRE(it2->second == "uno");
+    REQUIRE(map.size() == 1);
+  }
+
+  SECTION("at throws for a missing key") {
+    REQUIRE_THROWS_AS(map.at(7), std::out_of_range);
+    const auto& const_map = map;
+    REQUIRE_THROWS_AS(const_map.at(7), std::out_of_range);
+  }
+
+  SECTION("Erase by key and by iterator") {
+    for (int i = 0; i < 10; i++) map[i] = std::to_string(i);
+    REQUIRE(map.erase(3) == 1);
+    REQUIRE(map.erase(3) == 0);
+    REQUIRE_FALSE(map.contains(3));
+
+    map.erase(map.find(4));
+    REQUIRE(map.size() == 8);
+    for (int i = 0; i < 10; i++) REQUIRE(map.contains(i) == (i != 3 && i != 4));
+  }
+
+  SECTION("Erase while iterating") {
+    for (int i = 0; i < 100; i++) map[i] = std::to_string(i);
+    for (auto it = map.begin(); it != map.end();) {
+      it = it->first % 2 == 0 ? map.erase(it) : std::next(it);
+    }
+    REQUIRE(map.size() == 50);
+    for (const auto& [key, value] : map) REQUIRE(key % 2 == 1);
+  }
+
+  SECTION("Clear keeps the allocation") {
+    for (int i = 0; i < 100; i++) map[i] = "x";
+    size_t capacity = map.capacity();
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.capacity() == capacity);
+    REQUIRE_FALSE(map.contains(5));
+    map[5] = "y";
+    REQUIRE(map.at(5) == "y");
+  }
+}
+
+TEST_CASE("HashMap growth") {
+  SECTION("Matches std::unordered_map under random operations") {
+    stl::HashMap<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> reference;
+    std::mt19937_64 rng(7);
+
+    for (int i = 0; i < 200000; i++) {
+      uint64_t key = rng() % 5000;
+      switch (rng() % 3) {
+        case 0:
+          map[key] = i;
+          reference[key] = i;
+          break;
+        case 1:
+          REQUIRE(map.erase(key) == reference.erase(key));
+          break;
+        case 2:
+          REQUIRE(map.contains(key) == reference.contains(key));
+          break;
+      }
+    }
+
+    REQUIRE(map.size() == reference.size());
+    for (const auto& [key, value] : reference) REQUIRE(map.at(key) == value);
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+      REQUIRE(reference.at(key) == value);
+      visited++;
+    }
+    REQUIRE(visited == reference.size());
+  }
+
+  SECTION("Reserve avoids rehashing") {
+    stl::HashMap<int, int> map(1000);
+    size_t capacity = map.capacity();
+    REQUIRE(capacity * 7 / 8 >= 1000);
+    for (int i = 0; i < 1000; i++) map[i] = i;
+    REQUIRE(map.capacity() == capacity);
+  }
+
+  SECTION("Churn reuses tombstones instead of growing") {
+    stl::HashMap<int, int> map;
+    for (int i = 0; i < 100; i++) map[i] = i;
+    size_t capacity = map.capacity();
+
+    for (int i = 100; i < 100000; i++) {
+      map.erase(i - 100);
+      map[i] = i;
+    }
+    REQUIRE(map.size() == 100);
+    REQUIRE(map.capacity() == capacity);
+    for (int i = 99900; i < 100000; i++) REQUIRE(map.at(i) == i);
+  }
+
+  SECTION("Survives a hash that always collides") {
+    stl::HashMap<int, int, ConstantHash> map;
+    for (int i = 0; i < 500; i++) map[i] = i * 2;
+    for (int i = 0; i < 500; i += 2) map.erase(i);
+    REQUIRE(map.size() == 250);
+    for (int i = 0; i < 500; i++) {
+      REQUIRE(map.contains(i) == (i % 2 == 1));
+    }
+  }
+
+  SECTION("Sequential integer keys stay findable") {
+    stl::HashMap<uint64_t, int> map;
+    for (uint64_t i = 0; i < 100000; i++) map[i << 20] = 1;
+    for (uint64_t i = 0; i < 100000; i++) REQUIRE(map.contains(i << 20));
+    REQUIRE_FALSE(map.contains(1));
+  }
+}
+
+TEST_CASE("HashMap object lifetime") {
+  SECTION("Every constructed entry is destroyed") {
+    {
+      stl::HashMap<int, Counted> map;
+      for (int i = 0; i < 1000; i++) map.try_emplace(i, i);
+      for (int i = 0; i < 500; i++) map.erase(i);
+      REQUIRE(Counted::alive == 500);
+      map.clear();
+      REQUIRE(Counted::alive == 0);
+      for (int i = 0; i < 100; i++) map.try_emplace(i, i);
+    }
+    REQUIRE(Counted::alive == 0);
+  }
+
+  SECTION("Copy and move") {
+    stl::HashMap<std::string, int> map;
+    for (int i = 0; i < 100; i++) map[std::to_string(i)] = i;
+
+    stl::HashMap<std::string, int> copy(map);
+    copy["0"] = -1;
+    REQUIRE(map.at("0") == 0);
+    REQUIRE(copy.size() == 100);
+
+    stl::HashMap<std::string, int> moved(std::move(copy));
+    REQUIRE(moved.at("0") == -1);
+    REQUIRE(copy.empty());
+
+    copy = moved;
+    REQUIRE(copy.at("99") == 99);
+    map = std::move(moved);
+    REQUIRE(map.at("0") == -1);
+  }
+
+  SECTION("Const iteration") {
+    stl::HashMap<int, int> map;
+    for (int i = 0; i < 10; i++) map[i] = i;
+    const auto& const_map = map;
+
+    int sum = 0;
+    for (auto it = const_map.begin(); it != const_map.end(); ++it) {
+      sum += it->second;
+    }
+    REQUIRE(sum == 45);
+
+    stl::HashMap<int, int>::const_iterator converted = map.find(3);
+    REQUIRE(converted->second == 3);
+  }
+
+  SECTION("Move-only keys and values") {
+    stl::HashMap<MoveOnlyKey, std::unique_ptr<int>, ValueHash> map;
+    for (int i = 0; i < 1000; i++) {
+      map.try_emplace(MoveOnlyKey(i), std::make_unique<int>(i));
+    }
+    REQUIRE(map.size() == 1000);
+    for (int i = 0; i < 1000; i++) {
+      REQUIRE(*map.find(MoveOnlyKey(i))->second == i);
+    }
+  }
+
+  SECTION("A throwing copy during rehash leaves the map as it was") {
+    {
+      stl::HashMap<FragileKey, int, ValueHash> map;
+      // Fills the first table, so the next insert rehashes
+      while (map.size() < 14) {
+        int key = static_cast<int>(map.size());
+        map.try_emplace(FragileKey(key), key);
+      }
+      REQUIRE(map.capacity() == 16);
+
+      FragileKey::copies_left = 5;
+      REQUIRE_THROWS_AS(map.try_emplace(FragileKey(100), 100),
+                        std::runtime_error);
+      FragileKey::copies_left = -1;
+
+      REQUIRE(map.capacity() == 16);
+      REQUIRE(map.size() == 14);
+      REQUIRE(FragileKey::alive == 14);
+      for (int i = 0; i < 14; i++) REQUIRE(map.at(FragileKey(i)) == i);
+      REQUIRE(map.try_emplace(FragileKey(100), 100).second);
+      REQUIRE(map.at(FragileKey(100)) == 100);
+    }
+    REQUIRE(FragileKey::alive == 0);
+  }
+
+  SECTION("A throwing copy constructor leaks nothing") {
+    {
+      stl::HashMap<FragileKey, int, ValueHash> map;
+      for (int i = 0; i < 100; i++) map.try_emplace(FragileKey(i), i);
+
+      FragileKey::copies_left = 50;
+      using Map = stl::HashMap<FragileKey, int, ValueHash>;
+      REQUIRE_THROWS_AS(Map(map), std::runtime_error);
+      FragileKey::copies_left = -1;
+      REQUIRE(FragileKey::alive == 100);
+    }
+    REQUIRE(FragileKey::alive == 0);
+  }
+}
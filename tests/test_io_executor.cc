@@ -0,0 +1,158 @@
+#define CATCH_CONFIG_MAIN
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stl/io_executor.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+// Temp file removed on scope exit
+struct TempFile {
+  TempFile() {
+    std::string path =
+        (std::filesystem::temp_directory_path() / "stl_io_XXXXXX").string();
+    fd = ::mkstemp(path.data());
+    name = path;
+  }
+  ~TempFile() {
+    ::close(fd);
+    ::unlink(name.c_str());
+  }
+
+  int fd = -1;
+  std::string name;
+};
+
+std::vector<stl::IoBackend> backends() {
+  std::vector<stl::IoBackend> result{stl::IoBackend::kThreads};
+  if (stl::IoExecutor::io_uring_available()) {
+    result.push_back(stl::IoBackend::kIoUring);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("IoExecutor read and write") {
+  for (stl::IoBackend backend : backends()) {
+    SECTION("Write then read back, backend " +
+            std::to_string(static_cast<int>(backend))) {
+      TempFile file;
+      REQUIRE(file.fd >= 0);
+      stl::ThreadPool pool(2);
+      stl::IoExecutor io(pool, backend);
+      REQUIRE(io.backend() == backend);
+
+      std::string data = "hello from the io executor";
+      auto written = io.write(file.fd, data.data(), data.size(), 0).get();
+      REQUIRE(written.ok());
+      REQUIRE(written.bytes == data.size());
+
+      std::string buffer(data.size(), '\0');
+      auto read = io.read(file.fd, buffer.data(), buffer.size(), 0).get();
+      REQUIRE(read.ok());
+      REQUIRE(read.bytes == data.size());
+      REQUIRE(buffer == data);
+    }
+
+    SECTION("Callbacks run on pool workers, backend " +
+            std::to_string(static_cast<int>(backend))) {
+      TempFile file;
+      stl::ThreadPool pool(2);
+      stl::IoExecutor io(pool, backend);
+
+      constexpr size_t kBlocks = 64;
+      constexpr size_t kBlockSize = 4096;
+      std::vector<char> data(kBlocks * kBlockSize);
+      for (size_t i = 0; i < data.size(); ++i) data[i] = char(i * 7);
+
+      std::atomic<size_t> done = 0;
+      std::atomic<bool> all_on_workers = true;
+      std::atomic<bool> all_ok = true;
+      for (size_t block = 0; block < kBlocks; ++block) {
+        io.write(file.fd, data.data() + block * kBlockSize, kBlockSize,
+                 block * kBlockSize, [&](stl::IoResult result) {
+                   if (!pool.is_worker_thread()) all_on_workers = false;
+                   if (result.bytes != kBlockSize) all_ok = false;
+                   done++;
+                 });
+      }
+      while (done != kBlocks) std::this_thread::yield();
+      REQUIRE(all_on_workers);
+      REQUIRE(all_ok);
+
+      std::vector<char> back(data.size());
+      std::vector<std::future<stl::IoResult>> reads;
+      for (size_t block = 0; block < kBlocks; ++block) {
+        reads.push_back(io.read(file.fd, back.data() + block * kBlockSize,
+                                kBlockSize, block * kBlockSize));
+      }
+      for (auto& future : reads) REQUIRE(future.get().bytes == kBlockSize);
+      REQUIRE(back == data);
+    }
+
+    SECTION("Errors are reported, backend " +
+            std::to_string(static_cast<int>(backend))) {
+      stl::ThreadPool pool(1);
+      stl::IoExecutor io(pool, backend);
+
+      char buffer[16];
+      auto result = io.read(-1, buffer, sizeof(buffer), 0).get();
+      REQUIRE_FALSE(result.ok());
+      REQUIRE(result.error == EBADF);
+    }
+
+    SECTION("Short read at end of file, backend " +
+            std::to_string(static_cast<int>(backend))) {
+      TempFile file;
+      stl::ThreadPool pool(1);
+      stl::IoExecutor io(pool, backend);
+
+      REQUIRE(io.write(file.fd, "abc", 3, 0).get().bytes == 3);
+      char buffer[16];
+      auto result = io.read(file.fd, buffer, sizeof(buffer), 1).get();
+      REQUIRE(result.ok());
+      REQUIRE(result.bytes == 2);
+    }
+  }
+}
+
+TEST_CASE("IoExecutor lifetime") {
+  SECTION("Destructor completes accepted requests") {
+    TempFile file;
+    std::atomic<int> done = 0;
+    stl::ThreadPool pool(2);
+    std::vector<char> data(1 << 16, 'x');
+
+    {
+      stl::IoExecutor io(pool);
+      for (int i = 0; i < 32; ++i) {
+        io.write(file.fd, data.data(), data.size(), i * data.size(),
+                 [&done](stl::IoResult) { done++; });
+      }
+    }
+
+    // Callbacks were queued on the pool before the executor went away
+    while (done != 32) std::this_thread::yield();
+    REQUIRE(::lseek(file.fd, 0, SEEK_END) == 32 * (1 << 16));
+  }
+
+  SECTION("Forced io_uring throws when unavailable") {
+    stl::ThreadPool pool(1);
+    if (!stl::IoExecutor::io_uring_available()) {
+      REQUIRE_THROWS_AS(stl::IoExecutor(pool, stl::IoBackend::kIoUring),
+                        std::runtime_error);
+    } else {
+      REQUIRE(stl::IoExecutor(pool).backend() == stl::IoBackend::kIoUring);
+    }
+  }
+}
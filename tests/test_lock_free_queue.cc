@@ -3,6 +3,7 @@
 #include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <random>
 #include <set>
@@ -285,6 +286,32 @@ TEST_CASE("LockFreeQueue boundary conditions") {
       }
     }
   }
+
+  SECTION("Empty tracks pushes and pops") {
+    stl::LockFreeQueue<int, 4> queue;
+    REQUIRE(queue.empty());
+    REQUIRE(queue.try_push(1));
+    REQUIRE_FALSE(queue.empty());
+
+    int value;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(queue.empty());
+  }
+
+  SECTION("Compact alignment") {
+    using Compact = stl::LockFreeQueue<int64_t, 4, 8>;
+    REQUIRE(sizeof(Compact) < sizeof(stl::LockFreeQueue<int64_t, 4>));
+    REQUIRE(sizeof(Compact) == 4 * 16 + 2 * sizeof(size_t));
+
+    Compact queue;
+    for (int64_t i = 0; i < 4; ++i) REQUIRE(queue.try_push(i));
+    REQUIRE_FALSE(queue.try_push(4));
+    for (int64_t i = 0; i < 4; ++i) {
+      int64_t value;
+      REQUIRE(queue.try_pop(value));
+      REQUIRE(value == i);
+    }
+  }
 }
 
 TEST_CASE("LockFreeQueue concurrent operations") {
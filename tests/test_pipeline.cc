@@ -0,0 +1,234 @@
+#define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "stl/pipeline.h"
+#include "stl/thread_pool.h"
+
+// Source yielding 0, 1, ..., count - 1
+struct CountingSource {
+  int next = 0;
+  int count;
+
+  explicit CountingSource(int count) : count(count) {}
+
+  bool operator()(int& value) {
+    if (next == count) return false;
+    value = next++;
+    return true;
+  }
+};
+
+TEST_CASE("Pipeline basic flow") {
+  SECTION("Empty source") {
+    stl::ThreadPool pool(2);
+    stl::Pipeline<int> pipeline(pool);
+    pipeline.add_stage(stl::StageMode::kParallel, [](int& x) { x++; });
+
+    REQUIRE(pipeline.run(CountingSource(0)) == 0);
+  }
+
+  SECTION("No stages just counts the source") {
+    stl::ThreadPool pool(2);
+    stl::Pipeline<int> pipeline(pool);
+
+    REQUIRE(pipeline.num_stages() == 0);
+    REQUIRE(pipeline.run(CountingSource(100)) == 100);
+  }
+
+  SECTION("Every item passes every stage") {
+    stl::ThreadPool pool(4);
+    stl::Pipeline<int> pipeline(pool);
+    std::vector<int> sink;
+
+    pipeline.add_stage(stl::StageMode::kParallel, [](int& x) { x *= 2; })
+        .add_stage(stl::StageMode::kParallel, [](int& x) { x += 1; })
+        .add_stage(stl::StageMode::kSerialOutOfOrder,
+                   [&sink](int& x) { sink.push_back(x); });
+
+    REQUIRE(pipeline.run(CountingSource(1000)) == 1000);
+
+    std::sort(sink.begin(), sink.end());
+    REQUIRE(sink.size() == 1000);
+    for (int i = 0; i < 1000; ++i) {
+      REQUIRE(sink[i] == 2 * i + 1);
+    }
+  }
+
+  SECTION("Pipeline can be run more than once") {
+    stl::ThreadPool pool(2);
+    stl::Pipeline<int, 8> pipeline(pool);
+    std::vector<int> sink;
+
+    pipeline.add_stage(stl::StageMode::kSerialInOrder,
+                       [&sink](int& x) { sink.push_back(x); });
+
+    REQUIRE(pipeline.run(CountingSource(20)) == 20);
+    REQUIRE(pipeline.run(CountingSource(20)) == 20);
+    REQUIRE(sink.size() == 40);
+    REQUIRE(sink[20] == 0);
+  }
+}
+
+TEST_CASE("Pipeline ordering guarantees") {
+  SECTION("In-order stage restores source order after a parallel stage") {
+    stl::ThreadPool pool(4);
+    stl::Pipeline<int, 16> pipeline(pool);
+    std::vector<int> sink;
+
+    pipeline
+        .add_stage(stl::StageMode::kParallel,
+                   [](int& x) {
+                     // Uneven work so tokens overtake each other
+                     if (x % 7 == 0) {
+                       std::this_thread::sleep_for(
+                           std::chrono::microseconds(200));
+                     }
+                   })
+        .add_stage(stl::StageMode::kSerialInOrder,
+                   [&sink](int& x) { sink.push_back(x); });
+
+    REQUIRE(pipeline.run(CountingSource(500)) == 500);
+
+    REQUIRE(sink.size() == 500);
+    for (int i = 0; i < 500; ++i) {
+      REQUIRE(sink[i] == i);
+    }
+  }
+
+  SECTION("Serial stages never overlap") {
+    stl::ThreadPool pool(4);
+    stl::Pipeline<int> pipeline(pool);
+    std::atomic<int> active{0};
+    std::atomic<bool> overlapped{false};
+
+    auto serial = [&](int&) {
+      if (active.fetch_add(1) != 0) overlapped = true;
+      std::this_thread::yield();
+      active.fetch_sub(1);
+    };
+    pipeline.add_stage(stl::StageMode::kParallel, [](int&) {})
+        .add_stage(stl::StageMode::kSerialOutOfOrder, serial);
+
+    pipeline.run(CountingSource(2000));
+
+    REQUIRE_FALSE(overlapped.load());
+  }
+
+  SECTION("Tokens in flight stay within the limit") {
+    stl::ThreadPool pool(4);
+    stl::Pipeline<int, 32> pipeline(pool);
+    std::atomic<int> in_flight{0};
+    std::atomic<int> max_in_flight{0};
+
+    pipeline
+        .add_stage(stl::StageMode::kSerialInOrder,
+                   [&](int&) {
+                     int now = in_flight.fetch_add(1) + 1;
+                     int seen = max_in_flight.load();
+                     while (now > seen &&
+                            !max_in_flight.compare_exchange_weak(seen, now)) {
+                     }
+                   })
+        .add_stage(stl::StageMode::kParallel,
+                   [](int&) { std::this_thread::yield(); })
+        .add_stage(stl::StageMode::kSerialInOrder,
+                   [&](int&) { in_flight.fetch_sub(1); });
+
+    pipeline.run(CountingSource(1000), 4);
+
+    REQUIRE(max_in_flight.load() <= 4);
+  }
+}
+
+TEST_CASE("Pipeline error handling and nesting") {
+  SECTION("Stage exception is rethrown from run") {
+    stl::ThreadPool pool(2);
+    stl::Pipeline<int> pipeline(pool);
+    std::vector<int> sink;
+
+    pipeline
+        .add_stage(stl::StageMode::kParallel,
+                   [](int& x) {
+                     if (x == 10) throw std::runtime_error("bad item");
+                   })
+        .add_stage(stl::StageMode::kSerialInOrder,
+                   [&sink](int& x) { sink.push_back(x); });
+
+    REQUIRE_THROWS_AS(pipeline.run(CountingSource(1000)), std::runtime_error);
+    // The failing item never reaches later stages
+    REQUIRE(std::find(sink.begin(), sink.end(), 10) == sink.end());
+
+    // And the pipeline is reusable afterwards
+    sink.clear();
+    stl::Pipeline<int> clean(pool);
+    clean.add_stage(stl::StageMode::kSerialInOrder,
+                    [&sink](int& x) { sink.push_back(x); });
+    REQUIRE(clean.run(CountingSource(5)) == 5);
+  }
+
+  SECTION("Source exception is rethrown from run") {
+    stl::ThreadPool pool(2);
+    stl::Pipeline<int> pipeline(pool);
+    int produced = 0;
+
+    pipeline.add_stage(stl::StageMode::kParallel, [](int&) {});
+
+    REQUIRE_THROWS_AS(pipeline.run([&produced](int& x) {
+      if (produced == 3) throw std::runtime_error("source");
+      x = produced++;
+      return true;
+    }),
+                      std::runtime_error);
+  }
+
+  SECTION("Running from inside a single-worker pool does not deadlock") {
+    stl::ThreadPool pool(1);
+
+    auto future = pool.submit_task([&pool]() {
+      stl::Pipeline<int, 8> pipeline(pool);
+      long sum = 0;
+      pipeline.add_stage(stl::StageMode::kParallel, [](int& x) { x *= x; })
+          .add_stage(stl::StageMode::kSerialInOrder,
+                     [&sum](int& x) { sum += x; });
+      pipeline.run(CountingSource(100));
+      return sum;
+    });
+
+    REQUIRE(future.get() == 328350);
+  }
+
+  SECTION("Running from a pool task with one token in flight") {
+    // The waiting worker helps with other tasks, re-checking for a free
+    // token each time, and must not lose one it has already taken
+    stl::ThreadPool pool(2);
+
+    auto future = pool.submit_task([&pool]() {
+      stl::Pipeline<int, 4> pipeline(pool);
+      long sum = 0;
+      // The sleep leaves the waiter parked in the pool's condition wait
+      // when the other worker retires the token
+      pipeline
+          .add_stage(stl::StageMode::kParallel,
+                     [](int& x) {
+                       x += 1;
+                       std::this_thread::sleep_for(
+                           std::chrono::microseconds(20));
+                     })
+          .add_stage(stl::StageMode::kSerialInOrder,
+                     [&sum](int& x) { sum += x; });
+      size_t items = pipeline.run(CountingSource(2000), 1);
+      return std::make_pair(items, sum);
+    });
+
+    auto [items, sum] = future.get();
+    REQUIRE(items == 2000);
+    REQUIRE(sum == 2001000);
+  }
+}
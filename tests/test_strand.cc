@@ -0,0 +1,242 @@
+#define CATCH_CONFIG_MAIN
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "stl/strand.h"
+#include "stl/thread_pool.h"
+
+TEST_CASE("Strand basic execution") {
+  SECTION("Posted tasks run in FIFO order") {
+    stl::ThreadPool pool(4);
+    std::vector<int> order;
+
+    {
+      stl::Strand strand(pool);
+      for (int i = 0; i < 1000; ++i) {
+        strand.post([&order, i]() { order.push_back(i); });
+      }
+    }  // Destructor waits for the queue to drain
+
+    REQUIRE(order.size() == 1000);
+    for (int i = 0; i < 1000; ++i) {
+      REQUIRE(order[i] == i);
+    }
+  }
+
+  SECTION("Submit returns a future") {
+    stl::ThreadPool pool(2);
+    stl::Strand strand(pool);
+
+    auto future = strand.submit([](int a, int b) { return a + b; }, 40, 2);
+
+    REQUIRE(future.get() == 42);
+  }
+
+  SECTION("Exceptions surface through submit") {
+    stl::ThreadPool pool(2);
+    stl::Strand strand(pool);
+
+    auto future =
+        strand.submit([]() -> int { throw std::runtime_error("strand"); });
+
+    REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+  }
+
+  SECTION("Running in this thread") {
+    stl::ThreadPool pool(2);
+    stl::Strand strand(pool);
+    stl::Strand other(pool);
+
+    auto future = strand.submit([&strand, &other]() {
+      return strand.running_in_this_thread() &&
+             !other.running_in_this_thread();
+    });
+
+    REQUIRE(future.get());
+    REQUIRE_FALSE(strand.running_in_this_thread());
+  }
+}
+
+TEST_CASE("Strand serialisation") {
+  SECTION("Tasks never overlap") {
+    stl::ThreadPool pool(4);
+    std::atomic<int> in_flight{0};
+    std::atomic<int> max_in_flight{0};
+    int unsynchronised = 0;
+
+    {
+      stl::Strand strand(pool);
+      for (int i = 0; i < 2000; ++i) {
+        strand.post([&]() {
+          int now = in_flight.fetch_add(1) + 1;
+          int seen = max_in_flight.load();
+          while (now > seen &&
+                 !max_in_flight.compare_exchange_weak(seen, now)) {
+          }
+          unsynchronised++;
+          in_flight.fetch_sub(1);
+        });
+      }
+    }
+
+    REQUIRE(max_in_flight.load() == 1);
+    REQUIRE(unsynchronised == 2000);
+  }
+
+  SECTION("Per-producer order is kept with concurrent posters") {
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 2000;
+    stl::ThreadPool pool(4);
+    std::vector<std::vector<int>> seen(kProducers);
+
+    {
+      stl::Strand strand(pool);
+      std::vector<std::thread> producers;
+      for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&strand, &seen, p]() {
+          for (int i = 0; i < kPerProducer; ++i) {
+            strand.post([&seen, p, i]() { seen[p].push_back(i); });
+          }
+        });
+      }
+      for (auto& producer : producers) producer.join();
+    }
+
+    for (const auto& values : seen) {
+      REQUIRE(values.size() == kPerProducer);
+      for (int i = 0; i < kPerProducer; ++i) {
+        REQUIRE(values[i] == i);
+      }
+    }
+  }
+
+  SECTION("Tasks posted from inside the strand run after it") {
+    stl::ThreadPool pool(2);
+    std::vector<int> order;
+
+    {
+      stl::Strand strand(pool);
+      strand.post([&]() {
+        strand.post([&order]() { order.push_back(2); });
+        order.push_back(1);
+      });
+    }
+
+    REQUIRE(order == std::vector<int>{1, 2});
+  }
+
+  SECTION("Independent strands all complete") {
+    stl::ThreadPool pool(4);
+    std::vector<int> counts(8, 0);
+
+    {
+      std::vector<std::unique_ptr<stl::Strand>> strands;
+      for (size_t s = 0; s < counts.size(); ++s) {
+        strands.push_back(std::make_unique<stl::Strand>(pool));
+      }
+      for (int i = 0; i < 800; ++i) {
+        size_t s = i % counts.size();
+        strands[s]->post([&counts, s]() { counts[s]++; });
+      }
+    }
+
+    for (int count : counts) {
+      REQUIRE(count == 100);
+    }
+  }
+}
+
+TEST_CASE("Strand across pool shutdown") {
+  SECTION("A queued batch still runs in order") {
+    stl::ThreadPool pool(2);
+    std::vector<int> order;
+    std::atomic<bool> release = false;
+
+    {
+      stl::Strand strand(pool);
+      // Holds the strand on its worker until the pool is shut down, so the
+      // batch boundary finds the pool refusing continuations
+      strand.post([&release]() {
+        while (!release.load()) std::this_thread::yield();
+      });
+      for (int i = 0; i < 200; ++i) {
+        strand.post([&order, i]() { order.push_back(i); });
+      }
+      pool.shutdown();
+      release.store(true);
+    }
+
+    REQUIRE(order.size() == 200);
+    for (int i = 0; i < 200; ++i) {
+      REQUIRE(order[i] == i);
+    }
+  }
+
+  SECTION("Posting after shutdown runs on the caller") {
+    stl::ThreadPool pool(1);
+    pool.shutdown();
+    stl::Strand strand(pool);
+
+    std::thread::id ran_on;
+    strand.post([&ran_on]() { ran_on = std::this_thread::get_id(); });
+
+    REQUIRE(ran_on == std::this_thread::get_id());
+    REQUIRE(strand.pending() == 0);
+    REQUIRE(strand.submit([]() { return 7; }).get() == 7);
+  }
+}
+
+TEST_CASE("StrandMap keyed execution") {
+  SECTION("Same key maps to the same strand") {
+    stl::ThreadPool pool(2);
+    stl::StrandMap<std::string> strands(pool, 16);
+
+    REQUIRE(strands.size() == 16);
+    REQUIRE(&strands.strand_for("session-1") ==
+            &strands.strand_for("session-1"));
+  }
+
+  SECTION("Per-key order is preserved") {
+    constexpr int kKeys = 10;
+    constexpr int kPerKey = 500;
+    stl::ThreadPool pool(4);
+    std::vector<std::vector<int>> seen(kKeys);
+
+    {
+      stl::StrandMap<int> strands(pool, 4);
+      for (int i = 0; i < kPerKey; ++i) {
+        for (int key = 0; key < kKeys; ++key) {
+          strands.post(key, [&seen, key, i]() { seen[key].push_back(i); });
+        }
+      }
+    }
+
+    for (const auto& values : seen) {
+      REQUIRE(values.size() == kPerKey);
+      for (int i = 0; i < kPerKey; ++i) {
+        REQUIRE(values[i] == i);
+      }
+    }
+  }
+
+  SECTION("Zero strands are rejected") {
+    stl::ThreadPool pool(1);
+    using Map = stl::StrandMap<int>;
+    REQUIRE_THROWS_AS(Map(pool, 0), std::invalid_argument);
+  }
+
+  SECTION("Keyed submit returns a future") {
+    stl::ThreadPool pool(2);
+    stl::StrandMap<int> strands(pool, 4);
+
+    auto future = strands.submit(7, [](int x) { return x * 6; }, 7);
+
+    REQUIRE(future.get() == 42);
+  }
+}
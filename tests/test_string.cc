@@ -0,0 +1,222 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "stl/hash.h"
+#include "stl/hash_map.h"
+#include "stl/string.h"
+
+using stl::String;
+
+TEST_CASE("String small string optimization") {
+  SECTION("Is 24 bytes and starts empty and inline") {
+    REQUIRE(sizeof(String) == 24);
+    String s;
+    REQUIRE(s.empty());
+    REQUIRE(s.is_inline());
+    REQUIRE(s.capacity() == String::kInlineCapacity);
+    REQUIRE(std::strcmp(s.c_str(), "") == 0);
+  }
+
+  SECTION("Up to 23 chars stay inline") {
+    for (size_t len = 0; len <= 23; len++) {
+      String s(len, 'x');
+      REQUIRE(s.is_inline());
+      REQUIRE(s.size() == len);
+      REQUIRE(std::string_view(s) == std::string(len, 'x'));
+      REQUIRE(s.c_str()[len] == '\0');
+    }
+    String full("abcdefghijklmnopqrstuvw");
+    REQUIRE(full.size() == 23);
+    REQUIRE(full.is_inline());
+    REQUIRE(std::strlen(full.c_str()) == 23);
+  }
+
+  SECTION("The 24th char moves it to the heap") {
+    String s(23, 'a');
+    s.push_back('b');
+    REQUIRE_FALSE(s.is_inline());
+    REQUIRE(s.size() == 24);
+    REQUIRE(s.capacity() >= 46);
+    REQUIRE(s == std::string(23, 'a') + "b");
+  }
+
+  SECTION("shrink_to_fit moves a short heap string back inline") {
+    String s(100, 'a');
+    s.resize(5);
+    REQUIRE_FALSE(s.is_inline());
+    s.shrink_to_fit();
+    REQUIRE(s.is_inline());
+    REQUIRE(s == "aaaaa");
+  }
+}
+
+TEST_CASE("String operations") {
+  SECTION("Construct, compare and index") {
+    String s = "hello";
+    REQUIRE(s.size() == 5);
+    REQUIRE(s == "hello");
+    REQUIRE(s != "world");
+    REQUIRE(s < String("help"));
+    REQUIRE(s == String("hello"));
+    REQUIRE(s[1] == 'e');
+    REQUIRE(s.front() == 'h');
+    REQUIRE(s.back() == 'o');
+    REQUIRE(s.at(4) == 'o');
+    REQUIRE_THROWS_AS(s.at(5), std::out_of_range);
+    REQUIRE(std::string(s.begin(), s.end()) == "hello");
+  }
+
+  SECTION("Append grows geometrically") {
+    String s;
+    size_t reallocations = 0;
+    const char* last = s.data();
+    for (int i = 0; i < 10000; i++) {
+      s += 'x';
+      if (s.data() != last) {
+        reallocations++;
+        last = s.data();
+      }
+    }
+    REQUIRE(s.size() == 10000);
+    REQUIRE(reallocations < 15);
+  }
+
+  SECTION("Append from itself") {
+    String s = "abc";
+    for (int i = 0; i < 5; i++) s.append(s);
+    REQUIRE(s.size() == 3 * 32);
+    for (size_t i = 0; i < s.size(); i++) REQUIRE(s[i] == "abc"[i % 3]);
+
+    String t = "0123456789";
+    t.append(t.data() + 2, 3);
+    REQUIRE(t == "0123456789234");
+  }
+
+  SECTION("Assign from a part of itself") {
+    String s(50, 'z');
+    s[10] = 'a';
+    s = std::string_view(s).substr(10, 30);
+    REQUIRE(s.size() == 30);
+    REQUIRE(s[0] == 'a');
+  }
+
+  SECTION("reserve, resize and resize_for_overwrite") {
+    String s = "ab";
+    s.reserve(100);
+    REQUIRE(s.capacity() == 100);
+    REQUIRE(s == "ab");
+    const char* data = s.data();
+    s.append(98, 'c');
+    REQUIRE(s.data() == data);
+
+    s.resize(3);
+    REQUIRE(s == "abc");
+    s.resize(5, '!');
+    REQUIRE(s == "abc!!");
+
+    s.resize_for_overwrite(8);
+    std::memcpy(s.data() + 5, "xyz", 3);
+    REQUIRE(s == "abc!!xyz");
+    REQUIRE(s.c_str()[8] == '\0');
+  }
+
+  SECTION("Concatenation and substr") {
+    String a = "foo";
+    String b = "bar";
+    REQUIRE(a + b == "foobar");
+    REQUIRE(a + "baz" == "foobaz");
+    REQUIRE("baz" + a == "bazfoo");
+    REQUIRE(a + std::string("qux") == "fooqux");
+    REQUIRE((a + b).substr(2, 3) == "oba");
+    REQUIRE(a.substr(3).empty());
+    REQUIRE_THROWS_AS(a.substr(4), std::out_of_range);
+  }
+
+  SECTION("Streams") {
+    std::ostringstream os;
+    os << String("streamed");
+    REQUIRE(os.str() == "streamed");
+  }
+}
+
+TEST_CASE("String copy and move") {
+  for (size_t len : {0, 5, 23, 24, 200}) {
+    String original(len, 'q');
+
+    String copy(original);
+    REQUIRE(copy == original);
+    if (len > 23) REQUIRE(copy.data() != original.data());
+
+    String assigned = "something long enough to live on the heap";
+    assigned = original;
+    REQUIRE(assigned == original);
+
+    String moved(std::move(copy));
+    REQUIRE(moved == original);
+    REQUIRE(copy.empty());
+
+    String move_assigned;
+    move_assigned = std::move(moved);
+    REQUIRE(move_assigned == original);
+    REQUIRE(moved.empty());
+
+    swap(move_assigned, assigned);
+    REQUIRE(assigned == original);
+  }
+
+  SECTION("Matches std::string under random edits") {
+    std::mt19937 rng(5);
+    String s;
+    std::string reference;
+    for (int i = 0; i < 20000; i++) {
+      switch (rng() % 5) {
+        case 0:
+          s.push_back(static_cast<char>('a' + i % 26));
+          reference.push_back(static_cast<char>('a' + i % 26));
+          break;
+        case 1: {
+          std::string piece(rng() % 40, static_cast<char>('A' + i % 26));
+          s.append(piece);
+          reference.append(piece);
+          break;
+        }
+        case 2: {
+          size_t size = rng() % (reference.size() + 1);
+          s.resize(size);
+          reference.resize(size);
+          break;
+        }
+        case 3:
+          if (!reference.empty()) {
+            s.pop_back();
+            reference.pop_back();
+          }
+          break;
+        case 4: {
+          String copy = s;
+          s = std::move(copy);
+          break;
+        }
+      }
+      REQUIRE(std::string_view(s) == reference);
+      REQUIRE(s.c_str()[s.size()] == '\0');
+    }
+  }
+}
+
+TEST_CASE("String as a hash map key") {
+  REQUIRE(stl::Hash<String>{}(String("key")) ==
+          stl::Hash<std::string_view>{}("key"));
+
+  stl::HashMap<String, int> map;
+  for (int i = 0; i < 1000; i++) map[String(std::to_string(i))] = i;
+  REQUIRE(map.at(String("999")) == 999);
+}
@@ -0,0 +1,128 @@
+#define CATCH_CONFIG_MAIN
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stl/hash.h"
+#include "stl/hash_map.h"
+#include "stl/string_interner.h"
+#include "stl/thread_pool.h"
+
+using stl::Atom;
+using stl::StringInterner;
+
+TEST_CASE("StringInterner basic operations") {
+  StringInterner interner;
+
+  SECTION("Equal strings share an atom") {
+    Atom a = interner.intern("alpha");
+    Atom b = interner.intern(std::string("alp") + "ha");
+    Atom c = interner.intern("beta");
+    REQUIRE(a == b);
+    REQUIRE(a != c);
+    REQUIRE(a.valid());
+    REQUIRE(interner.size() == 2);
+    REQUIRE(interner.view(a) == "alpha");
+    REQUIRE(interner.view(c) == "beta");
+    REQUIRE(std::strcmp(interner.c_str(c), "beta") == 0);
+  }
+
+  SECTION("Empty and embedded nul strings") {
+    Atom empty = interner.intern("");
+    Atom nul = interner.intern(std::string_view("a\0b", 3));
+    REQUIRE(interner.view(empty).empty());
+    REQUIRE(interner.view(nul) == std::string_view("a\0b", 3));
+    REQUIRE(interner.intern("a") != nul);
+  }
+
+  SECTION("find does not intern") {
+    REQUIRE_FALSE(interner.find("missing").has_value());
+    REQUIRE(interner.size() == 0);
+    Atom a = interner.intern("present");
+    REQUIRE(interner.find("present") == a);
+  }
+
+  SECTION("Default atoms are invalid") {
+    REQUIRE_FALSE(Atom().valid());
+    REQUIRE(Atom() == Atom());
+  }
+
+  SECTION("Shard count is rounded up to a power of two") {
+    REQUIRE(StringInterner(3).num_shards() == 4);
+    REQUIRE(StringInterner(0).num_shards() == 1);
+    REQUIRE_THROWS_AS(StringInterner(1024), std::invalid_argument);
+  }
+}
+
+TEST_CASE("StringInterner growth") {
+  SECTION("Views stay valid as the tables and arena grow") {
+    StringInterner interner(4);
+    std::vector<Atom> atoms;
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 200000; i++) {
+      atoms.push_back(interner.intern("symbol_" + std::to_string(i)));
+      views.push_back(interner.view(atoms.back()));
+    }
+    REQUIRE(interner.size() == 200000);
+    for (int i = 0; i < 200000; i++) {
+      std::string expected = "symbol_" + std::to_string(i);
+      REQUIRE(views[i] == expected);
+      REQUIRE(interner.view(atoms[i]) == expected);
+      REQUIRE(interner.intern(expected) == atoms[i]);
+    }
+    REQUIRE(interner.memory_usage() > 200000 * 8);
+  }
+
+  SECTION("Long strings get their own arena space") {
+    StringInterner interner(1);
+    std::string big(1 << 20, 'x');
+    Atom a = interner.intern(big);
+    REQUIRE(interner.view(a) == big);
+    REQUIRE(interner.intern(big) == a);
+  }
+}
+
+TEST_CASE("StringInterner with ThreadPool workers") {
+  StringInterner interner(8);
+  stl::ThreadPool pool(4);
+  constexpr int kTasks = 8;
+  constexpr int kSymbols = 20000;
+
+  // Every task interns the same symbols in a different order
+  std::vector<std::future<std::vector<Atom>>> results;
+  for (int t = 0; t < kTasks; t++) {
+    results.push_back(pool.submit_task([&interner, t] {
+      std::vector<Atom> atoms(kSymbols);
+      for (int i = 0; i < kSymbols; i++) {
+        int symbol = (i * 7919 + t * 104729) % kSymbols;
+        atoms[symbol] = interner.intern("sym" + std::to_string(symbol));
+      }
+      return atoms;
+    }));
+  }
+
+  std::vector<Atom> first = results[0].get();
+  for (int t = 1; t < kTasks; t++) REQUIRE(results[t].get() == first);
+  REQUIRE(interner.size() == kSymbols);
+  for (int i = 0; i < kSymbols; i++) {
+    REQUIRE(interner.view(first[i]) == "sym" + std::to_string(i));
+  }
+}
+
+TEST_CASE("Atoms as hash map keys") {
+  StringInterner interner;
+  stl::HashMap<Atom, int> counts;
+  for (const char* word : {"a", "b", "a", "c", "a", "b"}) {
+    counts[interner.intern(word)]++;
+  }
+  REQUIRE(counts.size() == 3);
+  REQUIRE(counts.at(interner.intern("a")) == 3);
+  REQUIRE(stl::Hash<Atom>{}(interner.intern("b")) ==
+          stl::Hash<Atom>{}(interner.intern("b")));
+}
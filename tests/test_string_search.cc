@@ -0,0 +1,170 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stl/string_search.h"
+
+using stl::DelimiterSet;
+using stl::SimdLevel;
+using stl::Tokenizer;
+
+namespace {
+
+// Every kernel this CPU can run, scalar first
+std::vector<SimdLevel> supported_levels() {
+  std::vector<SimdLevel> levels;
+  for (SimdLevel level : {SimdLevel::kScalar, SimdLevel::kSse2,
+                          SimdLevel::kSse42, SimdLevel::kAvx2}) {
+    if (level <= stl::simd_level()) levels.push_back(level);
+  }
+  return levels;
+}
+
+std::vector<std::string_view> collect(const Tokenizer& tokens) {
+  std::vector<std::string_view> out;
+  for (std::string_view token : tokens) out.push_back(token);
+  return out;
+}
+
+}  // namespace
+
+TEST_CASE("DelimiterSet") {
+  DelimiterSet set(std::string_view(" ,\t,\0", 5));
+  REQUIRE(set.size() == 4);
+  REQUIRE(set.contains(' '));
+  REQUIRE(set.contains('\0'));
+  REQUIRE_FALSE(set.contains('a'));
+  REQUIRE(DelimiterSet(static_cast<char>(0xff)).contains('\xff'));
+}
+
+TEST_CASE("An empty DelimiterSet matches nothing") {
+  DelimiterSet empty("");
+  REQUIRE(empty.size() == 0);
+  // A NUL byte must not pass for a delimiter
+  std::string text(100, 'x');
+  text[40] = '\0';
+
+  for (SimdLevel level : supported_levels()) {
+    REQUIRE(stl::detail::find_any(level, text.data(), text.size(), empty) ==
+            text.size());
+    REQUIRE(stl::detail::count_any(level, text.data(), text.size(), empty) ==
+            0);
+  }
+  REQUIRE(stl::find_first_of(text, empty) == std::string_view::npos);
+  REQUIRE(stl::count(text, empty) == 0);
+  REQUIRE(stl::split(text, empty).size() == 1);
+  REQUIRE(collect(Tokenizer(text, empty)) ==
+          std::vector<std::string_view>{text});
+}
+
+TEST_CASE("Kernels agree with the scalar search") {
+  std::mt19937_64 rng(17);
+  const std::string all_delimiters = " ,;:|\t=/&?#[]{}<>\"'";
+
+  for (size_t num_delimiters : {1, 3, 5, 16, 20}) {
+    DelimiterSet set(
+        std::string_view(all_delimiters).substr(0, num_delimiters));
+    for (size_t len = 0; len <= 200; len++) {
+      // Delimiters are sparse so matches land in every block position
+      std::string text(len, 'x');
+      for (char& c : text) {
+        c = rng() % 16 == 0 ? all_delimiters[rng() % num_delimiters]
+                            : static_cast<char>('a' + rng() % 26);
+      }
+      size_t expected_find =
+          stl::detail::find_any_scalar(text.data(), len, set);
+      size_t expected_count =
+          stl::detail::count_any_scalar(text.data(), len, set);
+      for (SimdLevel level : supported_levels()) {
+        for (size_t pos = 0; pos <= len; pos += 7) {
+          REQUIRE(stl::detail::find_any(level, text.data() + pos, len - pos,
+                                        set) ==
+                  stl::detail::find_any_scalar(text.data() + pos, len - pos,
+                                               set));
+        }
+        REQUIRE(stl::detail::find_any(level, text.data(), len, set) ==
+                expected_find);
+        REQUIRE(stl::detail::count_any(level, text.data(), len, set) ==
+                expected_count);
+      }
+    }
+  }
+}
+
+TEST_CASE("find_first_of and count") {
+  std::string_view line = "GET /index.html?user=42&lang=en HTTP/1.1";
+
+  SECTION("Matches std::string_view::find_first_of") {
+    for (size_t pos = 0; pos <= line.size() + 1; pos++) {
+      REQUIRE(stl::find_first_of(line, "?&=", pos) ==
+              line.find_first_of("?&=", pos));
+    }
+    REQUIRE(stl::find_first_of(line, "~") == std::string_view::npos);
+    REQUIRE(stl::find_byte(line, '/') == 4);
+    REQUIRE(stl::find_byte("", '/') == std::string_view::npos);
+  }
+
+  SECTION("count") {
+    REQUIRE(stl::count(line, '/') == 2);
+    REQUIRE(stl::count(line, DelimiterSet("?&=")) == 4);
+    REQUIRE(stl::count("", ' ') == 0);
+  }
+}
+
+TEST_CASE("split keeps empty fields") {
+  auto fields = stl::split("a,b,,c,", ",");
+  REQUIRE(fields.size() == 5);
+  REQUIRE(fields[0] == "a");
+  REQUIRE(fields[1] == "b");
+  REQUIRE(fields[2].empty());
+  REQUIRE(fields[3] == "c");
+  REQUIRE(fields[4].empty());
+
+  REQUIRE(stl::split("", ",").size() == 1);
+  REQUIRE(stl::split("no delimiters", ",")[0] == "no delimiters");
+
+  // The fields are views into the input
+  std::string text = "2024-01-01 12:00:00 INFO request done";
+  auto parts = stl::split(text, " ");
+  REQUIRE(parts.size() == 5);
+  REQUIRE(parts[2].data() == text.data() + 20);
+}
+
+TEST_CASE("Tokenizer skips runs of delimiters") {
+  SECTION("Tokens") {
+    auto tokens = collect(Tokenizer("  alpha \t beta,gamma  ", " \t,"));
+    REQUIRE(tokens == std::vector<std::string_view>{"alpha", "beta", "gamma"});
+  }
+
+  SECTION("Empty and all-delimiter input") {
+    REQUIRE(collect(Tokenizer("", " ")).empty());
+    REQUIRE(collect(Tokenizer("   ", " ")).empty());
+    Tokenizer tokens("", " ");
+    REQUIRE(tokens.begin() == tokens.end());
+  }
+
+  SECTION("Long lines cross block boundaries") {
+    std::string line;
+    std::vector<std::string> words;
+    for (int i = 0; i < 100; i++) {
+      words.push_back("word" + std::to_string(i));
+      line += words.back();
+      line += i % 3 == 0 ? "   " : " ";
+    }
+    auto tokens = collect(Tokenizer(line, DelimiterSet(' ')));
+    REQUIRE(tokens.size() == words.size());
+    for (size_t i = 0; i < words.size(); i++) REQUIRE(tokens[i] == words[i]);
+  }
+
+  SECTION("Post-increment") {
+    Tokenizer tokens("a b", " ");
+    auto it = tokens.begin();
+    REQUIRE(*it++ == "a");
+    REQUIRE(*it == "b");
+    REQUIRE(++it == tokens.end());
+  }
+}
@@ -0,0 +1,175 @@
+#define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "stl/task_group.h"
+#include "stl/thread_pool.h"
+
+namespace {
+
+uint64_t parallel_fib(stl::ThreadPool& pool, int n) {
+  if (n < 2) return n;
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+  stl::TaskGroup group(pool);
+  group.run([&]() { a = parallel_fib(pool, n - 1); });
+  group.run_and_wait([&]() { b = parallel_fib(pool, n - 2); });
+  return a + b;
+}
+
+void parallel_sort(stl::ThreadPool& pool, int* first, int* last) {
+  if (last - first < 256) {
+    std::sort(first, last);
+    return;
+  }
+
+  int pivot = first[(last - first) / 2];
+  int* middle1 = std::partition(first, last, [&](int x) { return x < pivot; });
+  int* middle2 =
+      std::partition(middle1, last, [&](int x) { return !(pivot < x); });
+
+  stl::TaskGroup group(pool);
+  group.run([&]() { parallel_sort(pool, first, middle1); });
+  group.run_and_wait([&]() { parallel_sort(pool, middle2, last); });
+}
+
+}  // namespace
+
+TEST_CASE("TaskGroup basic execution") {
+  SECTION("Wait runs every spawned task") {
+    stl::ThreadPool pool(4);
+    stl::TaskGroup group(pool);
+    std::atomic<int> counter = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+      group.run([&counter]() { counter++; });
+    }
+    group.wait();
+
+    REQUIRE(counter == 1000);
+    REQUIRE(group.pending() == 0);
+  }
+
+  SECTION("Group can be reused after wait") {
+    stl::ThreadPool pool(2);
+    stl::TaskGroup group(pool);
+    std::atomic<int> counter = 0;
+
+    for (int round = 0; round < 5; ++round) {
+      for (int i = 0; i < 10; ++i) group.run([&counter]() { counter++; });
+      group.wait();
+      REQUIRE(counter == (round + 1) * 10);
+    }
+  }
+
+  SECTION("Large callables are stored out of line") {
+    stl::ThreadPool pool(2);
+    stl::TaskGroup group(pool);
+    std::array<int, 64> values{};
+    std::iota(values.begin(), values.end(), 0);
+    std::atomic<int> sum = 0;
+
+    for (int i = 0; i < 10; ++i) {
+      group.run([values, &sum]() {
+        sum += std::accumulate(values.begin(), values.end(), 0);
+      });
+    }
+    group.wait();
+
+    REQUIRE(sum == 10 * (63 * 64 / 2));
+  }
+
+  SECTION("Destructor waits for outstanding tasks") {
+    stl::ThreadPool pool(2);
+    std::atomic<int> counter = 0;
+
+    {
+      stl::TaskGroup group(pool);
+      for (int i = 0; i < 100; ++i) group.run([&counter]() { counter++; });
+    }
+
+    REQUIRE(counter == 100);
+  }
+
+  SECTION("Wait from a single worker pool does not deadlock") {
+    stl::ThreadPool pool(1);
+    stl::TaskGroup outer(pool);
+    std::atomic<int> counter = 0;
+
+    outer.run([&pool, &counter]() {
+      stl::TaskGroup inner(pool);
+      for (int i = 0; i < 10; ++i) inner.run([&counter]() { counter++; });
+      inner.wait();
+    });
+    outer.wait();
+
+    REQUIRE(counter == 10);
+  }
+}
+
+TEST_CASE("TaskGroup recursion") {
+  SECTION("Fork-join fibonacci") {
+    stl::ThreadPool pool(4);
+    REQUIRE(parallel_fib(pool, 20) == 6765);
+  }
+
+  SECTION("Parallel quicksort") {
+    stl::ThreadPool pool(4);
+    std::vector<int> values(100000);
+    std::mt19937 rng(42);
+    for (auto& value : values) value = static_cast<int>(rng() % 1000);
+
+    parallel_sort(pool, values.data(), values.data() + values.size());
+
+    REQUIRE(std::is_sorted(values.begin(), values.end()));
+  }
+}
+
+TEST_CASE("TaskGroup exceptions") {
+  SECTION("First exception is rethrown once") {
+    stl::ThreadPool pool(4);
+    stl::TaskGroup group(pool);
+    std::atomic<int> counter = 0;
+
+    for (int i = 0; i < 100; ++i) {
+      group.run([&counter, i]() {
+        counter++;
+        if (i % 10 == 0) throw std::runtime_error("task failed");
+      });
+    }
+
+    REQUIRE_THROWS_AS(group.wait(), std::runtime_error);
+    // Every task still ran, and the error is not reported twice
+    REQUIRE(counter == 100);
+    REQUIRE_NOTHROW(group.wait());
+  }
+
+  SECTION("Exception from run_and_wait") {
+    stl::ThreadPool pool(2);
+    stl::TaskGroup group(pool);
+    std::atomic<int> counter = 0;
+
+    group.run([&counter]() { counter++; });
+    REQUIRE_THROWS_AS(
+        group.run_and_wait([]() { throw std::logic_error("inline"); }),
+        std::logic_error);
+    REQUIRE(counter == 1);
+  }
+
+  SECTION("Run after shutdown throws") {
+    stl::ThreadPool pool(1);
+    stl::TaskGroup group(pool);
+    pool.shutdown();
+
+    REQUIRE_THROWS_AS(group.run([]() {}), std::runtime_error);
+    REQUIRE(group.pending() == 0);
+  }
+}
@@ -2,9 +2,13 @@
 #include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <chrono>
+#include <future>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include "stl/strand.h"
+#include "stl/task_group.h"
 #include "stl/thread_pool.h"
 
 // Helper function for testing
@@ -210,3 +214,413 @@ TEST_CASE("ThreadPool exception handling") {
     }
   }
 }
+
+// Recursive helper that waits on its own subtasks from inside the pool
+int parallel_fib(stl::ThreadPool& pool, int n) {
+  if (n < 2) return n;
+  auto left = pool.submit_task(parallel_fib, std::ref(pool), n - 1);
+  int right = parallel_fib(pool, n - 2);
+  return pool.get(left) + right;
+}
+
+TEST_CASE("ThreadPool work-helping wait") {
+  SECTION("Nested wait on a single worker does not deadlock") {
+    stl::ThreadPool pool(1);
+
+    auto outer = pool.submit_task([&pool]() {
+      auto inner = pool.submit_task([]() { return 21; });
+      return pool.get(inner) * 2;
+    });
+
+    REQUIRE(outer.get() == 42);
+  }
+
+  SECTION("Recursive parallelism deeper than the worker count") {
+    stl::ThreadPool pool(2);
+
+    auto future = pool.submit_task(parallel_fib, std::ref(pool), 15);
+
+    REQUIRE(future.get() == 610);
+  }
+
+  SECTION("Waiting on a task already running elsewhere") {
+    stl::ThreadPool pool(2);
+    std::atomic<bool> release{false};
+
+    auto slow = pool.submit_task([&release]() {
+      while (!release.load()) std::this_thread::yield();
+      return 7;
+    });
+    auto waiter = pool.submit_task([&pool, &slow]() { return pool.get(slow); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release = true;
+
+    REQUIRE(waiter.get() == 7);
+  }
+
+  SECTION("Wait outside the pool blocks normally") {
+    stl::ThreadPool pool(2);
+
+    auto future = pool.submit_task([]() { return 5; });
+
+    REQUIRE_FALSE(pool.is_worker_thread());
+    REQUIRE(pool.get(future) == 5);
+  }
+
+  SECTION("Worker thread detection") {
+    stl::ThreadPool pool(1);
+    stl::ThreadPool other(1);
+
+    auto future = pool.submit_task([&pool, &other]() {
+      return pool.is_worker_thread() && !other.is_worker_thread();
+    });
+
+    REQUIRE(future.get());
+  }
+}
+
+TEST_CASE("ThreadPool timers") {
+  SECTION("schedule_after runs on a worker once the delay passed") {
+    std::promise<bool> on_worker;
+    stl::ThreadPool pool(2);
+    auto start = std::chrono::steady_clock::now();
+
+    pool.schedule_after(std::chrono::milliseconds(20), [&]() {
+      on_worker.set_value(pool.is_worker_thread());
+    });
+
+    REQUIRE(on_worker.get_future().get());
+    REQUIRE(std::chrono::steady_clock::now() - start >=
+            std::chrono::milliseconds(20));
+  }
+
+  SECTION("schedule_at with a past time point runs promptly") {
+    std::promise<void> done;
+    stl::ThreadPool pool(1);
+
+    pool.schedule_at(std::chrono::steady_clock::now() -
+                         std::chrono::seconds(1),
+                     [&done]() { done.set_value(); });
+
+    REQUIRE(done.get_future().wait_for(std::chrono::seconds(5)) ==
+            std::future_status::ready);
+  }
+
+  SECTION("Cancelled timer never runs") {
+    Counter counter;
+    stl::ThreadPool pool(1);
+
+    auto id = pool.schedule_after(std::chrono::milliseconds(50),
+                                  [&counter]() { counter.increment(); });
+
+    REQUIRE(pool.pending_timers() == 1);
+    REQUIRE(pool.cancel_timer(id));
+    REQUIRE_FALSE(pool.cancel_timer(id));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    REQUIRE(counter.get() == 0);
+  }
+
+  SECTION("schedule_every repeats until cancelled") {
+    Counter counter;
+    stl::ThreadPool pool(2);
+
+    auto id = pool.schedule_every(std::chrono::milliseconds(5),
+                                  [&counter]() { counter.increment(); });
+
+    while (counter.get() < 3) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(pool.cancel_timer(id));
+    REQUIRE(pool.pending_timers() == 0);
+  }
+
+  SECTION("schedule_every rejects a period that is not positive") {
+    stl::ThreadPool pool(1);
+
+    REQUIRE_THROWS_AS(pool.schedule_every(std::chrono::milliseconds(0), [] {}),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(pool.schedule_every(std::chrono::seconds(-1), [] {}),
+                      std::invalid_argument);
+    REQUIRE(pool.pending_timers() == 0);
+  }
+
+  SECTION("Many timers expiring together all run") {
+    Counter counter;
+    stl::ThreadPool pool(4);
+
+    for (int i = 0; i < 1000; ++i) {
+      pool.schedule_after(std::chrono::milliseconds(i % 10),
+                          [&counter]() { counter.increment(); });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (counter.get() < 1000 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(counter.get() == 1000);
+  }
+
+  SECTION("Scheduling after shutdown throws") {
+    stl::ThreadPool pool(1);
+    pool.shutdown();
+
+    REQUIRE_THROWS_AS(
+        pool.schedule_after(std::chrono::milliseconds(1), []() {}),
+        std::runtime_error);
+  }
+}
+
+// Occupies every worker of a pool until release() is called
+struct Blocker {
+  std::atomic<bool> released{false};
+  std::atomic<int> started{0};
+
+  void occupy(stl::ThreadPool& pool, int workers) {
+    for (int i = 0; i < workers; ++i) {
+      pool.post([this]() {
+        started.fetch_add(1);
+        while (!released.load()) std::this_thread::yield();
+      });
+    }
+    while (started.load() < workers) std::this_thread::yield();
+  }
+
+  void release() { released = true; }
+};
+
+TEST_CASE("ThreadPool bounded queue") {
+  SECTION("Unbounded by default") {
+    stl::ThreadPool pool(1);
+
+    REQUIRE(pool.queue_capacity() == 0);
+    REQUIRE(pool.queue_depth() == 0);
+  }
+
+  SECTION("Reject policy fails fast") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 2, stl::OverflowPolicy::kReject);
+    blocker.occupy(pool, 1);
+
+    auto first = pool.submit_task([]() { return 1; });
+    auto second = pool.submit_task([]() { return 2; });
+    auto rejected = pool.submit_task([]() { return 3; });
+
+    REQUIRE(pool.queue_depth() == 2);
+    REQUIRE_THROWS_AS(rejected.get(), std::runtime_error);
+    REQUIRE_THROWS_AS(pool.post([]() {}), std::runtime_error);
+
+    blocker.release();
+    REQUIRE(first.get() == 1);
+    REQUIRE(second.get() == 2);
+  }
+
+  SECTION("try_submit returns nothing when full") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 1, stl::OverflowPolicy::kBlock);
+    blocker.occupy(pool, 1);
+
+    auto queued = pool.try_submit([]() { return 1; });
+    auto refused = pool.try_submit([]() { return 2; });
+
+    REQUIRE(queued.has_value());
+    REQUIRE_FALSE(refused.has_value());
+
+    blocker.release();
+    REQUIRE(queued->get() == 1);
+  }
+
+  SECTION("Caller runs policy executes on the submitting thread") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 1, stl::OverflowPolicy::kCallerRuns);
+    blocker.occupy(pool, 1);
+
+    auto queued = pool.submit_task([]() { return std::this_thread::get_id(); });
+    auto inline_run =
+        pool.submit_task([]() { return std::this_thread::get_id(); });
+
+    REQUIRE(inline_run.get() == std::this_thread::get_id());
+
+    blocker.release();
+    REQUIRE(queued.get() != std::this_thread::get_id());
+  }
+
+  SECTION("Drop oldest evicts the head of the queue") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 2, stl::OverflowPolicy::kDropOldest);
+    blocker.occupy(pool, 1);
+
+    auto oldest = pool.submit_task([]() { return 1; });
+    auto middle = pool.submit_task([]() { return 2; });
+    auto newest = pool.submit_task([]() { return 3; });
+
+    REQUIRE(pool.queue_depth() == 2);
+
+    blocker.release();
+    REQUIRE_THROWS_AS(oldest.get(), std::future_error);
+    REQUIRE(middle.get() == 2);
+    REQUIRE(newest.get() == 3);
+  }
+
+  SECTION("Drop oldest never evicts a continuation") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 3, stl::OverflowPolicy::kDropOldest);
+    stl::Strand strand(pool);
+    stl::TaskGroup group(pool);
+    blocker.occupy(pool, 1);
+
+    // The strand's runner and the group's task queue as continuations
+    std::atomic<int> strand_ran = 0;
+    std::atomic<int> group_ran = 0;
+    strand.post([&strand_ran]() { strand_ran++; });
+    group.run([&group_ran]() { group_ran++; });
+
+    auto first = pool.submit_task([]() { return 1; });
+    auto second = pool.submit_task([]() { return 2; });
+    auto third = pool.submit_task([]() { return 3; });
+    REQUIRE(pool.queue_depth() == 3);
+
+    blocker.release();
+    REQUIRE_THROWS_AS(first.get(), std::future_error);
+    REQUIRE_THROWS_AS(second.get(), std::future_error);
+    REQUIRE(third.get() == 3);
+    group.wait();
+    strand.post([&strand_ran]() { strand_ran++; });
+    while (strand.pending() != 0) std::this_thread::yield();
+    REQUIRE(strand_ran.load() == 2);
+    REQUIRE(group_ran.load() == 1);
+  }
+
+  SECTION("Drop oldest rejects when only continuations are queued") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 2, stl::OverflowPolicy::kDropOldest);
+    stl::Strand strand(pool);
+    stl::TaskGroup group(pool);
+    blocker.occupy(pool, 1);
+
+    std::atomic<int> ran = 0;
+    strand.post([&ran]() { ran++; });
+    group.run([&ran]() { ran++; });
+
+    REQUIRE_THROWS_AS(pool.post([]() {}), std::runtime_error);
+    auto rejected = pool.submit_task([]() { return 1; });
+
+    blocker.release();
+    REQUIRE_THROWS_AS(rejected.get(), std::runtime_error);
+    group.wait();
+    while (strand.pending() != 0) std::this_thread::yield();
+    REQUIRE(ran.load() == 2);
+  }
+
+  SECTION("Block policy waits for space") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 1, stl::OverflowPolicy::kBlock);
+    blocker.occupy(pool, 1);
+
+    auto queued = pool.submit_task([]() { return 1; });
+    std::atomic<bool> submitted{false};
+    std::future<int> blocked;
+
+    std::thread submitter([&]() {
+      blocked = pool.submit_task([]() { return 2; });
+      submitted = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE_FALSE(submitted.load());
+
+    blocker.release();
+    submitter.join();
+    REQUIRE(submitted.load());
+    REQUIRE(queued.get() == 1);
+    REQUIRE(blocked.get() == 2);
+  }
+
+  SECTION("Blocked submitter is released by shutdown") {
+    Blocker blocker;
+    stl::ThreadPool pool(1, 1, stl::OverflowPolicy::kBlock);
+    blocker.occupy(pool, 1);
+    pool.post([]() {});
+
+    std::future<int> blocked;
+    std::thread submitter(
+        [&]() { blocked = pool.submit_task([]() { return 2; }); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pool.shutdown();
+    submitter.join();
+    blocker.release();
+
+    REQUIRE_THROWS_AS(blocked.get(), std::runtime_error);
+  }
+
+  SECTION("Worker submitting to its own full queue does not deadlock") {
+    stl::ThreadPool pool(1, 1, stl::OverflowPolicy::kBlock);
+
+    auto outer = pool.submit_task([&pool]() {
+      auto first = pool.submit_task([]() { return 1; });
+      auto second = pool.submit_task([]() { return 2; });
+      return pool.get(first) + pool.get(second);
+    });
+
+    REQUIRE(outer.get() == 3);
+  }
+}
+
+TEST_CASE("ThreadPool worker context") {
+  SECTION("Worker index is only set on this pool's workers") {
+    stl::ThreadPool pool(3);
+    stl::ThreadPool other(1);
+
+    REQUIRE_FALSE(pool.current_worker_index().has_value());
+
+    std::vector<std::future<std::optional<size_t>>> futures;
+    for (int i = 0; i < 30; ++i) {
+      futures.push_back(
+          pool.submit_task([&pool]() { return pool.current_worker_index(); }));
+    }
+    for (auto& future : futures) {
+      auto index = future.get();
+      REQUIRE(index.has_value());
+      REQUIRE(*index < pool.size());
+    }
+
+    auto foreign =
+        other.submit_task([&pool]() { return pool.current_worker_index(); });
+    REQUIRE_FALSE(foreign.get().has_value());
+  }
+
+  SECTION("Scratch arena is reset between tasks") {
+    stl::ThreadPool pool(1);
+
+    auto first = pool.submit_task([]() {
+      auto& arena = stl::ThreadPool::scratch_arena();
+      arena.allocate_array<int>(100);
+      return arena.bytes_used();
+    });
+    REQUIRE(first.get() >= 100 * sizeof(int));
+
+    auto second = pool.submit_task(
+        []() { return stl::ThreadPool::scratch_arena().bytes_used(); });
+    REQUIRE(second.get() == 0);
+  }
+
+  SECTION("Nested tasks keep the outer task's scratch memory") {
+    stl::ThreadPool pool(1);
+
+    auto outer = pool.submit_task([&pool]() {
+      auto& arena = stl::ThreadPool::scratch_arena();
+      int* value = arena.create<int>(42);
+      // Runs through help_until on this worker, nested inside this task
+      auto inner = pool.submit_task([]() {
+        stl::ThreadPool::scratch_arena().allocate(64);
+      });
+      pool.get(inner);
+      return *value == 42 && arena.bytes_used() >= sizeof(int) + 64;
+    });
+
+    REQUIRE(outer.get());
+  }
+}
@@ -0,0 +1,141 @@
+#define CATCH_CONFIG_MAIN
+// Telemetry is compiled in for this test binary only
+#define STL_THREAD_POOL_TELEMETRY 1
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "stl/thread_pool.h"
+#include "stl/thread_pool_stats.h"
+
+TEST_CASE("LatencyHistogram") {
+  SECTION("Empty histogram") {
+    stl::LatencyHistogram histogram;
+
+    REQUIRE(histogram.count == 0);
+    REQUIRE(histogram.mean_ns() == 0.0);
+    REQUIRE(histogram.percentile_ns(99) == 0);
+  }
+
+  SECTION("Power-of-two buckets") {
+    REQUIRE(stl::LatencyHistogram::bucket_for(0) == 0);
+    REQUIRE(stl::LatencyHistogram::bucket_for(1) == 1);
+    REQUIRE(stl::LatencyHistogram::bucket_for(2) == 2);
+    REQUIRE(stl::LatencyHistogram::bucket_for(3) == 2);
+    REQUIRE(stl::LatencyHistogram::bucket_for(1024) == 11);
+    REQUIRE(stl::LatencyHistogram::bucket_for(UINT64_MAX) ==
+            stl::LatencyHistogram::kBuckets - 1);
+  }
+
+  SECTION("Percentiles are bucket upper bounds capped by the max") {
+    stl::LatencyHistogram histogram;
+    for (int i = 0; i < 99; ++i) histogram.record(100);
+    histogram.record(5000);
+
+    REQUIRE(histogram.count == 100);
+    REQUIRE(histogram.max_ns == 5000);
+    REQUIRE(histogram.percentile_ns(50) == 127);
+    REQUIRE(histogram.percentile_ns(100) == 5000);
+    REQUIRE(histogram.mean_ns() == (99.0 * 100 + 5000) / 100);
+  }
+
+  SECTION("Merge adds counts") {
+    stl::LatencyHistogram a;
+    stl::LatencyHistogram b;
+    a.record(10);
+    b.record(10);
+    b.record(1000);
+
+    a.merge(b);
+
+    REQUIRE(a.count == 3);
+    REQUIRE(a.total_ns == 1020);
+    REQUIRE(a.max_ns == 1000);
+    REQUIRE(a.buckets[stl::LatencyHistogram::bucket_for(10)] == 2);
+  }
+}
+
+TEST_CASE("ThreadPool telemetry") {
+  SECTION("Compiled in for this binary") {
+    REQUIRE(stl::ThreadPool::kTelemetryEnabled);
+  }
+
+  SECTION("Counts tasks and measures run time") {
+    stl::ThreadPool pool(2);
+    std::vector<std::future<void>> futures;
+
+    for (int i = 0; i < 20; ++i) {
+      futures.push_back(pool.submit_task([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }));
+    }
+    for (auto& future : futures) future.get();
+    // The last task's recorder update happens after its future is ready
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    auto stats = pool.stats();
+
+    REQUIRE(stats.workers.size() == 2);
+    REQUIRE(stats.total.tasks_executed == 20);
+    REQUIRE(stats.total.run_time.count == 20);
+    REQUIRE(stats.total.queue_wait.count == 20);
+    REQUIRE(stats.total.run_time.percentile_ns(50) >= 500'000);
+    REQUIRE(stats.total.busy_ns >= 20'000'000);
+    REQUIRE(stats.max_queue_depth >= 1);
+    REQUIRE(stats.queue_depth == 0);
+  }
+
+  SECTION("Queueing delay shows up when workers are saturated") {
+    stl::ThreadPool pool(1);
+    std::vector<std::future<void>> futures;
+
+    for (int i = 0; i < 5; ++i) {
+      futures.push_back(pool.submit_task([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }));
+    }
+    for (auto& future : futures) future.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    auto stats = pool.stats();
+
+    // The last task waited behind four 5ms tasks
+    REQUIRE(stats.total.queue_wait.max_ns >= 15'000'000);
+    REQUIRE(stats.max_queue_depth >= 4);
+  }
+
+  SECTION("Helped tasks are counted separately") {
+    stl::ThreadPool pool(1);
+
+    auto outer = pool.submit_task([&pool]() {
+      auto inner = pool.submit_task([]() { return 1; });
+      return pool.get(inner);
+    });
+    REQUIRE(outer.get() == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    auto stats = pool.stats();
+
+    REQUIRE(stats.total.tasks_executed == 1);
+    REQUIRE(stats.total.tasks_helped == 1);
+  }
+
+  SECTION("Idle time and utilisation") {
+    stl::ThreadPool pool(1);
+
+    pool.submit_task([]() {}).get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // Ends the worker's idle period so it is accounted
+    pool.submit_task([]() {}).get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    auto stats = pool.stats();
+
+    REQUIRE(stats.total.idle_ns >= 10'000'000);
+    REQUIRE(stats.utilisation() >= 0.0);
+    REQUIRE(stats.utilisation() < 0.5);
+  }
+}
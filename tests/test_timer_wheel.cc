@@ -0,0 +1,213 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+#include "stl/timer_wheel.h"
+
+// Runs every expired callback and returns how many fired
+size_t run_expired(stl::TimerWheel& wheel, stl::TimerWheel::Tick now) {
+  std::vector<stl::TimerWheel::Callback> expired;
+  wheel.advance(now, expired);
+  for (auto& callback : expired) callback();
+  return expired.size();
+}
+
+TEST_CASE("TimerWheel basic operations") {
+  SECTION("Empty wheel") {
+    stl::TimerWheel wheel;
+
+    REQUIRE(wheel.empty());
+    REQUIRE_FALSE(wheel.ticks_until_next().has_value());
+    REQUIRE(run_expired(wheel, 1000) == 0);
+    REQUIRE(wheel.now() == 1000);
+  }
+
+  SECTION("Timer fires exactly at its expiry") {
+    stl::TimerWheel wheel;
+    int fired = 0;
+
+    wheel.insert(10, [&fired]() { fired++; });
+
+    REQUIRE(wheel.size() == 1);
+    REQUIRE(wheel.ticks_until_next() == 10);
+    REQUIRE(run_expired(wheel, 9) == 0);
+    REQUIRE(run_expired(wheel, 10) == 1);
+    REQUIRE(fired == 1);
+    REQUIRE(wheel.empty());
+  }
+
+  SECTION("Expiry in the past fires on the next tick") {
+    stl::TimerWheel wheel(50);
+    int fired = 0;
+
+    wheel.insert(10, [&fired]() { fired++; });
+
+    REQUIRE(run_expired(wheel, 51) == 1);
+    REQUIRE(fired == 1);
+  }
+
+  SECTION("Callbacks come out in expiry order") {
+    stl::TimerWheel wheel;
+    std::vector<int> order;
+
+    wheel.insert(300, [&order]() { order.push_back(3); });
+    wheel.insert(5, [&order]() { order.push_back(1); });
+    wheel.insert(70000, [&order]() { order.push_back(4); });
+    wheel.insert(200, [&order]() { order.push_back(2); });
+
+    REQUIRE(run_expired(wheel, 100000) == 4);
+    REQUIRE(order == std::vector<int>{1, 2, 3, 4});
+  }
+}
+
+TEST_CASE("TimerWheel cancellation") {
+  SECTION("Cancel pending timer") {
+    stl::TimerWheel wheel;
+    int fired = 0;
+
+    auto id = wheel.insert(100, [&fired]() { fired++; });
+
+    REQUIRE(wheel.cancel(id));
+    REQUIRE(wheel.empty());
+    REQUIRE(run_expired(wheel, 200) == 0);
+    REQUIRE(fired == 0);
+  }
+
+  SECTION("Cancel twice and cancel after firing") {
+    stl::TimerWheel wheel;
+
+    auto cancelled = wheel.insert(100, []() {});
+    auto fired = wheel.insert(10, []() {});
+
+    REQUIRE(wheel.cancel(cancelled));
+    REQUIRE_FALSE(wheel.cancel(cancelled));
+
+    run_expired(wheel, 20);
+    REQUIRE_FALSE(wheel.cancel(fired));
+  }
+
+  SECTION("Stale handle does not cancel a reused slot") {
+    stl::TimerWheel wheel;
+
+    auto old_id = wheel.insert(10, []() {});
+    REQUIRE(wheel.cancel(old_id));
+
+    // Reuses the freed slot with a new generation
+    auto new_id = wheel.insert(20, []() {});
+    REQUIRE(new_id.index == old_id.index);
+    REQUIRE_FALSE(wheel.cancel(old_id));
+    REQUIRE(wheel.size() == 1);
+    REQUIRE(wheel.cancel(new_id));
+  }
+
+  SECTION("Cancel from the middle of a slot") {
+    stl::TimerWheel wheel;
+    std::vector<int> fired;
+
+    wheel.insert(10, [&fired]() { fired.push_back(1); });
+    auto middle = wheel.insert(10, [&fired]() { fired.push_back(2); });
+    wheel.insert(10, [&fired]() { fired.push_back(3); });
+
+    REQUIRE(wheel.cancel(middle));
+    REQUIRE(run_expired(wheel, 10) == 2);
+    REQUIRE(fired.size() == 2);
+  }
+}
+
+TEST_CASE("TimerWheel periodic timers") {
+  SECTION("Rearms every period") {
+    stl::TimerWheel wheel;
+    int fired = 0;
+
+    wheel.insert(10, [&fired]() { fired++; }, 10);
+
+    REQUIRE(run_expired(wheel, 10) == 1);
+    REQUIRE(run_expired(wheel, 20) == 1);
+    REQUIRE(run_expired(wheel, 35) == 1);
+    REQUIRE(fired == 3);
+    REQUIRE(wheel.size() == 1);
+  }
+
+  SECTION("Missed periods fire once, keeping the phase") {
+    stl::TimerWheel wheel;
+    int fired = 0;
+
+    wheel.insert(10, [&fired]() { fired++; }, 10);
+
+    // Ten periods late
+    REQUIRE(run_expired(wheel, 105) == 1);
+    REQUIRE(run_expired(wheel, 109) == 0);
+    REQUIRE(run_expired(wheel, 110) == 1);
+    REQUIRE(fired == 2);
+  }
+
+  SECTION("Periodic timer can be cancelled with its original id") {
+    stl::TimerWheel wheel;
+
+    auto id = wheel.insert(10, []() {}, 300);
+    run_expired(wheel, 1000);
+
+    REQUIRE(wheel.cancel(id));
+    REQUIRE(wheel.empty());
+  }
+}
+
+TEST_CASE("TimerWheel cascading across levels") {
+  SECTION("Timers on every level fire at the right tick") {
+    stl::TimerWheel wheel;
+    std::vector<stl::TimerWheel::Tick> expiries = {
+        1, 255, 256, 257, 65535, 65536, 70001, 16777216, 16777300};
+    std::vector<stl::TimerWheel::Tick> fired_at;
+
+    for (auto expiry : expiries) {
+      wheel.insert(expiry, [&fired_at, &wheel]() {
+        fired_at.push_back(wheel.now());
+      });
+    }
+
+    // Step tick by tick around each expiry to catch early or late firing
+    for (auto expiry : expiries) {
+      run_expired(wheel, expiry - 1);
+      REQUIRE(run_expired(wheel, expiry) == 1);
+      REQUIRE(fired_at.back() == expiry);
+    }
+    REQUIRE(wheel.empty());
+  }
+
+  SECTION("Beyond the wheel range still fires") {
+    stl::TimerWheel wheel;
+    stl::TimerWheel::Tick far = (stl::TimerWheel::Tick{1} << 32) + 5;
+    int fired = 0;
+
+    wheel.insert(far, [&fired]() { fired++; });
+
+    REQUIRE(run_expired(wheel, far - 1) == 0);
+    REQUIRE(run_expired(wheel, far) == 1);
+    REQUIRE(fired == 1);
+  }
+
+  SECTION("Random expiries all fire exactly once") {
+    stl::TimerWheel wheel(12345);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<stl::TimerWheel::Tick> dist(1, 200000);
+    std::vector<int> counts(2000, 0);
+    std::vector<stl::TimerId> ids;
+
+    for (size_t i = 0; i < counts.size(); i++) {
+      ids.push_back(wheel.insert(wheel.now() + dist(rng),
+                                 [&counts, i]() { counts[i]++; }));
+    }
+    // Cancel every fourth timer
+    for (size_t i = 0; i < ids.size(); i += 4) {
+      REQUIRE(wheel.cancel(ids[i]));
+    }
+
+    run_expired(wheel, wheel.now() + 200001);
+
+    REQUIRE(wheel.empty());
+    for (size_t i = 0; i < counts.size(); i++) {
+      REQUIRE(counts[i] == (i % 4 == 0 ? 0 : 1));
+    }
+  }
+}
@@ -0,0 +1,160 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "stl/thread_pool.h"
+#include "stl/tracer.h"
+
+namespace {
+
+size_t count_of(const std::string& text, const std::string& needle) {
+  size_t count = 0;
+  for (size_t pos = text.find(needle); pos != std::string::npos;
+       pos = text.find(needle, pos + needle.size())) {
+    count++;
+  }
+  return count;
+}
+
+std::string dump(const stl::Tracer& tracer) {
+  std::ostringstream out;
+  tracer.write_chrome_trace(out);
+  return out.str();
+}
+
+}  // namespace
+
+TEST_CASE("TraceRing") {
+  SECTION("Keeps events in order") {
+    stl::TraceRing ring(8);
+    ring.record(stl::TraceEventType::kTaskBegin, 10, false);
+    ring.record(stl::TraceEventType::kTaskEnd, 20, false);
+
+    auto events = ring.events();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].type == stl::TraceEventType::kTaskBegin);
+    REQUIRE(events[0].timestamp == 10);
+    REQUIRE(events[1].type == stl::TraceEventType::kTaskEnd);
+    REQUIRE(events[1].timestamp == 20);
+  }
+
+  SECTION("Overwrites the oldest events when full") {
+    stl::TraceRing ring(4);
+    for (uint64_t i = 0; i < 10; ++i) {
+      ring.record(stl::TraceEventType::kSubmit, i, true);
+    }
+
+    auto events = ring.events();
+    REQUIRE(ring.recorded() == 10);
+    REQUIRE(events.size() == 4);
+    for (uint64_t i = 0; i < 4; ++i) REQUIRE(events[i].timestamp == 6 + i);
+  }
+
+  SECTION("Capacity rounds up to a power of two") {
+    stl::TraceRing ring(5);
+    for (uint64_t i = 0; i < 20; ++i) {
+      ring.record(stl::TraceEventType::kSubmit, i, false);
+    }
+    REQUIRE(ring.events().size() == 8);
+  }
+}
+
+TEST_CASE("Tracer") {
+  SECTION("One ring per worker plus a shared one") {
+    stl::Tracer tracer(3, 16);
+    REQUIRE(tracer.num_rings() == 4);
+    REQUIRE(tracer.external_ring() == 3);
+
+    // Out of range workers fall back to the shared ring
+    tracer.record(7, stl::TraceEventType::kSubmit);
+    REQUIRE(tracer.ring(3).recorded() == 1);
+  }
+
+  SECTION("Chrome trace JSON") {
+    stl::Tracer tracer(1, 16);
+    tracer.record(0, stl::TraceEventType::kTaskBegin);
+    tracer.record(0, stl::TraceEventType::kTaskEnd);
+    tracer.record(tracer.external_ring(), stl::TraceEventType::kSubmit);
+
+    std::string json = dump(tracer);
+    REQUIRE(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) ==
+            0);
+    REQUIRE(json.find("]}") != std::string::npos);
+    REQUIRE(count_of(json, "\"thread_name\"") == 2);
+    REQUIRE(json.find("\"name\":\"worker 0\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"external\"") != std::string::npos);
+    REQUIRE(count_of(json, "\"name\":\"task\",\"ph\":\"B\"") == 1);
+    REQUIRE(count_of(json, "\"name\":\"task\",\"ph\":\"E\"") == 1);
+    REQUIRE(count_of(json, "\"name\":\"submit\",\"ph\":\"i\"") == 1);
+    REQUIRE(count_of(json, "{") == count_of(json, "}"));
+  }
+
+  SECTION("Writes to a file") {
+    stl::Tracer tracer(1, 16);
+    tracer.record(0, stl::TraceEventType::kSleepBegin);
+    tracer.record(0, stl::TraceEventType::kSleepEnd);
+
+    auto path = std::filesystem::temp_directory_path() / "stl_test_trace.json";
+    REQUIRE(tracer.write_chrome_trace(path.string()));
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    REQUIRE(count_of(contents.str(), "\"name\":\"sleep\"") == 2);
+    std::filesystem::remove(path);
+  }
+}
+
+TEST_CASE("ThreadPool tracing") {
+  SECTION("Records submit and task events") {
+    stl::Tracer tracer(2);
+    stl::ThreadPool pool(2);
+    pool.set_tracer(&tracer);
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 50; ++i) {
+      futures.push_back(pool.submit_task([i]() { return i; }));
+    }
+    for (auto& future : futures) future.get();
+    pool.set_tracer(nullptr);
+
+    std::string json = dump(tracer);
+    REQUIRE(count_of(json, "\"name\":\"submit\"") == 50);
+    // A task's end is recorded after its future is ready, so count begins
+    REQUIRE(count_of(json, "\"name\":\"task\",\"ph\":\"B\"") == 50);
+  }
+
+  SECTION("Helped tasks are traced separately") {
+    stl::Tracer tracer(1);
+    stl::ThreadPool pool(1);
+    pool.set_tracer(&tracer);
+
+    auto outer = pool.submit_task([&pool]() {
+      auto inner = pool.submit_task([]() { return 1; });
+      return pool.get(inner);
+    });
+    REQUIRE(outer.get() == 1);
+    pool.set_tracer(nullptr);
+
+    std::string json = dump(tracer);
+    REQUIRE(count_of(json, "\"name\":\"helped task\",\"ph\":\"B\"") == 1);
+    REQUIRE(count_of(json, "\"name\":\"helped task\",\"ph\":\"E\"") == 1);
+  }
+
+  SECTION("Detached pools record nothing") {
+    stl::Tracer tracer(1);
+    stl::ThreadPool pool(1);
+    pool.submit_task([]() {}).get();
+
+    for (size_t i = 0; i < tracer.num_rings(); ++i) {
+      REQUIRE(tracer.ring(i).recorded() == 0);
+    }
+    REQUIRE(pool.size() == 1);
+  }
+}
@@ -0,0 +1,88 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "stl/task_group.h"
+#include "stl/thread_pool.h"
+#include "stl/worker_local.h"
+
+TEST_CASE("WorkerLocal") {
+  SECTION("One slot per worker and lent thread plus a shared one") {
+    stl::ThreadPool pool(3);
+    stl::WorkerLocal<int> local(pool, 7);
+
+    REQUIRE(local.size() == 3 + stl::ThreadPool::kMaxLentThreads + 1);
+    REQUIRE(local.combine([](int a, int b) { return a + b; }) ==
+            7 * static_cast<int>(local.size()));
+  }
+
+  SECTION("Parallel reduction") {
+    stl::ThreadPool pool(4);
+    stl::WorkerLocal<uint64_t> sums(pool);
+
+    std::vector<std::future<void>> futures;
+    for (uint64_t i = 1; i <= 10000; ++i) {
+      futures.push_back(pool.submit_task([&sums, i]() { sums.local() += i; }));
+    }
+    for (auto& future : futures) future.get();
+
+    REQUIRE(sums.combine([](uint64_t a, uint64_t b) { return a + b; }) ==
+            10000 * 10001 / 2);
+  }
+
+  SECTION("Outside threads use the shared slot") {
+    stl::ThreadPool pool(2);
+    stl::WorkerLocal<int> local(pool);
+
+    local.local() = 5;
+
+    std::vector<int> values;
+    local.for_each([&values](int& value) { values.push_back(value); });
+    REQUIRE(values.size() == local.size());
+    REQUIRE(values.back() == 5);
+    REQUIRE(local.combine([](int a, int b) { return a + b; }) == 5);
+  }
+
+  SECTION("Helped tasks on an outside thread land in the shared slot") {
+    stl::ThreadPool pool(1);
+    stl::WorkerLocal<int> counts(pool);
+    stl::TaskGroup group(pool);
+
+    for (int i = 0; i < 100; ++i) group.run([&counts]() { counts.local()++; });
+    group.wait();
+
+    REQUIRE(counts.combine([](int a, int b) { return a + b; }) == 100);
+  }
+
+  SECTION("Lent workers get slots of their own") {
+    stl::ThreadPool pool(1);
+    stl::ThreadPool lender(3);
+    lender.lend_idle_workers_to(&pool);
+    stl::WorkerLocal<int> counts(pool);
+
+    // Keeps the pool's only worker busy, so its queue goes to the lender
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    auto blocker = pool.submit_task([released]() { released.wait(); });
+
+    std::vector<std::future<bool>> futures;
+    for (int i = 0; i < 1000; ++i) {
+      futures.push_back(pool.submit_task([&pool, &counts]() {
+        counts.local()++;
+        auto slot = pool.current_slot();
+        return slot.has_value() && *slot >= pool.size() &&
+               !pool.current_worker_index().has_value();
+      }));
+    }
+    bool all_lent = true;
+    for (auto& future : futures) all_lent = future.get() && all_lent;
+    release.set_value();
+    blocker.get();
+    lender.lend_idle_workers_to(nullptr);
+
+    REQUIRE(all_lent);
+    REQUIRE(counts.combine([](int a, int b) { return a + b; }) == 1000);
+  }
+}